@@ -1,4 +1,4 @@
 #! /bin/sh -x
 
 h5pcc=${CC:-cc}
-$h5pcc h5core.c -o h5core
+$h5pcc h5core.c -o h5core -lpthread -lm
@@ -1,10 +1,22 @@
+#define _GNU_SOURCE             /* mremap, RUSAGE_THREAD */
+
 #include "hdf5.h"
 #include "hdf5_hl.h"
 #include "mpi.h"
 
 #include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 /* 512 MB increments for re-allocation */
@@ -14,19 +26,255 @@
 #define MAX_ITER 5
 #define MAX_LEN 255
 #define MAX_TIME_LEVEL 70
+/* 64 GB of address space reserved per file with -m */
+#define RESERVE 64L*1024*1024*1024
 /* 64 MB page size */
 #define PAGE_SIZE 64*1024*1024
-/* dataset shape */
+/* default dataset shape */
 #define RANK 3
 #define X 48
 #define Y 48
 #define Z 600
 
-void getmemory (int *memtotal, int *memfree, int *buffers, int *cached,
-                int *swapcached, int *active, int *inactive);
+/* result record formats for -o */
+#define FMT_CSV 0
+#define FMT_JSON 1
+
+/* node files written with -N: a header, an index entry per rank, then
+   the images, each aligned */
+#define NODE_MAGIC "H5CNODE"
+#define NODE_ALIGN 4096
+/* largest single message while gathering an image */
+#define NODE_CHUNK (256*1024*1024)
+
+/* most page sizes in a -W sweep */
+#define MAX_PAGES 32
+
+/* drivers for -d */
+#define DRV_CORE 0
+#define DRV_CORE_BACKED 1
+#define DRV_SEC2 2
+#define DRV_STDIO 3
+#define DRV_SPLIT 4
+#define DRV_MPIO 5
+#define MAX_DRIVERS 8
+
+/* synthetic content for -c */
+#define FIELD_GARBAGE 0         /* one buffer, never filled */
+#define FIELD_ZERO 1
+#define FIELD_RAMP 2
+#define FIELD_SINE 3
+#define FIELD_RANDOM 4
+
+/* ways of reopening a file in the read-back phase */
+#define READ_CORE 0
+#define READ_SEC2 1
+#define READ_IMAGE 2
+#define READ_METHODS 3
+
+/* phases recorded with each memory sample */
+#define PHASE_IDLE 0
+#define PHASE_BUFFER 1
+#define PHASE_FLUSH 2
+#define PHASE_CREATE 3
+
+/* largest raw data that fits a compact layout's object header message */
+#define COMPACT_MAX 64000
+
+/* the image of a finished file on its way to disk */
+typedef struct image
+{
+  char name[MAX_LEN];
+  void *buf;
+  size_t size;
+  size_t maplen;                /* mapped length, 0 if on the heap */
+  struct image *next;
+} image_t;
+
+/* images handed to the background writer, at most maxinflight at a time */
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  image_t *head, *tail;
+  unsigned inflight, maxinflight;
+  int done;
+  double busy;                  /* seconds the writer spent writing */
+  double written;               /* bytes the writer wrote */
+} pipeline_t;
+
+/* Allocator behind the core driver's buffer.  With mmap the whole
+   reserve is mapped up front without swap reservation, so growing the
+   buffer only moves the end marker and never copies. */
+typedef struct
+{
+  int mapped;                   /* reserve address space with mmap */
+  int hugepages;                /* ask for transparent huge pages */
+  int keep;                     /* hand the buffer over at close */
+  size_t reserve;
+  void *buf;                    /* the live buffer */
+  size_t len;                   /* its mapped length */
+  size_t size;                  /* bytes the driver last asked for */
+  unsigned nrealloc;            /* calls to grow the buffer */
+  unsigned nmoved;              /* ... that returned a new address */
+} imgalloc_t;
+
+void *image_malloc (size_t size, H5FD_file_image_op_t op, void *udata);
+
+void *image_memcpy (void *dest, const void *src, size_t size,
+                    H5FD_file_image_op_t op, void *udata);
+
+void *image_realloc (void *ptr, size_t size, H5FD_file_image_op_t op,
+                     void *udata);
+
+herr_t image_free (void *ptr, H5FD_file_image_op_t op, void *udata);
+
+void *udata_copy (void *udata);
+
+herr_t udata_free (void *udata);
+
+/* one rank's numbers for one iteration, gathered to rank 0 for -o;
+   memory deltas are in kB, [0] over buffering and [1] over the close */
+typedef struct
+{
+  double buffering;
+  double flush;
+  double nrealloc;
+  double nmoved;
+  double minflt;
+  double majflt;
+  double dmemfree[2];
+  double dcached[2];
+  double dactive[2];
+  double dinactive[2];
+  double create_mean;           /* per dataset with -B, else 0 */
+  double create_max;
+  double write_mean;
+  double write_max;
+  double reopen;                /* with -N, else 0 */
+} record_t;
+
+/* node memory from /proc/meminfo, in kB */
+typedef struct
+{
+  long memtotal;
+  long memfree;
+  long memavailable;
+  long buffers;
+  long cached;
+  long swapcached;
+  long active;
+  long inactive;
+  long dirty;
+  long writeback;
+} meminfo_t;
+
+/* one sample of the background memory sampler; sizes in kB */
+typedef struct
+{
+  double time;                  /* seconds since the sampler started */
+  int iter;
+  int phase;
+  long rss;
+  long pss;                     /* -1 without smaps_rollup */
+  long dirty;
+  long writeback;
+  long image;                   /* core driver buffer */
+} sample_t;
+
+/* The sampler thread reads /proc only; the main thread publishes the
+   iteration and phase it is in. */
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int done;
+  double interval;
+  struct timeval start;
+  volatile int iter, phase;
+  const imgalloc_t *alloc;
+  sample_t *samples;
+  size_t nsamples, maxsamples;
+  sample_t peak;                /* high-water mark of each field */
+} sampler_t;
+
+void *samplememory (void *arg);
+
+/* what goes into each dataset: element i of dataset number seq is a
+   function of the field, i and seq only */
+typedef struct
+{
+  int field;
+  int isfloat;
+  size_t tsize;
+  size_t nelem;
+} content_t;
+
+/* Bounded ring of dataset buffers between the generating workers and
+   the HDF5 thread.  Dataset seq always goes to slot seq % nslots, and a
+   worker may only fill it once dataset seq - nslots has been written. */
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t filled, emptied;
+  const content_t *content;
+  void **slots;
+  int *full;
+  unsigned nslots;
+  unsigned long next;           /* next dataset to claim */
+  unsigned long written;        /* datasets written so far */
+  unsigned long total;
+  double busy;                  /* seconds workers spent generating */
+  double pstall;                /* seconds workers waited for a slot */
+  double cstall;                /* seconds the HDF5 thread waited */
+} ring_t;
+
+void fillbuffer (void *buf, const content_t *content, unsigned long seq);
+
+void *produce (void *arg);
+
+void *ringget (ring_t *ring, unsigned long seq);
+
+void ringput (ring_t *ring, unsigned long seq);
+
+double wtime (void);
+
+void getprocess (long *rss, long *pss);
+
+void getio (long long *wchar, long long *syscw);
+
+int getpages (char *list, size_t *pages, unsigned *npages);
+
+int getdrivers (char *list, int *drivers, unsigned *ndrivers);
+
+hid_t makefapl (int driver, hid_t corefapl, size_t incr);
+
+int gettype (const char *tname, hid_t *type);
+
+void setlinks (hid_t gcpl, unsigned children);
+
+int getshape (char *spec, int *ndims, hsize_t *dims);
+
+void putrecord (FILE *fp, int fmt, int rank, unsigned iter, const char *shape,
+                const char *tname, unsigned levels, unsigned groups,
+                unsigned dsets, double bytes, const record_t *rec);
 
-void printmemory (int rank, int memtotal, int memfree, int buffers, int cached,
-                  int swapcached, int active, int inactive);
+void *writeimages (void *arg);
+
+void putimage (pipeline_t *pipe, image_t *img);
+
+void gatherimage (MPI_Comm nodecomm, const char *fname, void *buf, size_t size);
+
+void reopenimage (const char *fname, int rank);
+
+double readback (const char *fname, int method, unsigned levels,
+                 unsigned groups, unsigned dsets, hid_t type, void *rbuf,
+                 void *buf, const content_t *content, unsigned long seq,
+                 double *opentime);
+
+void getmemory (meminfo_t *mem);
+
+void printmemory (int rank, const meminfo_t *mem);
 
 int
 main (int argc, char **argv)
@@ -35,18 +283,71 @@ main (int argc, char **argv)
   extern int optind, optopt;
   int c, errflg, backflg, incrflg, nopagflg, pagflg, rank, nranks;
   hid_t fapl, file, group, group1, dset;
+  hid_t space, dcpl, gcpl1, gcpl2;
+  int batchflg;
+  H5D_layout_t layout;
+  double t3, t4, t5;
   size_t incr, page;
+  unsigned inflight;
+  pipeline_t pipe;
+  pthread_t writer;
+  imgalloc_t alloc;
+  struct rusage ru1, ru2;
+  long minflt, majflt;
+  H5FD_file_image_callbacks_t callbacks;
+  image_t *img;
+  ssize_t imgsize;
   unsigned iter, level, igroup, idset, maxiter;
+  unsigned levels, groups, dsets;
   char name[MAX_LEN];
   char g1name[MAX_LEN];
   char g2name[MAX_LEN];
-  hsize_t dims[3] = { X, Y, Z };
-  float *buf;
+  char shape[MAX_LEN];
+  const char *tname, *outname;
+  int ndims, fmt;
+  hsize_t dims[H5S_MAX_RANK] = { X, Y, Z };
+  hid_t type;
+  size_t nelem;
+  double nbytes;
+  void *buf;
   double start, stop;
   double t1, t2;
   char cdum[MAX_LEN];
-  int i, memtotal, memfree, buffers, cached, swapcached, active, inactive;
+  int i;
+  meminfo_t mem, mem0;
+  sampler_t sampler;
+  pthread_t sampling;
+  double interval;
+  FILE *fp_mem;
+  size_t j;
+  int nodeflg, nnodes;
+  MPI_Comm nodecomm, leadcomm;
+  int nodeid;
+  int readflg, method;
+  void *rbuf;
+  double opentime[READ_METHODS], walktime[READ_METHODS];
+  static const char *methods[READ_METHODS] = { "core", "sec2", "file image" };
+  size_t pages[MAX_PAGES];
+  unsigned npages, ipage, sweepiter;
+  long long wchar1, syscw1, wchar2, syscw2;
+  struct stat st;
+  double sweepflush[MAX_PAGES];
+  long long sweepbytes[MAX_PAGES], sweepcalls[MAX_PAGES], sweepdisk[MAX_PAGES];
+  static const char *drvnames[] = { "core", "core-backed", "sec2", "stdio", "split", "mpio" };
+  int drivers[MAX_DRIVERS];
+  unsigned ndrivers, idriver;
+  hid_t fapls[MAX_DRIVERS];
+  content_t content;
+  ring_t ring;
+  unsigned nworkers, nslots, iworker;
+  pthread_t *workers;
+  unsigned long seq;
+  void *dbuf;
+  double consume;
+  double drvbuffer[MAX_DRIVERS], drvflush[MAX_DRIVERS];
   float fdum;
+  FILE *fp_out;
+  record_t rec, *recs;
 
   assert (MPI_Init (&argc, &argv) >= 0);
   assert (MPI_Comm_rank (MPI_COMM_WORLD, &rank) >= 0);
@@ -58,14 +359,93 @@ main (int argc, char **argv)
   incr = INCREMENT;
   page = PAGE_SIZE;
   maxiter = MAX_ITER;
+  inflight = 0;
+  levels = MAX_TIME_LEVEL;
+  groups = MAX_GROUPS;
+  dsets = MAX_DATASETS;
+  ndims = RANK;
+  assert (sprintf (shape, "%dx%dx%d", X, Y, Z) > 0);
+  tname = "float";
+  type = H5T_NATIVE_FLOAT;
+  outname = NULL;
+  fmt = FMT_CSV;
+  batchflg = 0;
+  layout = H5D_CONTIGUOUS;
+  interval = 0.0;
+  nodeflg = 0;
+  readflg = 0;
+  npages = 0;
+  ndrivers = 0;
+  content.field = FIELD_GARBAGE;
+  nworkers = nslots = 0;
+  alloc.mapped = alloc.hugepages = 0;
+  alloc.reserve = RESERVE;
 
-  while ((c = getopt(argc, argv, ":bni:t:p:")) != -1)
+  while ((c = getopt(argc, argv, ":bBc:d:D:F:G:Hi:l:L:mnNo:t:p:P:q:r:Rs:S:T:w:W:")) != -1)
     {
       switch (c)
       {
       case 'b':
         backflg++;
         break;
+      case 'B':
+        batchflg++;
+        break;
+      case 'c':
+        if (strcmp (optarg, "zero") == 0)
+          content.field = FIELD_ZERO;
+        else if (strcmp (optarg, "ramp") == 0)
+          content.field = FIELD_RAMP;
+        else if (strcmp (optarg, "sine") == 0)
+          content.field = FIELD_SINE;
+        else if (strcmp (optarg, "random") == 0)
+          content.field = FIELD_RANDOM;
+        else
+          {
+            fprintf(stderr, "Unknown content: %s\n", optarg);
+            errflg++;
+          }
+        break;
+      case 'd':
+        if (getdrivers (optarg, drivers, &ndrivers) < 0)
+          {
+            fprintf(stderr, "Bad driver list: %s\n", optarg);
+            errflg++;
+          }
+        break;
+      case 'D':
+        dsets = (unsigned)atol(optarg);
+        if (dsets == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'F':
+        if (strcmp (optarg, "csv") == 0)
+          fmt = FMT_CSV;
+        else if (strcmp (optarg, "json") == 0)
+          fmt = FMT_JSON;
+        else
+          {
+            fprintf(stderr, "Unknown result format: %s\n", optarg);
+            errflg++;
+          }
+        break;
+      case 'G':
+        groups = (unsigned)atol(optarg);
+        if (groups == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'H':
+        alloc.hugepages = 1;
+        alloc.mapped = 1;
+        break;
       case 'i':
         incrflg++;
         incr = (size_t)atol(optarg);
@@ -76,9 +456,36 @@ main (int argc, char **argv)
             errflg++;
           }
         break;
+      case 'l':
+        batchflg++;
+        if (strcmp (optarg, "compact") == 0)
+          layout = H5D_COMPACT;
+        else if (strcmp (optarg, "contiguous") == 0)
+          layout = H5D_CONTIGUOUS;
+        else
+          {
+            fprintf(stderr, "Unknown layout: %s\n", optarg);
+            errflg++;
+          }
+        break;
+      case 'L':
+        levels = (unsigned)atol(optarg);
+        if (levels == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'm':
+        alloc.mapped = 1;
+        break;
       case 'n':
         nopagflg++;
         break;
+      case 'N':
+        nodeflg++;
+        break;
       case 'p':
         pagflg++;
         page = (size_t)atol(optarg);
@@ -89,6 +496,65 @@ main (int argc, char **argv)
             errflg++;
           }
         break;
+      case 'P':
+        inflight = (unsigned)atol(optarg);
+        if (inflight == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'o':
+        outname = optarg;
+        break;
+      case 'q':
+        nslots = (unsigned)atol(optarg);
+        if (nslots == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'r':
+        alloc.reserve = (size_t)atol(optarg);
+        if (alloc.reserve == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'R':
+        readflg++;
+        break;
+      case 's':
+        assert (strlen (optarg) < MAX_LEN);
+        strcpy (shape, optarg);
+        if (getshape (optarg, &ndims, dims) < 0)
+          {
+            fprintf(stderr, "Bad dataset shape: %s\n", shape);
+            errflg++;
+          }
+        break;
+      case 'S':
+        interval = atof(optarg);
+        if (interval <= 0.0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'T':
+        tname = optarg;
+        if (gettype (tname, &type) < 0)
+          {
+            fprintf(stderr, "Unknown datatype: %s\n", tname);
+            errflg++;
+          }
+        break;
       case 't':
         maxiter = (unsigned)atol(optarg);
         if (maxiter == 0)
@@ -98,6 +564,22 @@ main (int argc, char **argv)
             errflg++;
           }
         break;
+      case 'w':
+        nworkers = (unsigned)atol(optarg);
+        if (nworkers == 0)
+          {
+            fprintf(stderr,
+                    "Option -%c requires a positive integer argument\n", optopt);
+            errflg++;
+          }
+        break;
+      case 'W':
+        if (getpages (optarg, pages, &npages) < 0)
+          {
+            fprintf(stderr, "Bad page size list: %s\n", optarg);
+            errflg++;
+          }
+        break;
       case ':':       /* -i or -p without operand */
         fprintf(stderr,
                 "Option -%c requires an operand\n", optopt);
@@ -121,10 +603,39 @@ main (int argc, char **argv)
           fprintf(stderr, "usage: h5core [OPTIONS]\n");
           fprintf(stderr, "  OPTIONS\n");
           fprintf(stderr, "     -b      Write file to disk on exit\n");
+          fprintf(stderr, "     -B      Create datasets from one dataspace and one tuned property\n");
+          fprintf(stderr, "             list, and report per-dataset create and write latency\n");
+          fprintf(stderr, "     -c C    Fill every dataset with zero, ramp, sine or random content\n");
+          fprintf(stderr, "             [default: one buffer, never filled]\n");
+          fprintf(stderr, "     -d L    Run each driver of the comma-separated list L for -t iterations:\n");
+          fprintf(stderr, "             core, core-backed, sec2, stdio, split or mpio (one rank per file)\n");
+          fprintf(stderr, "     -D D    Datasets per group [default: 10]\n");
+          fprintf(stderr, "     -F F    Result record format, csv or json [default: csv]\n");
+          fprintf(stderr, "     -G G    Groups per time level [default: 10]\n");
+          fprintf(stderr, "     -H      Like -m, with transparent huge pages\n");
           fprintf(stderr, "     -i I    Memory buffer increment size in bytes [default: 512 MB]\n");
+          fprintf(stderr, "     -l L    Dataset layout with -B, compact or contiguous [default: contiguous]\n");
+          fprintf(stderr, "     -L L    Time levels per file [default: 70]\n");
+          fprintf(stderr, "     -m      Reserve the memory buffer with mmap; growing it never copies\n");
           fprintf(stderr, "     -n      Disable write (to disk) paging\n");
+          fprintf(stderr, "     -N      Gather the images of each node into one file per node\n");
+          fprintf(stderr, "     -o O    Write a result record per rank and iteration to O\n");
           fprintf(stderr, "     -p P    Page size in bytes [default: 64 MB]\n");
+          fprintf(stderr, "     -P N    Write files to disk from a background thread while the\n");
+          fprintf(stderr, "             next one is buffered, at most N images in memory\n");
+          fprintf(stderr, "     -q Q    Dataset buffers between -w workers and HDF5 [default: 2 per worker]\n");
+          fprintf(stderr, "     -r R    Address space reserved per file with -m in bytes [default: 64 GB]\n");
+          fprintf(stderr, "     -R      Read every file back with the core driver, sec2 and\n");
+          fprintf(stderr, "             H5LTopen_file_image, and verify the data\n");
+          fprintf(stderr, "             (needs -b or -P, not -N)\n");
+          fprintf(stderr, "     -s S    Dataset shape, e.g. 48x48x600 [default: 48x48x600]\n");
+          fprintf(stderr, "     -S S    Sample process and node memory every S seconds into\n");
+          fprintf(stderr, "             rank<R>memory.csv and report the high-water marks\n");
           fprintf(stderr, "     -t T    Number of iterations [default: 5]\n");
+          fprintf(stderr, "     -T T    Datatype: char, short, int, long, float or double [default: float]\n");
+          fprintf(stderr, "     -w W    Generate -c content in W worker threads while HDF5 writes\n");
+          fprintf(stderr, "     -W L    Sweep the write tracking page size over the comma-separated\n");
+          fprintf(stderr, "             list L (0 disables tracking), running -t iterations each\n");
           fprintf(stderr, "\n");
           fflush(stderr);
         }
@@ -151,24 +662,128 @@ main (int argc, char **argv)
       exit(3);
     }
 
+  if (nworkers > 0 && content.field == FIELD_GARBAGE)
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "The -w option needs content to generate: use -c.\n");
+          fflush(stderr);
+        }
+      exit(3);
+    }
+  if (nworkers > 0 && nslots == 0)
+    nslots = 2 * nworkers;
+
+  if (ndrivers > 0 && (inflight || nodeflg || npages || readflg))
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "The -d option cannot be combined with -N, -P, -R or -W.\n");
+          fflush(stderr);
+        }
+      exit(3);
+    }
+
+  if (npages > 0)
+    {
+      if (inflight || nodeflg || pagflg || nopagflg)
+        {
+          if (rank == 0)
+            {
+              fprintf(stderr, "The -W option cannot be combined with -n, -N, -p or -P.\n");
+              fflush(stderr);
+            }
+          exit(3);
+        }
+      /* the sweep flushes through the driver's own writes */
+      backflg = 1;
+    }
+
+  if (inflight && nodeflg)
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "The -N and -P options are mutually exclusive.\n");
+          fflush(stderr);
+        }
+      exit(3);
+    }
+
+  if ((inflight || nodeflg) && (backflg || pagflg || nopagflg))
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "The -%c option writes the files itself; -b, -n and -p have no effect.\n",
+                  inflight ? 'P' : 'N');
+          fflush(stderr);
+        }
+      backflg = pagflg = 0;
+      nopagflg = 1;
+    }
+
+  /* after the reset above: -N aggregates per node and writes no per-rank files */
+  if (readflg && !backflg && !inflight)
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "The -R option needs the files on disk: use -b or -P, not -N.\n");
+          fflush(stderr);
+        }
+      exit(3);
+    }
+
   /* Let's go! */
 
   fapl = H5Pcreate (H5P_FILE_ACCESS);
   assert (fapl >= 0);
   assert (H5Pset_libver_bounds (fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST) >= 0);
   assert (H5Pset_fapl_core (fapl, incr, (hbool_t) backflg) >= 0);
-  if (nopagflg == 0)  /* the user didn't disable paging */
+  if (nopagflg == 0 && inflight == 0 && nodeflg == 0 && npages == 0)  /* the user didn't disable paging */
     {
       assert (H5Pset_core_write_tracking (fapl, 1, page) >= 0);
     }
+  /* the callbacks are always installed so that the default allocator
+     is counted the same way as mmap; -P and -N also keep the buffer at
+     close instead of copying it out */
+  alloc.keep = (inflight > 0 || nodeflg);
+  alloc.buf = NULL;
+  alloc.len = alloc.size = 0;
+  alloc.nrealloc = alloc.nmoved = 0;
+  callbacks.image_malloc = image_malloc;
+  callbacks.image_memcpy = image_memcpy;
+  callbacks.image_realloc = image_realloc;
+  callbacks.image_free = image_free;
+  callbacks.udata_copy = udata_copy;
+  callbacks.udata_free = udata_free;
+  callbacks.udata = &alloc;
+  assert (H5Pset_file_image_callbacks (fapl, &callbacks) >= 0);
 
   if (rank == 0)
     {
       printf("\n");
-      printf("Write to disk: %s\n", (backflg > 0) ? "YES" : "NO");
+      if (inflight > 0)
+        printf("Write to disk: PIPELINED, up to %u images in flight\n", inflight);
+      else if (nodeflg)
+        printf("Write to disk: ONE FILE PER NODE\n");
+      else if (ndrivers > 0)
+        printf("Write to disk: DEPENDS ON THE DRIVER\n");
+      else
+        printf("Write to disk: %s\n", (backflg > 0) ? "YES" : "NO");
       printf("Increment size: %ld [bytes]\n", incr);
+      if (alloc.mapped)
+        printf("Memory buffer: mmap, %ld [bytes] reserved per file%s\n",
+               alloc.reserve, alloc.hugepages ? ", huge pages" : "");
+      else
+        printf("Memory buffer: malloc/realloc\n");
 
-      if (nopagflg == 0)
+      if (npages > 0)
+        {
+          printf("Page size: SWEEP over");
+          for (ipage = 0; ipage < npages; ipage++)
+            printf(" %lu", (unsigned long) pages[ipage]);
+          printf(" [bytes]\n");
+        }
+      else if (nopagflg == 0)
         {
           printf("Page size: %ld [bytes]\n", page);
         }
@@ -177,18 +792,96 @@ main (int argc, char **argv)
           printf("Page size: PAGING DISABLED!\n");
         }
 
+      if (ndrivers > 0)
+        {
+          printf("Drivers:");
+          for (idriver = 0; idriver < ndrivers; idriver++)
+            printf(" %s", drvnames[drivers[idriver]]);
+          printf("\n");
+        }
+
       printf("Iterations: %d\n", maxiter);
+      printf("Dataset shape: %s %s\n", shape, tname);
+      printf("Hierarchy: %u levels x %u groups x %u datasets\n",
+             levels, groups, dsets);
+      if (content.field != FIELD_GARBAGE)
+        {
+          printf("Content: %s", (content.field == FIELD_ZERO) ? "zero" :
+                 (content.field == FIELD_RAMP) ? "ramp" :
+                 (content.field == FIELD_SINE) ? "sine" : "random");
+          if (nworkers > 0)
+            printf(", generated by %u workers into %u buffers", nworkers, nslots);
+          printf("\n");
+        }
+      if (interval > 0.0)
+        printf("Memory sampling: every %g seconds\n", interval);
+      if (batchflg)
+        printf("Dataset creation: BATCHED, %s layout, early allocation, no fill\n",
+               (layout == H5D_COMPACT) ? "compact" : "contiguous");
       printf("\n");
       fflush(stdout);
     }
 
-  buf = (float *) malloc (X * Y * Z * sizeof (float));
+  for (nelem = 1, i = 0; i < ndims; i++)
+    nelem *= (size_t) dims[i];
+  nbytes = (double) nelem * H5Tget_size (type) * dsets * groups * levels;
+  buf = malloc (nelem * H5Tget_size (type));
+  assert (buf != NULL);
+  content.isfloat = (H5Tget_class (type) == H5T_FLOAT);
+  content.tsize = H5Tget_size (type);
+  content.nelem = nelem;
+
+  if (batchflg && layout == H5D_COMPACT
+      && nelem * H5Tget_size (type) > COMPACT_MAX)
+    {
+      if (rank == 0)
+        {
+          fprintf(stderr, "A %s %s dataset is too large for the compact layout.\n",
+                  shape, tname);
+          fflush(stderr);
+        }
+      exit(3);
+    }
+
+  /* The batched path sets up everything that does not depend on the
+     dataset once: the dataspace, the creation property lists, and the
+     expected link counts of the two group levels. */
+  space = dcpl = gcpl1 = gcpl2 = H5P_DEFAULT;
+  if (batchflg)
+    {
+      space = H5Screate_simple (ndims, dims, NULL);
+      assert (space >= 0);
+      dcpl = H5Pcreate (H5P_DATASET_CREATE);
+      assert (dcpl >= 0);
+      assert (H5Pset_layout (dcpl, layout) >= 0);
+      assert (H5Pset_alloc_time (dcpl, H5D_ALLOC_TIME_EARLY) >= 0);
+      assert (H5Pset_fill_time (dcpl, H5D_FILL_TIME_NEVER) >= 0);
+      gcpl1 = H5Pcreate (H5P_GROUP_CREATE);
+      assert (gcpl1 >= 0);
+      setlinks (gcpl1, groups);
+      gcpl2 = H5Pcreate (H5P_GROUP_CREATE);
+      assert (gcpl2 >= 0);
+      setlinks (gcpl2, dsets);
+    }
+
+  fp_out = NULL;
+  recs = NULL;
+  if (outname != NULL && rank == 0)
+    {
+      assert ((fp_out = fopen (outname, "w")) != (FILE *) NULL);
+      assert ((recs = (record_t *) malloc (nranks * sizeof (record_t))) != NULL);
+      if (fmt == FMT_CSV)
+        assert (fprintf (fp_out, "rank,iteration,shape,type,levels,groups,datasets,bytes,"
+                         "buffering_s,flush_s,reallocs,moved,minflt,majflt,"
+                         "buffering_dmemfree_kb,buffering_dcached_kb,buffering_dactive_kb,buffering_dinactive_kb,"
+                         "flush_dmemfree_kb,flush_dcached_kb,flush_dactive_kb,flush_dinactive_kb,"
+                         "create_mean_s,create_max_s,write_mean_s,write_max_s,reopen_s\n") > 0);
+    }
 
   // Get basic memory info on each node, see how memory usage changes
   // after flushing to disk; do we end up back where we started?
 
-  getmemory (&memtotal, &memfree, &buffers, &cached, &swapcached, &active,
-             &inactive);
+  getmemory (&mem);
 
   if (rank == 0)
     {
@@ -199,12 +892,108 @@ main (int argc, char **argv)
     {
       if (rank == i)
         {
-          printmemory (rank, memtotal, memfree, buffers, cached, swapcached,
-                       active, inactive);
+          printmemory (rank, &mem);
         }
       MPI_Barrier (MPI_COMM_WORLD);
     }
 
+  /* a sweep runs the -t iterations once per page size */
+  sweepiter = maxiter;
+  if (npages > 0)
+    {
+      maxiter *= npages;
+      for (ipage = 0; ipage < npages; ipage++)
+        {
+          sweepflush[ipage] = 0.0;
+          sweepbytes[ipage] = sweepcalls[ipage] = sweepdisk[ipage] = 0;
+        }
+    }
+
+  /* and so does a driver comparison, once per driver */
+  if (ndrivers > 0)
+    {
+      maxiter *= ndrivers;
+      for (idriver = 0; idriver < ndrivers; idriver++)
+        {
+          fapls[idriver] = makefapl (drivers[idriver], fapl, incr);
+          drvbuffer[idriver] = drvflush[idriver] = 0.0;
+        }
+    }
+
+  /* The workers make no HDF5 or MPI calls; they only generate the
+     content of the datasets still to come, in any order. */
+  if (nworkers > 0)
+    {
+      ring.content = &content;
+      ring.nslots = nslots;
+      ring.next = ring.written = 0;
+      ring.total = (unsigned long) maxiter * levels * groups * dsets;
+      ring.busy = ring.pstall = ring.cstall = 0.0;
+      assert ((ring.slots = (void **) malloc (nslots * sizeof (void *))) != NULL);
+      assert ((ring.full = (int *) calloc (nslots, sizeof (int))) != NULL);
+      for (i = 0; i < (int) nslots; i++)
+        assert ((ring.slots[i] = malloc (nelem * content.tsize)) != NULL);
+      assert (pthread_mutex_init (&ring.lock, NULL) == 0);
+      assert (pthread_cond_init (&ring.filled, NULL) == 0);
+      assert (pthread_cond_init (&ring.emptied, NULL) == 0);
+      assert ((workers = (pthread_t *) malloc (nworkers * sizeof (pthread_t))) != NULL);
+      for (iworker = 0; iworker < nworkers; iworker++)
+        assert (pthread_create (&workers[iworker], NULL, produce, &ring) == 0);
+    }
+  seq = 0;
+  consume = 0.0;
+
+  /* one communicator per node; its rank 0 writes the node's file */
+  nodecomm = leadcomm = MPI_COMM_NULL;
+  nnodes = 0;
+  if (nodeflg)
+    {
+      assert (MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank,
+                                   MPI_INFO_NULL, &nodecomm) == MPI_SUCCESS);
+      assert (MPI_Comm_rank (nodecomm, &i) == MPI_SUCCESS);
+      assert (MPI_Comm_split (MPI_COMM_WORLD, (i == 0) ? 0 : MPI_UNDEFINED,
+                              rank, &leadcomm) == MPI_SUCCESS);
+      if (leadcomm != MPI_COMM_NULL)
+        {
+          assert (MPI_Comm_rank (leadcomm, &i) == MPI_SUCCESS);
+          assert (MPI_Comm_size (leadcomm, &nnodes) == MPI_SUCCESS);
+        }
+      assert (MPI_Bcast (&i, 1, MPI_INT, 0, nodecomm) == MPI_SUCCESS);
+      assert (MPI_Bcast (&nnodes, 1, MPI_INT, 0, nodecomm) == MPI_SUCCESS);
+      nodeid = i;
+    }
+
+  if (interval > 0.0)
+    {
+      sampler.done = 0;
+      sampler.interval = interval;
+      sampler.iter = -1;
+      sampler.phase = PHASE_IDLE;
+      sampler.alloc = &alloc;
+      sampler.nsamples = 0;
+      sampler.maxsamples = 1024;
+      assert ((sampler.samples = (sample_t *) malloc (sampler.maxsamples * sizeof (sample_t))) != NULL);
+      memset (&sampler.peak, 0, sizeof (sample_t));
+      assert (gettimeofday (&sampler.start, NULL) == 0);
+      assert (pthread_mutex_init (&sampler.lock, NULL) == 0);
+      assert (pthread_cond_init (&sampler.wake, NULL) == 0);
+      assert (pthread_create (&sampling, NULL, samplememory, &sampler) == 0);
+    }
+
+  /* The writer thread makes no HDF5 or MPI calls; it only writes out the
+     images the main thread has taken from the closed files. */
+  if (inflight > 0)
+    {
+      pipe.head = pipe.tail = NULL;
+      pipe.inflight = 0;
+      pipe.maxinflight = inflight;
+      pipe.done = 0;
+      pipe.busy = pipe.written = 0.0;
+      assert (pthread_mutex_init (&pipe.lock, NULL) == 0);
+      assert (pthread_cond_init (&pipe.changed, NULL) == 0);
+      assert (pthread_create (&writer, NULL, writeimages, &pipe) == 0);
+    }
+
   start = MPI_Wtime ();
 
   /* outer loop - simulated time */
@@ -216,33 +1005,92 @@ main (int argc, char **argv)
           assert (fflush (stdout) == 0);
         }
 
+      ipage = iter / sweepiter;
+      if (npages > 0)
+        {
+          if (rank == 0 && iter % sweepiter == 0)
+            {
+              printf ("Page size: %lu [bytes]%s\n", (unsigned long) pages[ipage],
+                      (pages[ipage] == 0) ? " (PAGING DISABLED)" : "");
+              assert (fflush (stdout) == 0);
+            }
+          assert (H5Pset_core_write_tracking (fapl, pages[ipage] > 0,
+                                              (pages[ipage] > 0) ? pages[ipage] : 1) >= 0);
+        }
+
+      idriver = iter / sweepiter;
+      if (ndrivers > 0 && rank == 0 && iter % sweepiter == 0)
+        {
+          printf ("Driver: %s\n", drvnames[drivers[idriver]]);
+          assert (fflush (stdout) == 0);
+        }
+
+      sampler.iter = iter;
+      sampler.phase = PHASE_CREATE;
       assert (sprintf (name, "rank%05dtime%04u.h5", rank, iter) > 0);
-      file = H5Fcreate (name, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+      file = H5Fcreate (name, H5F_ACC_TRUNC, H5P_DEFAULT,
+                        (ndrivers > 0) ? fapls[idriver] : fapl);
       assert (file >= 0);
 
+      getmemory (&mem0);
+      sampler.phase = PHASE_BUFFER;
+      alloc.nrealloc = alloc.nmoved = 0;
+      rec.create_mean = rec.create_max = rec.write_mean = rec.write_max = 0.0;
+      rec.reopen = 0.0;
+      assert (getrusage (RUSAGE_THREAD, &ru1) == 0);
       t1 = MPI_Wtime ();
 
       /* time level */
-      for (level = 0; level < MAX_TIME_LEVEL; ++level)
+      for (level = 0; level < levels; ++level)
         {
           assert (sprintf (g1name, "level%03d", level) > 0);
-          group = H5Gcreate2 (file, g1name, H5P_DEFAULT, H5P_DEFAULT,
+          group = H5Gcreate2 (file, g1name, H5P_DEFAULT, gcpl1,
                               H5P_DEFAULT);
           assert (group >= 0);
 
           /* group level */
-          for (igroup = 0; igroup < MAX_GROUPS; ++igroup)
+          for (igroup = 0; igroup < groups; ++igroup)
             {
               assert (sprintf (g2name, "group%02d", igroup) > 0);
-              group1 = H5Gcreate2 (group, g2name, H5P_DEFAULT, H5P_DEFAULT,
+              group1 = H5Gcreate2 (group, g2name, H5P_DEFAULT, gcpl2,
                                    H5P_DEFAULT);
               assert (group1 >= 0);
 
               /* dataset level */
-              for (idset = 0; idset < MAX_DATASETS; ++idset)
+              for (idset = 0; idset < dsets; ++idset)
                 {
                   assert (sprintf (name, "dataset%02d", idset) > 0);
-                  assert (H5LTmake_dataset_float (group1, name, RANK, dims, buf) >= 0);
+                  dbuf = buf;
+                  if (nworkers > 0)
+                    dbuf = ringget (&ring, seq);
+                  else if (content.field != FIELD_GARBAGE)
+                    fillbuffer (buf, &content, seq);
+                  t3 = MPI_Wtime ();
+                  if (batchflg)
+                    {
+                      dset = H5Dcreate2 (group1, name, type, space, H5P_DEFAULT,
+                                         dcpl, H5P_DEFAULT);
+                      assert (dset >= 0);
+                      t4 = MPI_Wtime ();
+                      assert (H5Dwrite (dset, type, H5S_ALL, H5S_ALL,
+                                        H5P_DEFAULT, dbuf) >= 0);
+                      assert (H5Dclose (dset) >= 0);
+                      t5 = MPI_Wtime ();
+                      rec.create_mean += t4 - t3;
+                      rec.write_mean += t5 - t4;
+                      if (t4 - t3 > rec.create_max)
+                        rec.create_max = t4 - t3;
+                      if (t5 - t4 > rec.write_max)
+                        rec.write_max = t5 - t4;
+                    }
+                  else
+                    {
+                      assert (H5LTmake_dataset (group1, name, ndims, dims, type, dbuf) >= 0);
+                    }
+                  consume += MPI_Wtime () - t3;
+                  if (nworkers > 0)
+                    ringput (&ring, seq);
+                  seq++;
 
 #ifdef DEBUG
                   assert (fprintf (stderr,
@@ -259,16 +1107,42 @@ main (int argc, char **argv)
         }
 
       t2 = MPI_Wtime ();
+      assert (getrusage (RUSAGE_THREAD, &ru2) == 0);
+      minflt = ru2.ru_minflt - ru1.ru_minflt;
+      majflt = ru2.ru_majflt - ru1.ru_majflt;
+      rec.buffering = t2 - t1;
+      rec.nrealloc = alloc.nrealloc;
+      rec.nmoved = alloc.nmoved;
+      rec.minflt = minflt;
+      rec.majflt = majflt;
 
       assert (fprintf (stdout,
                        "rank %04i Total time for buffering chunks to memory:\t %f seconds\n",
                        rank, t2 - t1));
+      assert (fprintf (stdout,
+                       "rank %04i Buffer growth: %u reallocations, %u moved, %ld minor / %ld major page faults\n",
+                       rank, alloc.nrealloc, alloc.nmoved, minflt, majflt));
+      if (batchflg)
+        {
+          rec.create_mean /= (double) levels * groups * dsets;
+          rec.write_mean /= (double) levels * groups * dsets;
+          assert (fprintf (stdout,
+                           "rank %04i Dataset create latency:\t mean %10.2f max %10.2f microseconds\n",
+                           rank, 1.0e6 * rec.create_mean, 1.0e6 * rec.create_max));
+          assert (fprintf (stdout,
+                           "rank %04i Dataset write latency:\t mean %10.2f max %10.2f microseconds\n",
+                           rank, 1.0e6 * rec.write_mean, 1.0e6 * rec.write_max));
+        }
       assert (fflush (stdout) == 0);
 
       MPI_Barrier (MPI_COMM_WORLD);    // To keep output less jumbled
 
-      getmemory (&memtotal, &memfree, &buffers, &cached, &swapcached, &active,
-                 &inactive);
+      getmemory (&mem);
+      rec.dmemfree[0] = mem.memfree - mem0.memfree;
+      rec.dcached[0] = mem.cached - mem0.cached;
+      rec.dactive[0] = mem.active - mem0.active;
+      rec.dinactive[0] = mem.inactive - mem0.inactive;
+      mem0 = mem;
 
       if (rank == 0)
         {
@@ -280,19 +1154,97 @@ main (int argc, char **argv)
         {
           if (rank == i)
             {
-              printmemory (rank, memtotal, memfree, buffers, cached, swapcached,
-                           active, inactive);
+              printmemory (rank, &mem);
             }
           MPI_Barrier (MPI_COMM_WORLD);
         }
 
       /* close the file */
+      sampler.phase = PHASE_FLUSH;
       t1 = MPI_Wtime ();
-      assert (H5Fclose (file) >= 0);
+      if (inflight > 0)
+        {
+          /* once the metadata is flushed, the close only rewrites the
+             superblock, so the image size is an upper bound on the file */
+          assert (H5Fflush (file, H5F_SCOPE_LOCAL) >= 0);
+          imgsize = H5Fget_file_image (file, NULL, 0);
+          assert (imgsize > 0);
+          assert (H5Fclose (file) >= 0);
+          assert (alloc.buf != NULL);
+          /* the close may have shrunk a heap image below that bound */
+          if ((size_t) imgsize > alloc.len)
+            imgsize = (ssize_t) alloc.len;
+          img = (image_t *) malloc (sizeof (image_t));
+          assert (img != NULL);
+          img->buf = alloc.buf;
+          img->size = (size_t) imgsize;
+          img->maplen = alloc.mapped ? alloc.len : 0;
+          assert (sprintf (img->name, "rank%05dtime%04u.h5", rank, iter) > 0);
+          alloc.buf = NULL;
+          alloc.len = 0;
+          putimage (&pipe, img);
+        }
+      else if (nodeflg)
+        {
+          assert (H5Fflush (file, H5F_SCOPE_LOCAL) >= 0);
+          imgsize = H5Fget_file_image (file, NULL, 0);
+          assert (imgsize > 0);
+          assert (H5Fclose (file) >= 0);
+          assert (alloc.buf != NULL);
+          /* the close may have shrunk a heap image below that bound */
+          if ((size_t) imgsize > alloc.len)
+            imgsize = (ssize_t) alloc.len;
+          assert (sprintf (name, "node%05dtime%04u.h5core", nodeid, iter) > 0);
+          gatherimage (nodecomm, name, alloc.buf, (size_t) imgsize);
+          if (alloc.mapped)
+            assert (munmap (alloc.buf, alloc.len) == 0);
+          else
+            free (alloc.buf);
+          alloc.buf = NULL;
+          alloc.len = 0;
+        }
+      else
+        {
+          if (npages > 0)
+            getio (&wchar1, &syscw1);
+          assert (H5Fclose (file) >= 0);
+          if (npages > 0)
+            getio (&wchar2, &syscw2);
+        }
       t2 = MPI_Wtime ();
+      sampler.phase = PHASE_IDLE;
+
+      if (npages > 0)
+        {
+          assert (sprintf (name, "rank%05dtime%04u.h5", rank, iter) > 0);
+          assert (stat (name, &st) == 0);
+          sweepflush[ipage] += t2 - t1;
+          sweepbytes[ipage] += wchar2 - wchar1;
+          sweepcalls[ipage] += syscw2 - syscw1;
+          sweepdisk[ipage] += (long long) st.st_blocks * 512;
+        }
+
+      if (nodeflg)
+        {
+          /* everyone's image is in the node file once the leader is done */
+          MPI_Barrier (nodecomm);
+          t3 = MPI_Wtime ();
+          reopenimage (name, rank);
+          rec.reopen = MPI_Wtime () - t3;
+        }
+
+      if (ndrivers > 0)
+        {
+          drvbuffer[idriver] += rec.buffering;
+          drvflush[idriver] += t2 - t1;
+        }
 
-      getmemory (&memtotal, &memfree, &buffers, &cached, &swapcached, &active,
-                 &inactive);
+      getmemory (&mem);
+      rec.flush = t2 - t1;
+      rec.dmemfree[1] = mem.memfree - mem0.memfree;
+      rec.dcached[1] = mem.cached - mem0.cached;
+      rec.dactive[1] = mem.active - mem0.active;
+      rec.dinactive[1] = mem.inactive - mem0.inactive;
 
       if (rank == 0)
         {
@@ -304,29 +1256,262 @@ main (int argc, char **argv)
         {
           if (rank == i)
             {
-              printmemory (rank, memtotal, memfree, buffers, cached, swapcached,
-                           active, inactive);
-              assert (fprintf (stdout, "rank %04i Total time for flushing to disk:\t\t %10.2f seconds\n", rank, t2 - t1));
+              printmemory (rank, &mem);
+              if (inflight > 0)
+                assert (fprintf (stdout, "rank %04i Total time for handing off image:\t %10.2f seconds\n", rank, t2 - t1));
+              else if (nodeflg)
+                {
+                  assert (fprintf (stdout, "rank %04i Total time for gathering to node file:\t %10.2f seconds\n", rank, t2 - t1));
+                  assert (fprintf (stdout, "rank %04i Total time for reopening from node file:\t %10.2f seconds\n", rank, rec.reopen));
+                }
+              else
+                assert (fprintf (stdout, "rank %04i Total time for flushing to disk:\t\t %10.2f seconds\n", rank, t2 - t1));
               assert (fflush (stderr) == 0);
             }
           MPI_Barrier (MPI_COMM_WORLD);
         }
+
+      if (outname != NULL)
+        {
+          MPI_Gather (&rec, sizeof (record_t) / sizeof (double), MPI_DOUBLE,
+                      recs, sizeof (record_t) / sizeof (double), MPI_DOUBLE,
+                      0, MPI_COMM_WORLD);
+          if (rank == 0)
+            {
+              for (i = 0; i < nranks; i++)
+                putrecord (fp_out, fmt, i, iter, shape, tname, levels, groups,
+                           dsets, nbytes, &recs[i]);
+              assert (fflush (fp_out) == 0);
+            }
+        }
+    }
+
+  if (inflight > 0)
+    {
+      /* wait for the last images to reach the disk */
+      t1 = MPI_Wtime ();
+      assert (pthread_mutex_lock (&pipe.lock) == 0);
+      pipe.done = 1;
+      assert (pthread_cond_broadcast (&pipe.changed) == 0);
+      assert (pthread_mutex_unlock (&pipe.lock) == 0);
+      assert (pthread_join (writer, NULL) == 0);
+      t2 = MPI_Wtime ();
+
+      assert (fprintf (stdout, "rank %04i Total time for draining the pipeline:\t %10.2f seconds\n", rank, t2 - t1));
+      assert (fprintf (stdout, "rank %04i Background write time:\t\t %10.2f seconds, %f GB/s\n",
+                       rank, pipe.busy,
+                       (pipe.busy > 0.0) ? pipe.written / (1024.0 * 1024.0 * 1024.0 * pipe.busy) : 0.0));
+      assert (fflush (stdout) == 0);
+
+      pthread_cond_destroy (&pipe.changed);
+      pthread_mutex_destroy (&pipe.lock);
     }
 
   stop = MPI_Wtime ();
+
+  if (interval > 0.0)
+    {
+      assert (pthread_mutex_lock (&sampler.lock) == 0);
+      sampler.done = 1;
+      assert (pthread_cond_signal (&sampler.wake) == 0);
+      assert (pthread_mutex_unlock (&sampler.lock) == 0);
+      assert (pthread_join (sampling, NULL) == 0);
+
+      assert (sprintf (name, "rank%05dmemory.csv", rank) > 0);
+      assert ((fp_mem = fopen (name, "w")) != (FILE *) NULL);
+      assert (fprintf (fp_mem, "time_s,iteration,phase,rss_kb,pss_kb,dirty_kb,writeback_kb,image_kb\n") > 0);
+      for (j = 0; j < sampler.nsamples; j++)
+        assert (fprintf (fp_mem, "%f,%d,%s,%ld,%ld,%ld,%ld,%ld\n",
+                         sampler.samples[j].time, sampler.samples[j].iter,
+                         (sampler.samples[j].phase == PHASE_BUFFER) ? "buffer" :
+                         (sampler.samples[j].phase == PHASE_FLUSH) ? "flush" :
+                         (sampler.samples[j].phase == PHASE_CREATE) ? "create" : "idle",
+                         sampler.samples[j].rss, sampler.samples[j].pss,
+                         sampler.samples[j].dirty, sampler.samples[j].writeback,
+                         sampler.samples[j].image) > 0);
+      assert (fclose (fp_mem) == 0);
+
+      assert (fprintf (stdout, "rank %04i Memory high-water (%lu samples): RSS %.2f GB, PSS %.2f GB, Dirty %.2f GB, Writeback %.2f GB, image %.2f GB\n",
+                       rank, (unsigned long) sampler.nsamples,
+                       sampler.peak.rss / 1048576.0, sampler.peak.pss / 1048576.0,
+                       sampler.peak.dirty / 1048576.0, sampler.peak.writeback / 1048576.0,
+                       sampler.peak.image / 1048576.0) > 0);
+      assert (fflush (stdout) == 0);
+
+      pthread_cond_destroy (&sampler.wake);
+      pthread_mutex_destroy (&sampler.lock);
+      free ((void *) sampler.samples);
+    }
+
   MPI_Barrier (MPI_COMM_WORLD);
 
   if (rank == 0)
     {
       printf ("Total time: %f s\n", stop - start);
       printf ("Aggregate bandwidth per process: %f GB/s\n",
-              ((float) X * Y * Z * sizeof (float)) *
-              ((float) MAX_DATASETS * MAX_GROUPS * MAX_TIME_LEVEL * MAX_ITER) /
-              (1024.0 * 1024.0 * 1024.0 * (stop - start)));
+              nbytes * maxiter / (1024.0 * 1024.0 * 1024.0 * (stop - start)));
+      if (nodeflg)
+        printf ("Files written: %u (one per node) instead of %u (one per rank)\n",
+                nnodes * maxiter, nranks * maxiter);
+    }
+
+  if (npages > 0)
+    {
+      if (rank == 0)
+        {
+          fprintf (stdout, "PAGE SIZE SWEEP (per file, mean of %u):\n", sweepiter);
+          fflush (stdout);
+        }
+      for (i = 0; i < nranks; i++)
+        {
+          if (rank == i)
+            {
+              for (ipage = 0; ipage < npages; ipage++)
+                assert (fprintf (stdout, "rank %04i page %12lu: flush %10.2f s, written %14.0f bytes in %10.0f calls, on disk %14.0f bytes\n",
+                                 rank, (unsigned long) pages[ipage],
+                                 sweepflush[ipage] / sweepiter,
+                                 (double) sweepbytes[ipage] / sweepiter,
+                                 (double) sweepcalls[ipage] / sweepiter,
+                                 (double) sweepdisk[ipage] / sweepiter) > 0);
+              assert (fflush (stdout) == 0);
+            }
+          MPI_Barrier (MPI_COMM_WORLD);
+        }
+    }
+
+  if (content.field != FIELD_GARBAGE)
+    {
+      if (nworkers > 0)
+        {
+          for (iworker = 0; iworker < nworkers; iworker++)
+            assert (pthread_join (workers[iworker], NULL) == 0);
+          free (workers);
+          for (i = 0; i < (int) nslots; i++)
+            free (ring.slots[i]);
+          free (ring.slots);
+          free (ring.full);
+          pthread_cond_destroy (&ring.emptied);
+          pthread_cond_destroy (&ring.filled);
+          pthread_mutex_destroy (&ring.lock);
+        }
+
+      if (rank == 0)
+        {
+          fprintf (stdout, "DATA GENERATION:\n");
+          fflush (stdout);
+        }
+      for (i = 0; i < nranks; i++)
+        {
+          if (rank == i)
+            {
+              if (nworkers > 0)
+                {
+                  assert (fprintf (stdout, "rank %04i Producers:\t %f GB/s (%f GB/s per worker), stalled %10.2f s waiting for buffers\n",
+                                   rank,
+                                   nbytes * maxiter * nworkers / (1024.0 * 1024.0 * 1024.0 * ring.busy),
+                                   nbytes * maxiter / (1024.0 * 1024.0 * 1024.0 * ring.busy),
+                                   ring.pstall) > 0);
+                  assert (fprintf (stdout, "rank %04i Consumer:\t %f GB/s in HDF5, stalled %10.2f s waiting for data\n",
+                                   rank, nbytes * maxiter / (1024.0 * 1024.0 * 1024.0 * consume),
+                                   ring.cstall) > 0);
+                }
+              else
+                assert (fprintf (stdout, "rank %04i Consumer:\t %f GB/s in HDF5, generating inline\n",
+                                 rank, nbytes * maxiter / (1024.0 * 1024.0 * 1024.0 * consume)) > 0);
+              assert (fflush (stdout) == 0);
+            }
+          MPI_Barrier (MPI_COMM_WORLD);
+        }
+    }
+
+  if (ndrivers > 0)
+    {
+      if (rank == 0)
+        {
+          fprintf (stdout, "DRIVER COMPARISON (per file, mean of %u):\n", sweepiter);
+          fflush (stdout);
+        }
+      for (i = 0; i < nranks; i++)
+        {
+          if (rank == i)
+            {
+              for (idriver = 0; idriver < ndrivers; idriver++)
+                assert (fprintf (stdout, "rank %04i %-12s: buffering %10.2f s, flush %10.2f s, total %10.2f s\n",
+                                 rank, drvnames[drivers[idriver]],
+                                 drvbuffer[idriver] / sweepiter,
+                                 drvflush[idriver] / sweepiter,
+                                 (drvbuffer[idriver] + drvflush[idriver]) / sweepiter) > 0);
+              assert (fflush (stdout) == 0);
+            }
+          MPI_Barrier (MPI_COMM_WORLD);
+        }
+      for (idriver = 0; idriver < ndrivers; idriver++)
+        assert (H5Pclose (fapls[idriver]) >= 0);
+    }
+
+  /* read-back phase: every file, each of the three ways */
+  if (readflg)
+    {
+      assert ((rbuf = malloc (nelem * H5Tget_size (type))) != NULL);
+      for (method = 0; method < READ_METHODS; method++)
+        {
+          opentime[method] = walktime[method] = 0.0;
+          MPI_Barrier (MPI_COMM_WORLD);
+          for (iter = 0; iter < maxiter; ++iter)
+            {
+              assert (sprintf (name, "rank%05dtime%04u.h5", rank, iter) > 0);
+              walktime[method] += readback (name, method, levels, groups, dsets,
+                                            type, rbuf, buf, &content,
+                                            (unsigned long) iter * levels * groups * dsets,
+                                            &t1);
+              opentime[method] += t1;
+            }
+        }
+      free (rbuf);
+
+      if (rank == 0)
+        {
+          fprintf (stdout, "READING BACK (%u files per rank, data verified):\n", maxiter);
+          fflush (stdout);
+        }
+      for (i = 0; i < nranks; i++)
+        {
+          if (rank == i)
+            {
+              for (method = 0; method < READ_METHODS; method++)
+                assert (fprintf (stdout, "rank %04i Read back (%s):\t open %10.2f s, traversal %10.2f s, %f GB/s\n",
+                                 rank, methods[method], opentime[method], walktime[method],
+                                 nbytes * maxiter / (1024.0 * 1024.0 * 1024.0
+                                                     * (opentime[method] + walktime[method]))) > 0);
+              assert (fflush (stdout) == 0);
+            }
+          MPI_Barrier (MPI_COMM_WORLD);
+        }
+    }
+
+  if (nodeflg)
+    {
+      if (leadcomm != MPI_COMM_NULL)
+        MPI_Comm_free (&leadcomm);
+      MPI_Comm_free (&nodecomm);
+    }
+
+  if (fp_out != NULL)
+    {
+      assert (fclose (fp_out) == 0);
+      free ((void *) recs);
     }
 
   free ((void *) buf);
 
+  if (batchflg)
+    {
+      assert (H5Sclose (space) >= 0);
+      assert (H5Pclose (dcpl) >= 0);
+      assert (H5Pclose (gcpl1) >= 0);
+      assert (H5Pclose (gcpl2) >= 0);
+    }
+
   assert (H5Pclose (fapl) >= 0);
 
   assert (MPI_Finalize () >= 0);
@@ -335,39 +1520,884 @@ main (int argc, char **argv)
 
 }
 
+/* Read the fields we report from /proc/meminfo by name; the line
+   order differs between kernels.  Missing fields read as 0. */
 void
-getmemory (int *memtotal, int *memfree, int *buffers, int *cached,
-           int *swapcached, int *active, int *inactive)
+getmemory (meminfo_t *mem)
 {
+  static const struct
+  {
+    const char *key;
+    size_t offset;
+  } fields[] = {
+    { "MemTotal", offsetof (meminfo_t, memtotal) },
+    { "MemFree", offsetof (meminfo_t, memfree) },
+    { "MemAvailable", offsetof (meminfo_t, memavailable) },
+    { "Buffers", offsetof (meminfo_t, buffers) },
+    { "Cached", offsetof (meminfo_t, cached) },
+    { "SwapCached", offsetof (meminfo_t, swapcached) },
+    { "Active", offsetof (meminfo_t, active) },
+    { "Inactive", offsetof (meminfo_t, inactive) },
+    { "Dirty", offsetof (meminfo_t, dirty) },
+    { "Writeback", offsetof (meminfo_t, writeback) },
+  };
   FILE *fp_meminfo;
-  char cdum[MAX_LEN];
+  char line[MAX_LEN], key[MAX_LEN];
+  long value;
+  size_t k;
+
+  memset (mem, 0, sizeof (meminfo_t));
   assert ((fp_meminfo = fopen ("/proc/meminfo", "r")) != (FILE *) NULL);
-  fscanf (fp_meminfo, "%s %i %s", cdum, memtotal, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, memfree, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, buffers, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, cached, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, swapcached, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, active, cdum);
-  fscanf (fp_meminfo, "%s %i %s", cdum, inactive, cdum);
+  while (fgets (line, sizeof (line), fp_meminfo) != NULL)
+    {
+      if (sscanf (line, "%254[^:]: %ld", key, &value) != 2)
+        continue;
+      for (k = 0; k < sizeof (fields) / sizeof (fields[0]); k++)
+        if (strcmp (key, fields[k].key) == 0)
+          *(long *) ((char *) mem + fields[k].offset) = value;
+    }
   fclose (fp_meminfo);
 
 }
 
 
+/* This process's resident and proportional set size in kB. */
+void
+getprocess (long *rss, long *pss)
+{
+  FILE *fp;
+  char line[MAX_LEN];
+
+  *rss = 0;
+  *pss = -1;
+  if ((fp = fopen ("/proc/self/status", "r")) != (FILE *) NULL)
+    {
+      while (fgets (line, sizeof (line), fp) != NULL)
+        if (sscanf (line, "VmRSS: %ld", rss) == 1)
+          break;
+      fclose (fp);
+    }
+  if ((fp = fopen ("/proc/self/smaps_rollup", "r")) != (FILE *) NULL)
+    {
+      while (fgets (line, sizeof (line), fp) != NULL)
+        if (sscanf (line, "Pss: %ld", pss) == 1)
+          break;
+      fclose (fp);
+    }
+}
+
+
+/* Bytes handed to write(2) and the number of write calls so far by
+   this process, from /proc/self/io. */
+void
+getio (long long *wchar, long long *syscw)
+{
+  FILE *fp;
+  char line[MAX_LEN];
+
+  *wchar = *syscw = 0;
+  assert ((fp = fopen ("/proc/self/io", "r")) != (FILE *) NULL);
+  while (fgets (line, sizeof (line), fp) != NULL)
+    {
+      sscanf (line, "wchar: %lld", wchar);
+      sscanf (line, "syscw: %lld", syscw);
+    }
+  fclose (fp);
+}
+
+
+/* Parse a -W list such as 4096,65536,1048576; -1 if an entry is not a
+   number or there are more than MAX_PAGES. */
+int
+getpages (char *list, size_t *pages, unsigned *npages)
+{
+  char *tok, *end;
+  long long size;
+
+  *npages = 0;
+  for (tok = strtok (list, ","); tok != NULL; tok = strtok (NULL, ","))
+    {
+      size = strtoll (tok, &end, 10);
+      if (*end != '\0' || size < 0 || *npages == MAX_PAGES)
+        return -1;
+      pages[(*npages)++] = (size_t) size;
+    }
+  return (*npages > 0) ? 0 : -1;
+}
+
+
+/* Parse a -d list such as sec2,core,split; -1 on an unknown name, or
+   on mpio without parallel HDF5. */
+int
+getdrivers (char *list, int *drivers, unsigned *ndrivers)
+{
+  char *tok;
+
+  *ndrivers = 0;
+  for (tok = strtok (list, ","); tok != NULL; tok = strtok (NULL, ","))
+    {
+      if (*ndrivers == MAX_DRIVERS)
+        return -1;
+      if (strcmp (tok, "core") == 0)
+        drivers[*ndrivers] = DRV_CORE;
+      else if (strcmp (tok, "core-backed") == 0)
+        drivers[*ndrivers] = DRV_CORE_BACKED;
+      else if (strcmp (tok, "sec2") == 0)
+        drivers[*ndrivers] = DRV_SEC2;
+      else if (strcmp (tok, "stdio") == 0)
+        drivers[*ndrivers] = DRV_STDIO;
+      else if (strcmp (tok, "split") == 0)
+        drivers[*ndrivers] = DRV_SPLIT;
+#ifdef H5_HAVE_PARALLEL
+      else if (strcmp (tok, "mpio") == 0)
+        drivers[*ndrivers] = DRV_MPIO;
+#endif
+      else
+        return -1;
+      (*ndrivers)++;
+    }
+  return (*ndrivers > 0) ? 0 : -1;
+}
+
+
+/* File access property list for DRIVER.  The core variants start from
+   COREFAPL, so they keep the allocator, -i and write tracking settings. */
+hid_t
+makefapl (int driver, hid_t corefapl, size_t incr)
+{
+  hid_t fapl;
+
+  if (driver == DRV_CORE || driver == DRV_CORE_BACKED)
+    {
+      fapl = H5Pcopy (corefapl);
+      assert (fapl >= 0);
+      assert (H5Pset_fapl_core (fapl, incr, (hbool_t) (driver == DRV_CORE_BACKED)) >= 0);
+      return fapl;
+    }
+
+  fapl = H5Pcreate (H5P_FILE_ACCESS);
+  assert (fapl >= 0);
+  assert (H5Pset_libver_bounds (fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST) >= 0);
+  switch (driver)
+    {
+    case DRV_SEC2:
+      assert (H5Pset_fapl_sec2 (fapl) >= 0);
+      break;
+    case DRV_STDIO:
+      assert (H5Pset_fapl_stdio (fapl) >= 0);
+      break;
+    case DRV_SPLIT:
+      assert (H5Pset_fapl_split (fapl, "-m.h5", H5P_DEFAULT, "-r.h5", H5P_DEFAULT) >= 0);
+      break;
+#ifdef H5_HAVE_PARALLEL
+    case DRV_MPIO:
+      assert (H5Pset_fapl_mpio (fapl, MPI_COMM_SELF, MPI_INFO_NULL) >= 0);
+      break;
+#endif
+    default:
+      assert (0);
+    }
+  return fapl;
+}
+
+
 void
-printmemory (int rank, int memtotal, int memfree, int buffers, int cached,
-             int swapcached, int active, int inactive)
+printmemory (int rank, const meminfo_t *mem)
 {
 
   float fdum;
   float kibble = 1.024;    // 1024/1000, KiB/KB conversion
-  fdum = 1.0e-6 * (float) memtotal / kibble;   fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Memtotal", fdum);
-  fdum = 1.0e-6 * (float) memfree / kibble;    fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "MemFree", fdum);
-  fdum = 1.0e-6 * (float) buffers / kibble;    fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Buffers", fdum);
-  fdum = 1.0e-6 * (float) cached / kibble;     fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Cached", fdum);
-  fdum = 1.0e-6 * (float) swapcached / kibble; fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "SwapCached", fdum);
-  fdum = 1.0e-6 * (float) active / kibble;     fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Active", fdum);
-  fdum = 1.0e-6 * (float) inactive / kibble;   fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Inactive", fdum);
+  fdum = 1.0e-6 * (float) mem->memtotal / kibble;     fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Memtotal", fdum);
+  fdum = 1.0e-6 * (float) mem->memfree / kibble;      fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "MemFree", fdum);
+  fdum = 1.0e-6 * (float) mem->memavailable / kibble; fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "MemAvailable", fdum);
+  fdum = 1.0e-6 * (float) mem->buffers / kibble;      fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Buffers", fdum);
+  fdum = 1.0e-6 * (float) mem->cached / kibble;       fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Cached", fdum);
+  fdum = 1.0e-6 * (float) mem->swapcached / kibble;   fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "SwapCached", fdum);
+  fdum = 1.0e-6 * (float) mem->active / kibble;       fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Active", fdum);
+  fdum = 1.0e-6 * (float) mem->inactive / kibble;     fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Inactive", fdum);
+  fdum = 1.0e-6 * (float) mem->dirty / kibble;        fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Dirty", fdum);
+  fdum = 1.0e-6 * (float) mem->writeback / kibble;    fprintf (stdout, "rank %04i %12s: %10.2f GB\n", rank, "Writeback", fdum);
   assert (fflush (stderr) == 0);
 
 }
+
+
+/* Sampler thread: every interval, record process RSS/PSS, node
+   Dirty/Writeback and the core image size until told to stop. */
+void *
+samplememory (void *arg)
+{
+  sampler_t *sampler = (sampler_t *) arg;
+  meminfo_t mem;
+  sample_t *sample;
+  struct timeval now;
+  struct timespec deadline;
+  double next;
+
+  next = 0.0;
+  assert (pthread_mutex_lock (&sampler->lock) == 0);
+  while (!sampler->done)
+    {
+      assert (pthread_mutex_unlock (&sampler->lock) == 0);
+
+      if (sampler->nsamples == sampler->maxsamples)
+        {
+          sampler->maxsamples *= 2;
+          sampler->samples = (sample_t *) realloc (sampler->samples,
+                                                   sampler->maxsamples * sizeof (sample_t));
+          assert (sampler->samples != NULL);
+        }
+      sample = &sampler->samples[sampler->nsamples++];
+
+      assert (gettimeofday (&now, NULL) == 0);
+      sample->time = (double) (now.tv_sec - sampler->start.tv_sec)
+        + 1.0e-6 * (double) (now.tv_usec - sampler->start.tv_usec);
+      sample->iter = sampler->iter;
+      sample->phase = sampler->phase;
+      getprocess (&sample->rss, &sample->pss);
+      getmemory (&mem);
+      sample->dirty = mem.dirty;
+      sample->writeback = mem.writeback;
+      /* read without the driver's knowledge; an aligned size_t is not torn */
+      sample->image = (long) (sampler->alloc->size / 1024);
+
+      if (sample->rss > sampler->peak.rss)
+        sampler->peak.rss = sample->rss;
+      if (sample->pss > sampler->peak.pss)
+        sampler->peak.pss = sample->pss;
+      if (sample->dirty > sampler->peak.dirty)
+        sampler->peak.dirty = sample->dirty;
+      if (sample->writeback > sampler->peak.writeback)
+        sampler->peak.writeback = sample->writeback;
+      if (sample->image > sampler->peak.image)
+        sampler->peak.image = sample->image;
+
+      /* sleep until the next tick or until woken to stop */
+      next += sampler->interval;
+      deadline.tv_sec = sampler->start.tv_sec + (time_t) next;
+      deadline.tv_nsec = 1000L * sampler->start.tv_usec
+        + (long) (1.0e9 * (next - (double) (time_t) next));
+      if (deadline.tv_nsec >= 1000000000L)
+        {
+          deadline.tv_sec++;
+          deadline.tv_nsec -= 1000000000L;
+        }
+      assert (pthread_mutex_lock (&sampler->lock) == 0);
+      while (!sampler->done
+             && pthread_cond_timedwait (&sampler->wake, &sampler->lock, &deadline) == 0)
+        ;
+    }
+  assert (pthread_mutex_unlock (&sampler->lock) == 0);
+
+  return NULL;
+}
+
+
+/* Map a -T name to the native HDF5 type; -1 if unknown. */
+int
+gettype (const char *tname, hid_t *type)
+{
+  if (strcmp (tname, "char") == 0)
+    *type = H5T_NATIVE_CHAR;
+  else if (strcmp (tname, "short") == 0)
+    *type = H5T_NATIVE_SHORT;
+  else if (strcmp (tname, "int") == 0)
+    *type = H5T_NATIVE_INT;
+  else if (strcmp (tname, "long") == 0)
+    *type = H5T_NATIVE_LONG;
+  else if (strcmp (tname, "float") == 0)
+    *type = H5T_NATIVE_FLOAT;
+  else if (strcmp (tname, "double") == 0)
+    *type = H5T_NATIVE_DOUBLE;
+  else
+    return -1;
+  return 0;
+}
+
+
+/* Size a group's link storage for CHILDREN links: keep them in the
+   object header (compact) and reserve room for their names up front. */
+void
+setlinks (hid_t gcpl, unsigned children)
+{
+  unsigned max_compact = (children > 8) ? children : 8;
+
+  if (max_compact > 65535)
+    max_compact = 65535;
+  assert (H5Pset_link_phase_change (gcpl, max_compact, max_compact - 2) >= 0);
+  assert (H5Pset_est_link_info (gcpl, (children > 65535) ? 65535 : children,
+                                sizeof ("dataset00") - 1) >= 0);
+}
+
+
+/* Parse a -s shape such as 48x48x600 into NDIMS and DIMS; -1 if any
+   extent is not a positive integer or there are too many. */
+int
+getshape (char *spec, int *ndims, hsize_t *dims)
+{
+  char *tok, *end;
+  long long extent;
+  int n = 0;
+
+  for (tok = strtok (spec, "x"); tok != NULL; tok = strtok (NULL, "x"))
+    {
+      extent = strtoll (tok, &end, 10);
+      if (*end != '\0' || extent <= 0 || n == H5S_MAX_RANK)
+        return -1;
+      dims[n++] = (hsize_t) extent;
+    }
+  if (n == 0)
+    return -1;
+  *ndims = n;
+  return 0;
+}
+
+
+/* Write one rank's record for one iteration as a CSV row or a line of
+   JSON. */
+void
+putrecord (FILE *fp, int fmt, int rank, unsigned iter, const char *shape,
+           const char *tname, unsigned levels, unsigned groups,
+           unsigned dsets, double bytes, const record_t *rec)
+{
+  if (fmt == FMT_CSV)
+    assert (fprintf (fp, "%d,%u,%s,%s,%u,%u,%u,%.0f,%f,%f,%.0f,%.0f,%.0f,%.0f,"
+                     "%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%g,%g,%g,%g,%f\n",
+                     rank, iter, shape, tname, levels, groups, dsets, bytes,
+                     rec->buffering, rec->flush, rec->nrealloc, rec->nmoved,
+                     rec->minflt, rec->majflt,
+                     rec->dmemfree[0], rec->dcached[0], rec->dactive[0], rec->dinactive[0],
+                     rec->dmemfree[1], rec->dcached[1], rec->dactive[1], rec->dinactive[1],
+                     rec->create_mean, rec->create_max, rec->write_mean, rec->write_max,
+                     rec->reopen) > 0);
+  else
+    assert (fprintf (fp, "{\"rank\": %d, \"iteration\": %u, \"shape\": \"%s\", \"type\": \"%s\", "
+                     "\"levels\": %u, \"groups\": %u, \"datasets\": %u, \"bytes\": %.0f, "
+                     "\"buffering_s\": %f, \"flush_s\": %f, \"reallocs\": %.0f, \"moved\": %.0f, "
+                     "\"minflt\": %.0f, \"majflt\": %.0f, "
+                     "\"buffering_kb\": {\"memfree\": %.0f, \"cached\": %.0f, \"active\": %.0f, \"inactive\": %.0f}, "
+                     "\"flush_kb\": {\"memfree\": %.0f, \"cached\": %.0f, \"active\": %.0f, \"inactive\": %.0f}, "
+                     "\"create_s\": {\"mean\": %g, \"max\": %g}, \"write_s\": {\"mean\": %g, \"max\": %g}, "
+                     "\"reopen_s\": %f}\n",
+                     rank, iter, shape, tname, levels, groups, dsets, bytes,
+                     rec->buffering, rec->flush, rec->nrealloc, rec->nmoved,
+                     rec->minflt, rec->majflt,
+                     rec->dmemfree[0], rec->dcached[0], rec->dactive[0], rec->dinactive[0],
+                     rec->dmemfree[1], rec->dcached[1], rec->dactive[1], rec->dinactive[1],
+                     rec->create_mean, rec->create_max, rec->write_mean, rec->write_max,
+                     rec->reopen) > 0);
+}
+
+
+/* File image callbacks: the heap or one mmap'd reserve per file.  At
+   close the buffer is handed to the imgalloc_t instead of being freed
+   when it is going to the writer thread. */
+void *
+image_malloc (size_t size, H5FD_file_image_op_t op, void *udata)
+{
+  imgalloc_t *alloc = (imgalloc_t *) udata;
+  void *ptr;
+
+  alloc->size = size;
+  if (!alloc->mapped)
+    {
+      alloc->buf = malloc (size);
+      alloc->len = size;
+      return alloc->buf;
+    }
+
+  alloc->len = (size > alloc->reserve) ? size : alloc->reserve;
+  ptr = mmap (NULL, alloc->len, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  assert (ptr != MAP_FAILED);
+  if (alloc->hugepages)
+    assert (madvise (ptr, alloc->len, MADV_HUGEPAGE) == 0);
+  alloc->buf = ptr;
+  return ptr;
+}
+
+
+void *
+image_memcpy (void *dest, const void *src, size_t size,
+              H5FD_file_image_op_t op, void *udata)
+{
+  return memcpy (dest, src, size);
+}
+
+
+void *
+image_realloc (void *ptr, size_t size, H5FD_file_image_op_t op, void *udata)
+{
+  imgalloc_t *alloc = (imgalloc_t *) udata;
+  void *newptr;
+  size_t newlen;
+
+  if (ptr == NULL)
+    return image_malloc (size, op, udata);
+
+  alloc->nrealloc++;
+  alloc->size = size;
+  if (!alloc->mapped)
+    {
+      newptr = realloc (ptr, size);
+      alloc->len = size;
+    }
+  else if (size <= alloc->len)
+    {
+      newptr = ptr;
+    }
+  else
+    {
+      /* past the reserve: remap another reserve's worth, which moves
+         page tables at worst but never the data */
+      newlen = size + alloc->reserve;
+      newptr = mremap (ptr, alloc->len, newlen, MREMAP_MAYMOVE);
+      assert (newptr != MAP_FAILED);
+      if (alloc->hugepages)
+        assert (madvise (newptr, newlen, MADV_HUGEPAGE) == 0);
+      alloc->len = newlen;
+    }
+  if (newptr != ptr)
+    alloc->nmoved++;
+  alloc->buf = newptr;
+  return newptr;
+}
+
+
+herr_t
+image_free (void *ptr, H5FD_file_image_op_t op, void *udata)
+{
+  imgalloc_t *alloc = (imgalloc_t *) udata;
+
+  if (op == H5FD_FILE_IMAGE_OP_FILE_CLOSE && alloc->keep)
+    {
+      alloc->size = 0;
+      return 0;
+    }
+  if (alloc->mapped)
+    assert (munmap (ptr, alloc->len) == 0);
+  else
+    free (ptr);
+  alloc->buf = NULL;
+  alloc->len = 0;
+  alloc->size = 0;
+  return 0;
+}
+
+
+void *
+udata_copy (void *udata)
+{
+  return udata;
+}
+
+
+herr_t
+udata_free (void *udata)
+{
+  return 0;
+}
+
+
+/* Queue IMG for the writer thread, waiting while all slots are taken. */
+void
+putimage (pipeline_t *pipe, image_t *img)
+{
+  img->next = NULL;
+
+  assert (pthread_mutex_lock (&pipe->lock) == 0);
+  while (pipe->inflight >= pipe->maxinflight)
+    {
+      assert (pthread_cond_wait (&pipe->changed, &pipe->lock) == 0);
+    }
+  if (pipe->tail)
+    pipe->tail->next = img;
+  else
+    pipe->head = img;
+  pipe->tail = img;
+  pipe->inflight++;
+  assert (pthread_cond_broadcast (&pipe->changed) == 0);
+  assert (pthread_mutex_unlock (&pipe->lock) == 0);
+}
+
+
+/* Writer thread: stream queued images to their files until told to stop
+   and the queue is empty.  An image keeps its slot until it is on disk. */
+void *
+writeimages (void *arg)
+{
+  pipeline_t *pipe = (pipeline_t *) arg;
+  image_t *img;
+  FILE *fp;
+  struct timeval t1, t2;
+
+  for (;;)
+    {
+      assert (pthread_mutex_lock (&pipe->lock) == 0);
+      while (pipe->head == NULL && !pipe->done)
+        {
+          assert (pthread_cond_wait (&pipe->changed, &pipe->lock) == 0);
+        }
+      img = pipe->head;
+      if (img)
+        {
+          pipe->head = img->next;
+          if (pipe->head == NULL)
+            pipe->tail = NULL;
+        }
+      assert (pthread_mutex_unlock (&pipe->lock) == 0);
+
+      if (img == NULL)
+        break;
+
+      gettimeofday (&t1, NULL);
+      assert ((fp = fopen (img->name, "wb")) != (FILE *) NULL);
+      assert (fwrite (img->buf, 1, img->size, fp) == img->size);
+      assert (fclose (fp) == 0);
+      gettimeofday (&t2, NULL);
+
+      assert (pthread_mutex_lock (&pipe->lock) == 0);
+      pipe->busy += (double) (t2.tv_sec - t1.tv_sec) + 1.0e-6 * (double) (t2.tv_usec - t1.tv_usec);
+      pipe->written += (double) img->size;
+      pipe->inflight--;
+      assert (pthread_cond_broadcast (&pipe->changed) == 0);
+      assert (pthread_mutex_unlock (&pipe->lock) == 0);
+
+      if (img->maplen > 0)
+        assert (munmap (img->buf, img->maplen) == 0);
+      else
+        free (img->buf);
+      free (img);
+    }
+
+  return NULL;
+}
+
+
+/* Collect every image of NODECOMM in its rank 0 and write them to FNAME
+   in one sequential pass: the index first, then the images in rank
+   order.  Images travel in NODE_CHUNK pieces, so the leader only ever
+   holds its own image and one piece of somebody else's. */
+void
+gatherimage (MPI_Comm nodecomm, const char *fname, void *buf, size_t size)
+{
+  int noderank, nodesize, wrank, r;
+  uint64_t mine[2], *index, offset, done, piece;
+  char *stage, pad[NODE_ALIGN];
+  FILE *fp;
+
+  assert (MPI_Comm_rank (nodecomm, &noderank) == MPI_SUCCESS);
+  assert (MPI_Comm_size (nodecomm, &nodesize) == MPI_SUCCESS);
+  assert (MPI_Comm_rank (MPI_COMM_WORLD, &wrank) == MPI_SUCCESS);
+
+  mine[0] = (uint64_t) wrank;
+  mine[1] = (uint64_t) size;
+  index = NULL;
+  if (noderank == 0)
+    assert ((index = (uint64_t *) malloc (3 * nodesize * sizeof (uint64_t))) != NULL);
+  assert (MPI_Gather (mine, 2, MPI_UINT64_T, index, 2, MPI_UINT64_T, 0, nodecomm)
+          == MPI_SUCCESS);
+
+  if (noderank != 0)
+    {
+      for (done = 0; done < size; done += piece)
+        {
+          piece = (size - done < NODE_CHUNK) ? size - done : NODE_CHUNK;
+          assert (MPI_Send ((char *) buf + done, (int) piece, MPI_BYTE, 0, 0,
+                            nodecomm) == MPI_SUCCESS);
+        }
+      return;
+    }
+
+  /* spread (rank, size) pairs into (rank, offset, size) entries */
+  offset = sizeof (NODE_MAGIC) + sizeof (uint64_t) + 3 * nodesize * sizeof (uint64_t);
+  for (r = nodesize - 1; r >= 0; r--)
+    {
+      index[3 * r + 2] = index[2 * r + 1];
+      index[3 * r] = index[2 * r];
+    }
+  for (r = 0; r < nodesize; r++)
+    {
+      offset = (offset + NODE_ALIGN - 1) / NODE_ALIGN * NODE_ALIGN;
+      index[3 * r + 1] = offset;
+      offset += index[3 * r + 2];
+    }
+
+  memset (pad, 0, sizeof (pad));
+  assert ((stage = (char *) malloc (NODE_CHUNK)) != NULL);
+  assert ((fp = fopen (fname, "wb")) != (FILE *) NULL);
+  assert (fwrite (NODE_MAGIC, 1, sizeof (NODE_MAGIC), fp) == sizeof (NODE_MAGIC));
+  offset = (uint64_t) nodesize;
+  assert (fwrite (&offset, sizeof (uint64_t), 1, fp) == 1);
+  assert (fwrite (index, sizeof (uint64_t), 3 * nodesize, fp) == (size_t) 3 * nodesize);
+  for (r = 0; r < nodesize; r++)
+    {
+      offset = (uint64_t) ftell (fp);
+      assert (fwrite (pad, 1, index[3 * r + 1] - offset, fp) == index[3 * r + 1] - offset);
+      if (r == 0)
+        {
+          assert (fwrite (buf, 1, size, fp) == size);
+          continue;
+        }
+      for (done = 0; done < index[3 * r + 2]; done += piece)
+        {
+          piece = (index[3 * r + 2] - done < NODE_CHUNK) ? index[3 * r + 2] - done : NODE_CHUNK;
+          assert (MPI_Recv (stage, (int) piece, MPI_BYTE, r, 0, nodecomm,
+                            MPI_STATUS_IGNORE) == MPI_SUCCESS);
+          assert (fwrite (stage, 1, piece, fp) == piece);
+        }
+    }
+  assert (fclose (fp) == 0);
+
+  free (stage);
+  free (index);
+}
+
+
+/* Find RANK's image in the node file FNAME, read it in one call and open
+   it with H5LTopen_file_image to check that it is a usable file. */
+void
+reopenimage (const char *fname, int rank)
+{
+  char magic[sizeof (NODE_MAGIC)];
+  uint64_t count, entry[3], k;
+  void *image;
+  hid_t file, dset;
+  FILE *fp;
+
+  assert ((fp = fopen (fname, "rb")) != (FILE *) NULL);
+  assert (fread (magic, 1, sizeof (magic), fp) == sizeof (magic));
+  assert (memcmp (magic, NODE_MAGIC, sizeof (magic)) == 0);
+  assert (fread (&count, sizeof (uint64_t), 1, fp) == 1);
+  for (k = 0; k < count; k++)
+    {
+      assert (fread (entry, sizeof (uint64_t), 3, fp) == 3);
+      if (entry[0] == (uint64_t) rank)
+        break;
+    }
+  assert (k < count);
+
+  assert ((image = malloc (entry[2])) != NULL);
+  assert (fseek (fp, (long) entry[1], SEEK_SET) == 0);
+  assert (fread (image, 1, entry[2], fp) == entry[2]);
+  assert (fclose (fp) == 0);
+
+  file = H5LTopen_file_image (image, entry[2],
+                              H5LT_FILE_IMAGE_DONT_COPY | H5LT_FILE_IMAGE_DONT_RELEASE);
+  assert (file >= 0);
+  dset = H5Dopen2 (file, "level000/group00/dataset00", H5P_DEFAULT);
+  assert (dset >= 0);
+  assert (H5Dclose (dset) >= 0);
+  assert (H5Fclose (file) >= 0);
+  free (image);
+}
+
+
+/* Open FNAME with METHOD, then read every dataset of the hierarchy into
+   RBUF and check it against BUF, regenerating BUF from CONTENT for
+   dataset SEQ onwards if there is any.  Returns the traversal time and leaves
+   the time to open in *OPENTIME. */
+double
+readback (const char *fname, int method, unsigned levels, unsigned groups,
+          unsigned dsets, hid_t type, void *rbuf, void *buf,
+          const content_t *content, unsigned long seq, double *opentime)
+{
+  char name[MAX_LEN];
+  unsigned level, igroup, idset;
+  hid_t fapl, file, dset;
+  void *image;
+  long size;
+  FILE *fp;
+  double t1, t2;
+
+  image = NULL;
+  t1 = MPI_Wtime ();
+  if (method == READ_IMAGE)
+    {
+      assert ((fp = fopen (fname, "rb")) != (FILE *) NULL);
+      assert (fseek (fp, 0, SEEK_END) == 0);
+      assert ((size = ftell (fp)) > 0);
+      assert (fseek (fp, 0, SEEK_SET) == 0);
+      assert ((image = malloc ((size_t) size)) != NULL);
+      assert (fread (image, 1, (size_t) size, fp) == (size_t) size);
+      assert (fclose (fp) == 0);
+      file = H5LTopen_file_image (image, (size_t) size,
+                                  H5LT_FILE_IMAGE_DONT_COPY | H5LT_FILE_IMAGE_DONT_RELEASE);
+    }
+  else
+    {
+      fapl = H5Pcreate (H5P_FILE_ACCESS);
+      assert (fapl >= 0);
+      if (method == READ_CORE)
+        assert (H5Pset_fapl_core (fapl, INCREMENT, 0) >= 0);
+      else
+        assert (H5Pset_fapl_sec2 (fapl) >= 0);
+      file = H5Fopen (fname, H5F_ACC_RDONLY, fapl);
+      assert (H5Pclose (fapl) >= 0);
+    }
+  assert (file >= 0);
+  t2 = MPI_Wtime ();
+  *opentime = t2 - t1;
+
+  for (level = 0; level < levels; ++level)
+    for (igroup = 0; igroup < groups; ++igroup)
+      for (idset = 0; idset < dsets; ++idset)
+        {
+          assert (sprintf (name, "level%03d/group%02d/dataset%02d",
+                           level, igroup, idset) > 0);
+          dset = H5Dopen2 (file, name, H5P_DEFAULT);
+          assert (dset >= 0);
+          assert (H5Dread (dset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, rbuf) >= 0);
+          assert (H5Dclose (dset) >= 0);
+          if (content->field != FIELD_GARBAGE)
+            fillbuffer (buf, content, seq++);
+          assert (memcmp (rbuf, buf, content->nelem * content->tsize) == 0);
+        }
+
+  assert (H5Fclose (file) >= 0);
+  free (image);
+
+  return MPI_Wtime () - t2;
+}
+
+
+/* Fill BUF with dataset SEQ's content.  Integers wrap, so every type
+   gets the same pattern modulo its width. */
+void
+fillbuffer (void *buf, const content_t *content, unsigned long seq)
+{
+  size_t i;
+  unsigned long long u, x;
+  double v;
+
+  x = 0x9e3779b97f4a7c15ULL * (seq + 1);
+  for (i = 0; i < content->nelem; i++)
+    {
+      switch (content->field)
+        {
+        case FIELD_RAMP:
+          u = seq + i;
+          v = (double) u;
+          break;
+        case FIELD_SINE:
+          v = sin (0.001 * (double) i + (double) seq);
+          u = (unsigned long long) (long long) (1000.0 * v);
+          break;
+        case FIELD_RANDOM:
+          /* xorshift64* */
+          x ^= x >> 12;
+          x ^= x << 25;
+          x ^= x >> 27;
+          u = x * 0x2545f4914f6cdd1dULL;
+          v = (double) (u >> 11) * (1.0 / 9007199254740992.0);
+          break;
+        default:
+          u = 0;
+          v = 0.0;
+          break;
+        }
+
+      if (content->isfloat)
+        {
+          if (content->tsize == sizeof (float))
+            ((float *) buf)[i] = (float) v;
+          else
+            ((double *) buf)[i] = v;
+        }
+      else
+        {
+          switch (content->tsize)
+            {
+            case 1:
+              ((uint8_t *) buf)[i] = (uint8_t) u;
+              break;
+            case 2:
+              ((uint16_t *) buf)[i] = (uint16_t) u;
+              break;
+            case 4:
+              ((uint32_t *) buf)[i] = (uint32_t) u;
+              break;
+            default:
+              ((uint64_t *) buf)[i] = (uint64_t) u;
+              break;
+            }
+        }
+    }
+}
+
+
+/* Worker thread: claim the next dataset, wait for its slot to be
+   written out, and generate its content, until all are claimed. */
+void *
+produce (void *arg)
+{
+  ring_t *ring = (ring_t *) arg;
+  unsigned long seq;
+  unsigned slot;
+  double t1, t2;
+
+  assert (pthread_mutex_lock (&ring->lock) == 0);
+  while (ring->next < ring->total)
+    {
+      seq = ring->next++;
+      slot = seq % ring->nslots;
+      t1 = wtime ();
+      while (seq >= ring->written + ring->nslots)
+        assert (pthread_cond_wait (&ring->emptied, &ring->lock) == 0);
+      ring->pstall += wtime () - t1;
+      assert (pthread_mutex_unlock (&ring->lock) == 0);
+
+      t1 = wtime ();
+      fillbuffer (ring->slots[slot], ring->content, seq);
+      t2 = wtime ();
+
+      assert (pthread_mutex_lock (&ring->lock) == 0);
+      ring->busy += t2 - t1;
+      ring->full[slot] = 1;
+      assert (pthread_cond_broadcast (&ring->filled) == 0);
+    }
+  assert (pthread_mutex_unlock (&ring->lock) == 0);
+
+  return NULL;
+}
+
+
+/* The buffer holding dataset SEQ, once a worker has filled it. */
+void *
+ringget (ring_t *ring, unsigned long seq)
+{
+  unsigned slot = seq % ring->nslots;
+  double t1;
+
+  assert (pthread_mutex_lock (&ring->lock) == 0);
+  t1 = wtime ();
+  while (!ring->full[slot])
+    assert (pthread_cond_wait (&ring->filled, &ring->lock) == 0);
+  ring->cstall += wtime () - t1;
+  assert (pthread_mutex_unlock (&ring->lock) == 0);
+
+  return ring->slots[slot];
+}
+
+
+/* Hand dataset SEQ's buffer back to the workers. */
+void
+ringput (ring_t *ring, unsigned long seq)
+{
+  assert (pthread_mutex_lock (&ring->lock) == 0);
+  ring->full[seq % ring->nslots] = 0;
+  ring->written = seq + 1;
+  assert (pthread_cond_broadcast (&ring->emptied) == 0);
+  assert (pthread_mutex_unlock (&ring->lock) == 0);
+}
+
+
+/* Wall-clock seconds for threads that must not call MPI. */
+double
+wtime (void)
+{
+  struct timespec ts;
+
+  assert (clock_gettime (CLOCK_MONOTONIC, &ts) == 0);
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
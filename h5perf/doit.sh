@@ -14,4 +14,11 @@
 # access to either file, you may request a copy from help@hdfgroup.org.
 
 h5pcc=${CC:-cc}
-$h5pcc -DSTANDALONE pio_perf.c pio_engine.c pio_timer.c -o h5perf
+
+# "doit.sh threads" builds h5perf_threads, which runs without MPI on a
+# thread-safe serial HDF5 (CC=h5cc); its processes are threads
+if [ "$1" = threads ]; then
+    $h5pcc -DSTANDALONE -DPIO_THREADS pio_perf.c pio_engine.c pio_timer.c pio_replay.c pio_compare.c pio_thread.c -o h5perf_threads -lm -lpthread
+else
+    $h5pcc -DSTANDALONE pio_perf.c pio_engine.c pio_timer.c pio_replay.c pio_compare.c -o h5perf -lm -lpthread
+fi
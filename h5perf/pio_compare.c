@@ -0,0 +1,560 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF5.  The full HDF5 copyright notice, including     *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the files COPYING and Copyright.html.  COPYING can be found at the root   *
+ * of the source code distribution tree; Copyright.html can be found at the  *
+ * root level of an installed copy of the electronic HDF5 document set and   *
+ * is linked from the top-level documents page.  It can also be found at     *
+ * http://hdfgroup.org/HDF5/doc/Copyright.html.  If you do not have          *
+ * access to either file, you may request a copy from help@hdfgroup.org.     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+ * Purpose:
+ *
+ * Comparison of h5perf reports with a stored baseline.  Both sides are the
+ * text h5perf prints: the parameters header, then for every number of
+ * processes, transfer size and API the maximum, average and minimum
+ * throughput of each phase over the iterations.  Results are matched on
+ * their configuration and each new one is given as a percentage of its
+ * baseline.  A difference counts as a regression or improvement if a
+ * Welch t-test on the two sets of iterations finds it significant at 5%,
+ * and it is at least PIO_COMPARE_MIN_CHANGE percent.  The reports only
+ * keep the range of the iterations, so the standard deviation is
+ * estimated from it (range over the d2 constant for that many samples).
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+
+#include "hdf5.h"
+
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
+
+#ifdef PIO_THREADS
+#include "pio_thread.h"
+#else
+#include <mpi.h>
+#endif  /* PIO_THREADS */
+
+#ifndef MPI_FILE_NULL           /*MPIO may be defined in mpi.h already       */
+#   include <mpio.h>
+#endif  /* !MPI_FILE_NULL */
+
+#include "pio_perf.h"
+
+#ifndef MIN
+#   define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif  /* !MIN */
+
+#ifndef MAX
+#   define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif  /* !MAX */
+
+/* Smallest change, in percent, reported as a regression or improvement */
+#define PIO_COMPARE_MIN_CHANGE  5.0
+
+/* Most distinct phase names kept in order of appearance */
+#define PIO_COMPARE_MAX_PHASES  32
+
+/* One throughput result of a report */
+typedef struct cmp_result_ {
+    char        key[512];       /* Configuration the result is matched on */
+    int         nprocs;
+    char        api[16];
+    char        phase[40];
+    char        xfer[40];       /* Transfer buffer size as printed      */
+    double      file_mb;        /* File size in MB                      */
+    int         n;              /* Iterations                           */
+    double      mean;           /* Average throughput in MB/s           */
+    double      sd;             /* Estimated deviation, <0 if unknown   */
+    int         matched;
+} cmp_result;
+
+typedef struct cmp_set_ {
+    int         num;
+    int         max;
+    int         nfiles;         /* Reports read                         */
+    cmp_result *r;
+} cmp_set;
+
+/* Configuration while reading a report */
+typedef struct cmp_state_ {
+    char        method[32];     /* Independent or Collective            */
+    char        geometry[16];
+    char        storage[32];
+    char        block[32];
+    char        pattern[32];
+    int         nprocs;
+    char        xfer[40];
+    double      file_mb;
+    long        nfiles, ndsets;
+    char        api[16];
+    char        phase[40];
+    int         n;
+    double      max, avg;
+    int         have;           /* Throughput lines seen of the phase   */
+} cmp_state;
+
+/* Range of a sample of n normal values over its deviation, n = 2..20 */
+static const double cmp_d2[] = {
+    0, 0, 1.128, 1.693, 2.059, 2.326, 2.534, 2.704, 2.847, 2.970, 3.078,
+    3.173, 3.258, 3.336, 3.407, 3.472, 3.532, 3.588, 3.640, 3.689, 3.735
+};
+
+/* Two-sided 5% critical values of Student's t, df = 1..30 */
+static const double cmp_t05[] = {
+    0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static char cmp_phases[PIO_COMPARE_MAX_PHASES][40];
+static int cmp_nphases;
+
+/* local functions */
+static int cmp_load(const char *path, cmp_set *set);
+static int cmp_load_file(const char *fname, cmp_set *set);
+static void cmp_add(cmp_set *set, cmp_state *st, double min);
+static int cmp_phase_index(const char *phase);
+static int cmp_result_cmp(const void *a, const void *b);
+static void cmp_copy_value(char *dst, size_t size, const char *line,
+    const char *label);
+static int cmp_verdict(const cmp_result *base, const cmp_result *cur,
+    double pct);
+
+/*
+ * Function:    pio_compare
+ * Purpose:     Compare the reports in REPORTS (files, or directories
+ *              searched for *.out files) with those under BASE, and print
+ *              every matched result as a percentage of its baseline, then
+ *              a summary per number of processes, API and phase.
+ * Return:      Number of significant regressions, or -1 if BASE or a
+ *              report cannot be read
+ * Modifications:
+ */
+int
+pio_compare(const char *base, int nreports, char *const *reports)
+{
+    static const char *verdicts[] = { "", "regression", "improvement",
+        "regression?", "improvement?" };
+    cmp_set     bset, nset;
+    int         i, j, k, start;
+    int         regressions = 0, improvements = 0, untested = 0;
+    int         matched = 0, unmatched = 0;
+    int         ret_value = -1;
+
+    HDmemset(&bset, 0, sizeof(bset));
+    HDmemset(&nset, 0, sizeof(nset));
+    cmp_nphases = 0;
+
+    if (cmp_load(base, &bset) < 0)
+        goto done;
+    for (i = 0; i < nreports; i++)
+        if (cmp_load(reports[i], &nset) < 0)
+            goto done;
+
+    if (bset.num == 0 || nset.num == 0) {
+        fprintf(stderr, "h5perf: no throughput results in the %s\n",
+                bset.num == 0 ? "baseline" : "reports to compare");
+        goto done;
+    }
+
+    qsort(nset.r, (size_t)nset.num, sizeof(cmp_result), cmp_result_cmp);
+
+    HDfprintf(output, "Baseline %s: %d result(s) in %d report(s)\n", base,
+              bset.num, bset.nfiles);
+    HDfprintf(output, "Compared: %d result(s) in %d report(s)\n", nset.num,
+              nset.nfiles);
+    HDfprintf(output, "%5s %-5s %-16s %-14s %9s %5s %10s %10s %9s\n", "procs",
+              "API", "phase", "xfer", "file MB", "iters", "base MB/s", "MB/s",
+              "% of base");
+
+    for (i = 0; i < nset.num; i++) {
+        cmp_result *cur = &nset.r[i];
+        cmp_result *old = NULL;
+        double      pct;
+
+        for (j = 0; j < bset.num && !old; j++)
+            if (!HDstrcmp(bset.r[j].key, cur->key))
+                old = &bset.r[j];
+        if (!old) {
+            unmatched++;
+            continue;
+        }
+
+        old->matched = cur->matched = 1;
+        matched++;
+        pct = 100.0 * cur->mean / old->mean;
+        k = cmp_verdict(old, cur, pct);
+        regressions += k == 1;
+        improvements += k == 2;
+        untested += k >= 3;
+
+        HDfprintf(output, "%5d %-5s %-16s %-14s %9.2f %2d/%-2d %10.2f %10.2f %8.1f%% %s\n",
+                  cur->nprocs, cur->api, cur->phase, cur->xfer, cur->file_mb,
+                  old->n, cur->n, old->mean, cur->mean, pct, verdicts[k]);
+    }
+
+    /* Geometric mean of the ratios of each rank count, API and phase */
+    HDfprintf(output, "\nSummary by processes, API and phase:\n");
+    HDfprintf(output, "%5s %-5s %-16s %7s %9s %11s %12s\n", "procs", "API",
+              "phase", "results", "% of base", "regressions", "improvements");
+    for (start = 0; start < nset.num; start = i) {
+        cmp_result *first = &nset.r[start];
+        double      log_sum = 0;
+        int         n = 0, reg = 0, imp = 0;
+
+        for (i = start; i < nset.num; i++) {
+            cmp_result *cur = &nset.r[i];
+
+            if (cur->nprocs != first->nprocs || HDstrcmp(cur->api, first->api) ||
+                    HDstrcmp(cur->phase, first->phase))
+                break;
+            if (!cur->matched)
+                continue;
+            for (j = 0; j < bset.num; j++)
+                if (!HDstrcmp(bset.r[j].key, cur->key)) {
+                    double pct = 100.0 * cur->mean / bset.r[j].mean;
+
+                    k = cmp_verdict(&bset.r[j], cur, pct);
+                    reg += k == 1;
+                    imp += k == 2;
+                    if (cur->mean > 0)
+                        log_sum += log(cur->mean / bset.r[j].mean);
+                    n++;
+                    break;
+                }
+        }
+
+        if (n > 0)
+            HDfprintf(output, "%5d %-5s %-16s %7d %8.1f%% %11d %12d\n",
+                      first->nprocs, first->api, first->phase, n,
+                      100.0 * exp(log_sum / n), reg, imp);
+    }
+
+    for (j = 0, k = 0; j < bset.num; j++)
+        k += !bset.r[j].matched;
+    HDfprintf(output, "\n%d matched: %d regression(s), %d improvement(s), "
+              "%d untested change(s); %d result(s) without a baseline, "
+              "%d baseline result(s) not rerun\n", matched, regressions,
+              improvements, untested, unmatched, k);
+    ret_value = regressions;
+
+done:
+    HDfree(bset.r);
+    HDfree(nset.r);
+    return ret_value;
+}
+
+/*
+ * Function:    cmp_verdict
+ * Purpose:     Decide whether CUR differs from BASE: a Welch t-test at 5%
+ *              when both have a deviation estimate, the size of the change
+ *              alone (and flagged as untested) otherwise.
+ * Return:      0 none, 1 regression, 2 improvement, 3 and 4 the same but
+ *              untested
+ * Modifications:
+ */
+static int
+cmp_verdict(const cmp_result *base, const cmp_result *cur, double pct)
+{
+    double  se2, t, df, crit;
+
+    if (fabs(pct - 100.0) < PIO_COMPARE_MIN_CHANGE)
+        return 0;
+
+    if (base->sd < 0 || cur->sd < 0)
+        return pct < 100.0 ? 3 : 4;
+
+    se2 = base->sd * base->sd / base->n + cur->sd * cur->sd / cur->n;
+    if (se2 > 0) {
+        t = fabs(cur->mean - base->mean) / sqrt(se2);
+        df = se2 * se2 /
+            (pow(base->sd * base->sd / base->n, 2) / (base->n - 1) +
+             pow(cur->sd * cur->sd / cur->n, 2) / (cur->n - 1));
+        crit = df < 1 ? cmp_t05[1] : df <= 30 ? cmp_t05[(int)df] : 1.96;
+        if (t < crit)
+            return 0;
+    }
+
+    return pct < 100.0 ? 1 : 2;
+}
+
+/*
+ * Function:    cmp_load
+ * Purpose:     Read the report PATH, or every *.out file below the
+ *              directory PATH, into SET.
+ * Return:      0 or -1 on error
+ * Modifications:
+ */
+static int
+cmp_load(const char *path, cmp_set *set)
+{
+    struct stat     sb;
+    DIR            *dir;
+    struct dirent  *ent;
+    int             ret_value = 0;
+
+    if (stat(path, &sb) < 0) {
+        fprintf(stderr, "h5perf: cannot read %s\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(sb.st_mode))
+        return cmp_load_file(path, set);
+
+    if ((dir = opendir(path)) == NULL) {
+        fprintf(stderr, "h5perf: cannot read directory %s\n", path);
+        return -1;
+    }
+
+    while (ret_value == 0 && (ent = readdir(dir)) != NULL) {
+        char    name[FILENAME_MAX];
+        size_t  len = HDstrlen(ent->d_name);
+
+        if (ent->d_name[0] == '.')
+            continue;
+        if ((size_t)snprintf(name, sizeof(name), "%s/%s", path, ent->d_name) >= sizeof(name))
+            continue;
+        if (stat(name, &sb) < 0)
+            continue;
+        if (S_ISDIR(sb.st_mode))
+            ret_value = cmp_load(name, set);
+        else if (len > 4 && !HDstrcmp(ent->d_name + len - 4, ".out"))
+            ret_value = cmp_load_file(name, set);
+    }
+
+    closedir(dir);
+    return ret_value;
+}
+
+/*
+ * Function:    cmp_load_file
+ * Purpose:     Read the throughput results of one h5perf report into SET.
+ *              Parameter lines may carry a "rank N: " prefix.
+ * Return:      0 or -1 on error
+ * Modifications:
+ */
+static int
+cmp_load_file(const char *fname, cmp_set *set)
+{
+    FILE       *f;
+    char        line[1024];
+    cmp_state   st;
+
+    if ((f = fopen(fname, "r")) == NULL) {
+        fprintf(stderr, "h5perf: cannot read %s\n", fname);
+        return -1;
+    }
+
+    HDmemset(&st, 0, sizeof(st));
+    while (fgets(line, sizeof(line), f)) {
+        char   *p;
+        double  v;
+
+        if ((p = strstr(line, "I/O Method for MPI and HDF5=")) != NULL)
+            cmp_copy_value(st.method, sizeof(st.method), p, "=");
+        else if ((p = strstr(line, "Geometry=")) != NULL)
+            cmp_copy_value(st.geometry, sizeof(st.geometry), p, "=");
+        else if ((p = strstr(line, "Data storage method in HDF5=")) != NULL)
+            cmp_copy_value(st.storage, sizeof(st.storage), p, "=");
+        else if ((p = strstr(line, "Block size=")) != NULL)
+            cmp_copy_value(st.block, sizeof(st.block), p, "=");
+        else if ((p = strstr(line, "Block Pattern in Dataset=")) != NULL)
+            cmp_copy_value(st.pattern, sizeof(st.pattern), p, "=");
+        else if (sscanf(line, "Number of processors = %d", &st.nprocs) == 1)
+            ;
+        else if (sscanf(line, "Transfer Buffer Size: %39s bytes, File size: %lf",
+                        st.xfer, &st.file_mb) == 2)
+            ;
+        else if (sscanf(line, " # of files: %ld, # of datasets: %ld", &st.nfiles,
+                        &st.ndsets) == 2)
+            ;
+        else if ((p = strstr(line, "IO API = ")) != NULL)
+            sscanf(p + 9, "%15s", st.api);
+        else if ((p = strstr(line, " iteration(s)):")) != NULL) {
+            char   *q = p;
+
+            /* "PHASE (N iteration(s)):" */
+            while (q > line && q[-1] != '(')
+                q--;
+            if (q == line)
+                continue;
+            st.n = atoi(q);
+            for (q--; q > line && q[-1] == ' '; q--)
+                ;
+            for (p = line; *p == ' '; p++)
+                ;
+            if (q <= p)
+                continue;
+            *q = '\0';
+            HDstrncpy(st.phase, p, sizeof(st.phase) - 1);
+            st.phase[sizeof(st.phase) - 1] = '\0';
+            st.have = 0;
+        } else if ((p = strstr(line, "Maximum Throughput:")) != NULL &&
+                   sscanf(p + 19, "%lf", &v) == 1) {
+            st.max = v;
+            st.have |= 1;
+        } else if ((p = strstr(line, "Average Throughput:")) != NULL &&
+                   sscanf(p + 19, "%lf", &v) == 1) {
+            st.avg = v;
+            st.have |= 2;
+        } else if ((p = strstr(line, "Minimum Throughput:")) != NULL &&
+                   sscanf(p + 19, "%lf", &v) == 1 && st.have == 3 &&
+                   st.phase[0] && st.api[0]) {
+            cmp_add(set, &st, v);
+            st.have = 0;
+        }
+    }
+
+    fclose(f);
+    set->nfiles++;
+    return 0;
+}
+
+/*
+ * Function:    cmp_copy_value
+ * Purpose:     Copy what follows LABEL in LINE, without the line end and
+ *              trailing blanks, to DST.
+ * Return:      void
+ * Modifications:
+ */
+static void
+cmp_copy_value(char *dst, size_t size, const char *line, const char *label)
+{
+    const char *p = strstr(line, label);
+    size_t      len;
+
+    p = p ? p + HDstrlen(label) : line;
+    for (len = HDstrlen(p); len > 0 && (p[len - 1] == '\n' || p[len - 1] == ' ' ||
+            p[len - 1] == '\r'); len--)
+        ;
+    len = MIN(len, size - 1);
+    memcpy(dst, p, len);
+    dst[len] = '\0';
+}
+
+/*
+ * Function:    cmp_add
+ * Purpose:     Add the phase ST just finished, MIN being its lowest
+ *              throughput, to SET.  A configuration already in SET (the
+ *              same run repeated) is pooled with it.  Phases that failed
+ *              and report no throughput are left out.
+ * Return:      void
+ * Modifications:
+ */
+static void
+cmp_add(cmp_set *set, cmp_state *st, double min)
+{
+    cmp_result  r;
+    int         i;
+
+    if (st->avg <= 0)
+        return;
+
+    HDmemset(&r, 0, sizeof(r));
+    snprintf(r.key, sizeof(r.key), "%d|%s|%s|%s|%.2f|%ld|%ld|%s|%s|%s|%s|%s",
+             st->nprocs, st->api, st->phase, st->xfer, st->file_mb, st->nfiles,
+             st->ndsets, st->method, st->geometry, st->storage, st->block,
+             st->pattern);
+    r.nprocs = st->nprocs;
+    HDstrcpy(r.api, st->api);
+    HDstrcpy(r.phase, st->phase);
+    HDstrcpy(r.xfer, st->xfer);
+    r.file_mb = st->file_mb;
+    r.n = MAX(st->n, 1);
+    r.mean = st->avg;
+    if (r.n >= 2)
+        r.sd = (st->max - min) / cmp_d2[MIN(r.n, 20)];
+    else
+        r.sd = -1;
+    cmp_phase_index(r.phase);
+
+    for (i = 0; i < set->num; i++) {
+        cmp_result *o = &set->r[i];
+
+        if (!HDstrcmp(o->key, r.key)) {
+            int     n = o->n + r.n;
+            double  mean = (o->n * o->mean + r.n * r.mean) / n;
+
+            if (o->sd >= 0 && r.sd >= 0)
+                o->sd = sqrt(((o->n - 1) * o->sd * o->sd + (r.n - 1) * r.sd * r.sd +
+                    (double)o->n * r.n / n * (o->mean - r.mean) * (o->mean - r.mean)) /
+                    (n - 1));
+            else
+                o->sd = -1;
+            o->mean = mean;
+            o->n = n;
+            return;
+        }
+    }
+
+    if (set->num == set->max) {
+        int         n = set->max ? 2 * set->max : 64;
+        cmp_result *p = (cmp_result *)realloc(set->r, n * sizeof(*p));
+
+        if (p == NULL) {
+            fprintf(stderr, "h5perf: out of memory for the compared results\n");
+            return;
+        }
+        set->r = p;
+        set->max = n;
+    }
+    set->r[set->num++] = r;
+}
+
+/*
+ * Function:    cmp_phase_index
+ * Purpose:     Number the phase names in the order they are first seen,
+ *              so the summary lists them the way h5perf runs them.
+ * Return:      Index of PHASE
+ * Modifications:
+ */
+static int
+cmp_phase_index(const char *phase)
+{
+    int i;
+
+    for (i = 0; i < cmp_nphases; i++)
+        if (!HDstrcmp(cmp_phases[i], phase))
+            return i;
+    if (cmp_nphases == PIO_COMPARE_MAX_PHASES)
+        return PIO_COMPARE_MAX_PHASES;
+    HDstrcpy(cmp_phases[cmp_nphases], phase);
+    return cmp_nphases++;
+}
+
+/*
+ * Function:    cmp_result_cmp
+ * Purpose:     qsort comparator ordering results by number of processes,
+ *              API, phase and transfer size.
+ * Return:      <0, 0 or >0
+ * Modifications:
+ */
+static int
+cmp_result_cmp(const void *a, const void *b)
+{
+    const cmp_result *x = (const cmp_result *)a, *y = (const cmp_result *)b;
+    int     c;
+
+    if (x->nprocs != y->nprocs)
+        return x->nprocs < y->nprocs ? -1 : 1;
+    if ((c = HDstrcmp(x->api, y->api)) != 0)
+        return c;
+    if ((c = cmp_phase_index(x->phase) - cmp_phase_index(y->phase)) != 0)
+        return c;
+    if (atol(x->xfer) != atol(y->xfer))
+        return atol(x->xfer) < atol(y->xfer) ? -1 : 1;
+    return HDstrcmp(x->key, y->key);
+}
+
+#endif /* H5_HAVE_PARALLEL */
@@ -26,12 +26,18 @@
 #include <unistd.h>
 #endif
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
 
 #include "hdf5.h"
 
-#ifdef H5_HAVE_PARALLEL
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
 
+#ifdef PIO_THREADS
+#include "pio_thread.h"
+#else
 #include <mpi.h>
+#endif  /* PIO_THREADS */
 
 #ifndef MPI_FILE_NULL           /*MPIO may be defined in mpi.h already       */
 #   include <mpio.h>
@@ -43,11 +49,11 @@
 /* Macro definitions */
 
 #if H5_VERS_MAJOR == 1 && H5_VERS_MINOR == 6
-#    define H5DCREATE(fd, name, type, space, dcpl)    H5Dcreate(fd, name, type, space, dcpl)
-#    define H5DOPEN(fd, name)                         H5Dopen(fd, name)
+#    define H5DCREATE(fd, name, type, space, dcpl, dapl) H5Dcreate(fd, name, type, space, dcpl)
+#    define H5DOPEN(fd, name, dapl)                   H5Dopen(fd, name)
 #else
-#    define H5DCREATE(fd, name, type, space, dcpl)    H5Dcreate2(fd, name, type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT)
-#    define H5DOPEN(fd, name)                         H5Dopen2(fd, name, H5P_DEFAULT)
+#    define H5DCREATE(fd, name, type, space, dcpl, dapl) H5Dcreate2(fd, name, type, space, H5P_DEFAULT, dcpl, dapl)
+#    define H5DOPEN(fd, name, dapl)                   H5Dopen2(fd, name, dapl)
 #endif
 
 /* sizes of various items. these sizes won't change during program execution */
@@ -56,6 +62,10 @@
 #define ELMT_MPI_TYPE       MPI_BYTE
 #define ELMT_H5_TYPE        H5T_NATIVE_UCHAR
 
+/* What verified data holds: the writer's rank + 1, or the same for all
+ * processes when other processes read it back (checkpoint/restart) */
+#define PIO_VERIFY_BYTE(parms)  ((parms)->verify_shared ? 1 : pio_mpi_rank_g + 1)
+
 #define GOTOERROR(errcode)  { ret_code = errcode; goto done; }
 #define GOTODONE        { goto done; }
 #define ERRMSG(mesg) {                                                  \
@@ -94,7 +104,7 @@ enum {
 };
 
 /* Global variables */
-static int  clean_file_g = -1;  /*whether to cleanup temporary test     */
+static PIO_TLS int clean_file_g = -1;  /*whether to cleanup temporary test */
 /*files. -1 is not defined;             */
 /*0 is no cleanup; 1 is do cleanup      */
 
@@ -112,6 +122,24 @@ static int  clean_file_g = -1;  /*whether to cleanup temporary test     */
 #   define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif  /* !MIN */
 
+/* MPI-4 has large-count ("_c") bindings; older MPIs need derived types
+ * to describe more than INT_MAX bytes in one call. */
+#if defined(MPI_VERSION) && MPI_VERSION >= 4
+#   define PIO_HAVE_MPI_LARGE_COUNT 1
+#endif
+
+/* Piece size used to build derived types larger than INT_MAX bytes */
+#define PIO_TYPE_PIECE      ((size_t)1 << 30)
+
+/* Seconds a SWMR reader waits for the writer to make progress */
+#define PIO_SWMR_TIMEOUT    60.0
+
+/* Nanoseconds a SWMR reader sleeps after a poll that saw nothing new */
+#define PIO_SWMR_POLL       100000L
+
+/* Bytes the core driver grows its in-memory file by */
+#define PIO_CORE_INCREMENT  ((size_t)64 * 1024 * 1024)
+
 /* the different types of file descriptors we can expect */
 typedef union _file_descr {
     int         posixfd;    /* POSIX file handle*/
@@ -119,17 +147,54 @@ typedef union _file_descr {
     hid_t       h5fd;       /* HDF5 file        */
 } file_descr;
 
+/* What the raw data chunk cache of one open dataset holds */
+typedef struct _chunk_model {
+    int         rank;           /* Dataset rank, 0 if not chunked       */
+    hsize_t     chunk[2];       /* Chunk dims                           */
+    hsize_t     nchunks[2];     /* Chunks along each dimension          */
+    size_t      nslots;         /* Hash table slots                     */
+    size_t      capacity;       /* Chunks that fit into the cache       */
+    size_t      nused;          /* Chunks in the cache                  */
+    hsize_t    *slot;           /* 1 + index of the chunk in each slot  */
+    unsigned long *stamp;       /* Transfer that last used each slot    */
+    unsigned long clock;        /* Transfers seen so far                */
+    hsize_t    *touched;        /* Chunks of the current transfer       */
+    size_t      ntouched_max;   /* Room in touched                      */
+    hssize_t   *offsets;        /* Selection offset of each transfer    */
+    size_t      noffsets;       /* Transfers recorded                   */
+    size_t      noffsets_max;   /* Room in offsets                      */
+    long        hits;           /* Chunk lookups found in the cache     */
+    long        misses;         /* Chunk lookups that went to the file  */
+} chunk_model;
+
 /* local functions */
-static char  *pio_create_filename(iotype iot, const char *base_name,
-    char *fullname, size_t size);
+static void pio_base_name(parameters *param, long nf, char *base_name);
 static herr_t do_write(results *res, file_descr *fd, parameters *parms,
     long ndsets, off_t nelmts, size_t buf_size, void *buffer);
 static herr_t do_read(results *res, file_descr *fd, parameters *parms,
     long ndsets, off_t nelmts, size_t buf_size, void *buffer /*out*/);
+static herr_t do_append_step(results *res, file_descr *fd, parameters *parms,
+    hid_t h5ds_id, hid_t h5dset_space_id, hid_t h5mem_space_id, hid_t h5dxpl,
+    off_t nbytes, off_t nbytes_xfer, void *buffer);
+static herr_t chunk_model_init(chunk_model *model, hid_t h5ds_id,
+    size_t nxfers);
+static void chunk_model_record(chunk_model *model, const hssize_t *h5offset);
+static herr_t chunk_model_touch(chunk_model *model, const hsize_t *blocks,
+    size_t nblocks, const hssize_t *h5offset);
+static herr_t chunk_model_replay(chunk_model *model, hid_t h5space_id);
+static void chunk_model_free(chunk_model *model);
+static hid_t pio_create_dapl(parameters *parms);
+static herr_t pio_set_filters(hid_t h5dcpl, parameters *parms);
+static hid_t pio_create_dxpl(parameters *parms);
+static herr_t pio_query_mpio(mpio_modes *modes, hid_t h5dxpl);
+static herr_t do_swmr(results *res, parameters *parms, char *fname,
+    long ndsets, off_t nbytes, size_t buf_size, void *buffer);
 static herr_t do_fopen(parameters *param, char *fname, file_descr *fd /*out*/,
     int flags);
 static herr_t do_fclose(iotype iot, file_descr *fd);
-static void do_cleanupfile(iotype iot, char *fname);
+static int pio_type_bytes(size_t nbytes, MPI_Datatype *newtype);
+static ssize_t pio_posix_write(int fd, const void *buf, size_t nbytes);
+static ssize_t pio_posix_read(int fd, void *buf, size_t nbytes);
 
 /*
  * Function:        do_pio
@@ -190,6 +255,24 @@ do_pio(parameters param)
             GOTOERROR(FAIL);
     }
 
+    if (param.counters)
+        pio_time_counters(res.timers);
+    if (param.sample_interval > 0.0)
+        pio_time_sampling(res.timers, param.sample_interval);
+
+    /* Set by do_write once the stripe alignment has been checked */
+    res.stripe_misaligned = 0;
+    res.stripe_unknown = 1;
+    res.num_steps = 0;
+    res.step_min = res.step_max = res.step_sum = 0.0;
+    res.swmr_plain = res.swmr_write = res.swmr_flush = 0.0;
+    res.num_seen = 0;
+    res.seen_min = res.seen_max = res.seen_sum = 0.0;
+    res.write_hits = res.write_misses = 0;
+    res.read_hits = res.read_misses = 0;
+    memset(&res.write_modes, 0, sizeof(res.write_modes));
+    memset(&res.read_modes, 0, sizeof(res.read_modes));
+
     ndsets = param.num_dsets;       /* number of datasets per file          */
     nbytes = param.num_bytes;       /* number of bytes per dataset          */
     buf_size = param.buf_size;
@@ -236,6 +319,12 @@ do_pio(parameters param)
         "Transfer buffer size (%zu) must be > 0\n", buf_size);
     GOTOERROR(FAIL);
     }
+    if ((buf_size / blk_size) > INT_MAX){
+    HDfprintf(stderr,
+        "Transfer buffer size (%zu) holds more than %d blocks of size (%zu)\n",
+        buf_size, INT_MAX, blk_size);
+    GOTOERROR(FAIL);
+    }
     if ((buf_size % blk_size) != 0){
     HDfprintf(stderr,
         "Transfer buffer size (%zu) must be a multiple of the "
@@ -251,6 +340,27 @@ do_pio(parameters param)
     GOTOERROR(FAIL);
     }
 
+#ifndef H5F_ACC_SWMR_WRITE
+    if (param.swmr) {
+        HDfprintf(stderr, "The SWMR workload needs HDF5 1.10 or later\n");
+        GOTOERROR(FAIL);
+    }
+#endif
+
+    if (param.append || param.swmr) {
+        if (iot != PHDF5 || param.dim2d) {
+        HDfprintf(stderr,
+            "The append and SWMR workloads need the PHDF5 API and 1D geometry\n");
+        GOTOERROR(FAIL);
+        }
+        if (param.extend_steps <= 0) {
+        HDfprintf(stderr,
+            "Number of steps per extension (%ld) must be > 0\n",
+            param.extend_steps);
+        GOTOERROR(FAIL);
+        }
+    }
+
     if (!param.dim2d){
         if(((snbytes/pio_mpi_nprocs_g)%buf_size)!=0) {
         HDfprintf(stderr,
@@ -288,18 +398,28 @@ do_pio(parameters param)
     }
 
     for (nf = 1; nf <= param.num_files; nf++) {
-    /*
-     * Write performance measurement
-     */
-    /* Open file for write */
     char base_name[256];
 
-    sprintf(base_name, "#pio_tmp_%lu", nf);
+    pio_base_name(&param, nf, base_name);
     pio_create_filename(iot, base_name, fname, sizeof(fname));
     if (pio_debug_level > 0)
         HDfprintf(output, "rank %d: data filename=%s\n",
             pio_mpi_rank_g, fname);
 
+    if (param.swmr) {
+        /*
+         * SWMR writer and reader measurement
+         */
+        MPI_Barrier(pio_comm_g);
+
+        hrc = do_swmr(&res, &param, fname, ndsets, nbytes, buf_size, buffer);
+        VRFY((hrc == SUCCESS), "do_swmr failed");
+    }
+
+    if (!param.read_only && !param.swmr) {
+    /*
+     * Write performance measurement
+     */
     /* Need barrier to make sure everyone starts at the same time */
     MPI_Barrier(pio_comm_g);
 
@@ -320,8 +440,9 @@ do_pio(parameters param)
 
     set_time(res.timers, HDF5_GROSS_WRITE_FIXED_DIMS, TSTOP);
     VRFY((hrc == SUCCESS), "do_fclose failed");
+    } /* end if */
 
-    if (!param.h5_write_only) {
+    if (!param.h5_write_only && !param.swmr) {
         /*
          * Read performance measurement
          */
@@ -352,7 +473,8 @@ do_pio(parameters param)
     /* Need barrier to make sure everyone is done with the file */
     /* before it may be removed by do_cleanupfile */
     MPI_Barrier(pio_comm_g);
-    do_cleanupfile(iot, fname);
+    if (!param.keep_files)
+        do_cleanupfile(iot, fname);
     }
 
 done:
@@ -383,6 +505,44 @@ done:
     return res;
 }
 
+/*
+ * Function:    do_pio_cleanup
+ * Purpose:     Remove the files of a test run with keep_files set.
+ * Return:      Nothing
+ * Modifications:
+ */
+    void
+do_pio_cleanup(parameters param)
+{
+    char    fname[FILENAME_MAX];
+    char    base_name[256];
+    long    nf;
+
+    MPI_Barrier(pio_comm_g);
+
+    for (nf = 1; nf <= param.num_files; nf++) {
+        pio_base_name(&param, nf, base_name);
+        if (pio_create_filename(param.io_type, base_name, fname, sizeof(fname)))
+            do_cleanupfile(param.io_type, fname);
+    }
+}
+
+/*
+ * Function:    pio_base_name
+ * Purpose:     Build the base name of data file NF.  Concurrent process
+ *              groups each get their own set of files.
+ * Return:      Nothing
+ * Modifications:
+ */
+    static void
+pio_base_name(parameters *param, long nf, char *base_name)
+{
+    if (param->group >= 0)
+        sprintf(base_name, "#pio_tmp_g%d_%lu", param->group, nf);
+    else
+        sprintf(base_name, "#pio_tmp_%lu", nf);
+}
+
 /*
  * Function:    pio_create_filename
  * Purpose:     Create a new filename to write to. Determine the correct
@@ -393,7 +553,7 @@ done:
  * Programmer:  Bill Wendling, 21. November 2001
  * Modifications:
  */
-    static char *
+    char *
 pio_create_filename(iotype iot, const char *base_name, char *fullname, size_t size)
 {
     const char *prefix, *suffix = "";
@@ -516,6 +676,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
     long        ndset;
     size_t      blk_size;       /* The block size to subdivide the xfer buffer into */
     off_t       nbytes_xfer;    /* Total number of bytes transferred so far */
+    off_t       nbytes_sampled; /* Bytes counted for the bandwidth sampler */
     size_t      nbytes_xfer_advance; /* Number of bytes transferred in a single I/O operation */
     size_t      nbytes_toxfer;  /* Number of bytes to transfer a particular time */
     char        dname[64];
@@ -560,6 +721,11 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
     hssize_t    h5offset[2];            /* Selection offset within dataspace */
     hid_t       h5dcpl = -1;            /* Dataset creation property list */
     hid_t       h5dxpl = -1;            /* Dataset transfer property list */
+    hid_t       h5dapl = -1;            /* Dataset access property list */
+    hid_t       h5append_space_id = -1; /* Initial space of appended dataset */
+    chunk_model h5model;                /* Chunk cache of the open dataset */
+
+    memset(&h5model, 0, sizeof(h5model));
 
     /* Get the parameters from the parameter block */
     blk_size=parms->blk_size;
@@ -585,9 +751,13 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             bytes_begin[0] = (off_t)(blk_size*pio_mpi_rank_g);
         } /* end else */
 
+        /* Appending: each step holds one transfer of every process */
+        if (parms->append && !parms->interleaved)
+            bytes_begin[0] = (off_t)(buf_size*pio_mpi_rank_g);
+
         /* Prepare buffer for verifying data */
         if (parms->verify)
-            memset(buffer,pio_mpi_rank_g+1,buf_size);
+            memset(buffer,PIO_VERIFY_BYTE(parms),buf_size);
     }/* end if */
     /* 2D dataspace */
     else {
@@ -613,7 +783,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
         /* Prepare buffer for verifying data */
         if (parms->verify)
-            memset(buffer,pio_mpi_rank_g+1,buf_size*blk_size);
+            memset(buffer,PIO_VERIFY_BYTE(parms),buf_size*blk_size);
     } /* end else */
 
 
@@ -656,8 +826,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
         /* 1D dataspace */
         if (!parms->dim2d){
             /* Build block's derived type */
-            mrc = MPI_Type_contiguous((int)blk_size,
-                MPI_BYTE, &mpi_blk_type);
+            mrc = pio_type_bytes(blk_size, &mpi_blk_type);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Build file's derived type */
@@ -677,8 +846,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
         else {
             /* Build partial buffer derived type for contiguous access */
 
-            mrc = MPI_Type_contiguous((int)buf_size, MPI_BYTE,
-                &mpi_partial_buffer_cont);
+            mrc = pio_type_bytes(buf_size, &mpi_partial_buffer_cont);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit partial buffer derived type */
@@ -695,8 +863,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build partial buffer derived type for interleaved access */
-            mrc = MPI_Type_contiguous((int)blk_size, MPI_BYTE,
-                &mpi_partial_buffer_inter);
+            mrc = pio_type_bytes(blk_size, &mpi_partial_buffer_inter);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit partial buffer derived type */
@@ -713,8 +880,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build full buffer derived type */
-            mrc = MPI_Type_contiguous((int)(blk_size*buf_size), MPI_BYTE,
-                &mpi_full_buffer);
+            mrc = pio_type_bytes(blk_size*buf_size, &mpi_full_buffer);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit full buffer derived type */
@@ -722,8 +888,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build full chunk derived type */
-            mrc = MPI_Type_contiguous((int)(blk_size*blk_size), MPI_BYTE,
-                &mpi_full_chunk);
+            mrc = pio_type_bytes(blk_size*blk_size, &mpi_full_chunk);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit full chunk derived type */
@@ -843,21 +1008,12 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             } /* end else */
         } /* end else */
 
-        /* Create the dataset transfer property list */
-        h5dxpl = H5Pcreate(H5P_DATASET_XFER);
+        /* Create the dataset transfer property list, collective if asked */
+        h5dxpl = pio_create_dxpl(parms);
         if (h5dxpl < 0) {
         fprintf(stderr, "HDF5 Property List Create failed\n");
         GOTOERROR(FAIL);
         }
-
-        /* Change to collective I/O, if asked */
-        if(parms->collective) {
-            hrc = H5Pset_dxpl_mpio(h5dxpl, H5FD_MPIO_COLLECTIVE);
-            if (hrc < 0) {
-                fprintf(stderr, "HDF5 Property List Set failed\n");
-                GOTOERROR(FAIL);
-            } /* end if */
-        } /* end if */
         break;
     } /* end switch */
 
@@ -880,11 +1036,37 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                 GOTOERROR(FAIL);
             }
             /* 1D dataspace */
-            if (!parms->dim2d){
+            if (parms->append) {
+                /* Appended datasets start empty and grow without limit */
+                hsize_t h5maxdims[1] = {H5S_UNLIMITED};
+
+                if (parms->append_chunk > 0)
+                    h5dims[0] = parms->append_chunk;
+                else if (parms->h5_chunk[0] > 0)
+                    h5dims[0] = parms->h5_chunk[0];
+                else if (parms->h5_use_chunks)
+                    h5dims[0] = blk_size;
+                else
+                    h5dims[0] = buf_size*pio_mpi_nprocs_g;
+                hrc = H5Pset_chunk(h5dcpl, 1, h5dims);
+                if (hrc < 0) {
+                    fprintf(stderr, "HDF5 Property List Set failed\n");
+                    GOTOERROR(FAIL);
+                } /* end if */
+
+                h5dims[0] = 0;
+                h5append_space_id = H5Screate_simple(1, h5dims, h5maxdims);
+                VRFY((h5append_space_id >= 0), "H5Screate_simple");
+            }/* end if */
+            else if (!parms->dim2d){
                 /* Make the dataset chunked if asked */
                 if(parms->h5_use_chunks) {
-                /* Set the chunk size to be the same as the buffer size */
-                h5dims[0] = blk_size;
+                /* Set the chunk size to be the same as the block size
+                 * unless chunk dims were given */
+                if (parms->h5_chunk[0] > 0)
+                    h5dims[0] = MIN(parms->h5_chunk[0], (hsize_t)nbytes);
+                else
+                    h5dims[0] = blk_size;
                 hrc = H5Pset_chunk(h5dcpl, 1, h5dims);
                 if (hrc < 0) {
                     fprintf(stderr, "HDF5 Property List Set failed\n");
@@ -895,9 +1077,16 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
             else{
                 /* 2D dataspace */
                 if(parms->h5_use_chunks) {
-                /* Set the chunk size to be the same as the block size */
-                h5dims[0] = blk_size;
-                h5dims[1] = blk_size;
+                /* Set the chunk size to be the same as the block size
+                 * unless chunk dims were given */
+                if (parms->h5_chunk[0] > 0) {
+                    h5dims[0] = MIN(parms->h5_chunk[0], (hsize_t)snbytes);
+                    h5dims[1] = MIN(parms->h5_chunk[1], (hsize_t)snbytes);
+                } /* end if */
+                else {
+                    h5dims[0] = blk_size;
+                    h5dims[1] = blk_size;
+                } /* end else */
                 hrc = H5Pset_chunk(h5dcpl, 2, h5dims);
                 if (hrc < 0) {
                     fprintf(stderr, "HDF5 Property List Set failed\n");
@@ -906,9 +1095,42 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                 } /* end if */
             }/* end else */
 
+            /* Filters only go on chunked datasets */
+            if (parms->filters && (parms->append || parms->h5_use_chunks)) {
+                hrc = pio_set_filters(h5dcpl, parms);
+                if (hrc < 0) {
+                    fprintf(stderr, "HDF5 Property List Set failed\n");
+                    GOTOERROR(FAIL);
+                } /* end if */
+            } /* end if */
+
+            h5dapl = pio_create_dapl(parms);
+            if (h5dapl < 0) {
+                fprintf(stderr, "HDF5 Property List Create failed\n");
+                GOTOERROR(FAIL);
+            }
+
             sprintf(dname, "Dataset_%ld", ndset);
+#ifdef PIO_THREADS
+            /* the first thread creates the dataset, the others open it */
+            if (pio_mpi_rank_g == 0)
+                h5ds_id = H5DCREATE(fd->h5fd, dname, ELMT_H5_TYPE,
+                    parms->append ? h5append_space_id : h5dset_space_id, h5dcpl,
+                    h5dapl);
+            MPI_Barrier(pio_comm_g);
+            if (pio_mpi_rank_g != 0)
+                h5ds_id = H5DOPEN(fd->h5fd, dname, h5dapl);
+#else
             h5ds_id = H5DCREATE(fd->h5fd, dname, ELMT_H5_TYPE,
-                h5dset_space_id, h5dcpl);
+                parms->append ? h5append_space_id : h5dset_space_id, h5dcpl,
+                h5dapl);
+#endif  /* PIO_THREADS */
+
+            if (parms->append) {
+                hrc = H5Sclose(h5append_space_id);
+                VRFY((hrc >= 0), "H5Sclose");
+                h5append_space_id = -1;
+            } /* end if */
 
             if (h5ds_id < 0) {
                 fprintf(stderr, "HDF5 Dataset Create failed\n");
@@ -921,6 +1143,20 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                 fprintf(stderr, "HDF5 Property List Close failed\n");
                 GOTOERROR(FAIL);
             }
+
+            hrc = H5Pclose(h5dapl);
+            if (hrc < 0) {
+                fprintf(stderr, "HDF5 Property List Close failed\n");
+                GOTOERROR(FAIL);
+            }
+            h5dapl = -1;
+
+            /* Appended datasets change shape under the cache; leave them out */
+            if (parms->model_cache && !parms->append) {
+                hrc = chunk_model_init(&h5model, h5ds_id,
+                    (size_t)(bytes_count / (off_t)buf_size) + 1);
+                VRFY((hrc == SUCCESS), "chunk_model_init");
+            }
             break;
     }
 
@@ -931,6 +1167,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
      * all bytes_count in contiguous.
      */
     nbytes_xfer = 0 ;
+    nbytes_sampled = 0;
 
     /* 1D dataspace */
     if (!parms->dim2d){
@@ -971,7 +1208,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                     /* check if all bytes are written */
                     rc = ((ssize_t)buf_size ==
-                        POSIXWRITE(fd->posixfd, buffer, buf_size));
+                        pio_posix_write(fd->posixfd, buffer, buf_size));
                     VRFY((rc != 0), "POSIXWRITE");
 
                     /* Advance global offset in dataset */
@@ -997,7 +1234,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                         /* check if all bytes are written */
                         rc = ((ssize_t)blk_size ==
-                            POSIXWRITE(fd->posixfd, buf_p, blk_size));
+                            pio_posix_write(fd->posixfd, buf_p, blk_size));
                         VRFY((rc != 0), "POSIXWRITE");
 
                         /* Advance location in buffer */
@@ -1092,7 +1329,7 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                     /* check if all bytes are written */
                     rc = ((ssize_t)nbytes_xfer_advance ==
-                        POSIXWRITE(fd->posixfd, buf_p, nbytes_xfer_advance));
+                        pio_posix_write(fd->posixfd, buf_p, nbytes_xfer_advance));
                     VRFY((rc != 0), "POSIXWRITE");
 
                     /* Advance location in buffer */
@@ -1286,8 +1523,8 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                     /* Loop over portions of the buffer to write */
                     while(nbytes_toxfer>0){
                         /* Perform independent write */
-                        mrc = MPI_File_write_at(fd->mpifd, mpi_offset, buf_p,
-                            (int)nbytes_xfer_advance, MPI_BYTE, &mpi_status);
+                        mrc = pio_file_write_at(fd->mpifd, mpi_offset, buf_p,
+                            nbytes_xfer_advance, FALSE, &mpi_status);
                         VRFY((mrc==MPI_SUCCESS), "MPIO_WRITE");
 
                         /* Advance location in buffer */
@@ -1312,8 +1549,8 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                     VRFY((mrc==MPI_SUCCESS), "MPIO_VIEW");
 
                     /* Perform write */
-                    MPI_File_write_at_all(fd->mpifd, 0, buffer,(int)(buf_size*blk_size),
-                        MPI_BYTE, &mpi_status);
+                    mrc = pio_file_write_at(fd->mpifd, 0, buffer, buf_size*blk_size,
+                        TRUE, &mpi_status);
                     VRFY((mrc==MPI_SUCCESS), "MPIO_WRITE");
 
                     /* Advance global offset in dataset */
@@ -1326,7 +1563,15 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
         case PHDF5:
             /* 1D dataspace */
-            if (!parms->dim2d){
+            if (parms->append){
+            hrc = do_append_step(res, fd, parms, h5ds_id, h5dset_space_id,
+                h5mem_space_id, h5dxpl, nbytes, nbytes_xfer, buffer);
+            VRFY((hrc == SUCCESS), "do_append_step");
+
+            /* Increment number of bytes transferred */
+            nbytes_xfer += buf_size;
+            } /* end if */
+            else if (!parms->dim2d){
             /* Set up the file dset space id to move the selection to process */
             if (!parms->interleaved){
                 /* Contiguous pattern */
@@ -1345,6 +1590,13 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                 h5dset_space_id, h5dxpl, buffer);
             VRFY((hrc >= 0), "H5Dwrite");
 
+            chunk_model_record(&h5model, h5offset);
+
+            if (parms->collective) {
+                hrc = pio_query_mpio(&res->write_modes, h5dxpl);
+                VRFY((hrc == SUCCESS), "pio_query_mpio");
+            }
+
             /* Increment number of bytes transferred */
             nbytes_xfer += buf_size;
             } /* end if */
@@ -1372,6 +1624,13 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
                 h5dset_space_id, h5dxpl, buffer);
             VRFY((hrc >= 0), "H5Dwrite");
 
+            chunk_model_record(&h5model, h5offset);
+
+            if (parms->collective) {
+                hrc = pio_query_mpio(&res->write_modes, h5dxpl);
+                VRFY((hrc == SUCCESS), "pio_query_mpio");
+            }
+
             /* Increment number of bytes transferred */
             nbytes_xfer += buf_size*blk_size;
 
@@ -1379,15 +1638,59 @@ do_write(results *res, file_descr *fd, parameters *parms, long ndsets,
 
             break;
         } /* switch (parms->io_type) */
+
+        /* Count the bytes for the bandwidth sampler */
+        add_sample_bytes(res->timers, (long long)(nbytes_xfer - nbytes_sampled));
+        nbytes_sampled = nbytes_xfer;
     } /* end while */
 
     /* Stop "raw data" write timer */
     set_time(res->timers, HDF5_RAW_WRITE_FIXED_DIMS, TSTOP);
 
+    /* Model the chunk cache outside the timed region */
+    if (parms->io_type == PHDF5) {
+        hrc = chunk_model_replay(&h5model, h5dset_space_id);
+        VRFY((hrc == SUCCESS), "chunk_model_replay");
+    }
+
+    /* Check where this process's first byte landed relative to the file
+     * system stripes.  A process whose region starts inside a stripe shares
+     * that stripe (and its extent lock) with its neighbor. */
+    if (ndset == 1 && parms->stripe_size > 0) {
+        off_t first_byte;           /* File offset of this process's first byte */
+
+        if (parms->io_type == PHDF5) {
+            haddr_t h5addr = H5Dget_offset(h5ds_id);
+
+            /* Chunked datasets have no single base address */
+            if (h5addr == HADDR_UNDEF)
+                first_byte = -1;
+            else
+                first_byte = (off_t)h5addr + posix_file_offset;
+        } /* end if */
+        else
+            first_byte = posix_file_offset;
+
+        res->stripe_unknown = (first_byte < 0);
+        if (first_byte < 0)
+            res->stripe_misaligned = 0;
+        else if ((first_byte % (off_t)parms->stripe_size) != 0)
+            res->stripe_misaligned = 1;
+        else if (parms->interleaved && (blk_size % parms->stripe_size) != 0)
+            /* Every block boundary is a process boundary */
+            res->stripe_misaligned = 1;
+        else
+            res->stripe_misaligned = 0;
+    } /* end if */
+
     /* Calculate write time */
 
     /* Close dataset. Only HDF5 needs to do an explicit close. */
     if (parms->io_type == PHDF5) {
+        res->write_hits += h5model.hits;
+        res->write_misses += h5model.misses;
+        chunk_model_free(&h5model);
+
         hrc = H5Dclose(h5ds_id);
 
         if (hrc < 0) {
@@ -1445,6 +1748,14 @@ done:
     } /* end if */
 
     /* release HDF5 objects */
+    chunk_model_free(&h5model);
+
+    if (h5append_space_id != -1)
+        H5Sclose(h5append_space_id);
+
+    if (h5dapl != -1)
+        H5Pclose(h5dapl);
+
     if (h5dset_space_id != -1) {
     hrc = H5Sclose(h5dset_space_id);
     if (hrc < 0){
@@ -1478,6 +1789,462 @@ done:
     return ret_code;
 }
 
+/*
+ * Function:        do_append_step
+ * Purpose:         Append one transfer buffer of every process to a 1D
+ *                  dataset with unlimited dimension.  Every EXTEND_STEPS
+ *                  steps all processes grow the dataset together with
+ *                  H5Dset_extent, and every FLUSH_STEPS steps the dataset
+ *                  (or the whole file) is flushed.  The time of each step,
+ *                  extension and flush included, goes into the step
+ *                  statistics of RES.
+ * Return:          SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+do_append_step(results *res, file_descr *fd, parameters *parms,
+    hid_t h5ds_id, hid_t h5dset_space_id, hid_t h5mem_space_id, hid_t h5dxpl,
+    off_t nbytes, off_t nbytes_xfer, void *buffer)
+{
+    int         ret_code = SUCCESS;
+    herr_t      hrc;                    /*HDF5 return code              */
+    hsize_t     step_size;              /*bytes appended by one step    */
+    long        step;                   /*index of this step            */
+    hssize_t    h5offset[1];            /*selection offset for the step */
+    double      t;
+
+    step_size = (hsize_t)parms->buf_size * (hsize_t)pio_mpi_nprocs_g;
+    step = (long)(nbytes_xfer / (off_t)parms->buf_size);
+
+    t = MPI_Wtime();
+
+    if ((step % parms->extend_steps) == 0) {
+        hsize_t h5dims[1];
+        hsize_t h5maxdims[1] = {H5S_UNLIMITED};
+
+        h5dims[0] = MIN((hsize_t)(step + parms->extend_steps) * step_size,
+                        (hsize_t)nbytes);
+        hrc = H5Dset_extent(h5ds_id, h5dims);
+        VRFY((hrc >= 0), "H5Dset_extent");
+
+        /* Keep the selection's extent in step with the dataset */
+        hrc = H5Sset_extent_simple(h5dset_space_id, 1, h5dims, h5maxdims);
+        VRFY((hrc >= 0), "H5Sset_extent_simple");
+    } /* end if */
+
+    h5offset[0] = (hssize_t)step * (hssize_t)step_size;
+    hrc = H5Soffset_simple(h5dset_space_id, h5offset);
+    VRFY((hrc >= 0), "H5Soffset_simple");
+
+    hrc = H5Dwrite(h5ds_id, ELMT_H5_TYPE, h5mem_space_id,
+        h5dset_space_id, h5dxpl, buffer);
+    VRFY((hrc >= 0), "H5Dwrite");
+
+    if (parms->collective) {
+        hrc = pio_query_mpio(&res->write_modes, h5dxpl);
+        VRFY((hrc == SUCCESS), "pio_query_mpio");
+    }
+
+    if (parms->flush_steps > 0 && ((step + 1) % parms->flush_steps) == 0) {
+        if (parms->flush_file)
+            hrc = H5Fflush(fd->h5fd, H5F_SCOPE_LOCAL);
+        else
+            hrc = H5Dflush(h5ds_id);
+        VRFY((hrc >= 0), "H5Dflush/H5Fflush");
+    } /* end if */
+
+    t = MPI_Wtime() - t;
+
+    if (res->num_steps == 0 || t < res->step_min)
+        res->step_min = t;
+    if (t > res->step_max)
+        res->step_max = t;
+    res->step_sum += t;
+    res->num_steps++;
+
+done:
+    return ret_code;
+}
+
+/*
+ * Function:        pio_create_dapl
+ * Purpose:         Create the dataset access property list carrying the
+ *                  chunk cache settings of PARMS.  Settings left at their
+ *                  H5D_CHUNK_CACHE_*_DEFAULT values come from the file.
+ * Return:          The property list, or a negative value on failure
+ * Modifications:
+ */
+    static hid_t
+pio_create_dapl(parameters *parms)
+{
+    hid_t       h5dapl;
+
+    h5dapl = H5Pcreate(H5P_DATASET_ACCESS);
+    if (h5dapl < 0)
+        return h5dapl;
+
+    if (H5Pset_chunk_cache(h5dapl, parms->cache_nslots, parms->cache_nbytes,
+            parms->cache_w0) < 0) {
+        H5Pclose(h5dapl);
+        return -1;
+    }
+
+    return h5dapl;
+}
+
+/*
+ * Function:        pio_set_filters
+ * Purpose:         Add the filters of PARMS to the chunked dataset creation
+ *                  property list H5DCPL: shuffle, then deflate, then the
+ *                  Fletcher32 checksum.
+ * Return:          Non-negative on success, negative on failure
+ * Modifications:
+ */
+    static herr_t
+pio_set_filters(hid_t h5dcpl, parameters *parms)
+{
+    if ((parms->filters & PIO_FILTER_SHUFFLE) && H5Pset_shuffle(h5dcpl) < 0)
+        return -1;
+
+    if ((parms->filters & PIO_FILTER_DEFLATE) &&
+            H5Pset_deflate(h5dcpl, (unsigned)parms->deflate_level) < 0)
+        return -1;
+
+    if ((parms->filters & PIO_FILTER_FLETCHER32) && H5Pset_fletcher32(h5dcpl) < 0)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Function:        pio_create_dxpl
+ * Purpose:         Create the dataset transfer property list of PARMS:
+ *                  collective if asked, with the collective chunk I/O and
+ *                  collective buffering settings that were given.
+ * Return:          The property list, or a negative value on failure
+ * Modifications:
+ */
+    static hid_t
+pio_create_dxpl(parameters *parms)
+{
+    hid_t       h5dxpl;
+    herr_t      hrc = 0;
+
+    h5dxpl = H5Pcreate(H5P_DATASET_XFER);
+    if (h5dxpl < 0 || !parms->collective)
+        return h5dxpl;
+
+#ifdef PIO_THREADS
+    /* no MPI-IO driver; parse_command_line turns --collective down */
+    hrc = FAIL;
+#else
+    hrc = H5Pset_dxpl_mpio(h5dxpl, H5FD_MPIO_COLLECTIVE);
+    if (hrc >= 0 && parms->chunk_opt != H5FD_MPIO_CHUNK_DEFAULT)
+        hrc = H5Pset_dxpl_mpio_chunk_opt(h5dxpl,
+            (H5FD_mpio_chunk_opt_t)parms->chunk_opt);
+    if (hrc >= 0 && parms->chunk_opt_num > 0)
+        hrc = H5Pset_dxpl_mpio_chunk_opt_num(h5dxpl,
+            (unsigned)parms->chunk_opt_num);
+    if (hrc >= 0 && parms->chunk_opt_ratio >= 0)
+        hrc = H5Pset_dxpl_mpio_chunk_opt_ratio(h5dxpl,
+            (unsigned)parms->chunk_opt_ratio);
+    if (hrc >= 0 && parms->coll_opt >= 0)
+        hrc = H5Pset_dxpl_mpio_collective_opt(h5dxpl,
+            (H5FD_mpio_collective_opt_t)parms->coll_opt);
+#endif  /* PIO_THREADS */
+
+    if (hrc < 0) {
+        H5Pclose(h5dxpl);
+        return -1;
+    }
+
+    return h5dxpl;
+}
+
+/*
+ * Function:        pio_query_mpio
+ * Purpose:         Count in MODES how the MPI-IO driver actually carried
+ *                  out the transfer just done with H5DXPL, and why it was
+ *                  not collective if it was not.
+ * Return:          SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+pio_query_mpio(mpio_modes *modes, hid_t h5dxpl)
+{
+#ifdef PIO_THREADS
+    (void)modes;
+    (void)h5dxpl;
+    return FAIL;
+#else
+    H5D_mpio_actual_io_mode_t io_mode;
+    H5D_mpio_actual_chunk_opt_mode_t chunk_opt;
+    uint32_t    local_cause, global_cause;
+
+    if (H5Pget_mpio_actual_io_mode(h5dxpl, &io_mode) < 0 ||
+            H5Pget_mpio_actual_chunk_opt_mode(h5dxpl, &chunk_opt) < 0 ||
+            H5Pget_mpio_no_collective_cause(h5dxpl, &local_cause, &global_cause) < 0)
+        return FAIL;
+
+    if ((unsigned)io_mode < sizeof(modes->io_mode) / sizeof(modes->io_mode[0]))
+        modes->io_mode[io_mode]++;
+    if ((unsigned)chunk_opt < sizeof(modes->chunk_opt) / sizeof(modes->chunk_opt[0]))
+        modes->chunk_opt[chunk_opt]++;
+
+    if (io_mode == H5D_MPIO_NO_COLLECTIVE || io_mode == H5D_MPIO_CHUNK_INDEPENDENT ||
+            (local_cause | global_cause) != H5D_MPIO_COLLECTIVE)
+        modes->fallback++;
+    modes->cause |= local_cause | global_cause;
+
+    return SUCCESS;
+#endif  /* PIO_THREADS */
+}
+
+/*
+ * Function:        chunk_model_init
+ * Purpose:         Set MODEL up to follow the raw data chunk cache of the
+ *                  open dataset H5DS_ID.  The library keeps no hit or miss
+ *                  counts, so chunk_model_replay runs every transfer
+ *                  against a copy of the cache: one chunk per hash slot
+ *                  (chunk index modulo nslots), as many chunks as fit into
+ *                  nbytes, least recently used out first.  Chunks larger
+ *                  than the cache are never cached.  Datasets that are not
+ *                  chunked leave MODEL empty.  Room is made for the
+ *                  offsets of NXFERS transfers.
+ * Return:          SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+chunk_model_init(chunk_model *model, hid_t h5ds_id, size_t nxfers)
+{
+    hid_t       h5dcpl = -1, h5dapl = -1, h5space_id = -1;
+    hsize_t     h5dims[2];
+    size_t      nbytes;
+    double      w0;
+    hsize_t     chunk_bytes;
+    herr_t      ret_code = SUCCESS;
+    int         i;
+
+    memset(model, 0, sizeof(*model));
+
+    h5dcpl = H5Dget_create_plist(h5ds_id);
+    VRFY((h5dcpl >= 0), "H5Dget_create_plist");
+    if (H5Pget_layout(h5dcpl) != H5D_CHUNKED)
+        GOTODONE;
+
+    model->rank = H5Pget_chunk(h5dcpl, 2, model->chunk);
+    VRFY((model->rank > 0), "H5Pget_chunk");
+
+    h5space_id = H5Dget_space(h5ds_id);
+    VRFY((h5space_id >= 0), "H5Dget_space");
+    VRFY((H5Sget_simple_extent_dims(h5space_id, h5dims, NULL) == model->rank),
+        "H5Sget_simple_extent_dims");
+
+    h5dapl = H5Dget_access_plist(h5ds_id);
+    VRFY((h5dapl >= 0), "H5Dget_access_plist");
+    VRFY((H5Pget_chunk_cache(h5dapl, &model->nslots, &nbytes, &w0) >= 0),
+        "H5Pget_chunk_cache");
+
+    chunk_bytes = ELMT_SIZE;
+    for (i = 0; i < model->rank; i++) {
+        model->nchunks[i] = (h5dims[i] + model->chunk[i] - 1) / model->chunk[i];
+        chunk_bytes *= model->chunk[i];
+    }
+    model->capacity = (size_t)(nbytes / chunk_bytes);
+    if (model->nslots == 0)
+        model->nslots = 1;
+
+    model->slot = (hsize_t *)calloc(model->nslots, sizeof(hsize_t));
+    model->stamp = (unsigned long *)calloc(model->nslots, sizeof(unsigned long));
+    model->offsets = (hssize_t *)malloc(nxfers * 2 * sizeof(hssize_t));
+    model->noffsets_max = nxfers;
+    VRFY((model->slot && model->stamp && model->offsets), "chunk model allocation");
+
+done:
+    if (h5space_id != -1)
+        H5Sclose(h5space_id);
+    if (h5dapl != -1)
+        H5Pclose(h5dapl);
+    if (h5dcpl != -1)
+        H5Pclose(h5dcpl);
+    if (ret_code != SUCCESS)
+        chunk_model_free(model);
+    return ret_code;
+}
+
+static int
+cmp_hsize(const void *a, const void *b)
+{
+    hsize_t x = *(const hsize_t *)a, y = *(const hsize_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * Function:        chunk_model_record
+ * Purpose:         Note the offset H5OFFSET of a transfer for
+ *                  chunk_model_replay.  Cheap enough for the timed loop.
+ * Return:          Nothing
+ * Modifications:
+ */
+    static void
+chunk_model_record(chunk_model *model, const hssize_t *h5offset)
+{
+    if (model->rank == 0 || model->noffsets == model->noffsets_max)
+        return;
+
+    model->offsets[2 * model->noffsets] = h5offset[0];
+    model->offsets[2 * model->noffsets + 1] = model->rank > 1 ? h5offset[1] : 0;
+    model->noffsets++;
+}
+
+/*
+ * Function:        chunk_model_touch
+ * Purpose:         Look every chunk the NBLOCKS hyperslab blocks BLOCKS,
+ *                  moved by H5OFFSET, touch up in MODEL once and count
+ *                  the hits and misses.
+ * Return:          SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+chunk_model_touch(chunk_model *model, const hsize_t *blocks, size_t nblocks,
+    const hssize_t *h5offset)
+{
+    size_t      ntouched = 0, n, k;
+    herr_t      ret_code = SUCCESS;
+    int         i;
+
+    /* List the chunks under each block, row-major over the chunk grid */
+    for (k = 0; k < nblocks; k++) {
+        const hsize_t *start = blocks + k * 2 * model->rank;
+        const hsize_t *end = start + model->rank;
+        hsize_t lo[2] = {0, 0}, hi[2] = {0, 0}, c0, c1;
+
+        for (i = 0; i < model->rank; i++) {
+            lo[i] = (start[i] + h5offset[i]) / model->chunk[i];
+            hi[i] = (end[i] + h5offset[i]) / model->chunk[i];
+        }
+
+        n = (size_t)((hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1));
+        if (ntouched + n > model->ntouched_max) {
+            hsize_t *touched;
+
+            model->ntouched_max = 2 * (ntouched + n);
+            touched = (hsize_t *)realloc(model->touched,
+                model->ntouched_max * sizeof(hsize_t));
+            VRFY((touched != NULL), "chunk model allocation");
+            model->touched = touched;
+        }
+
+        for (c0 = lo[0]; c0 <= hi[0]; c0++)
+            for (c1 = lo[1]; c1 <= hi[1]; c1++)
+                model->touched[ntouched++] = model->rank == 1 ? c0 :
+                    c0 * model->nchunks[1] + c1;
+    }
+
+    /* The library visits each chunk of a transfer once */
+    qsort(model->touched, ntouched, sizeof(hsize_t), cmp_hsize);
+    model->clock++;
+
+    for (k = 0; k < ntouched; k++) {
+        hsize_t idx = model->touched[k];
+        size_t  s = (size_t)(idx % model->nslots), j, lru;
+
+        if (k > 0 && idx == model->touched[k - 1])
+            continue;
+
+        if (model->slot[s] == idx + 1) {
+            model->hits++;
+            model->stamp[s] = model->clock;
+            continue;
+        }
+
+        model->misses++;
+        if (model->capacity == 0)
+            continue;
+
+        /* A chunk hashing to a taken slot evicts its holder */
+        if (model->slot[s] != 0) {
+            model->slot[s] = 0;
+            model->nused--;
+        }
+
+        while (model->nused >= model->capacity) {
+            for (lru = model->nslots, j = 0; j < model->nslots; j++)
+                if (model->slot[j] != 0 &&
+                        (lru == model->nslots || model->stamp[j] < model->stamp[lru]))
+                    lru = j;
+            model->slot[lru] = 0;
+            model->nused--;
+        }
+
+        model->slot[s] = idx + 1;
+        model->stamp[s] = model->clock;
+        model->nused++;
+    }
+
+done:
+    return ret_code;
+}
+
+/*
+ * Function:        chunk_model_replay
+ * Purpose:         Run the transfers chunk_model_record noted through
+ *                  MODEL, each the hyperslab selection of H5SPACE_ID
+ *                  moved by its offset.  Called after the timers stop.
+ * Return:          SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+chunk_model_replay(chunk_model *model, hid_t h5space_id)
+{
+    hsize_t     *blocks = NULL;
+    hssize_t    nblocks;
+    size_t      k;
+    herr_t      ret_code = SUCCESS;
+
+    if (model->rank == 0 || model->noffsets == 0)
+        return SUCCESS;
+
+    nblocks = H5Sget_select_hyper_nblocks(h5space_id);
+    VRFY((nblocks >= 0), "H5Sget_select_hyper_nblocks");
+    blocks = (hsize_t *)malloc((size_t)nblocks * 2 * (size_t)model->rank * sizeof(hsize_t));
+    VRFY((blocks != NULL), "chunk model allocation");
+    VRFY((H5Sget_select_hyper_blocklist(h5space_id, 0, (hsize_t)nblocks, blocks) >= 0),
+        "H5Sget_select_hyper_blocklist");
+
+    for (k = 0; k < model->noffsets; k++)
+        VRFY((chunk_model_touch(model, blocks, (size_t)nblocks,
+            model->offsets + 2 * k) == SUCCESS), "chunk_model_touch");
+    model->noffsets = 0;
+
+done:
+    free(blocks);
+    return ret_code;
+}
+
+/*
+ * Function:        chunk_model_free
+ * Purpose:         Release what MODEL holds.  Safe to call twice.
+ * Return:          Nothing
+ * Modifications:
+ */
+    static void
+chunk_model_free(chunk_model *model)
+{
+    free(model->slot);
+    free(model->stamp);
+    free(model->touched);
+    free(model->offsets);
+    model->slot = NULL;
+    model->stamp = NULL;
+    model->touched = NULL;
+    model->offsets = NULL;
+    model->ntouched_max = 0;
+    model->noffsets = model->noffsets_max = 0;
+    model->rank = 0;
+}
+
 /*
  * Function:        do_read
  * Purpose:         read the required amount of data from the file.
@@ -1496,6 +2263,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
     size_t      blk_size;       /* The block size to subdivide the xfer buffer into */
     size_t      bsize;          /* Size of the actual buffer */
     off_t       nbytes_xfer;    /* Total number of bytes transferred so far */
+    off_t       nbytes_sampled; /* Bytes counted for the bandwidth sampler */
     size_t      nbytes_xfer_advance; /* Number of bytes transferred in a single I/O operation */
     size_t      nbytes_toxfer;  /* Number of bytes to transfer a particular time */
     char        dname[64];
@@ -1539,6 +2307,10 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
     hsize_t h5start[2];
     hssize_t    h5offset[2];            /* Selection offset within dataspace */
     hid_t       h5dxpl = -1;            /* Dataset transfer property list */
+    hid_t       h5dapl = -1;            /* Dataset access property list */
+    chunk_model h5model;                /* Chunk cache of the open dataset */
+
+    memset(&h5model, 0, sizeof(h5model));
 
     /* Get the parameters from the parameter block */
     blk_size=parms->blk_size;
@@ -1564,6 +2336,10 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         else {
             bytes_begin[0] = (off_t)(blk_size*pio_mpi_rank_g);
         } /* end else */
+
+        /* Appending: each step holds one transfer of every process */
+        if (parms->append && !parms->interleaved)
+            bytes_begin[0] = (off_t)(buf_size*pio_mpi_rank_g);
     }/* end if */
     /* 2D dataspace */
     else {
@@ -1629,8 +2405,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         /* 1D dataspace */
         if (!parms->dim2d){
             /* Build block's derived type */
-            mrc = MPI_Type_contiguous((int)blk_size,
-                MPI_BYTE, &mpi_blk_type);
+            mrc = pio_type_bytes(blk_size, &mpi_blk_type);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Build file's derived type */
@@ -1649,8 +2424,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         /* 2D dataspace */
         else {
             /* Build partial buffer derived type for contiguous access */
-            mrc = MPI_Type_contiguous((int)buf_size, MPI_BYTE,
-                &mpi_partial_buffer_cont);
+            mrc = pio_type_bytes(buf_size, &mpi_partial_buffer_cont);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit partial buffer derived type */
@@ -1667,8 +2441,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build partial buffer derived type for interleaved access */
-            mrc = MPI_Type_contiguous((int)blk_size, MPI_BYTE,
-                &mpi_partial_buffer_inter);
+            mrc = pio_type_bytes(blk_size, &mpi_partial_buffer_inter);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit partial buffer derived type */
@@ -1685,8 +2458,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build full buffer derived type */
-            mrc = MPI_Type_contiguous((int)(blk_size*buf_size), MPI_BYTE,
-                &mpi_full_buffer);
+            mrc = pio_type_bytes(blk_size*buf_size, &mpi_full_buffer);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit full buffer derived type */
@@ -1694,8 +2466,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_COMMIT");
 
             /* Build full chunk derived type */
-            mrc = MPI_Type_contiguous((int)(blk_size*blk_size), MPI_BYTE,
-                &mpi_full_chunk);
+            mrc = pio_type_bytes(blk_size*blk_size, &mpi_full_chunk);
             VRFY((mrc==MPI_SUCCESS), "MPIO_TYPE_CREATE");
 
             /* Commit full chunk derived type */
@@ -1814,21 +2585,12 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         } /* end else */
         } /* end else */
 
-        /* Create the dataset transfer property list */
-        h5dxpl = H5Pcreate(H5P_DATASET_XFER);
+        /* Create the dataset transfer property list, collective if asked */
+        h5dxpl = pio_create_dxpl(parms);
         if (h5dxpl < 0) {
         fprintf(stderr, "HDF5 Property List Create failed\n");
         GOTOERROR(FAIL);
         }
-
-        /* Change to collective I/O, if asked */
-        if(parms->collective) {
-        hrc = H5Pset_dxpl_mpio(h5dxpl, H5FD_MPIO_COLLECTIVE);
-        if (hrc < 0) {
-            fprintf(stderr, "HDF5 Property List Set failed\n");
-            GOTOERROR(FAIL);
-        } /* end if */
-        } /* end if */
         break;
     } /* end switch */
 
@@ -1845,13 +2607,32 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         break;
 
         case PHDF5:
+        h5dapl = pio_create_dapl(parms);
+        if (h5dapl < 0) {
+            fprintf(stderr, "HDF5 Property List Create failed\n");
+            GOTOERROR(FAIL);
+        }
+
         sprintf(dname, "Dataset_%ld", ndset);
-        h5ds_id = H5DOPEN(fd->h5fd, dname);
+        h5ds_id = H5DOPEN(fd->h5fd, dname, h5dapl);
         if (h5ds_id < 0) {
             fprintf(stderr, "HDF5 Dataset open failed\n");
             GOTOERROR(FAIL);
         }
 
+        hrc = H5Pclose(h5dapl);
+        if (hrc < 0) {
+            fprintf(stderr, "HDF5 Property List Close failed\n");
+            GOTOERROR(FAIL);
+        }
+        h5dapl = -1;
+
+        if (parms->model_cache) {
+            hrc = chunk_model_init(&h5model, h5ds_id,
+                (size_t)(bytes_count / (off_t)buf_size) + 1);
+            VRFY((hrc == SUCCESS), "chunk_model_init");
+        }
+
         break;
     }
 
@@ -1862,6 +2643,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
      * all bytes_count in contiguous.
      */
     nbytes_xfer = 0 ;
+    nbytes_sampled = 0;
 
     /* 1D dataspace */
     if (!parms->dim2d){
@@ -1902,7 +2684,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                     /* check if all bytes are read */
                     rc = ((ssize_t)buf_size ==
-                        POSIXREAD(fd->posixfd, buffer, buf_size));
+                        pio_posix_read(fd->posixfd, buffer, buf_size));
                     VRFY((rc != 0), "POSIXREAD");
 
                     /* Advance global offset in dataset */
@@ -1928,7 +2710,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                     /* check if all bytes are read */
                     rc = ((ssize_t)blk_size ==
-                        POSIXREAD(fd->posixfd, buf_p, blk_size));
+                        pio_posix_read(fd->posixfd, buf_p, blk_size));
                     VRFY((rc != 0), "POSIXREAD");
 
                     /* Advance location in buffer */
@@ -2023,7 +2805,7 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
 
                     /* check if all bytes are read */
                     rc = ((ssize_t)nbytes_xfer_advance ==
-                        POSIXREAD(fd->posixfd, buf_p, nbytes_xfer_advance));
+                        pio_posix_read(fd->posixfd, buf_p, nbytes_xfer_advance));
                     VRFY((rc != 0), "POSIXREAD");
 
                     /* Advance location in buffer */
@@ -2216,8 +2998,8 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
                     /* Loop over portions of the buffer to read */
                     while(nbytes_toxfer>0){
                         /* Perform independent read */
-                        mrc = MPI_File_read_at(fd->mpifd, mpi_offset, buf_p,
-                            (int)nbytes_xfer_advance, MPI_BYTE, &mpi_status);
+                        mrc = pio_file_read_at(fd->mpifd, mpi_offset, buf_p,
+                            nbytes_xfer_advance, FALSE, &mpi_status);
                         VRFY((mrc==MPI_SUCCESS), "MPIO_READ");
 
                         /* Advance location in buffer */
@@ -2242,8 +3024,8 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
                     VRFY((mrc==MPI_SUCCESS), "MPIO_VIEW");
 
                     /* Perform read */
-                    MPI_File_read_at_all(fd->mpifd, 0, buffer,(int)(buf_size*blk_size),
-                        MPI_BYTE, &mpi_status);
+                    mrc = pio_file_read_at(fd->mpifd, 0, buffer, buf_size*blk_size,
+                        TRUE, &mpi_status);
                     VRFY((mrc==MPI_SUCCESS), "MPIO_READ");
 
                     /* Advance global offset in dataset */
@@ -2257,12 +3039,13 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             /* 1D dataspace */
             if (!parms->dim2d){
             /* Set up the file dset space id to move the selection to process */
-            if (!parms->interleaved){
+            if (!parms->interleaved && !parms->append){
                 /* Contiguous pattern */
                 h5offset[0] = nbytes_xfer;
             } /* end if */
             else {
-                /* Interleaved access pattern */
+                /* Interleaved access pattern, or one transfer of every
+                 * process per appended step */
                 /* Skip offset over blocks of other processes */
                 h5offset[0] = (nbytes_xfer*pio_mpi_nprocs_g);
             } /* end else */
@@ -2274,6 +3057,13 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
                 h5dset_space_id, h5dxpl, buffer);
             VRFY((hrc >= 0), "H5Dread");
 
+            chunk_model_record(&h5model, h5offset);
+
+            if (parms->collective) {
+                hrc = pio_query_mpio(&res->read_modes, h5dxpl);
+                VRFY((hrc == SUCCESS), "pio_query_mpio");
+            }
+
             /* Increment number of bytes transferred */
             nbytes_xfer += buf_size;
             } /* end if */
@@ -2300,6 +3090,13 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
                 h5dset_space_id, h5dxpl, buffer);
             VRFY((hrc >= 0), "H5Dread");
 
+            chunk_model_record(&h5model, h5offset);
+
+            if (parms->collective) {
+                hrc = pio_query_mpio(&res->read_modes, h5dxpl);
+                VRFY((hrc == SUCCESS), "pio_query_mpio");
+            }
+
             /* Increment number of bytes transferred */
             nbytes_xfer += buf_size*blk_size;
 
@@ -2307,6 +3104,10 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             break;
         } /* switch (parms->io_type) */
 
+        /* Count the bytes for the bandwidth sampler */
+        add_sample_bytes(res->timers, (long long)(nbytes_xfer - nbytes_sampled));
+        nbytes_sampled = nbytes_xfer;
+
         /* Verify raw data, if asked */
         if (parms->verify) {
         /* Verify data read */
@@ -2315,13 +3116,13 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
         int nerror=0;
 
         for (i = 0; i < bsize; ++i){
-            if (*ucharptr++ != pio_mpi_rank_g+1) {
+            if (*ucharptr++ != PIO_VERIFY_BYTE(parms)) {
             if (++nerror < 20){
                 /* report at most 20 errors */
                 HDprint_rank(output);
                 HDfprintf(output, "read data error, expected (%d), "
                     "got (%d)\n",
-                    pio_mpi_rank_g+1,
+                    PIO_VERIFY_BYTE(parms),
                     (int)*(ucharptr-1));
             } /* end if */
             } /* end if */
@@ -2332,6 +3133,10 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
             HDfprintf(output, "total read data errors=%d\n",
                 nerror);
         } /* end if */
+
+        /* a restart that reads back bad data failed */
+        if (nerror > 0 && parms->verify_shared)
+            GOTOERROR(FAIL);
         }   /* if (parms->verify) */
 
     } /* end while */
@@ -2339,10 +3144,20 @@ do_read(results *res, file_descr *fd, parameters *parms, long ndsets,
     /* Stop "raw data" read timer */
     set_time(res->timers, HDF5_RAW_READ_FIXED_DIMS, TSTOP);
 
+    /* Model the chunk cache outside the timed region */
+    if (parms->io_type == PHDF5) {
+        hrc = chunk_model_replay(&h5model, h5dset_space_id);
+        VRFY((hrc == SUCCESS), "chunk_model_replay");
+    }
+
     /* Calculate read time */
 
     /* Close dataset. Only HDF5 needs to do an explicit close. */
     if (parms->io_type == PHDF5) {
+        res->read_hits += h5model.hits;
+        res->read_misses += h5model.misses;
+        chunk_model_free(&h5model);
+
         hrc = H5Dclose(h5ds_id);
 
         if (hrc < 0) {
@@ -2400,6 +3215,11 @@ done:
     } /* end if */
 
     /* release HDF5 objects */
+    chunk_model_free(&h5model);
+
+    if (h5dapl != -1)
+        H5Pclose(h5dapl);
+
     if (h5dset_space_id != -1) {
     hrc = H5Sclose(h5dset_space_id);
     if (hrc < 0){
@@ -2433,6 +3253,400 @@ done:
     return ret_code;
 }
 
+#ifdef H5F_ACC_SWMR_WRITE
+/*
+ * Function:    swmr_create
+ * Purpose:     Create FNAME with NDSETS empty chunked datasets that have an
+ *              unlimited dimension.  With SWMR set, switch the file to
+ *              SWMR writing once the datasets exist.
+ * Return:      The file ID, or -1 on failure
+ * Modifications:
+ */
+    static hid_t
+swmr_create(parameters *parms, hid_t fapl, char *fname, long ndsets,
+    size_t buf_size, int swmr, hid_t *dsets /*out*/)
+{
+    int         ret_code = SUCCESS;
+    hid_t       fid = -1, dcpl = -1, space = -1;
+    hsize_t     h5dims[1] = {0};
+    hsize_t     h5maxdims[1] = {H5S_UNLIMITED};
+    char        dname[64];
+    long        nd;
+    herr_t      hrc;
+
+    fid = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    VRFY((fid >= 0), "H5Fcreate");
+
+    space = H5Screate_simple(1, h5dims, h5maxdims);
+    VRFY((space >= 0), "H5Screate_simple");
+
+    dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    VRFY((dcpl >= 0), "H5Pcreate");
+    h5dims[0] = (parms->append_chunk > 0) ? parms->append_chunk : buf_size;
+    hrc = H5Pset_chunk(dcpl, 1, h5dims);
+    VRFY((hrc >= 0), "H5Pset_chunk");
+
+    for (nd = 0; nd < ndsets; nd++) {
+        sprintf(dname, "Dataset_%ld", nd + 1);
+        dsets[nd] = H5DCREATE(fid, dname, ELMT_H5_TYPE, space, dcpl, H5P_DEFAULT);
+        VRFY((dsets[nd] >= 0), "H5Dcreate");
+    }
+
+    if (swmr) {
+        hrc = H5Fstart_swmr_write(fid);
+        VRFY((hrc >= 0), "H5Fstart_swmr_write");
+    }
+
+done:
+    if (dcpl >= 0)
+        H5Pclose(dcpl);
+    if (space >= 0)
+        H5Sclose(space);
+    if (ret_code != SUCCESS && fid >= 0) {
+        H5Fclose(fid);
+        fid = -1;
+    }
+    return fid;
+}
+
+/*
+ * Function:    swmr_append
+ * Purpose:     Append NBYTES to every dataset, one transfer buffer per
+ *              dataset and step, extending the datasets before every
+ *              step.  With SWMR set, the data is flushed every
+ *              FLUSH_STEPS steps so readers can see it, and STAMPS gets the
+ *              time (since T0) at which each step had been written.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+swmr_append(results *res, parameters *parms, hid_t fid, hid_t *dsets,
+    long ndsets, off_t nbytes, size_t buf_size, void *buffer, int swmr,
+    double t0, double *stamps /*out*/)
+{
+    int         ret_code = SUCCESS;
+    hid_t       mspace = -1, fspace = -1;
+    hsize_t     h5dims[1], h5start[1], h5count[1];
+    long        nsteps = (long)(nbytes / (off_t)buf_size);
+    long        step, nd;
+    double      t, tf;
+    herr_t      hrc;
+
+    h5dims[0] = buf_size;
+    mspace = H5Screate_simple(1, h5dims, NULL);
+    VRFY((mspace >= 0), "H5Screate_simple");
+
+    for (step = 0; step < nsteps; step++) {
+        t = MPI_Wtime();
+
+        for (nd = 0; nd < ndsets; nd++) {
+            /* Readers take the extent as the end of the written data, so
+             * it only ever grows by what is about to be written */
+            h5dims[0] = (hsize_t)(step + 1) * buf_size;
+            hrc = H5Dset_extent(dsets[nd], h5dims);
+            VRFY((hrc >= 0), "H5Dset_extent");
+
+            fspace = H5Dget_space(dsets[nd]);
+            VRFY((fspace >= 0), "H5Dget_space");
+            h5start[0] = (hsize_t)step * buf_size;
+            h5count[0] = buf_size;
+            hrc = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, h5start, NULL,
+                h5count, NULL);
+            VRFY((hrc >= 0), "H5Sselect_hyperslab");
+
+            hrc = H5Dwrite(dsets[nd], ELMT_H5_TYPE, mspace, fspace,
+                H5P_DEFAULT, buffer);
+            VRFY((hrc >= 0), "H5Dwrite");
+
+            hrc = H5Sclose(fspace);
+            fspace = -1;
+            VRFY((hrc >= 0), "H5Sclose");
+        }
+
+        if (!swmr)
+            continue;
+
+        stamps[step] = MPI_Wtime() - t0;
+
+        if (parms->flush_steps > 0 && ((step + 1) % parms->flush_steps) == 0) {
+            tf = MPI_Wtime();
+            if (parms->flush_file) {
+                hrc = H5Fflush(fid, H5F_SCOPE_LOCAL);
+                VRFY((hrc >= 0), "H5Fflush");
+            } else {
+                for (nd = 0; nd < ndsets; nd++) {
+                    hrc = H5Dflush(dsets[nd]);
+                    VRFY((hrc >= 0), "H5Dflush");
+                }
+            }
+            res->swmr_flush += MPI_Wtime() - tf;
+        }
+
+        t = MPI_Wtime() - t;
+
+        if (res->num_steps == 0 || t < res->step_min)
+            res->step_min = t;
+        if (t > res->step_max)
+            res->step_max = t;
+        res->step_sum += t;
+        res->num_steps++;
+    }
+
+done:
+    if (fspace >= 0)
+        H5Sclose(fspace);
+    if (mspace >= 0)
+        H5Sclose(mspace);
+    return ret_code;
+}
+
+/*
+ * Function:    swmr_poll
+ * Purpose:     Follow the last dataset of a file opened for SWMR reading
+ *              until it holds NBYTES.  Every poll refreshes the dataset;
+ *              newly visible steps are read and the time (since T0) at
+ *              which each step showed up goes into SEEN.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+swmr_poll(parameters *parms, hid_t did, off_t nbytes, size_t buf_size,
+    void *buffer, double t0, double *seen /*out*/)
+{
+    int         ret_code = SUCCESS;
+    hid_t       mspace = -1, fspace = -1;
+    hsize_t     h5dims[1], h5start[1], h5count[1];
+    long        nsteps = (long)(nbytes / (off_t)buf_size);
+    long        nseen = 0, visible;
+    double      now, progress = 0.0;
+    struct timespec nap;
+    herr_t      hrc;
+
+    nap.tv_sec = 0;
+    nap.tv_nsec = PIO_SWMR_POLL;
+
+    h5dims[0] = buf_size;
+    mspace = H5Screate_simple(1, h5dims, NULL);
+    VRFY((mspace >= 0), "H5Screate_simple");
+
+    while (nseen < nsteps) {
+        hrc = H5Drefresh(did);
+        VRFY((hrc >= 0), "H5Drefresh");
+
+        fspace = H5Dget_space(did);
+        VRFY((fspace >= 0), "H5Dget_space");
+        hrc = H5Sget_simple_extent_dims(fspace, h5dims, NULL);
+        VRFY((hrc >= 0), "H5Sget_simple_extent_dims");
+
+        now = MPI_Wtime() - t0;
+
+        visible = (long)(h5dims[0] / buf_size);
+        if (visible > nsteps)
+            visible = nsteps;
+
+        if (visible <= nseen) {
+            hrc = H5Sclose(fspace);
+            fspace = -1;
+            VRFY((hrc >= 0), "H5Sclose");
+
+            if (now - progress > PIO_SWMR_TIMEOUT) {
+                fprintf(stderr, "SWMR reader saw no progress for %.0f seconds\n",
+                        PIO_SWMR_TIMEOUT);
+                GOTOERROR(FAIL);
+            }
+
+            /* don't spin on the file's metadata while the writer works */
+            nanosleep(&nap, NULL);
+            continue;
+        }
+
+        for (; nseen < visible; nseen++) {
+            seen[nseen] = now;
+
+            h5start[0] = (hsize_t)nseen * buf_size;
+            h5count[0] = buf_size;
+            hrc = H5Sselect_hyperslab(fspace, H5S_SELECT_SET, h5start, NULL,
+                h5count, NULL);
+            VRFY((hrc >= 0), "H5Sselect_hyperslab");
+
+            hrc = H5Dread(did, ELMT_H5_TYPE, mspace, fspace, H5P_DEFAULT,
+                buffer);
+            VRFY((hrc >= 0), "H5Dread");
+
+            if (parms->verify) {
+                size_t i;
+
+                for (i = 0; i < buf_size; i++)
+                    if (((unsigned char *)buffer)[i] != 1) {
+                        fprintf(stderr, "SWMR reader found bad data at "
+                                "%" H5_PRINTF_LL_WIDTH "d\n",
+                                (long long)(h5start[0] + i));
+                        GOTOERROR(FAIL);
+                    }
+            }
+        }
+
+        progress = now;
+
+        hrc = H5Sclose(fspace);
+        fspace = -1;
+        VRFY((hrc >= 0), "H5Sclose");
+    }
+
+done:
+    if (fspace >= 0)
+        H5Sclose(fspace);
+    if (mspace >= 0)
+        H5Sclose(mspace);
+    return ret_code;
+}
+#endif  /* H5F_ACC_SWMR_WRITE */
+
+/*
+ * Function:    do_swmr
+ * Purpose:     Single-writer/multiple-reader measurement.  Process 0 of
+ *              pio_comm_g appends NBYTES to each of NDSETS datasets, first
+ *              to a plain file and then to a file in SWMR write mode,
+ *              while all other processes open the SWMR file for reading
+ *              and follow it with H5Drefresh.  SWMR needs a driver that
+ *              does not share the file among processes, so both sides use
+ *              the sec2 driver.  RES gets the writer times, the part spent
+ *              in flushes, and for readers the time from the write of a
+ *              step until it became visible.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+    static herr_t
+do_swmr(results *res, parameters *parms, char *fname, long ndsets,
+    off_t nbytes, size_t buf_size, void *buffer)
+{
+    int         ret_code = SUCCESS;
+#ifdef H5F_ACC_SWMR_WRITE
+    int         writer = (pio_mpi_rank_g == 0);
+    long        nsteps = (long)(nbytes / (off_t)buf_size);
+    long        step, nd;
+    hid_t       fapl = -1, fid = -1;
+    hid_t      *dsets = NULL;
+    double     *stamps = NULL;      /* when each step had been written */
+    double     *seen = NULL;        /* when a reader saw each step     */
+    double      t, t0;
+    char        dname[64];
+    int         mrc;
+    herr_t      hrc;
+
+    dsets = (hid_t *)malloc((size_t)(ndsets > 0 ? ndsets : 1) * sizeof(hid_t));
+    stamps = (double *)calloc((size_t)(nsteps > 0 ? nsteps : 1), sizeof(double));
+    seen = (double *)calloc((size_t)(nsteps > 0 ? nsteps : 1), sizeof(double));
+    VRFY((dsets && stamps && seen), "malloc");
+    for (nd = 0; nd < ndsets; nd++)
+        dsets[nd] = -1;
+
+    if (parms->verify)
+        memset(buffer, 1, buf_size);
+
+    fapl = H5Pcreate(H5P_FILE_ACCESS);
+    VRFY((fapl >= 0), "H5Pcreate");
+    hrc = H5Pset_fapl_sec2(fapl);
+    VRFY((hrc >= 0), "H5Pset_fapl_sec2");
+    hrc = H5Pset_libver_bounds(fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    VRFY((hrc >= 0), "H5Pset_libver_bounds");
+    hrc = H5Pset_alignment(fapl, parms->h5_thresh, parms->h5_align);
+    VRFY((hrc >= 0), "H5Pset_alignment");
+
+    /* The writer first runs alone without SWMR, for comparison */
+    if (writer) {
+        t = MPI_Wtime();
+        fid = swmr_create(parms, fapl, fname, ndsets, buf_size, FALSE, dsets);
+        VRFY((fid >= 0), "swmr_create");
+        hrc = swmr_append(res, parms, fid, dsets, ndsets, nbytes, buf_size,
+            buffer, FALSE, 0.0, stamps);
+        VRFY((hrc == SUCCESS), "swmr_append");
+        for (nd = 0; nd < ndsets; nd++) {
+            H5Dclose(dsets[nd]);
+            dsets[nd] = -1;
+        }
+        hrc = H5Fclose(fid);
+        fid = -1;
+        VRFY((hrc >= 0), "H5Fclose");
+        res->swmr_plain += MPI_Wtime() - t;
+
+        /* then sets up the file in SWMR write mode */
+        t = MPI_Wtime();
+        fid = swmr_create(parms, fapl, fname, ndsets, buf_size, TRUE, dsets);
+        VRFY((fid >= 0), "swmr_create");
+        res->swmr_write += MPI_Wtime() - t;
+    }
+
+    /* Readers may only open the file once it is in SWMR write mode */
+    mrc = MPI_Barrier(pio_comm_g);
+    VRFY((mrc == MPI_SUCCESS), "MPI_Barrier");
+
+    if (!writer) {
+        fid = H5Fopen(fname, H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, fapl);
+        VRFY((fid >= 0), "H5Fopen");
+        sprintf(dname, "Dataset_%ld", ndsets);
+        dsets[0] = H5DOPEN(fid, dname, H5P_DEFAULT);
+        VRFY((dsets[0] >= 0), "H5Dopen");
+    }
+
+    mrc = MPI_Barrier(pio_comm_g);
+    VRFY((mrc == MPI_SUCCESS), "MPI_Barrier");
+    t0 = MPI_Wtime();
+
+    if (writer) {
+        hrc = swmr_append(res, parms, fid, dsets, ndsets, nbytes, buf_size,
+            buffer, TRUE, t0, stamps);
+        VRFY((hrc == SUCCESS), "swmr_append");
+        for (nd = 0; nd < ndsets; nd++) {
+            H5Dclose(dsets[nd]);
+            dsets[nd] = -1;
+        }
+        hrc = H5Fclose(fid);
+        fid = -1;
+        VRFY((hrc >= 0), "H5Fclose");
+        res->swmr_write += MPI_Wtime() - t0;
+    } else if (ndsets > 0) {
+        hrc = swmr_poll(parms, dsets[0], nbytes, buf_size, buffer, t0, seen);
+        VRFY((hrc == SUCCESS), "swmr_poll");
+    }
+
+    /* Readers compare what they saw against when it was written */
+    mrc = MPI_Bcast(stamps, (int)nsteps, MPI_DOUBLE, 0, pio_comm_g);
+    VRFY((mrc == MPI_SUCCESS), "MPI_Bcast");
+
+    if (!writer && ndsets > 0) {
+        for (step = 0; step < nsteps; step++) {
+            t = seen[step] - stamps[step];
+
+            /* clocks of different nodes are only as close as the barrier */
+            if (t < 0.0)
+                t = 0.0;
+            if (res->num_seen == 0 || t < res->seen_min)
+                res->seen_min = t;
+            if (t > res->seen_max)
+                res->seen_max = t;
+            res->seen_sum += t;
+            res->num_seen++;
+        }
+    }
+
+done:
+    if (dsets) {
+        for (nd = 0; nd < ndsets; nd++)
+            if (dsets[nd] >= 0)
+                H5Dclose(dsets[nd]);
+    }
+    if (fid >= 0)
+        H5Fclose(fid);
+    if (fapl >= 0)
+        H5Pclose(fapl);
+    free(dsets);
+    free(stamps);
+    free(seen);
+#endif  /* H5F_ACC_SWMR_WRITE */
+    return ret_code;
+}
+
 /*
  * Function:    do_fopen
  * Purpose:     Open the specified file.
@@ -2445,6 +3659,7 @@ do_fopen(parameters *param, char *fname, file_descr *fd /*out*/, int flags)
 {
     int ret_code = SUCCESS, mrc;
     hid_t acc_tpl = -1;         /* file access templates */
+    herr_t hrc;
 
     switch (param->io_type) {
         case POSIXIO:
@@ -2505,8 +3720,23 @@ do_fopen(parameters *param, char *fname, file_descr *fd /*out*/, int flags)
                 GOTOERROR(FAIL);
             }
 
-            /* Set the file driver to the MPI-IO driver */
-            if (H5Pset_fapl_mpio(acc_tpl, pio_comm_g, h5_io_info_g) < 0) {
+            /* Set the file driver, the MPI-IO driver unless told otherwise */
+            switch (param->h5_driver) {
+                case PIO_DRIVER_SEC2:
+                    hrc = H5Pset_fapl_sec2(acc_tpl);
+                    break;
+                case PIO_DRIVER_CORE:
+                    hrc = H5Pset_fapl_core(acc_tpl, PIO_CORE_INCREMENT, TRUE);
+                    break;
+                default:
+#ifdef PIO_THREADS
+                    hrc = FAIL;
+#else
+                    hrc = H5Pset_fapl_mpio(acc_tpl, pio_comm_g, h5_io_info_g);
+#endif  /* PIO_THREADS */
+                    break;
+            }
+            if (hrc < 0) {
                 fprintf(stderr, "HDF5 Property List Set failed\n");
                 GOTOERROR(FAIL);
             }
@@ -2518,8 +3748,21 @@ do_fopen(parameters *param, char *fname, file_descr *fd /*out*/, int flags)
             }
 
             /* create the parallel file */
+#ifdef PIO_THREADS
+            /* The threads share one file: the first creates it and the
+             * others open it, which HDF5 turns into the same open file */
+            if (flags & (PIO_CREATE | PIO_WRITE)) {
+                fd->h5fd = -1;
+                if (pio_mpi_rank_g == 0)
+                    fd->h5fd = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, acc_tpl);
+                MPI_Barrier(pio_comm_g);
+                if (pio_mpi_rank_g != 0)
+                    fd->h5fd = H5Fopen(fname, H5F_ACC_RDWR, acc_tpl);
+            }
+#else
             if (flags & (PIO_CREATE | PIO_WRITE))
                 fd->h5fd = H5Fcreate(fname, H5F_ACC_TRUNC, H5P_DEFAULT, acc_tpl);
+#endif  /* PIO_THREADS */
             else
                 fd->h5fd = H5Fopen(fname, H5F_ACC_RDONLY, acc_tpl);
             if (fd->h5fd < 0) {
@@ -2602,7 +3845,7 @@ done:
  * Programmer:  Albert Cheng 2001/12/12
  * Modifications:
  */
-    static void
+    void
 do_cleanupfile(iotype iot, char *fname)
 {
     if (pio_mpi_rank_g != 0)
@@ -2624,6 +3867,222 @@ do_cleanupfile(iotype iot, char *fname)
     }
 }
 
+/*
+ * Function:    pio_type_bytes
+ * Purpose:     Build an (uncommitted) datatype describing NBYTES contiguous
+ *              bytes.  Sizes that do not fit in an int are built from
+ *              PIO_TYPE_PIECE sized pieces plus a remainder.
+ * Return:      MPI_SUCCESS or an MPI error code
+ * Modifications:
+ */
+    static int
+pio_type_bytes(size_t nbytes, MPI_Datatype *newtype)
+{
+#ifdef PIO_HAVE_MPI_LARGE_COUNT
+    return MPI_Type_contiguous_c((MPI_Count)nbytes, MPI_BYTE, newtype);
+#else
+    MPI_Datatype piece, pieces, rest, types[2];
+    int          blocklens[2] = {1, 1};
+    MPI_Aint     displs[2];
+    size_t       npieces;
+    int          mrc;
+
+    if (nbytes <= INT_MAX)
+        return MPI_Type_contiguous((int)nbytes, MPI_BYTE, newtype);
+
+    npieces = nbytes / PIO_TYPE_PIECE;
+
+    if ((mrc = MPI_Type_contiguous((int)PIO_TYPE_PIECE, MPI_BYTE, &piece)) != MPI_SUCCESS)
+        return mrc;
+    mrc = MPI_Type_contiguous((int)npieces, piece, &pieces);
+    MPI_Type_free(&piece);
+    if (mrc != MPI_SUCCESS)
+        return mrc;
+
+    /* Whole number of pieces */
+    if ((nbytes % PIO_TYPE_PIECE) == 0) {
+        *newtype = pieces;
+        return MPI_SUCCESS;
+    }
+
+    mrc = MPI_Type_contiguous((int)(nbytes % PIO_TYPE_PIECE), MPI_BYTE, &rest);
+    if (mrc != MPI_SUCCESS) {
+        MPI_Type_free(&pieces);
+        return mrc;
+    }
+
+    types[0] = pieces;
+    types[1] = rest;
+    displs[0] = 0;
+    displs[1] = (MPI_Aint)(npieces * PIO_TYPE_PIECE);
+    mrc = MPI_Type_create_struct(2, blocklens, displs, types, newtype);
+
+    MPI_Type_free(&pieces);
+    MPI_Type_free(&rest);
+    return mrc;
+#endif  /* PIO_HAVE_MPI_LARGE_COUNT */
+}
+
+/*
+ * Function:    pio_file_write_at
+ * Purpose:     Write NBYTES bytes at OFFSET (relative to the current file
+ *              view), independently or collectively.  Transfers of more
+ *              than INT_MAX bytes use the large-count bindings where
+ *              available and a single derived-type element otherwise.
+ * Return:      MPI_SUCCESS or an MPI error code
+ * Modifications:
+ */
+    int
+pio_file_write_at(MPI_File fh, MPI_Offset offset, void *buf, size_t nbytes,
+    int collective, MPI_Status *status)
+{
+    MPI_Datatype type;
+    int          mrc;
+
+#ifdef PIO_HAVE_MPI_LARGE_COUNT
+    if (nbytes > INT_MAX) {
+        if (collective)
+            return MPI_File_write_at_all_c(fh, offset, buf, (MPI_Count)nbytes,
+                MPI_BYTE, status);
+        return MPI_File_write_at_c(fh, offset, buf, (MPI_Count)nbytes,
+            MPI_BYTE, status);
+    }
+#endif  /* PIO_HAVE_MPI_LARGE_COUNT */
+
+    if (nbytes <= INT_MAX) {
+        if (collective)
+            return MPI_File_write_at_all(fh, offset, buf, (int)nbytes,
+                MPI_BYTE, status);
+        return MPI_File_write_at(fh, offset, buf, (int)nbytes, MPI_BYTE,
+            status);
+    }
+
+    if ((mrc = pio_type_bytes(nbytes, &type)) != MPI_SUCCESS)
+        return mrc;
+    if ((mrc = MPI_Type_commit(&type)) == MPI_SUCCESS) {
+        if (collective)
+            mrc = MPI_File_write_at_all(fh, offset, buf, 1, type, status);
+        else
+            mrc = MPI_File_write_at(fh, offset, buf, 1, type, status);
+    }
+    MPI_Type_free(&type);
+
+    return mrc;
+}
+
+/*
+ * Function:    pio_file_read_at
+ * Purpose:     Read counterpart of pio_file_write_at.
+ * Return:      MPI_SUCCESS or an MPI error code
+ * Modifications:
+ */
+    int
+pio_file_read_at(MPI_File fh, MPI_Offset offset, void *buf, size_t nbytes,
+    int collective, MPI_Status *status)
+{
+    MPI_Datatype type;
+    int          mrc;
+
+#ifdef PIO_HAVE_MPI_LARGE_COUNT
+    if (nbytes > INT_MAX) {
+        if (collective)
+            return MPI_File_read_at_all_c(fh, offset, buf, (MPI_Count)nbytes,
+                MPI_BYTE, status);
+        return MPI_File_read_at_c(fh, offset, buf, (MPI_Count)nbytes,
+            MPI_BYTE, status);
+    }
+#endif  /* PIO_HAVE_MPI_LARGE_COUNT */
+
+    if (nbytes <= INT_MAX) {
+        if (collective)
+            return MPI_File_read_at_all(fh, offset, buf, (int)nbytes,
+                MPI_BYTE, status);
+        return MPI_File_read_at(fh, offset, buf, (int)nbytes, MPI_BYTE,
+            status);
+    }
+
+    if ((mrc = pio_type_bytes(nbytes, &type)) != MPI_SUCCESS)
+        return mrc;
+    if ((mrc = MPI_Type_commit(&type)) == MPI_SUCCESS) {
+        if (collective)
+            mrc = MPI_File_read_at_all(fh, offset, buf, 1, type, status);
+        else
+            mrc = MPI_File_read_at(fh, offset, buf, 1, type, status);
+    }
+    MPI_Type_free(&type);
+
+    return mrc;
+}
+
+/*
+ * Function:    pio_posix_write
+ * Purpose:     Write all NBYTES bytes, looping over partial writes (Linux
+ *              moves at most 2GB less a page per write call) and
+ *              retrying interrupted calls.
+ * Return:      Number of bytes written, or -1 on error.
+ * Modifications:
+ */
+    static ssize_t
+pio_posix_write(int fd, const void *buf, size_t nbytes)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t  left = nbytes;
+    ssize_t n;
+
+    while (left > 0) {
+        n = POSIXWRITE(fd, p, left);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        /* no progress; let the caller see the short count */
+        if (n == 0)
+            break;
+
+        p += n;
+        left -= (size_t)n;
+    }
+
+    return (ssize_t)(nbytes - left);
+}
+
+/*
+ * Function:    pio_posix_read
+ * Purpose:     Read NBYTES bytes, looping over partial reads.
+ * Return:      Number of bytes read (short only at end of file), or -1 on
+ *              error.
+ * Modifications:
+ */
+    static ssize_t
+pio_posix_read(int fd, void *buf, size_t nbytes)
+{
+    unsigned char *p = (unsigned char *)buf;
+    size_t  left = nbytes;
+    ssize_t n;
+
+    while (left > 0) {
+        n = POSIXREAD(fd, p, left);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        /* end of file */
+        if (n == 0)
+            break;
+
+        p += n;
+        left -= (size_t)n;
+    }
+
+    return (ssize_t)(nbytes - left);
+}
+
 #ifdef TIME_MPI
 /* instrument the MPI_File_wrirte_xxx and read_xxx calls to measure
  * pure time spent in MPI_File code.
@@ -58,16 +58,25 @@
  */
 
 /* system header files */
+#include <float.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/xattr.h>
+#endif  /* __linux__ */
 
 #include "hdf5.h"
 
-#ifdef H5_HAVE_PARALLEL
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
 
 /* library header files */
+#ifdef PIO_THREADS
+#include "pio_thread.h"
+#else
 #include <mpi.h>
+#endif  /* PIO_THREADS */
 
 /* our header files */
 #include "pio_perf.h"
@@ -83,6 +92,43 @@
 #define PIO_MPI             0x2
 #define PIO_HDF5            0x4
 
+#ifndef MIN
+#   define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif  /* !MIN */
+
+#ifndef MAX
+#   define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif  /* !MAX */
+
+/* concurrent process groups */
+#define PIO_MAX_GROUPS      64
+#define PIO_GROUP_WRITE     0x1
+#define PIO_GROUP_READ      0x2
+
+/* most chunk to transfer size ratios in one --chunk-sweep */
+#define PIO_MAX_RATIOS      32
+
+/* checkpoint/restart: most reader counts and the scaling modes */
+#define PIO_MAX_RESTARTS    32
+#define PIO_SCALE_STRONG    0x1
+#define PIO_SCALE_WEAK      0x2
+
+/* most values in one sweep schedule */
+#define PIO_MAX_SCHED       256
+
+/* --workload files: most phases, most options per phase, what they do */
+#define PIO_MAX_PHASES      64
+#define PIO_MAX_PHASE_ARGS  64
+#define PIO_PHASE_READWRITE 0
+#define PIO_PHASE_WRITE     1
+#define PIO_PHASE_READ      2
+
+/* Causes of broken collective I/O that HDF5 1.10.2 added */
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 10 || \
+        (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 2)))
+#   define PIO_HAVE_FILTER_CAUSES  1
+#endif
+
 /* report 0.0 in case t is zero too */
 #define MB_PER_SEC(bytes,t) (((t)==0.0) ? 0.0 : ((((double)bytes) / ONE_MB) / (t)))
 
@@ -94,13 +140,21 @@
 #endif  /* FALSE */
 
 /* global variables */
-FILE       *output;             /* output file                          */
-int         comm_world_rank_g;  /* my rank in MPI_COMM_RANK             */
-int         comm_world_nprocs_g;/* num. of processes of MPI_COMM_WORLD  */
-MPI_Comm    pio_comm_g;         /* Communicator to run the PIO          */
-int         pio_mpi_rank_g;     /* MPI rank of pio_comm_g               */
-int         pio_mpi_nprocs_g;   /* Number of processes of pio_comm_g    */
-int         pio_debug_level = 0;/* The debug level:
+PIO_TLS FILE *output;           /* output file                          */
+PIO_TLS int comm_world_rank_g;  /* my rank in MPI_COMM_RANK             */
+PIO_TLS int comm_world_nprocs_g;/* num. of processes of MPI_COMM_WORLD  */
+
+/* communicators of the process counts of a sweep, split once each */
+static PIO_TLS struct {
+    int num_procs;
+    MPI_Comm comm;              /* MPI_COMM_NULL if not one of them     */
+} comm_cache_g[PIO_MAX_SCHED + PIO_MAX_RESTARTS];
+static PIO_TLS int num_comms_g = 0;
+PIO_TLS MPI_Comm pio_comm_g;    /* Communicator to run the PIO          */
+PIO_TLS int pio_mpi_rank_g;     /* MPI rank of pio_comm_g               */
+PIO_TLS int pio_mpi_nprocs_g;   /* Number of processes of pio_comm_g    */
+static PIO_TLS int bad_arg_g;   /* argv index parse_command_line stopped at */
+PIO_TLS int pio_debug_level = 0;/* The debug level:
                                  *   0 - Off
                                  *   1 - Minimal
                                  *   2 - Some more
@@ -117,7 +171,7 @@ static const char  *progname = "h5perf";
  * adding more, make sure that they don't clash with each other.
  */
 #if 1
-static const char *s_opts = "a:A:B:cCd:D:e:F:ghi:Imno:p:P:stT:wx:X:";
+static const char *s_opts = "a:A:B:cCd:D:e:E:f:F:gG:hH:i:Ij:J:k:K:l:LmM:nN:o:O:p:P:q:Q:r:R:sS:tT:u:U:v:V:wWx:X:yY:z:Z:";
 #else
 static const char *s_opts = "a:A:bB:cCd:D:e:F:ghi:Imno:p:P:stT:wx:X:";
 #endif  /* 1 */
@@ -126,6 +180,15 @@ static struct long_options l_opts[] = {
     { "alig", require_arg, 'a' },
     { "ali", require_arg, 'a' },
     { "al", require_arg, 'a' },
+    { "append-chunk", require_arg, 'z' },
+    { "append-chun", require_arg, 'z' },
+    { "append-chu", require_arg, 'z' },
+    { "append-ch", require_arg, 'z' },
+    { "append-c", require_arg, 'z' },
+    { "append", no_arg, 'y' },
+    { "appen", no_arg, 'y' },
+    { "appe", no_arg, 'y' },
+    { "app", no_arg, 'y' },
     { "api", require_arg, 'A' },
     { "ap", require_arg, 'A' },
 #if 0
@@ -136,6 +199,7 @@ static struct long_options l_opts[] = {
     { "bin", no_arg, 'b' },
     { "bi", no_arg, 'b' },
 #endif  /* 0 */
+    { "blocks", require_arg, 'Y' },
     { "block-size", require_arg, 'B' },
     { "block-siz", require_arg, 'B' },
     { "block-si", require_arg, 'B' },
@@ -145,10 +209,38 @@ static struct long_options l_opts[] = {
     { "bloc", require_arg, 'B' },
     { "blo", require_arg, 'B' },
     { "bl", require_arg, 'B' },
+    { "chunk-cache", require_arg, 'j' },
+    { "chunk-cach", require_arg, 'j' },
+    { "chunk-cac", require_arg, 'j' },
+    { "chunk-ca", require_arg, 'j' },
+    { "chunk-c", require_arg, 'j' },
+    { "chunk-opt-num", require_arg, 'N' },
+    { "chunk-opt-nu", require_arg, 'N' },
+    { "chunk-opt-n", require_arg, 'N' },
+    { "chunk-opt-ratio", require_arg, 'R' },
+    { "chunk-opt-rati", require_arg, 'R' },
+    { "chunk-opt-rat", require_arg, 'R' },
+    { "chunk-opt-ra", require_arg, 'R' },
+    { "chunk-opt-r", require_arg, 'R' },
+    { "chunk-opt", require_arg, 'O' },
+    { "chunk-op", require_arg, 'O' },
+    { "chunk-o", require_arg, 'O' },
+    { "chunk-dims", require_arg, 'K' },
+    { "chunk-dim", require_arg, 'K' },
+    { "chunk-di", require_arg, 'K' },
+    { "chunk-d", require_arg, 'K' },
+    { "chunk-sweep", require_arg, 'J' },
+    { "chunk-swee", require_arg, 'J' },
+    { "chunk-swe", require_arg, 'J' },
+    { "chunk-sw", require_arg, 'J' },
+    { "chunk-s", require_arg, 'J' },
     { "chunk", no_arg, 'c' },
     { "chun", no_arg, 'c' },
     { "chu", no_arg, 'c' },
     { "ch", no_arg, 'c' },
+    { "collective-opt", require_arg, 'Q' },
+    { "collective-op", require_arg, 'Q' },
+    { "collective-o", require_arg, 'Q' },
     { "collective", no_arg, 'C' },
     { "collectiv", no_arg, 'C' },
     { "collecti", no_arg, 'C' },
@@ -157,11 +249,50 @@ static struct long_options l_opts[] = {
     { "colle", no_arg, 'C' },
     { "coll", no_arg, 'C' },
     { "col", no_arg, 'C' },
+    { "compare", require_arg, 'v' },
+    { "compar", require_arg, 'v' },
+    { "compa", require_arg, 'v' },
+    { "comp", require_arg, 'v' },
+    { "com", require_arg, 'v' },
     { "co", no_arg, 'C' },
+    { "dsets", require_arg, 'Z' },
+    { "dset", require_arg, 'Z' },
+    { "dse", require_arg, 'Z' },
+    { "ds", require_arg, 'Z' },
     { "debug", require_arg, 'D' },
     { "debu", require_arg, 'D' },
     { "deb", require_arg, 'D' },
     { "de", require_arg, 'D' },
+    /* no short name either */
+    { "driver", require_arg, '@' },
+    { "drive", require_arg, '@' },
+    { "driv", require_arg, '@' },
+    { "dri", require_arg, '@' },
+    { "dr", require_arg, '@' },
+    { "extend-steps", require_arg, 'E' },
+    { "extend-step", require_arg, 'E' },
+    { "extend-ste", require_arg, 'E' },
+    { "extend-st", require_arg, 'E' },
+    { "extend-s", require_arg, 'E' },
+    { "extend", require_arg, 'E' },
+    { "exten", require_arg, 'E' },
+    { "exte", require_arg, 'E' },
+    { "ext", require_arg, 'E' },
+    { "filters", require_arg, 'H' },
+    { "filter", require_arg, 'H' },
+    { "filte", require_arg, 'H' },
+    { "filt", require_arg, 'H' },
+    { "fil", require_arg, 'H' },
+    { "fi", require_arg, 'H' },
+    { "flush-steps", require_arg, 'f' },
+    { "flush-step", require_arg, 'f' },
+    { "flush-ste", require_arg, 'f' },
+    { "flush-st", require_arg, 'f' },
+    { "flush-s", require_arg, 'f' },
+    { "flush-file", no_arg, 'L' },
+    { "flush-fil", no_arg, 'L' },
+    { "flush-fi", no_arg, 'L' },
+    { "flush-f", no_arg, 'L' },
     { "geometry", no_arg, 'g' },
     { "geometr", no_arg, 'g' },
     { "geomet", no_arg, 'g' },
@@ -169,6 +300,11 @@ static struct long_options l_opts[] = {
     { "geom", no_arg, 'g' },
     { "geo", no_arg, 'g' },
     { "ge", no_arg, 'g' },
+    { "groups", require_arg, 'G' },
+    { "group", require_arg, 'G' },
+    { "grou", require_arg, 'G' },
+    { "gro", require_arg, 'G' },
+    { "gr", require_arg, 'G' },
     { "help", no_arg, 'h' },
     { "hel", no_arg, 'h' },
     { "he", no_arg, 'h' },
@@ -246,6 +382,48 @@ static struct long_options l_opts[] = {
     { "outp", require_arg, 'o' },
     { "out", require_arg, 'o' },
     { "ou", require_arg, 'o' },
+    { "procs", require_arg, 'M' },
+    { "proc", require_arg, 'M' },
+    { "pro", require_arg, 'M' },
+    { "pr", require_arg, 'M' },
+    { "replay-mode", require_arg, 'q' },
+    { "replay-mod", require_arg, 'q' },
+    { "replay-mo", require_arg, 'q' },
+    { "replay-m", require_arg, 'q' },
+    { "replay", require_arg, 'U' },
+    { "repla", require_arg, 'U' },
+    { "repl", require_arg, 'U' },
+    { "rep", require_arg, 'U' },
+    { "restart", require_arg, 'r' },
+    { "restar", require_arg, 'r' },
+    { "resta", require_arg, 'r' },
+    { "rest", require_arg, 'r' },
+    { "res", require_arg, 'r' },
+    { "re", require_arg, 'r' },
+    /* no short name, the letters have run out */
+    { "sample", require_arg, '#' },
+    { "sampl", require_arg, '#' },
+    { "samp", require_arg, '#' },
+    { "sam", require_arg, '#' },
+    { "sa", require_arg, '#' },
+    { "scaling", require_arg, 'u' },
+    { "scalin", require_arg, 'u' },
+    { "scali", require_arg, 'u' },
+    { "scal", require_arg, 'u' },
+    { "sca", require_arg, 'u' },
+    { "sc", require_arg, 'u' },
+    { "stripe-size", require_arg, 'S' },
+    { "stripe-siz", require_arg, 'S' },
+    { "stripe-si", require_arg, 'S' },
+    { "stripe-s", require_arg, 'S' },
+    { "stripe-count", require_arg, 'k' },
+    { "stripe-coun", require_arg, 'k' },
+    { "stripe-cou", require_arg, 'k' },
+    { "stripe-co", require_arg, 'k' },
+    { "stripe-c", require_arg, 'k' },
+    { "swmr", no_arg, 'W' },
+    { "swm", no_arg, 'W' },
+    { "sw", no_arg, 'W' },
     { "threshold", require_arg, 'T' },
     { "threshol", require_arg, 'T' },
     { "thresho", require_arg, 'T' },
@@ -254,6 +432,17 @@ static struct long_options l_opts[] = {
     { "thre", require_arg, 'T' },
     { "thr", require_arg, 'T' },
     { "th", require_arg, 'T' },
+    { "xfers", require_arg, 'V' },
+    { "xfer", require_arg, 'V' },
+    { "xfe", require_arg, 'V' },
+    { "xf", require_arg, 'V' },
+    { "workload", require_arg, 'l' },
+    { "workloa", require_arg, 'l' },
+    { "worklo", require_arg, 'l' },
+    { "workl", require_arg, 'l' },
+    { "work", require_arg, 'l' },
+    { "wor", require_arg, 'l' },
+    { "wo", require_arg, 'l' },
     { "write-only", require_arg, 'w' },
     { "write-onl", require_arg, 'w' },
     { "write-on", require_arg, 'w' },
@@ -265,6 +454,19 @@ static struct long_options l_opts[] = {
     { NULL, 0, '\0' }
 };
 
+typedef struct group_spec_ {
+    iotype io_type;             /* API the group runs                   */
+    int mode;                   /* PIO_GROUP_WRITE and/or PIO_GROUP_READ */
+    int num_procs;              /* processes in the group, 0 to share   */
+} group_spec;
+
+/* Values swept by the test loop: a list, progressions or both */
+typedef struct pio_sched_ {
+    int num;                    /* number of values                     */
+    int given;                  /* set on the command line              */
+    off_t vals[PIO_MAX_SCHED];  /* the values, in order                 */
+} pio_sched;
+
 struct options {
     long io_types;              /* bitmask of which I/O types to test   */
     const char *output_file;    /* file to print report to              */
@@ -282,13 +484,86 @@ struct options {
     unsigned dim2d;             /* 1D vs. 2D geometry                   */
     int print_times;       	/* print times as well as throughputs   */
     int print_raw;         	/* print raw data throughput info       */
+    int print_counters;         /* print the event counters of the phases */
+    double sample_interval;     /* seconds between bandwidth samples, 0 if off */
     off_t h5_alignment;         /* alignment in HDF5 file               */
     off_t h5_threshold;         /* threshold for alignment in HDF5 file */
+    int h5_driver;              /* PIO_DRIVER_* of the HDF5 files       */
     int h5_use_chunks;     	/* Make HDF5 dataset chunked            */
     int h5_write_only;        	/* Perform the write tests only         */
     int verify;        		/* Verify data correctness              */
+    off_t stripe_size;          /* File system stripe size, 0 if unused,
+                                 * -1 to query the file system          */
+    int stripe_count;           /* File system stripe count, 0 to query */
+    int h5_align_set;           /* Alignment given on the command line  */
+    int h5_thresh_set;          /* Threshold given on the command line  */
+    int append;                 /* Append workload on growing datasets  */
+    off_t append_chunk;         /* chunk size of appended datasets      */
+    long extend_steps;          /* steps added per H5Dset_extent call   */
+    long flush_steps;           /* steps between flushes, 0 for none    */
+    int flush_file;             /* flush the file, not the dataset      */
+    int swmr;                   /* SWMR writer with concurrent readers  */
+    int num_groups;             /* concurrent process groups, 0 if none */
+    group_spec groups[PIO_MAX_GROUPS];  /* workload of each group       */
+    off_t chunk_dims[2];        /* HDF5 chunk dims, 0 for the block size */
+    size_t cache_nslots;        /* chunk cache hash slots               */
+    size_t cache_nbytes;        /* chunk cache size in bytes            */
+    double cache_w0;            /* chunk cache preemption policy        */
+    int cache_set;              /* --chunk-cache given                  */
+    int num_ratios;             /* chunk/transfer size ratios to sweep  */
+    double chunk_ratios[PIO_MAX_RATIOS];    /* the ratios, in order     */
+    int chunk_opt;              /* H5FD_mpio_chunk_opt_t of collective I/O */
+    int chunk_opt_num;          /* link-chunk threshold, 0 for default  */
+    int chunk_opt_ratio;        /* collective chunk percent, -1 for default */
+    int coll_opt;               /* H5FD_mpio_collective_opt_t, -1 for default */
+    int num_restarts;           /* reader counts of a checkpoint/restart */
+    int restart_procs[PIO_MAX_RESTARTS];    /* the counts, in order     */
+    int scaling;                /* PIO_SCALE_STRONG and/or PIO_SCALE_WEAK */
+    pio_sched procs_sched;      /* numbers of processes to run with     */
+    pio_sched xfer_sched;       /* transfer buffer sizes                */
+    pio_sched blk_sched;        /* block sizes                          */
+    pio_sched dsets_sched;      /* numbers of datasets per file         */
+    unsigned filters;           /* PIO_FILTER_* of chunked datasets     */
+    int deflate_level;          /* compression level of deflate         */
+    int read_only;              /* read files an earlier phase kept     */
+    int keep_files;             /* keep the files for a later phase     */
+    const char *workload;       /* --workload file, NULL if none        */
+    const char *replay;         /* --replay trace, NULL if none         */
+    int replay_timed;           /* keep the traced times of the accesses */
+    const char *compare;        /* --compare baseline, NULL if none     */
+    int num_reports;            /* reports to compare with the baseline */
+    char **reports;
 };
 
+/* One phase of a --workload file, or the defaults before the first */
+typedef struct pio_phase_ {
+    char name[64];              /* from the [name] line                 */
+    int line;                   /* where it starts, for messages        */
+    int op;                     /* PIO_PHASE_*, -1 if not given         */
+    int keep;                   /* keep the files, -1 if not given      */
+    const char *hints;          /* MPI-IO hints KEY=VALUE;..., or NULL  */
+    int nargs;                  /* options of the phase                 */
+    const char *keys[PIO_MAX_PHASE_ARGS];   /* long option names        */
+    const char *vals[PIO_MAX_PHASE_ARGS];   /* their values, NULL for flags */
+    int lines[PIO_MAX_PHASE_ARGS];          /* where they were set      */
+    int argc;                   /* the command line built from them     */
+    char *argv[2 * PIO_MAX_PHASE_ARGS + 2];
+    int arglines[2 * PIO_MAX_PHASE_ARGS + 2];   /* and its lines        */
+    struct options *opts;       /* and what parse_command_line made of it */
+} pio_phase;
+
+/* One run of a --chunk-sweep */
+typedef struct chunk_point_ {
+    hsize_t dims[2];            /* chunk dims of the run                */
+    double ratio;               /* chunk bytes over transfer bytes      */
+    double write_mbs;           /* average write throughput             */
+    double read_mbs;            /* average read throughput              */
+    long write_hits;            /* chunk cache hits of all processes    */
+    long write_misses;
+    long read_hits;
+    long read_misses;
+} chunk_point;
+
 typedef struct _minmax {
     double min;
     double max;
@@ -296,16 +571,49 @@ typedef struct _minmax {
     int num;
 } minmax;
 
+/* The bandwidth of all processes over one phase, from the sampler */
+typedef struct bw_series_ {
+    long count;                 /* sampler ticks, -1 if not sampled     */
+    long long *bytes;           /* bytes moved at each tick, then total */
+    double elapsed;             /* seconds of the slowest process       */
+} bw_series;
+
 /* local functions */
 static off_t parse_size_directive(const char *size);
 static struct options *parse_command_line(int argc, char *argv[]);
 static void run_test_loop(struct options *options);
-static int run_test(iotype iot, parameters parms, struct options *opts);
+static void run_group_test(struct options *opts, parameters parms);
+static int run_test(iotype iot, parameters parms, struct options *opts,
+                    chunk_point *point);
+static void run_chunk_sweep(struct options *opts, parameters parms);
+static void run_restart_test(struct options *opts, parameters parms);
+static int run_workload(struct options *opts);
+static int run_replay(struct options *opts);
+static char *read_input_file(const char *fname, const char *what, long *len);
+static int parse_workload(char *text, const char *fname, pio_phase *phases,
+                          int *num_phases);
+static int workload_phase_options(pio_phase *defaults, pio_phase *phase,
+                                  const char *fname);
+static int set_info_hints(const char *hints);
+static int restart_phase(parameters parms, int num_procs, double *seconds);
+static void output_chunk_cache(const char *name, long hits, long misses);
+static void reduce_counters(pio_time *pt, timer_type t, long long *total,
+                            double *wall);
+static void output_counters(const char *name, const long long *counts,
+                            double wall, double bytes);
+static void reduce_samples(pio_time *pt, timer_type t, bw_series *series);
+static void output_samples(const char *name, const bw_series *series,
+                           int niters, double interval);
+static void reduce_mpio_modes(const mpio_modes *modes, mpio_modes *total);
+static void output_mpio_modes(const char *name, const mpio_modes *modes);
 static void output_all_info(minmax *mm, int count, int indent_level);
 static void get_minmax(minmax *mm, double val);
 static minmax accumulate_minmax_stuff(minmax *mm, int count);
 static int create_comm_world(int num_procs, int *doing_pio);
 static int destroy_comm_world(void);
+static void build_comm_worlds(const struct options *opts);
+static int select_comm_world(int num_procs, int *doing_pio);
+static void free_comm_worlds(void);
 static void output_results(const struct options *options, const char *name,
                            minmax *table, int table_size, off_t data_size);
 static void output_times(const struct options *options, const char *name,
@@ -314,6 +622,21 @@ static void output_report(const char *fmt, ...);
 static void print_indent(register int indent);
 static void usage(const char *prog);
 static void report_parameters(struct options *opts);
+static int setup_striping(struct options *opts);
+static size_t stripe_block_size(size_t blk_size, const struct options *opts);
+static int query_striping(const char *dir, off_t *stripe_size, int *stripe_count);
+static int parse_group_spec(const char *spec, struct options *opts);
+static int parse_chunk_dims(const char *spec, struct options *opts);
+static int parse_chunk_cache(const char *spec, struct options *opts);
+static int parse_chunk_ratios(const char *spec, struct options *opts);
+static int parse_restart_procs(const char *spec, struct options *opts);
+static int parse_schedule(const char *spec, const char *name, pio_sched *sched);
+static int parse_filters(const char *spec, struct options *opts);
+static int parse_sched_value(const char **spec, off_t *val);
+static int fill_schedules(struct options *opts);
+static void print_schedule(const char *name, const pio_sched *sched);
+static const char *group_mode_name(int mode);
+static const char *driver_name(int driver);
 
 /*
  * Function:    main
@@ -324,7 +647,11 @@ static void report_parameters(struct options *opts);
  * Modifications:
  */
 int
+#ifdef PIO_THREADS
+pio_rank_main(int argc, char **argv)
+#else
 main(int argc, char **argv)
+#endif  /* PIO_THREADS */
 {
     int ret;
     int exit_value = EXIT_SUCCESS;
@@ -385,6 +712,36 @@ main(int argc, char **argv)
         }
     }
 
+    /* only process 0 reads and compares the reports */
+    if (opts->compare) {
+        int regressions = 0;
+
+        if (comm_world_rank_g == 0)
+            regressions = pio_compare(opts->compare, opts->num_reports, opts->reports);
+        MPI_Bcast(&regressions, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+        if (regressions != 0)
+            exit_value = EXIT_FAILURE;
+        goto finish;
+    }
+
+    if (opts->workload) {
+        if (run_workload(opts) != SUCCESS)
+            exit_value = EXIT_FAILURE;
+        goto finish;
+    }
+
+    if (setup_striping(opts) != SUCCESS) {
+        exit_value = EXIT_FAILURE;
+        goto finish;
+    }
+
+    if (opts->replay) {
+        if (run_replay(opts) != SUCCESS)
+            exit_value = EXIT_FAILURE;
+        goto finish;
+    }
+
     if ((pio_debug_level == 0 && comm_world_rank_g == 0) || pio_debug_level > 0)
         report_parameters(opts);
 
@@ -401,27 +758,32 @@ finish:
  * Purpose:     Run the I/O tests. Write the results to OUTPUT.
  *
  *            - The slowest changing part of the test is the number of
- *              processors to use. For each loop iteration, we divide that
- *              number by 2 and rerun the test.
+ *              processors to use, taken from the process schedule (by
+ *              default halving from the maximum to the minimum).  The
+ *              communicator of every distinct count is split once up
+ *              front and reused.
+ *
+ *            - Then come the dataset count and block size schedules.
  *
  *            - The second slowest is what type of IO API to perform. We have
  *              three choices: POSIXIO, MPI-IO, and PHDF5.
  *
- *            - Then we change the size of the buffer. This information is
- *              inferred from the number of datasets to create and the number
- *              of integers to put into each dataset. The backend code figures
- *              this out.
+ *            - Then we change the size of the buffer, following the
+ *              transfer size schedule (by default doubling from the minimum
+ *              to the maximum). The backend code figures out the rest
+ *              from the number of datasets and bytes per process.
  *
  * Return:      Nothing
  * Programmer:  Bill Wendling, 30. October 2001
  * Modifications:
  *    Added 2D testing (Christian Chilan, 10. August 2005)
+ *    Sweep schedules and one communicator per process count.
  */
 static void
 run_test_loop(struct options *opts)
 {
     parameters parms;
-    int num_procs;
+    int p, d, b, x;
     int doing_pio;      /* if this process is doing PIO */
 
     parms.num_files = opts->num_files;
@@ -433,1059 +795,4068 @@ run_test_loop(struct options *opts)
     parms.dim2d = opts->dim2d;
     parms.h5_align = opts->h5_alignment;
     parms.h5_thresh = opts->h5_threshold;
+    parms.stripe_size = (opts->stripe_size > 0) ? (hsize_t)opts->stripe_size : 0;
+    parms.stripe_count = opts->stripe_count;
     parms.h5_use_chunks = opts->h5_use_chunks;
     parms.h5_write_only = opts->h5_write_only;
     parms.verify = opts->verify;
+    parms.read_only = opts->read_only;
+    parms.keep_files = opts->keep_files;
+    parms.group = -1;
+    parms.append = opts->append;
+    parms.append_chunk = (hsize_t)opts->append_chunk;
+    parms.extend_steps = opts->extend_steps;
+    parms.flush_steps = opts->flush_steps;
+    parms.flush_file = opts->flush_file;
+    parms.swmr = opts->swmr;
+    parms.h5_chunk[0] = (hsize_t)opts->chunk_dims[0];
+    parms.h5_chunk[1] = (hsize_t)opts->chunk_dims[1];
+    parms.cache_nslots = opts->cache_nslots;
+    parms.cache_nbytes = opts->cache_nbytes;
+    parms.cache_w0 = opts->cache_w0;
+    /* the chunk cache model costs time; run it only when asked about the cache */
+    parms.model_cache = opts->cache_set || opts->num_ratios > 0;
+    parms.chunk_opt = opts->chunk_opt;
+    parms.chunk_opt_num = opts->chunk_opt_num;
+    parms.chunk_opt_ratio = opts->chunk_opt_ratio;
+    parms.coll_opt = opts->coll_opt;
+    parms.filters = opts->filters;
+    parms.counters = opts->print_counters;
+    parms.sample_interval = opts->sample_interval;
+    parms.h5_driver = opts->h5_driver;
+    parms.deflate_level = opts->deflate_level;
+
+    if (opts->num_groups > 0) {
+        run_group_test(opts, parms);
+        return;
+    }
 
-    /* start with max_num_procs and decrement it by half for each loop. */
-    /* if performance needs restart, fewer processes may be needed. */
-    for (num_procs = opts->max_num_procs;
-            num_procs >= opts->min_num_procs; num_procs >>= 1) {
-        register size_t buf_size;
+    build_comm_worlds(opts);
 
-        parms.num_procs = num_procs;
+    if (opts->num_restarts > 0) {
+        run_restart_test(opts, parms);
+        free_comm_worlds();
+        return;
+    }
 
-        if (create_comm_world(parms.num_procs, &doing_pio) != SUCCESS) {
-            /* do something harsh */
-        }
+    for (p = 0; p < opts->procs_sched.num; p++) {
+        parms.num_procs = (int)opts->procs_sched.vals[p];
 
-    /* only processes doing PIO will run the tests */
-    if (doing_pio){
-            output_report("Number of processors = %ld\n", parms.num_procs);
+        if (select_comm_world(parms.num_procs, &doing_pio) != SUCCESS)
+            continue;
 
-            /* multiply the xfer buffer size by 2 for each loop iteration */
-            for (buf_size = opts->min_xfer_size;
-                    buf_size <= opts->max_xfer_size; buf_size <<= 1) {
-                parms.buf_size = buf_size;
+        /* only processes doing PIO will run the tests */
+        if (!doing_pio)
+            continue;
 
-        if (parms.dim2d){
-            parms.num_bytes = (off_t)pow((double)(opts->num_bpp*parms.num_procs),2);
-            if (parms.interleaved)
-            output_report("Transfer Buffer Size: %ldx%ld bytes, File size: %.2f MBs\n",
-                buf_size, opts->blk_size,
-                ((double)parms.num_dsets * (double)parms.num_bytes)
-                / ONE_MB);
-            else
-            output_report("Transfer Buffer Size: %ldx%ld bytes, File size: %.2f MBs\n",
-                opts->blk_size, buf_size,
-                ((double)parms.num_dsets * (double)parms.num_bytes)
-                / ONE_MB);
+        output_report("Number of processors = %ld\n", parms.num_procs);
 
-            print_indent(1);
-            output_report("  # of files: %ld, # of datasets: %ld, dataset size: %.2fx%.2f KBs\n",
-                parms.num_files, parms.num_dsets, (double)(opts->num_bpp*parms.num_procs)/ONE_KB,
-                (double)(opts->num_bpp*parms.num_procs)/ONE_KB);
-        }
-        else{
-            parms.num_bytes = (off_t)opts->num_bpp*parms.num_procs;
-            output_report("Transfer Buffer Size: %ld bytes, File size: %.2f MBs\n",
-                buf_size,((double)parms.num_dsets * (double)parms.num_bytes) / ONE_MB);
+        for (d = 0; d < opts->dsets_sched.num; d++) {
+            parms.num_dsets = (long)opts->dsets_sched.vals[d];
 
-            print_indent(1);
-            output_report("  # of files: %ld, # of datasets: %ld, dataset size: %.2f MBs\n",
-                parms.num_files, parms.num_dsets, (double)(opts->num_bpp*parms.num_procs)/ONE_MB);
-        }
+            for (b = 0; b < opts->blk_sched.num; b++) {
+                parms.blk_size = (size_t)opts->blk_sched.vals[b];
 
-                if (opts->io_types & PIO_POSIX)
-                    run_test(POSIXIO, parms, opts);
+                for (x = 0; x < opts->xfer_sched.num; x++) {
+                    size_t buf_size = (size_t)opts->xfer_sched.vals[x];
 
-                if (opts->io_types & PIO_MPI)
-                    run_test(MPIO, parms, opts);
+                    parms.buf_size = buf_size;
 
-                if (opts->io_types & PIO_HDF5)
-                    run_test(PHDF5, parms, opts);
+                    if (parms.dim2d){
+                        parms.num_bytes = (off_t)pow((double)(opts->num_bpp*parms.num_procs),2);
+                        if (parms.interleaved)
+                            output_report("Transfer Buffer Size: %ldx%ld bytes, File size: %.2f MBs\n",
+                                buf_size, parms.blk_size,
+                                ((double)parms.num_dsets * (double)parms.num_bytes)
+                                / ONE_MB);
+                        else
+                            output_report("Transfer Buffer Size: %ldx%ld bytes, File size: %.2f MBs\n",
+                                parms.blk_size, buf_size,
+                                ((double)parms.num_dsets * (double)parms.num_bytes)
+                                / ONE_MB);
 
-                /* Run the tests once if buf_size==0, but then break out */
-                if(buf_size==0)
-                    break;
-            }
+                        print_indent(1);
+                        output_report("  # of files: %ld, # of datasets: %ld, dataset size: %.2fx%.2f KBs\n",
+                            parms.num_files, parms.num_dsets, (double)(opts->num_bpp*parms.num_procs)/ONE_KB,
+                            (double)(opts->num_bpp*parms.num_procs)/ONE_KB);
+                    }
+                    else{
+                        parms.num_bytes = (off_t)opts->num_bpp*parms.num_procs;
+                        output_report("Transfer Buffer Size: %ld bytes, File size: %.2f MBs\n",
+                            buf_size,((double)parms.num_dsets * (double)parms.num_bytes) / ONE_MB);
+
+                        print_indent(1);
+                        output_report("  # of files: %ld, # of datasets: %ld, dataset size: %.2f MBs\n",
+                            parms.num_files, parms.num_dsets, (double)(opts->num_bpp*parms.num_procs)/ONE_MB);
+                        if (opts->blk_sched.given) {
+                            print_indent(1);
+                            output_report("  block size: %ld bytes\n", (long)parms.blk_size);
+                        }
+                    }
+
+                    if (opts->io_types & PIO_POSIX)
+                        run_test(POSIXIO, parms, opts, NULL);
 
-            if (destroy_comm_world() != SUCCESS) {
-                /* do something harsh */
+                    if (opts->io_types & PIO_MPI)
+                        run_test(MPIO, parms, opts, NULL);
+
+                    if (opts->io_types & PIO_HDF5) {
+                        if (opts->num_ratios > 0)
+                            run_chunk_sweep(opts, parms);
+                        else
+                            run_test(PHDF5, parms, opts, NULL);
+                    }
+                }
             }
+        }
     }
-    }
+
+    free_comm_worlds();
 }
 
 /*
- * Function:    run_test
- * Purpose:     Inner loop call to actually run the I/O test.
- * Return:      Nothing
- * Programmer:  Bill Wendling, 18. December 2001
+ * Function:    run_workload
+ * Purpose:     Run the phases of the --workload file.  Process 0 reads the
+ *              file and broadcasts it; every process then turns each phase
+ *              into a command line for parse_command_line, so a phase takes
+ *              exactly the options h5perf does.  All phases are checked
+ *              before the first one runs.  Each runs through
+ *              run_test_loop with its MPI-IO hints added to the global ones.
+ * Return:      SUCCESS or FAIL
  * Modifications:
  */
 static int
-run_test(iotype iot, parameters parms, struct options *opts)
+run_workload(struct options *opts)
 {
-    results         res;
-    register int    i, ret_value = SUCCESS;
-    int             comm_size;
-    off_t           raw_size;
-    minmax         *write_mpi_mm_table=NULL;
-    minmax         *write_mm_table=NULL;
-    minmax         *write_gross_mm_table=NULL;
-    minmax         *write_raw_mm_table=NULL;
-    minmax         *read_mpi_mm_table=NULL;
-    minmax         *read_mm_table=NULL;
-    minmax         *read_gross_mm_table=NULL;
-    minmax         *read_raw_mm_table=NULL;
-    minmax         *read_open_mm_table=NULL;
-    minmax         *read_close_mm_table=NULL;
-    minmax         *write_open_mm_table=NULL;
-    minmax         *write_close_mm_table=NULL;
-    minmax          write_mpi_mm = {0.0, 0.0, 0.0, 0};
-    minmax          write_mm = {0.0, 0.0, 0.0, 0};
-    minmax          write_gross_mm = {0.0, 0.0, 0.0, 0};
-    minmax          write_raw_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_mpi_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_gross_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_raw_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_open_mm = {0.0, 0.0, 0.0, 0};
-    minmax          read_close_mm = {0.0, 0.0, 0.0, 0};
-    minmax          write_open_mm = {0.0, 0.0, 0.0, 0};
-    minmax          write_close_mm = {0.0, 0.0, 0.0, 0};
-
-    raw_size = parms.num_files * (off_t)parms.num_dsets * (off_t)parms.num_bytes;
-    parms.io_type = iot;
-    print_indent(2);
-    output_report("IO API = ");
+    pio_phase *phases = NULL;   /* phases[0] holds the defaults */
+    char *text = NULL;
+    long len;
+    int num_phases = 0, i, ret_value = SUCCESS;
 
-    switch (iot) {
-        case POSIXIO:
-            output_report("POSIX\n");
-            break;
-        case MPIO:
-            output_report("MPIO\n");
-            break;
-        case PHDF5:
-            output_report("PHDF5 (w/MPI-IO driver)\n");
-            break;
+    if ((text = read_input_file(opts->workload, "workload", &len)) == NULL) {
+        ret_value = FAIL;
+        goto done;
     }
 
-    MPI_Comm_size(pio_comm_g, &comm_size);
+    if ((phases = calloc(PIO_MAX_PHASES + 1, sizeof(pio_phase))) == NULL)
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
 
-    /* allocate space for tables minmax and that it is sufficient */
-    /* to initialize all elements to zeros by calloc.             */
-    write_mpi_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    write_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    write_gross_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    write_raw_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    write_open_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    write_close_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-    if (!parms.h5_write_only) {
-        read_mpi_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-        read_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-        read_gross_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-        read_raw_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-        read_open_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
-        read_close_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    /* every process parses the same text, so all of them agree */
+    if (parse_workload(text, opts->workload, phases, &num_phases) != SUCCESS) {
+        ret_value = FAIL;
+        goto done;
     }
 
-    /* Do IO iteration times, collecting statistics each time */
-    for (i = 0; i < parms.num_iters; ++i) {
-        double t;
+    for (i = 1; i <= num_phases; i++) {
+        if (workload_phase_options(&phases[0], &phases[i], opts->workload) != SUCCESS) {
+            ret_value = FAIL;
+            goto done;
+        }
+    }
 
-        MPI_Barrier(pio_comm_g);
-        res = do_pio(parms);
+    for (i = 1; i <= num_phases; i++) {
+        pio_phase *phase = &phases[i];
+        struct options *popts = phase->opts;
+        MPI_Info base = h5_io_info_g;
 
-        /* gather all of the "mpi write" times */
-        t = get_time(res.timers, HDF5_MPI_WRITE);
-        get_minmax(&write_mpi_mm, t);
+        if (base != MPI_INFO_NULL)
+            MPI_Info_dup(base, &h5_io_info_g);
 
-        write_mpi_mm_table[i] = write_mpi_mm;
+        if ((phase->hints && set_info_hints(phase->hints) != SUCCESS) ||
+                setup_striping(popts) != SUCCESS) {
+            ret_value = FAIL;
+        } else {
+            if (comm_world_rank_g == 0)
+                HDfprintf(output, "==== Phase %d of %d: %s (%s) ====\n", i,
+                          num_phases, phase->name,
+                          popts->read_only ? "read" :
+                          popts->h5_write_only ? "write" : "readwrite");
+
+            if ((pio_debug_level == 0 && comm_world_rank_g == 0) || pio_debug_level > 0)
+                report_parameters(popts);
+
+            run_test_loop(popts);
+
+            /* a read phase removes what it read unless told to keep it */
+            if (popts->read_only && !phase->keep) {
+                static const struct {
+                    long mask;
+                    iotype iot;
+                } apis[] = {
+                    { PIO_POSIX, POSIXIO }, { PIO_MPI, MPIO }, { PIO_HDF5, PHDF5 },
+                };
+                parameters parms;
+                size_t a;
+
+                memset(&parms, 0, sizeof(parms));
+                parms.num_files = popts->num_files;
+                parms.group = -1;
+                pio_comm_g = MPI_COMM_WORLD;
+                pio_mpi_rank_g = comm_world_rank_g;
+
+                for (a = 0; a < sizeof(apis) / sizeof(apis[0]); a++) {
+                    if (popts->io_types & apis[a].mask) {
+                        parms.io_type = apis[a].iot;
+                        do_pio_cleanup(parms);
+                    }
+                }
+            }
+        }
 
-        /* gather all of the "write" times */
-        t = get_time(res.timers, HDF5_FINE_WRITE_FIXED_DIMS);
-        get_minmax(&write_mm, t);
+        if (h5_io_info_g != MPI_INFO_NULL)
+            MPI_Info_free(&h5_io_info_g);
+        h5_io_info_g = base;
 
-        write_mm_table[i] = write_mm;
+        if (ret_value != SUCCESS)
+            break;
+    }
 
-        /* gather all of the "write" times from open to close */
-        t = get_time(res.timers, HDF5_GROSS_WRITE_FIXED_DIMS);
-        get_minmax(&write_gross_mm, t);
+done:
+    if (phases) {
+        for (i = 1; i <= num_phases; i++) {
+            int j;
 
-        write_gross_mm_table[i] = write_gross_mm;
+            for (j = 1; j < phases[i].argc; j++)
+                free(phases[i].argv[j]);
+            free(phases[i].opts);
+        }
 
-        /* gather all of the raw "write" times */
-        t = get_time(res.timers, HDF5_RAW_WRITE_FIXED_DIMS);
-        get_minmax(&write_raw_mm, t);
+        free(phases);
+    }
 
-        write_raw_mm_table[i] = write_raw_mm;
+    free(text);
+    return ret_value;
+}
 
-        /* gather all of the file open times (time from open to first write) */
-        t = get_time(res.timers, HDF5_FILE_WRITE_OPEN);
-        get_minmax(&write_open_mm, t);
+/*
+ * Function:    read_input_file
+ * Purpose:     Process 0 reads the whole of file FNAME and broadcasts it
+ *              to the processes of MPI_COMM_WORLD, so that the file only
+ *              needs to be visible to process 0.  All processes must call
+ *              it.  WHAT names the file in the error message.
+ * Return:      The NUL terminated contents, to be freed by the caller, and
+ *              their length in *LEN; NULL on every process if the file
+ *              cannot be read.
+ * Modifications:
+ */
+static char *
+read_input_file(const char *fname, const char *what, long *len)
+{
+    char *text = NULL;
 
-        write_open_mm_table[i] = write_open_mm;
+    *len = -1;
 
-        /* gather all of the file close times (time from last write to close) */
-        t = get_time(res.timers, HDF5_FILE_WRITE_CLOSE);
-        get_minmax(&write_close_mm, t);
+    if (comm_world_rank_g == 0) {
+        FILE *f = fopen(fname, "r");
 
-        write_close_mm_table[i] = write_close_mm;
+        if (f) {
+            if (fseek(f, 0L, SEEK_END) == 0 && (*len = ftell(f)) >= 0 && *len < INT_MAX) {
+                rewind(f);
+                if ((text = malloc((size_t)*len + 1)) == NULL ||
+                        fread(text, 1, (size_t)*len, f) != (size_t)*len)
+                    *len = -1;
+            } else {
+                *len = -1;
+            }
 
-        if (!parms.h5_write_only) {
-            /* gather all of the "mpi read" times */
-            t = get_time(res.timers, HDF5_MPI_READ);
-            get_minmax(&read_mpi_mm, t);
+            fclose(f);
+        }
 
-            read_mpi_mm_table[i] = read_mpi_mm;
+        if (*len < 0) {
+            fprintf(stderr, "%s: cannot read %s file %s\n", progname, what, fname);
+            free(text);
+            text = NULL;
+        }
+    }
 
-            /* gather all of the "read" times */
-            t = get_time(res.timers, HDF5_FINE_READ_FIXED_DIMS);
-            get_minmax(&read_mm, t);
+    MPI_Bcast(len, 1, MPI_LONG, 0, MPI_COMM_WORLD);
 
-            read_mm_table[i] = read_mm;
+    if (*len < 0)
+        return NULL;
 
-            /* gather all of the "read" times from open to close */
-            t = get_time(res.timers, HDF5_GROSS_READ_FIXED_DIMS);
-            get_minmax(&read_gross_mm, t);
+    if (comm_world_rank_g != 0 && (text = malloc((size_t)*len + 1)) == NULL)
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
 
-            read_gross_mm_table[i] = read_gross_mm;
+    MPI_Bcast(text, (int)*len, MPI_CHAR, 0, MPI_COMM_WORLD);
+    text[*len] = '\0';
+    return text;
+}
 
-            /* gather all of the raw "read" times */
-            t = get_time(res.timers, HDF5_RAW_READ_FIXED_DIMS);
-            get_minmax(&read_raw_mm, t);
+/*
+ * Function:    run_replay
+ * Purpose:     Replay the --replay trace with every number of processes
+ *              of the process schedule and every API asked for, each
+ *              num-iterations times.  Process 0 reads the trace and
+ *              broadcasts it; every process parses it the same way.  Each
+ *              row gives the operations and bytes of all processes, the
+ *              time of the slowest from the common start to its last
+ *              access, and in timed mode how far behind the traced
+ *              schedule the accesses were issued.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+run_replay(struct options *opts)
+{
+    static const struct {
+        long mask;
+        iotype iot;
+        const char *name;
+    } apis[] = {
+        { PIO_POSIX, POSIXIO, "POSIX" },
+        { PIO_MPI, MPIO, "MPIO" },
+    };
+    replay_trace trace;
+    long long reads = 0, writes = 0, bytes_read = 0, bytes_written = 0;
+    char *text;
+    long len;
+    int f, p, ret_value = SUCCESS;
+
+    if ((text = read_input_file(opts->replay, "trace", &len)) == NULL)
+        return FAIL;
+
+    if (replay_parse(text, &trace) != SUCCESS) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: no POSIX counters or DXT accesses in trace %s\n",
+                    progname, opts->replay);
+        free(text);
+        replay_free(&trace);
+        return FAIL;
+    }
+    free(text);
 
-            read_raw_mm_table[i] = read_raw_mm;
+    for (f = 0; f < trace.nrecords; f++) {
+        replay_record *rec = &trace.records[f];
+        long k;
 
-            /* gather all of the file open times (time from open to first read) */
-            t = get_time(res.timers, HDF5_FILE_READ_OPEN);
-            get_minmax(&read_open_mm, t);
+        if (rec->nops == 0) {
+            reads += MAX(rec->reads, 0);
+            writes += MAX(rec->writes, 0);
+            bytes_read += MAX(rec->bytes_read, 0);
+            bytes_written += MAX(rec->bytes_written, 0);
+        }
 
-            read_open_mm_table[i] = read_open_mm;
+        for (k = 0; k < rec->nops; k++) {
+            if (rec->ops[k].write) {
+                writes++;
+                bytes_written += (long long)rec->ops[k].length;
+            } else {
+                reads++;
+                bytes_read += (long long)rec->ops[k].length;
+            }
+        }
+    }
 
-            /* gather all of the file close times (time from last read to close) */
-            t = get_time(res.timers, HDF5_FILE_READ_CLOSE);
-            get_minmax(&read_close_mm, t);
+    pio_comm_g = MPI_COMM_WORLD;
+    output_report("Trace %s: %d file(s)", opts->replay, trace.nfiles);
+    if (trace.nprocs > 0)
+        output_report(", %d processes", trace.nprocs);
+    if (trace.run_time > 0)
+        output_report(", %.3f s run time", trace.run_time);
+    output_report("\n");
+    print_indent(1);
+    output_report("%lld reads (%.2f MB), %lld writes (%.2f MB) in %.3f s\n",
+                  reads, (double)bytes_read / ONE_MB, writes,
+                  (double)bytes_written / ONE_MB, trace.last - trace.first);
+    output_report("Replay, %s:\n", opts->replay_timed ? "timed" : "as fast as possible");
+    print_indent(1);
+    output_report("%-5s %5s %9s %9s %10s %10s %9s %9s %9s %9s\n", "API", "procs",
+                  "reads", "writes", "read MB", "write MB", "elapsed s", "MB/s",
+                  "max lag s", "mean lag s");
+
+    build_comm_worlds(opts);
+
+    for (p = 0; p < opts->procs_sched.num && ret_value == SUCCESS; p++) {
+        int num_procs = (int)opts->procs_sched.vals[p];
+        size_t a;
+
+        for (a = 0; a < sizeof(apis) / sizeof(apis[0]); a++) {
+            double elapsed = 0.0, max_lag = 0.0, sum_lag = 0.0;
+            long long bytes = 0, counts[4] = { 0, 0, 0, 0 };
+            int i, rc = SUCCESS;
+
+            if (!(opts->io_types & apis[a].mask))
+                continue;
+
+            for (i = 0; i < opts->num_iters && rc == SUCCESS; i++) {
+                replay_results res;
+                long long mine[4] = { 0, 0, 0, 0 }, all[4];
+                double t[2] = { 0.0, 0.0 }, all_t[2], lag = 0.0, all_lag;
+                int doing_pio, all_rc;
+
+                if (select_comm_world(num_procs, &doing_pio) != SUCCESS) {
+                    ret_value = FAIL;
+                    break;
+                }
 
-            read_close_mm_table[i] = read_close_mm;
+                memset(&res, 0, sizeof(res));
+                if (doing_pio) {
+                    res = do_replay(&trace, apis[a].iot, opts->replay_timed);
+                    mine[0] = res.reads;
+                    mine[1] = res.writes;
+                    mine[2] = res.bytes_read;
+                    mine[3] = res.bytes_written;
+                    t[0] = res.elapsed;
+                    t[1] = res.max_lag;
+                    lag = res.sum_lag;
+                }
 
-         }
+                pio_comm_g = MPI_COMM_WORLD;
+                MPI_Allreduce(mine, all, 4, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+                MPI_Allreduce(t, all_t, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+                MPI_Allreduce(&lag, &all_lag, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+                MPI_Allreduce(&res.ret_code, &all_rc, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+                rc = all_rc;
+
+                counts[0] += all[0];
+                counts[1] += all[1];
+                counts[2] += all[2];
+                counts[3] += all[3];
+                elapsed += all_t[0];
+                max_lag = MAX(max_lag, all_t[1]);
+                sum_lag += all_lag;
+            }
 
-         pio_time_destroy(res.timers);
-    }
+            print_indent(1);
+            output_report("%-5s %5d ", apis[a].name, num_procs);
+            if (rc != SUCCESS) {
+                output_report("failed\n");
+                ret_value = FAIL;
+                break;
+            }
 
-    /*
-     * Show various statistics
-     */
-    /* Write statistics	*/
-    /* Print the raw data throughput if desired */
-    if (opts->print_raw) {
-        /* accumulate and output the max, min, and average "raw write" times */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("Raw Data Write details:\n");
-            output_all_info(write_raw_mm_table, parms.num_iters, 4);
+            bytes = counts[2] + counts[3];
+            elapsed /= opts->num_iters;
+            output_report("%9lld %9lld %10.2f %10.2f %9.3f %9.2f ",
+                          counts[0] / opts->num_iters, counts[1] / opts->num_iters,
+                          (double)counts[2] / opts->num_iters / ONE_MB,
+                          (double)counts[3] / opts->num_iters / ONE_MB, elapsed,
+                          MB_PER_SEC(bytes / opts->num_iters, elapsed));
+            if (opts->replay_timed)
+                output_report("%9.4f %10.4f\n", max_lag, (counts[0] + counts[1]) ?
+                              sum_lag / (double)(counts[0] + counts[1]) : 0.0);
+            else
+                output_report("%9s %10s\n", "-", "-");
         }
+    }
 
-        output_results(opts,"Raw Data Write",write_raw_mm_table,parms.num_iters,raw_size);
-    } /* end if */
+    free_comm_worlds();
+    replay_free(&trace);
+    return ret_value;
+}
 
-    /* show mpi write statics */
-    if (pio_debug_level >= 3) {
-        /* output all of the times for all iterations */
-        print_indent(3);
-        output_report("MPI Write details:\n");
-        output_all_info(write_mpi_mm_table, parms.num_iters, 4);
-    }
+/*
+ * Function:    workload_phase_options
+ * Purpose:     Build the command line of PHASE from its options and those
+ *              of DEFAULTS it does not set itself, parse it, and apply the
+ *              op and keep settings.  A bad option value is reported
+ *              with the line of FNAME that set it.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+workload_phase_options(pio_phase *defaults, pio_phase *phase, const char *fname)
+{
+    struct options *popts;
+    int op, i, j;
 
-    /* We don't currently output the MPI write results */
+    phase->argc = 0;
+    phase->argv[phase->argc++] = (char *)progname;
 
-    /* accumulate and output the max, min, and average "write" times */
-    if (pio_debug_level >= 3) {
-        /* output all of the times for all iterations */
-        print_indent(3);
-        output_report("Write details:\n");
-        output_all_info(write_mm_table, parms.num_iters, 4);
-    }
+    for (i = 0; i < defaults->nargs + phase->nargs; i++) {
+        const pio_phase *from = (i < defaults->nargs) ? defaults : phase;
+        int k = (i < defaults->nargs) ? i : i - defaults->nargs;
+        char *arg;
 
-    output_results(opts,"Write",write_mm_table,parms.num_iters,raw_size);
+        if (from == defaults) {
+            for (j = 0; j < phase->nargs; j++)
+                if (!HDstrcmp(phase->keys[j], defaults->keys[k]))
+                    break;
 
-    /* accumulate and output the max, min, and average "gross write" times */
-    if (pio_debug_level >= 3) {
-        /* output all of the times for all iterations */
-        print_indent(3);
-        output_report("Write Open-Close details:\n");
-        output_all_info(write_gross_mm_table, parms.num_iters, 4);
+            if (j < phase->nargs)
+                continue;
+        }
+
+        arg = malloc(HDstrlen(from->keys[k]) + 4 +
+                     (from->vals[k] ? HDstrlen(from->vals[k]) : 0));
+        if (arg == NULL)
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+
+        sprintf(arg, "--%s%s%s", from->keys[k], from->vals[k] ? "=" : "",
+                from->vals[k] ? from->vals[k] : "");
+        phase->arglines[phase->argc] = from->lines[k];
+        phase->argv[phase->argc++] = arg;
     }
 
-    output_results(opts,"Write Open-Close",write_gross_mm_table,parms.num_iters,raw_size);
+    phase->argv[phase->argc] = NULL;
 
-    if (opts->print_times) {
-        output_times(opts,"Write File Open",write_open_mm_table,parms.num_iters);
-        output_times(opts,"Write File Close",write_close_mm_table,parms.num_iters);
+    /* parse it like a command line of its own */
+    opt_ind = 1;
+    if ((phase->opts = popts = parse_command_line(phase->argc, phase->argv)) == NULL) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: %s:%d: invalid option in phase %s\n", progname, fname,
+                    bad_arg_g > 0 ? phase->arglines[bad_arg_g] : phase->line,
+                    phase->name);
+        return FAIL;
     }
 
-    /* Print out time from open to first write */
-    if (pio_debug_level >= 3) {
-       /* output all of the times for all iterations */
-       print_indent(3);
-       output_report("Write file open details:\n");
-       output_all_info(write_open_mm_table, parms.num_iters, 4);
+    op = (phase->op >= 0) ? phase->op : (defaults->op >= 0) ? defaults->op :
+         PIO_PHASE_READWRITE;
+    if (phase->keep < 0)
+        phase->keep = (defaults->keep >= 0) ? defaults->keep : (op == PIO_PHASE_WRITE);
+    if (!phase->hints)
+        phase->hints = defaults->hints;
+
+    if (popts->workload) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: phase %s: workloads do not nest\n", progname,
+                    phase->name);
+        return FAIL;
     }
 
-    /* Print out time from last write to close */
-    if (pio_debug_level >= 3) {
-       /* output all of the times for all iterations */
-       print_indent(3);
-       output_report("Write file close details:\n");
-       output_all_info(write_close_mm_table, parms.num_iters, 4);
+    if (op != PIO_PHASE_READWRITE && (popts->num_groups > 0 || popts->num_restarts > 0 ||
+            popts->swmr || popts->append)) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: phase %s: op = %s does not mix with groups, restart, "
+                    "swmr or append\n", progname, phase->name,
+                    op == PIO_PHASE_WRITE ? "write" : "read");
+        return FAIL;
     }
 
-    if (!parms.h5_write_only) {
-        /* Read statistics	*/
-        /* Print the raw data throughput if desired */
-        if (opts->print_raw) {
-            /* accumulate and output the max, min, and average "raw read" times */
-            if (pio_debug_level >= 3) {
-                /* output all of the times for all iterations */
-                print_indent(3);
-                output_report("Raw Data Read details:\n");
-                output_all_info(read_raw_mm_table, parms.num_iters, 4);
-            }
+    /* a read phase keeps its files while it sweeps, run_workload removes them */
+    if (op == PIO_PHASE_WRITE) {
+        popts->h5_write_only = TRUE;
+        popts->keep_files = phase->keep;
+    } else if (op == PIO_PHASE_READ) {
+        popts->read_only = TRUE;
+        popts->h5_write_only = FALSE;
+        popts->keep_files = TRUE;
+    } else {
+        popts->keep_files = phase->keep;
+    }
 
-            output_results(opts, "Raw Data Read", read_raw_mm_table,
-                           parms.num_iters, raw_size);
-        } /* end if */
+    return SUCCESS;
+}
 
-        /* show mpi read statics */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("MPI Read details:\n");
-            output_all_info(read_mpi_mm_table, parms.num_iters, 4);
-        }
-
-        /* We don't currently output the MPI read results */
-
-        /* accumulate and output the max, min, and average "read" times */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("Read details:\n");
-            output_all_info(read_mm_table, parms.num_iters, 4);
-        }
-
-        output_results(opts, "Read", read_mm_table, parms.num_iters, raw_size);
-
-        /* accumulate and output the max, min, and average "gross read" times */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("Read Open-Close details:\n");
-            output_all_info(read_gross_mm_table, parms.num_iters, 4);
-        }
+/*
+ * Function:    set_info_hints
+ * Purpose:     Add the KEY=VALUE;... MPI-IO hints HINTS to h5_io_info_g,
+ *              creating it if needed.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+set_info_hints(const char *hints)
+{
+    const char *end = hints;
 
-        output_results(opts, "Read Open-Close", read_gross_mm_table,parms.num_iters, raw_size);
+    if (h5_io_info_g == MPI_INFO_NULL)
+        MPI_Info_create(&h5_io_info_g);
 
-        if (opts->print_times) {
-            output_times(opts,"Read File Open",read_open_mm_table,parms.num_iters);
-            output_times(opts,"Read File Close",read_close_mm_table,parms.num_iters);
-        }
+    while (*end != '\0') {
+        char key[MPI_MAX_INFO_KEY + 1], val[MPI_MAX_INFO_VAL + 1];
+        size_t len = strcspn(end, ";");
+        const char *eq = memchr(end, '=', len);
 
-        /* Print out time from open to first read */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("Read file open details:\n");
-            output_all_info(read_open_mm_table, parms.num_iters, 4);
+        if (eq == NULL || eq == end || (size_t)(eq - end) > MPI_MAX_INFO_KEY ||
+                len - (size_t)(eq - end) - 1 > MPI_MAX_INFO_VAL) {
+            if (comm_world_rank_g == 0)
+                fprintf(stderr, "%s: invalid hints %s\n", progname, hints);
+            return FAIL;
         }
 
-        /* Print out time from last read to close */
-        if (pio_debug_level >= 3) {
-            /* output all of the times for all iterations */
-            print_indent(3);
-            output_report("Read file close details:\n");
-            output_all_info(read_close_mm_table, parms.num_iters, 4);
-        }
+        HDstrncpy(key, end, (size_t)(eq - end));
+        key[eq - end] = '\0';
+        HDstrncpy(val, eq + 1, len - (size_t)(eq - end) - 1);
+        val[len - (size_t)(eq - end) - 1] = '\0';
 
-    }
+        if (MPI_Info_set(h5_io_info_g, key, val) != MPI_SUCCESS)
+            return FAIL;
 
-    /* clean up our mess */
-    free(write_mpi_mm_table);
-    free(write_mm_table);
-    free(write_gross_mm_table);
-    free(write_raw_mm_table);
-    free(write_open_mm_table);
-    free(write_close_mm_table);
+        end += len;
 
-    if (!parms.h5_write_only) {
-        free(read_mpi_mm_table);
-        free(read_mm_table);
-        free(read_gross_mm_table);
-        free(read_raw_mm_table);
-        free(read_open_mm_table);
-        free(read_close_mm_table);
+        if (*end == ';')
+            end++;
     }
 
-    return ret_value;
+    return SUCCESS;
 }
 
 /*
- * Function:    output_all_info
- * Purpose:
- * Return:      Nothing
- * Programmer:  Bill Wendling, 29. January 2002
+ * Function:    restart_phase
+ * Purpose:     Run one phase of a checkpoint/restart test, the checkpoint
+ *              write or the restart read given by PARMS, on the first
+ *              NUM_PROCS processes of MPI_COMM_WORLD, on the communicator
+ *              build_comm_worlds split for them.  All processes of
+ *              MPI_COMM_WORLD must call it.
+ * Return:      SUCCESS or FAIL; *SECONDS is the time of the slowest
+ *              process from file open to close.
  * Modifications:
  */
-static void
-output_all_info(minmax *mm, int count, int indent_level)
+static int
+restart_phase(parameters parms, int num_procs, double *seconds)
 {
-    int i;
+    results res;
+    double t = 0.0;
+    int rc = SUCCESS, all_rc;
+    int doing_pio;
 
-    for (i = 0; i < count; ++i) {
-        print_indent(indent_level);
-        output_report("Iteration %d:\n", i + 1);
-        print_indent(indent_level + 1);
-        output_report("Minimum Time: %.2fs\n", mm[i].min);
-        print_indent(indent_level + 1);
-        output_report("Maximum Time: %.2fs\n", mm[i].max);
+    if (select_comm_world(num_procs, &doing_pio) != SUCCESS)
+        return FAIL;
+
+    if (doing_pio) {
+        parms.num_procs = num_procs;
+        MPI_Barrier(pio_comm_g);
+        res = do_pio(parms);
+        rc = res.ret_code;
+        t = get_time(res.timers, parms.read_only ? HDF5_GROSS_READ_FIXED_DIMS :
+                     HDF5_GROSS_WRITE_FIXED_DIMS);
+        pio_time_destroy(res.timers);
     }
+
+    pio_comm_g = MPI_COMM_WORLD;
+    MPI_Allreduce(&t, seconds, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&rc, &all_rc, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    return all_rc;
 }
 
 /*
- * Function:    get_minmax
- * Purpose:     Gather all the min, max and total of val.
+ * Function:    run_restart_test
+ * Purpose:     Checkpoint/restart workload.  For every writer count of
+ *              the process schedule the datasets are written by that
+ *              many processes, then read back by every reader count given
+ *              with --restart, so each reader picks up a slice that
+ *              several writers (or a part of one) produced.  With strong
+ *              scaling the checkpoint holds bytes-per-process times the
+ *              maximum number of processes whatever the writer count; with
+ *              weak scaling it grows with the writers.  Each row reports
+ *              the checkpoint and restart times of the slowest process,
+ *              open to close, and their sum as the time to solution.
  * Return:      Nothing
- * Programmer:  Bill Wendling, 21. December 2001
  * Modifications:
- *    Use MPI_Allreduce to do it. -akc, 2002/01/11
  */
 static void
-get_minmax(minmax *mm, double val)
+run_restart_test(struct options *opts, parameters parms)
 {
-    int myrank;
+    static const struct {
+        long mask;
+        iotype iot;
+        const char *name;
+    } apis[] = {
+        { PIO_POSIX, POSIXIO, "POSIX" },
+        { PIO_MPI, MPIO, "MPIO" },
+        { PIO_HDF5, PHDF5, "PHDF5" },
+    };
+    int scaling;
 
-    MPI_Comm_rank(pio_comm_g, &myrank);
-    MPI_Comm_size(pio_comm_g, &mm->num);
+    pio_comm_g = MPI_COMM_WORLD;
+    parms.keep_files = TRUE;
+
+    for (scaling = PIO_SCALE_STRONG; scaling <= PIO_SCALE_WEAK; scaling <<= 1) {
+        int p;
+
+        if (!(opts->scaling & scaling))
+            continue;
+
+        output_report("Checkpoint/Restart, %s scaling:\n",
+                      scaling == PIO_SCALE_STRONG ? "strong" : "weak");
+        print_indent(1);
+        output_report("%-5s %7s %7s %5s %10s %10s %10s %9s %11s %9s %11s %10s\n",
+                      "API", "writers", "readers", "dsets", "block", "xfer", "ckpt MB",
+                      "ckpt s", "ckpt MB/s", "restart s", "restart MB/s", "solution s");
+
+        for (p = 0; p < opts->procs_sched.num; p++) {
+            int num_procs = (int)opts->procs_sched.vals[p];
+            off_t side;             /* dataset length, a side in 2D */
+            int cell;
+
+            side = opts->num_bpp *
+                (scaling == PIO_SCALE_STRONG ? opts->max_num_procs : num_procs);
+            parms.num_bytes = parms.dim2d ? side * side : side;
+
+            /* every dataset count, block size and transfer size in turn */
+            for (cell = 0; cell < opts->dsets_sched.num * opts->blk_sched.num *
+                    opts->xfer_sched.num; cell++) {
+                int x = cell % opts->xfer_sched.num;
+                int b = (cell / opts->xfer_sched.num) % opts->blk_sched.num;
+                int d = cell / (opts->xfer_sched.num * opts->blk_sched.num);
+                size_t buf_size = (size_t)opts->xfer_sched.vals[x];
+                double ckpt_bytes;
+                size_t a;
+                int r;
+
+                parms.num_dsets = (long)opts->dsets_sched.vals[d];
+                parms.blk_size = (size_t)opts->blk_sched.vals[b];
+                parms.buf_size = buf_size;
+                ckpt_bytes = (double)parms.num_files * (double)parms.num_dsets *
+                             (double)parms.num_bytes;
+
+                for (a = 0; a < sizeof(apis) / sizeof(apis[0]); a++) {
+                    if (!(opts->io_types & apis[a].mask))
+                        continue;
+
+                    parms.io_type = apis[a].iot;
+
+                    for (r = 0; r < opts->num_restarts; r++) {
+                        int readers = opts->restart_procs[r];
+                        double write_sum = 0.0, read_sum = 0.0;
+                        int i, ok = SUCCESS;
+
+                        print_indent(1);
+                        output_report("%-5s %7d %7d %5ld %10ld %10ld %10.2f ",
+                                      apis[a].name, num_procs, readers, parms.num_dsets,
+                                      (long)parms.blk_size, (long)buf_size,
+                                      ckpt_bytes / ONE_MB);
+
+                        /* do_pio insists that every process gets whole
+                         * transfers; say so here rather than fail there */
+                        if (buf_size == 0 || (side % num_procs) || (side % readers) ||
+                                (parms.dim2d ? (side % (off_t)buf_size) :
+                                 ((side / num_procs) % (off_t)buf_size) ||
+                                 ((side / readers) % (off_t)buf_size))) {
+                            output_report("skipped: data does not divide evenly\n");
+                            continue;
+                        }
 
-    MPI_Allreduce(&val, &mm->max, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
-    MPI_Allreduce(&val, &mm->min, 1, MPI_DOUBLE, MPI_MIN, pio_comm_g);
-    MPI_Allreduce(&val, &mm->sum, 1, MPI_DOUBLE, MPI_SUM, pio_comm_g);
+                        for (i = 0; i < parms.num_iters && ok == SUCCESS; i++) {
+                            parameters phase = parms;
+                            double t;
+
+                            /* with -D v the readers check what other
+                             * processes wrote: all write the same bytes */
+                            phase.verify_shared = TRUE;
+
+                            /* checkpoint: writers write and keep the files */
+                            phase.h5_write_only = TRUE;
+                            phase.read_only = FALSE;
+                            phase.keep_files = TRUE;
+                            ok = restart_phase(phase, num_procs, &t);
+                            write_sum += t;
+
+                            /* restart: readers read them back and remove
+                             * them, unless the files are to be kept */
+                            phase.h5_write_only = FALSE;
+                            phase.read_only = TRUE;
+                            phase.keep_files = opts->keep_files;
+                            if (ok == SUCCESS)
+                                ok = restart_phase(phase, readers, &t);
+                            read_sum += t;
+                        }
+
+                        if (ok != SUCCESS) {
+                            output_report("failed\n");
+
+                            /* the readers did not get to remove the files */
+                            if (!opts->keep_files) {
+                                pio_comm_g = MPI_COMM_WORLD;
+                                pio_mpi_rank_g = comm_world_rank_g;
+                                do_pio_cleanup(parms);
+                            }
+                            continue;
+                        }
+
+                        write_sum /= parms.num_iters;
+                        read_sum /= parms.num_iters;
+                        output_report("%9.3f %11.2f %9.3f %11.2f %10.3f\n",
+                                      write_sum, MB_PER_SEC(ckpt_bytes, write_sum),
+                                      read_sum, MB_PER_SEC(ckpt_bytes, read_sum),
+                                      write_sum + read_sum);
+                    }
+                }
+            }
+        }
+    }
 }
 
 /*
- * Function:    accumulate_minmax_stuff
- * Purpose:     Accumulate the minimum, maximum, and average of the times
- *              across all processes.
- * Return:      TOTAL_MM - the total of all of these.
- * Programmer:  Bill Wendling, 21. December 2001
+ * Function:    run_chunk_sweep
+ * Purpose:     Run the PHDF5 test once for every ratio given with
+ *              --chunk-sweep, with chunks of that many times the bytes of
+ *              one transfer, then print throughput and chunk cache hits
+ *              and misses against the ratio.  A chunk keeps the shape of
+ *              the transfer: in 2D only its long side is scaled.  Chunk
+ *              dims are clamped to the dataset, so the reported ratio is
+ *              the one that was run.
+ * Return:      Nothing
  * Modifications:
- *              Changed to use seconds instead of MB/s - QAK, 5/9/02
  */
-static minmax
-accumulate_minmax_stuff(minmax *mm, int count)
+static void
+run_chunk_sweep(struct options *opts, parameters parms)
 {
-    int i;
-    minmax total_mm;
+    chunk_point points[PIO_MAX_RATIOS];
+    hsize_t side;               /* dataset length along a dimension     */
+    double xfer_bytes;          /* bytes of one transfer of a process   */
+    int r;
+
+    if (parms.dim2d) {
+        side = (hsize_t)opts->num_bpp * (hsize_t)parms.num_procs;
+        xfer_bytes = (double)parms.buf_size * (double)parms.blk_size;
+    } else {
+        side = (hsize_t)parms.num_bytes;
+        xfer_bytes = (double)parms.buf_size;
+    }
 
-    total_mm.sum = 0.0;
-    total_mm.max = -DBL_MAX;
-    total_mm.min = DBL_MAX;
-    total_mm.num = count;
+    parms.h5_use_chunks = TRUE;
 
-    for (i = 0; i < count; ++i) {
-        double m = mm[i].max;
+    for (r = 0; r < opts->num_ratios; r++) {
+        chunk_point *pt = &points[r];
+        double len = opts->chunk_ratios[r] * (double)parms.buf_size;
+        hsize_t h5len = len < 1.0 ? 1 : MIN((hsize_t)len, side);
 
-        total_mm.sum += m;
+        if (!parms.dim2d) {
+            pt->dims[0] = h5len;
+            pt->dims[1] = 1;
+        } else if (parms.interleaved) {
+            pt->dims[0] = h5len;
+            pt->dims[1] = MIN((hsize_t)parms.blk_size, side);
+        } else {
+            pt->dims[0] = MIN((hsize_t)parms.blk_size, side);
+            pt->dims[1] = h5len;
+        }
+        pt->ratio = xfer_bytes > 0.0 ?
+            (double)pt->dims[0] * (double)pt->dims[1] / xfer_bytes : 0.0;
 
-        if (m < total_mm.min)
-            total_mm.min = m;
+        parms.h5_chunk[0] = pt->dims[0];
+        parms.h5_chunk[1] = pt->dims[1];
 
-        if (m > total_mm.max)
-            total_mm.max = m;
+        print_indent(1);
+        if (parms.dim2d)
+            output_report("Chunk Size: %ldx%ld bytes (%.3g x transfer)\n",
+                          (long)pt->dims[0], (long)pt->dims[1], pt->ratio);
+        else
+            output_report("Chunk Size: %ld bytes (%.3g x transfer)\n",
+                          (long)pt->dims[0], pt->ratio);
+
+        run_test(PHDF5, parms, opts, pt);
     }
 
-    return total_mm;
+    print_indent(2);
+    output_report("Chunk Size Sweep (PHDF5, average throughput):\n");
+    print_indent(3);
+    output_report("%10s %21s %11s %11s %19s %19s\n", "chunk/xfer", "chunk dims",
+                  "write MB/s", "read MB/s", "write hits/misses",
+                  "read hits/misses");
+
+    for (r = 0; r < opts->num_ratios; r++) {
+        chunk_point *pt = &points[r];
+        char dims[32], whm[32], rhm[32];
+
+        if (parms.dim2d)
+            sprintf(dims, "%ldx%ld", (long)pt->dims[0], (long)pt->dims[1]);
+        else
+            sprintf(dims, "%ld", (long)pt->dims[0]);
+        sprintf(whm, "%ld/%ld", pt->write_hits, pt->write_misses);
+        sprintf(rhm, "%ld/%ld", pt->read_hits, pt->read_misses);
+
+        print_indent(3);
+        if (parms.h5_write_only)
+            output_report("%10.3g %21s %11.2f %11s %19s %19s\n", pt->ratio, dims,
+                          pt->write_mbs, "-", whm, "-");
+        else
+            output_report("%10.3g %21s %11.2f %11.2f %19s %19s\n", pt->ratio, dims,
+                          pt->write_mbs, pt->read_mbs, whm, rhm);
+    }
 }
 
 /*
- * Function:    create_comm_world
- * Purpose:     Create an MPI Comm world and store it in pio_comm_g, which
- *              is a global variable.
- * Return:      SUCCESS on success.
- *              FAIL otherwise.
- * Programmer:  Bill Wendling, 19. December 2001
+ * Function:    run_group_test
+ * Purpose:     Split MPI_COMM_WORLD into the process groups given with
+ *              --groups and run every group's workload at the same time,
+ *              each against its own files.  A group that only reads first
+ *              writes its files untimed, then all groups start together.
+ *              Each group reports into its own file; rank 0 of
+ *              MPI_COMM_WORLD then prints the bandwidth every group saw
+ *              and the aggregate over all of them.
+ * Return:      Nothing
  * Modifications:
  */
-static int
-create_comm_world(int num_procs, int *doing_pio)
+static void
+run_group_test(struct options *opts, parameters parms)
 {
-    /* MPI variables */
-    int     mrc;     /* return values                */
-    int     color;              /* for communicator creation    */
-    int     myrank, nprocs;
+    FILE       *summary = output;
+    char        fname[FILENAME_MAX];
+    int         sizes[PIO_MAX_GROUPS];
+    double      mine[4];        /* group, # of processes, bytes, seconds */
+    double     *all = NULL;
+    double      total_bytes = 0.0, slowest = 0.0;
+    double      elapsed = 0.0, bytes = 0.0;
+    int         shared = 0, left = comm_world_nprocs_g;
+    int         color = MPI_UNDEFINED, first = 0;
+    int         g, x, phases;
+    size_t      buf_size;
+    group_spec *spec;
+
+    /* processes not given to a group are shared by the others */
+    for (g = 0; g < opts->num_groups; g++)
+        if (opts->groups[g].num_procs > 0)
+            left -= opts->groups[g].num_procs;
+        else
+            shared++;
+
+    if (left < shared) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: the process groups need more than the %d "
+                    "processes in MPI_COMM_WORLD\n", progname,
+                    comm_world_nprocs_g);
+        return;
+    }
 
-    pio_comm_g = MPI_COMM_NULL;
+    for (g = 0; g < opts->num_groups; g++) {
+        sizes[g] = opts->groups[g].num_procs;
 
-    /*
-     * Create a sub communicator for this PIO run. Easier to use the first N
-     * processes.
-     */
-    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+        if (sizes[g] == 0)
+            sizes[g] = left / shared + (g < left % shared ? 1 : 0);
 
-    if (num_procs > nprocs) {
-        fprintf(stderr,
-                "number of process(%d) must be <= number of processes in MPI_COMM_WORLD(%d)\n",
-                num_procs, nprocs);
-        goto error_done;
+        if (comm_world_rank_g >= first && comm_world_rank_g < first + sizes[g])
+            color = g;
+
+        first += sizes[g];
     }
 
-    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-    color = (myrank < num_procs);
-    mrc = MPI_Comm_split(MPI_COMM_WORLD, color, myrank, &pio_comm_g);
+    if (MPI_Comm_split(MPI_COMM_WORLD, color, comm_world_rank_g,
+                       &pio_comm_g) != MPI_SUCCESS) {
+        fprintf(stderr, "%s: MPI_Comm_split failed\n", progname);
+        return;
+    }
 
-    if (mrc != MPI_SUCCESS) {
-        fprintf(stderr, "MPI_Comm_split failed\n");
-        goto error_done;
+    mine[0] = (color == MPI_UNDEFINED) ? -1.0 : (double)color;
+    mine[1] = mine[2] = mine[3] = 0.0;
+
+    if (color != MPI_UNDEFINED) {
+        spec = &opts->groups[color];
+        phases = ((spec->mode & PIO_GROUP_WRITE) ? 1 : 0) +
+                 ((spec->mode & PIO_GROUP_READ) ? 1 : 0);
+
+        MPI_Comm_size(pio_comm_g, &pio_mpi_nprocs_g);
+        MPI_Comm_rank(pio_comm_g, &pio_mpi_rank_g);
+
+        parms.group = color;
+        parms.io_type = spec->io_type;
+        parms.num_procs = pio_mpi_nprocs_g;
+        parms.h5_write_only = !(spec->mode & PIO_GROUP_READ);
+        parms.read_only = !(spec->mode & PIO_GROUP_WRITE);
+        parms.keep_files = parms.read_only;
+
+        if (pio_mpi_rank_g == 0) {
+            sprintf(fname, "%s.group%d",
+                    opts->output_file ? opts->output_file : progname, color);
+
+            if ((output = fopen(fname, "w")) == NULL) {
+                perror(fname);
+                output = summary;
+            }
+        }
+
+        output_report("Process group %d, number of processors = %ld\n",
+                      color, parms.num_procs);
     }
 
-    if (!color) {
-        /* not involved in this run */
-        mrc = destroy_comm_world();
-        goto done;
+    for (x = 0; x < opts->xfer_sched.num; x++) {
+        double start;
+
+        buf_size = (size_t)opts->xfer_sched.vals[x];
+
+        if (color != MPI_UNDEFINED) {
+            parms.buf_size = buf_size;
+
+            if (parms.dim2d)
+                parms.num_bytes = (off_t)pow((double)(opts->num_bpp*parms.num_procs),2);
+            else
+                parms.num_bytes = (off_t)opts->num_bpp*parms.num_procs;
+
+            /* readers need their files in place before the clock starts */
+            if (parms.read_only) {
+                parameters setup = parms;
+                results res;
+
+                setup.num_iters = 1;
+                setup.h5_write_only = TRUE;
+                setup.read_only = FALSE;
+                res = do_pio(setup);
+                pio_time_destroy(res.timers);
+            }
+        }
+
+        /* all groups start at the same time */
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+
+        if (color != MPI_UNDEFINED) {
+            output_report("Transfer Buffer Size: %ld bytes, File size: %.2f MBs\n",
+                          buf_size, ((double)parms.num_dsets * (double)parms.num_bytes) / ONE_MB);
+            run_test(spec->io_type, parms, opts, NULL);
+            MPI_Barrier(pio_comm_g);
+            elapsed += MPI_Wtime() - start;
+            bytes += (double)phases * (double)parms.num_iters * (double)parms.num_files *
+                     (double)parms.num_dsets * (double)parms.num_bytes;
+
+            if (parms.keep_files)
+                do_pio_cleanup(parms);
+        }
     }
 
-    /* determine the MPI rank in the PIO communicator */
-    MPI_Comm_size(pio_comm_g, &pio_mpi_nprocs_g);
-    MPI_Comm_rank(pio_comm_g, &pio_mpi_rank_g);
+    if (color != MPI_UNDEFINED) {
+        mine[1] = (double)pio_mpi_nprocs_g;
+        mine[2] = bytes;
+        mine[3] = elapsed;
 
-done:
-    *doing_pio = color;
-    return SUCCESS;
+        if (output != summary) {
+            fclose(output);
+            output = summary;
+        }
 
-error_done:
-    destroy_comm_world();
-    return FAIL;
-}
+        destroy_comm_world();
+    }
 
-/*
- * Function:    destroy_comm_world
- * Purpose:     Destroy the created MPI Comm world which is stored in the
- *              pio_comm_g global variable.
- * Return:      SUCCESS on success.
- *              FAIL otherwise.
- * Programmer:  Bill Wendling, 19. December 2001
- * Modifications:
- */
-static int
-destroy_comm_world(void)
-{
-    int     mrc = SUCCESS;      /* return code      */
+    pio_comm_g = MPI_COMM_WORLD;
 
-    /* release MPI resources */
-    if (pio_comm_g != MPI_COMM_NULL)
-        mrc = (MPI_Comm_free(&pio_comm_g) == MPI_SUCCESS ? SUCCESS : FAIL);
+    if (comm_world_rank_g == 0)
+        all = malloc(sizeof(mine) * (size_t)comm_world_nprocs_g);
 
-    return mrc;
+    MPI_Gather(mine, 4, MPI_DOUBLE, all, 4, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (comm_world_rank_g == 0) {
+        int i;
+
+        fprintf(output, "Concurrent process groups:\n");
+
+        for (i = 0; i < comm_world_nprocs_g; i++) {
+            double *row = all + 4 * i;
+
+            /* the first rank of each group speaks for it */
+            if (row[0] < 0.0 || row[1] == 0.0 || (i > 0 && row[-4] == row[0]))
+                continue;
+
+            g = (int)row[0];
+            print_indent(1);
+            fprintf(output, "Group %d: %s %s, %d process(es), %.2f MB in %.3f s, "
+                    "%.2f MB/s\n", g,
+                    opts->groups[g].io_type == POSIXIO ? "POSIX" :
+                    opts->groups[g].io_type == MPIO ? "MPIO" : "PHDF5",
+                    group_mode_name(opts->groups[g].mode),
+                    (int)row[1], row[2] / ONE_MB, row[3],
+                    MB_PER_SEC(row[2], row[3]));
+            total_bytes += row[2];
+            if (row[3] > slowest)
+                slowest = row[3];
+        }
+
+        print_indent(1);
+        fprintf(output, "Aggregate: %.2f MB in %.3f s, %.2f MB/s\n",
+                total_bytes / ONE_MB, slowest, MB_PER_SEC(total_bytes, slowest));
+        free(all);
+    }
 }
 
 /*
- * Function:    output_results
- * Purpose:     Print information about the time & bandwidth for a given
- *                  minmax & # of iterations.
+ * Function:    run_test
+ * Purpose:     Inner loop call to actually run the I/O test.
  * Return:      Nothing
- * Programmer:  Quincey Koziol, 9. May 2002
+ * Programmer:  Bill Wendling, 18. December 2001
  * Modifications:
  */
-static void
-output_results(const struct options *opts, const char *name, minmax *table,
+static int
+run_test(iotype iot, parameters parms, struct options *opts, chunk_point *point)
+{
+    results         res;
+    register int    i, ret_value = SUCCESS;
+    int             comm_size;
+    off_t           raw_size;
+    minmax         *write_mpi_mm_table=NULL;
+    minmax         *write_mm_table=NULL;
+    minmax         *write_gross_mm_table=NULL;
+    minmax         *write_raw_mm_table=NULL;
+    minmax         *read_mpi_mm_table=NULL;
+    minmax         *read_mm_table=NULL;
+    minmax         *read_gross_mm_table=NULL;
+    minmax         *read_raw_mm_table=NULL;
+    minmax         *read_open_mm_table=NULL;
+    minmax         *read_close_mm_table=NULL;
+    minmax         *write_open_mm_table=NULL;
+    minmax         *write_close_mm_table=NULL;
+    minmax          write_mpi_mm = {0.0, 0.0, 0.0, 0};
+    minmax          write_mm = {0.0, 0.0, 0.0, 0};
+    minmax          write_gross_mm = {0.0, 0.0, 0.0, 0};
+    minmax          write_raw_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_mpi_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_gross_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_raw_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_open_mm = {0.0, 0.0, 0.0, 0};
+    minmax          read_close_mm = {0.0, 0.0, 0.0, 0};
+    minmax          write_open_mm = {0.0, 0.0, 0.0, 0};
+    minmax          write_close_mm = {0.0, 0.0, 0.0, 0};
+    int             stripe_misaligned = 0;  /* # of misaligned processes */
+    int             stripe_unknown = 1;     /* some could not tell      */
+    long            num_steps = 0;  /* append steps of all processes    */
+    double          step_min = 0.0, step_max = 0.0, step_sum = 0.0;
+    double          swmr_plain = 0.0, swmr_write = 0.0, swmr_flush = 0.0;
+    long            num_seen = 0;   /* steps seen by all SWMR readers   */
+    double          seen_min = 0.0, seen_max = 0.0, seen_sum = 0.0;
+    long            cache_counts[4] = {0, 0, 0, 0};  /* chunk cache write
+                                     * hits/misses, read hits/misses    */
+    mpio_modes      write_modes, read_modes;    /* collective transfers
+                                     * of all processes, as done        */
+    long long       write_counters[NUM_COUNTERS];   /* event counts of all
+                                     * processes, -1 if not counted     */
+    long long       read_counters[NUM_COUNTERS];
+    double          write_wall = 0.0, read_wall = 0.0;  /* open to close
+                                     * times of all processes           */
+    bw_series      *write_series = NULL;    /* sampled bandwidth of each */
+    bw_series      *read_series = NULL;     /* iteration, if asked       */
+
+    raw_size = parms.num_files * (off_t)parms.num_dsets * (off_t)parms.num_bytes;
+    parms.io_type = iot;
+    print_indent(2);
+    output_report("IO API = ");
+
+    switch (iot) {
+        case POSIXIO:
+            output_report("POSIX\n");
+            break;
+        case MPIO:
+            output_report("MPIO\n");
+            break;
+        case PHDF5:
+#ifdef PIO_THREADS
+            /* the threads take turns in the library, see the usage */
+            output_report("PHDF5 (w/%s driver, serialized by the HDF5 library lock)\n",
+                          driver_name(parms.h5_driver));
+#else
+            output_report("PHDF5 (w/%s driver)\n", driver_name(parms.h5_driver));
+#endif  /* PIO_THREADS */
+            break;
+    }
+
+    MPI_Comm_size(pio_comm_g, &comm_size);
+
+    memset(&write_modes, 0, sizeof(write_modes));
+    memset(&read_modes, 0, sizeof(read_modes));
+    memset(write_counters, 0, sizeof(write_counters));
+    memset(read_counters, 0, sizeof(read_counters));
+
+    /* allocate space for tables minmax and that it is sufficient */
+    /* to initialize all elements to zeros by calloc.             */
+    write_mpi_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    write_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    write_gross_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    write_raw_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    write_open_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    write_close_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    if (!parms.h5_write_only) {
+        read_mpi_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+        read_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+        read_gross_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+        read_raw_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+        read_open_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+        read_close_mm_table = calloc((size_t)parms.num_iters , sizeof(minmax));
+    }
+    if (parms.sample_interval > 0.0) {
+        write_series = calloc((size_t)parms.num_iters, sizeof(bw_series));
+        read_series = calloc((size_t)parms.num_iters, sizeof(bw_series));
+    }
+
+    /* Do IO iteration times, collecting statistics each time */
+    for (i = 0; i < parms.num_iters; ++i) {
+        double t;
+
+        MPI_Barrier(pio_comm_g);
+        res = do_pio(parms);
+
+        /* gather all of the "mpi write" times */
+        t = get_time(res.timers, HDF5_MPI_WRITE);
+        get_minmax(&write_mpi_mm, t);
+
+        write_mpi_mm_table[i] = write_mpi_mm;
+
+        /* gather all of the "write" times */
+        t = get_time(res.timers, HDF5_FINE_WRITE_FIXED_DIMS);
+        get_minmax(&write_mm, t);
+
+        write_mm_table[i] = write_mm;
+
+        /* gather all of the "write" times from open to close */
+        t = get_time(res.timers, HDF5_GROSS_WRITE_FIXED_DIMS);
+        get_minmax(&write_gross_mm, t);
+
+        write_gross_mm_table[i] = write_gross_mm;
+
+        /* gather all of the raw "write" times */
+        t = get_time(res.timers, HDF5_RAW_WRITE_FIXED_DIMS);
+        get_minmax(&write_raw_mm, t);
+
+        write_raw_mm_table[i] = write_raw_mm;
+
+        /* gather all of the file open times (time from open to first write) */
+        t = get_time(res.timers, HDF5_FILE_WRITE_OPEN);
+        get_minmax(&write_open_mm, t);
+
+        write_open_mm_table[i] = write_open_mm;
+
+        /* gather all of the file close times (time from last write to close) */
+        t = get_time(res.timers, HDF5_FILE_WRITE_CLOSE);
+        get_minmax(&write_close_mm, t);
+
+        write_close_mm_table[i] = write_close_mm;
+
+        /* count the processes whose first byte is off a stripe boundary,
+         * if all of them could tell */
+        MPI_Allreduce(&res.stripe_unknown, &stripe_unknown, 1, MPI_INT,
+                      MPI_MAX, pio_comm_g);
+        MPI_Allreduce(&res.stripe_misaligned, &stripe_misaligned, 1, MPI_INT,
+                      MPI_SUM, pio_comm_g);
+
+        /* add up the event counts of all processes, open to close */
+        if (parms.counters) {
+            reduce_counters(res.timers, HDF5_GROSS_WRITE_FIXED_DIMS,
+                            write_counters, &write_wall);
+            if (!parms.h5_write_only)
+                reduce_counters(res.timers, HDF5_GROSS_READ_FIXED_DIMS,
+                                read_counters, &read_wall);
+        }
+
+        /* add up the bandwidth samples of all processes, open to close */
+        if (parms.sample_interval > 0.0) {
+            reduce_samples(res.timers, HDF5_GROSS_WRITE_FIXED_DIMS, &write_series[i]);
+            if (!parms.h5_write_only)
+                reduce_samples(res.timers, HDF5_GROSS_READ_FIXED_DIMS, &read_series[i]);
+        }
+
+        /* add up the chunk cache hits and misses of all processes */
+        if (iot == PHDF5) {
+            long counts[4], sums[4];
+            int k;
+
+            counts[0] = res.write_hits;
+            counts[1] = res.write_misses;
+            counts[2] = res.read_hits;
+            counts[3] = res.read_misses;
+            MPI_Allreduce(counts, sums, 4, MPI_LONG, MPI_SUM, pio_comm_g);
+            for (k = 0; k < 4; k++)
+                cache_counts[k] += sums[k];
+
+            if (parms.collective) {
+                reduce_mpio_modes(&res.write_modes, &write_modes);
+                reduce_mpio_modes(&res.read_modes, &read_modes);
+            }
+        }
+
+        /* gather the append step latencies of all processes */
+        if (parms.append || parms.swmr) {
+            long steps;
+            double t_min, t_max, t_sum;
+
+            MPI_Allreduce(&res.num_steps, &steps, 1, MPI_LONG, MPI_SUM, pio_comm_g);
+            t = res.num_steps ? res.step_min : DBL_MAX;
+            MPI_Allreduce(&t, &t_min, 1, MPI_DOUBLE, MPI_MIN, pio_comm_g);
+            MPI_Allreduce(&res.step_max, &t_max, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+            MPI_Allreduce(&res.step_sum, &t_sum, 1, MPI_DOUBLE, MPI_SUM, pio_comm_g);
+
+            if (num_steps == 0 || t_min < step_min)
+                step_min = t_min;
+            if (t_max > step_max)
+                step_max = t_max;
+            step_sum += t_sum;
+            num_steps += steps;
+        }
+
+        /* gather the SWMR writer times and what the readers saw */
+        if (parms.swmr) {
+            long seen;
+            double t_min, t_max, t_sum;
+
+            MPI_Allreduce(&res.swmr_plain, &t, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+            swmr_plain += t;
+            MPI_Allreduce(&res.swmr_write, &t, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+            swmr_write += t;
+            MPI_Allreduce(&res.swmr_flush, &t, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+            swmr_flush += t;
+
+            MPI_Allreduce(&res.num_seen, &seen, 1, MPI_LONG, MPI_SUM, pio_comm_g);
+            t = res.num_seen ? res.seen_min : DBL_MAX;
+            MPI_Allreduce(&t, &t_min, 1, MPI_DOUBLE, MPI_MIN, pio_comm_g);
+            MPI_Allreduce(&res.seen_max, &t_max, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+            MPI_Allreduce(&res.seen_sum, &t_sum, 1, MPI_DOUBLE, MPI_SUM, pio_comm_g);
+
+            if (seen > 0) {
+                if (num_seen == 0 || t_min < seen_min)
+                    seen_min = t_min;
+                if (t_max > seen_max)
+                    seen_max = t_max;
+                seen_sum += t_sum;
+                num_seen += seen;
+            }
+        }
+
+        if (!parms.h5_write_only) {
+            /* gather all of the "mpi read" times */
+            t = get_time(res.timers, HDF5_MPI_READ);
+            get_minmax(&read_mpi_mm, t);
+
+            read_mpi_mm_table[i] = read_mpi_mm;
+
+            /* gather all of the "read" times */
+            t = get_time(res.timers, HDF5_FINE_READ_FIXED_DIMS);
+            get_minmax(&read_mm, t);
+
+            read_mm_table[i] = read_mm;
+
+            /* gather all of the "read" times from open to close */
+            t = get_time(res.timers, HDF5_GROSS_READ_FIXED_DIMS);
+            get_minmax(&read_gross_mm, t);
+
+            read_gross_mm_table[i] = read_gross_mm;
+
+            /* gather all of the raw "read" times */
+            t = get_time(res.timers, HDF5_RAW_READ_FIXED_DIMS);
+            get_minmax(&read_raw_mm, t);
+
+            read_raw_mm_table[i] = read_raw_mm;
+
+            /* gather all of the file open times (time from open to first read) */
+            t = get_time(res.timers, HDF5_FILE_READ_OPEN);
+            get_minmax(&read_open_mm, t);
+
+            read_open_mm_table[i] = read_open_mm;
+
+            /* gather all of the file close times (time from last read to close) */
+            t = get_time(res.timers, HDF5_FILE_READ_CLOSE);
+            get_minmax(&read_close_mm, t);
+
+            read_close_mm_table[i] = read_close_mm;
+
+         }
+
+         pio_time_destroy(res.timers);
+    }
+
+    /*
+     * Show various statistics
+     */
+    /* SWMR statistics */
+    if (parms.swmr) {
+        print_indent(3);
+        output_report("SWMR Writer (%d iteration(s)):\n", parms.num_iters);
+        print_indent(4);
+        output_report("Throughput with SWMR:    %6.2f MB/s (%7.3f s)\n",
+                      MB_PER_SEC(raw_size * parms.num_iters, swmr_write), swmr_write);
+        print_indent(4);
+        output_report("Throughput without SWMR: %6.2f MB/s (%7.3f s)\n",
+                      MB_PER_SEC(raw_size * parms.num_iters, swmr_plain), swmr_plain);
+        print_indent(4);
+        output_report("SWMR Overhead:           %6.1f %%\n",
+                      swmr_plain > 0.0 ? (swmr_write / swmr_plain - 1.0) * 100.0 : 0.0);
+        print_indent(4);
+        output_report("Flush Time:              %7.3f s (%.1f %% of SWMR write time)\n",
+                      swmr_flush, swmr_write > 0.0 ? swmr_flush / swmr_write * 100.0 : 0.0);
+        if (num_steps > 0) {
+            print_indent(4);
+            output_report("Step Latency:            %8.3f / %8.3f / %8.3f ms (min/avg/max)\n",
+                          step_min * 1000.0, step_sum / num_steps * 1000.0,
+                          step_max * 1000.0);
+        }
+
+        print_indent(3);
+        output_report("SWMR Readers (%d process(es)):\n", comm_size - 1);
+        print_indent(4);
+        if (num_seen > 0)
+            output_report("Write to Visible Latency: %8.3f / %8.3f / %8.3f ms "
+                          "(min/avg/max of %ld steps)\n",
+                          seen_min * 1000.0, seen_sum / num_seen * 1000.0,
+                          seen_max * 1000.0, num_seen);
+        else
+            output_report("Write to Visible Latency: no readers\n");
+    }
+
+    /* Write statistics	*/
+    if (!parms.read_only && !parms.swmr) {
+        /* Print the raw data throughput if desired */
+        if (opts->print_raw) {
+            /* accumulate and output the max, min, and average "raw write" times */
+            if (pio_debug_level >= 3) {
+                /* output all of the times for all iterations */
+                print_indent(3);
+                output_report("Raw Data Write details:\n");
+                output_all_info(write_raw_mm_table, parms.num_iters, 4);
+            }
+
+            output_results(opts,"Raw Data Write",write_raw_mm_table,parms.num_iters,raw_size);
+        } /* end if */
+
+        /* show mpi write statics */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("MPI Write details:\n");
+            output_all_info(write_mpi_mm_table, parms.num_iters, 4);
+        }
+
+        /* We don't currently output the MPI write results */
+
+        /* accumulate and output the max, min, and average "write" times */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Write details:\n");
+            output_all_info(write_mm_table, parms.num_iters, 4);
+        }
+
+        output_results(opts,"Write",write_mm_table,parms.num_iters,raw_size);
+
+        if (cache_counts[0] + cache_counts[1] > 0)
+            output_chunk_cache("Write", cache_counts[0], cache_counts[1]);
+
+        if (iot == PHDF5 && parms.collective)
+            output_mpio_modes("Write", &write_modes);
+
+        /* Report the time each append step took */
+        if (parms.append && num_steps > 0) {
+            print_indent(3);
+            output_report("Append Step Latency (%ld step(s) of all processes):\n",
+                          num_steps);
+            print_indent(4);
+            output_report("Minimum Latency: %8.3f ms\n", step_min * 1000.0);
+            print_indent(4);
+            output_report("Average Latency: %8.3f ms\n",
+                          step_sum / num_steps * 1000.0);
+            print_indent(4);
+            output_report("Maximum Latency: %8.3f ms\n", step_max * 1000.0);
+        }
+
+        /* Report processes sharing a stripe with their neighbor */
+        if (parms.stripe_size > 0) {
+            print_indent(3);
+            if (stripe_unknown)
+                output_report("Stripe Alignment: not determined for this layout\n");
+            else
+                output_report("Stripe Alignment: %d of %d process boundaries off a "
+                              "%ld byte stripe boundary%s\n", stripe_misaligned,
+                              comm_size, (long)parms.stripe_size,
+                              stripe_misaligned ? " (lock contention likely)" : "");
+        }
+
+        /* accumulate and output the max, min, and average "gross write" times */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Write Open-Close details:\n");
+            output_all_info(write_gross_mm_table, parms.num_iters, 4);
+        }
+
+        output_results(opts,"Write Open-Close",write_gross_mm_table,parms.num_iters,raw_size);
+
+        if (parms.counters)
+            output_counters("Write", write_counters, write_wall,
+                            (double)raw_size * parms.num_iters);
+
+        if (parms.sample_interval > 0.0)
+            output_samples("Write", write_series, parms.num_iters,
+                           parms.sample_interval);
+
+        if (opts->print_times) {
+            output_times(opts,"Write File Open",write_open_mm_table,parms.num_iters);
+            output_times(opts,"Write File Close",write_close_mm_table,parms.num_iters);
+        }
+
+        /* Print out time from open to first write */
+        if (pio_debug_level >= 3) {
+           /* output all of the times for all iterations */
+           print_indent(3);
+           output_report("Write file open details:\n");
+           output_all_info(write_open_mm_table, parms.num_iters, 4);
+        }
+
+        /* Print out time from last write to close */
+        if (pio_debug_level >= 3) {
+           /* output all of the times for all iterations */
+           print_indent(3);
+           output_report("Write file close details:\n");
+           output_all_info(write_close_mm_table, parms.num_iters, 4);
+        }
+    }
+
+    if (!parms.h5_write_only && !parms.swmr) {
+        /* Read statistics	*/
+        /* Print the raw data throughput if desired */
+        if (opts->print_raw) {
+            /* accumulate and output the max, min, and average "raw read" times */
+            if (pio_debug_level >= 3) {
+                /* output all of the times for all iterations */
+                print_indent(3);
+                output_report("Raw Data Read details:\n");
+                output_all_info(read_raw_mm_table, parms.num_iters, 4);
+            }
+
+            output_results(opts, "Raw Data Read", read_raw_mm_table,
+                           parms.num_iters, raw_size);
+        } /* end if */
+
+        /* show mpi read statics */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("MPI Read details:\n");
+            output_all_info(read_mpi_mm_table, parms.num_iters, 4);
+        }
+
+        /* We don't currently output the MPI read results */
+
+        /* accumulate and output the max, min, and average "read" times */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Read details:\n");
+            output_all_info(read_mm_table, parms.num_iters, 4);
+        }
+
+        output_results(opts, "Read", read_mm_table, parms.num_iters, raw_size);
+
+        if (cache_counts[2] + cache_counts[3] > 0)
+            output_chunk_cache("Read", cache_counts[2], cache_counts[3]);
+
+        if (iot == PHDF5 && parms.collective)
+            output_mpio_modes("Read", &read_modes);
+
+        /* accumulate and output the max, min, and average "gross read" times */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Read Open-Close details:\n");
+            output_all_info(read_gross_mm_table, parms.num_iters, 4);
+        }
+
+        output_results(opts, "Read Open-Close", read_gross_mm_table,parms.num_iters, raw_size);
+
+        if (parms.counters)
+            output_counters("Read", read_counters, read_wall,
+                            (double)raw_size * parms.num_iters);
+
+        if (parms.sample_interval > 0.0)
+            output_samples("Read", read_series, parms.num_iters,
+                           parms.sample_interval);
+
+        if (opts->print_times) {
+            output_times(opts,"Read File Open",read_open_mm_table,parms.num_iters);
+            output_times(opts,"Read File Close",read_close_mm_table,parms.num_iters);
+        }
+
+        /* Print out time from open to first read */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Read file open details:\n");
+            output_all_info(read_open_mm_table, parms.num_iters, 4);
+        }
+
+        /* Print out time from last read to close */
+        if (pio_debug_level >= 3) {
+            /* output all of the times for all iterations */
+            print_indent(3);
+            output_report("Read file close details:\n");
+            output_all_info(read_close_mm_table, parms.num_iters, 4);
+        }
+
+    }
+
+    /* hand the averages to a chunk size sweep */
+    if (point) {
+        minmax total_mm;
+
+        total_mm = accumulate_minmax_stuff(write_mm_table, parms.num_iters);
+        point->write_mbs = MB_PER_SEC(raw_size, total_mm.sum / total_mm.num);
+        point->read_mbs = 0.0;
+        if (!parms.h5_write_only) {
+            total_mm = accumulate_minmax_stuff(read_mm_table, parms.num_iters);
+            point->read_mbs = MB_PER_SEC(raw_size, total_mm.sum / total_mm.num);
+        }
+        point->write_hits = cache_counts[0];
+        point->write_misses = cache_counts[1];
+        point->read_hits = cache_counts[2];
+        point->read_misses = cache_counts[3];
+    }
+
+    /* clean up our mess */
+    free(write_mpi_mm_table);
+    free(write_mm_table);
+    free(write_gross_mm_table);
+    free(write_raw_mm_table);
+    free(write_open_mm_table);
+    free(write_close_mm_table);
+
+    if (!parms.h5_write_only) {
+        free(read_mpi_mm_table);
+        free(read_mm_table);
+        free(read_gross_mm_table);
+        free(read_raw_mm_table);
+        free(read_open_mm_table);
+        free(read_close_mm_table);
+    }
+
+    if (parms.sample_interval > 0.0) {
+        for (i = 0; i < parms.num_iters; i++) {
+            free(write_series[i].bytes);
+            free(read_series[i].bytes);
+        }
+        free(write_series);
+        free(read_series);
+    }
+
+    return ret_value;
+}
+
+/*
+ * Function:    output_all_info
+ * Purpose:
+ * Return:      Nothing
+ * Programmer:  Bill Wendling, 29. January 2002
+ * Modifications:
+ */
+static void
+output_all_info(minmax *mm, int count, int indent_level)
+{
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        print_indent(indent_level);
+        output_report("Iteration %d:\n", i + 1);
+        print_indent(indent_level + 1);
+        output_report("Minimum Time: %.2fs\n", mm[i].min);
+        print_indent(indent_level + 1);
+        output_report("Maximum Time: %.2fs\n", mm[i].max);
+    }
+}
+
+/*
+ * Function:    get_minmax
+ * Purpose:     Gather all the min, max and total of val.
+ * Return:      Nothing
+ * Programmer:  Bill Wendling, 21. December 2001
+ * Modifications:
+ *    Use MPI_Allreduce to do it. -akc, 2002/01/11
+ */
+static void
+get_minmax(minmax *mm, double val)
+{
+    int myrank;
+
+    MPI_Comm_rank(pio_comm_g, &myrank);
+    MPI_Comm_size(pio_comm_g, &mm->num);
+
+    MPI_Allreduce(&val, &mm->max, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+    MPI_Allreduce(&val, &mm->min, 1, MPI_DOUBLE, MPI_MIN, pio_comm_g);
+    MPI_Allreduce(&val, &mm->sum, 1, MPI_DOUBLE, MPI_SUM, pio_comm_g);
+}
+
+/*
+ * Function:    accumulate_minmax_stuff
+ * Purpose:     Accumulate the minimum, maximum, and average of the times
+ *              across all processes.
+ * Return:      TOTAL_MM - the total of all of these.
+ * Programmer:  Bill Wendling, 21. December 2001
+ * Modifications:
+ *              Changed to use seconds instead of MB/s - QAK, 5/9/02
+ */
+static minmax
+accumulate_minmax_stuff(minmax *mm, int count)
+{
+    int i;
+    minmax total_mm;
+
+    total_mm.sum = 0.0;
+    total_mm.max = -DBL_MAX;
+    total_mm.min = DBL_MAX;
+    total_mm.num = count;
+
+    for (i = 0; i < count; ++i) {
+        double m = mm[i].max;
+
+        total_mm.sum += m;
+
+        if (m < total_mm.min)
+            total_mm.min = m;
+
+        if (m > total_mm.max)
+            total_mm.max = m;
+    }
+
+    return total_mm;
+}
+
+/*
+ * Function:    create_comm_world
+ * Purpose:     Create an MPI Comm world and store it in pio_comm_g, which
+ *              is a global variable.
+ * Return:      SUCCESS on success.
+ *              FAIL otherwise.
+ * Programmer:  Bill Wendling, 19. December 2001
+ * Modifications:
+ */
+static int
+create_comm_world(int num_procs, int *doing_pio)
+{
+    /* MPI variables */
+    int     mrc;     /* return values                */
+    int     color;              /* for communicator creation    */
+    int     myrank, nprocs;
+
+    pio_comm_g = MPI_COMM_NULL;
+
+    /*
+     * Create a sub communicator for this PIO run. Easier to use the first N
+     * processes.
+     */
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+    if (num_procs > nprocs) {
+        fprintf(stderr,
+                "number of process(%d) must be <= number of processes in MPI_COMM_WORLD(%d)\n",
+                num_procs, nprocs);
+        goto error_done;
+    }
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+    color = (myrank < num_procs);
+    mrc = MPI_Comm_split(MPI_COMM_WORLD, color, myrank, &pio_comm_g);
+
+    if (mrc != MPI_SUCCESS) {
+        fprintf(stderr, "MPI_Comm_split failed\n");
+        goto error_done;
+    }
+
+    if (!color) {
+        /* not involved in this run */
+        mrc = destroy_comm_world();
+        goto done;
+    }
+
+    /* determine the MPI rank in the PIO communicator */
+    MPI_Comm_size(pio_comm_g, &pio_mpi_nprocs_g);
+    MPI_Comm_rank(pio_comm_g, &pio_mpi_rank_g);
+
+done:
+    *doing_pio = color;
+    return SUCCESS;
+
+error_done:
+    destroy_comm_world();
+    return FAIL;
+}
+
+/*
+ * Function:    build_comm_worlds
+ * Purpose:     Split MPI_COMM_WORLD once for every distinct number of
+ *              processes of the process schedule and of the restart
+ *              readers, so the sweeps only switch communicators.  Counts
+ *              create_comm_world turns down are left out.  All processes
+ *              of MPI_COMM_WORLD must call it.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+build_comm_worlds(const struct options *opts)
+{
+    int i;
+
+    for (i = 0; i < opts->procs_sched.num + opts->num_restarts; i++) {
+        int num_procs, doing_pio, c;
+
+        num_procs = (i < opts->procs_sched.num) ? (int)opts->procs_sched.vals[i] :
+                    opts->restart_procs[i - opts->procs_sched.num];
+
+        for (c = 0; c < num_comms_g; c++)
+            if (comm_cache_g[c].num_procs == num_procs)
+                break;
+
+        if (c < num_comms_g || create_comm_world(num_procs, &doing_pio) != SUCCESS)
+            continue;
+
+        comm_cache_g[num_comms_g].num_procs = num_procs;
+        comm_cache_g[num_comms_g].comm = pio_comm_g;
+        num_comms_g++;
+    }
+
+    pio_comm_g = MPI_COMM_NULL;
+}
+
+/*
+ * Function:    select_comm_world
+ * Purpose:     Run the following tests on the communicator of NUM_PROCS
+ *              processes that build_comm_worlds split, setting
+ *              pio_comm_g and the PIO rank and size.
+ * Return:      SUCCESS, or FAIL if there is no such communicator;
+ *              *DOING_PIO tells whether this process is one of them.
+ * Modifications:
+ */
+static int
+select_comm_world(int num_procs, int *doing_pio)
+{
+    int c;
+
+    *doing_pio = FALSE;
+    pio_comm_g = MPI_COMM_NULL;
+
+    for (c = 0; c < num_comms_g; c++)
+        if (comm_cache_g[c].num_procs == num_procs)
+            break;
+
+    if (c == num_comms_g)
+        return FAIL;
+
+    pio_comm_g = comm_cache_g[c].comm;
+
+    if (pio_comm_g != MPI_COMM_NULL) {
+        MPI_Comm_size(pio_comm_g, &pio_mpi_nprocs_g);
+        MPI_Comm_rank(pio_comm_g, &pio_mpi_rank_g);
+        *doing_pio = TRUE;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Function:    free_comm_worlds
+ * Purpose:     Free the communicators of build_comm_worlds.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+free_comm_worlds(void)
+{
+    int c;
+
+    for (c = 0; c < num_comms_g; c++) {
+        pio_comm_g = comm_cache_g[c].comm;
+        destroy_comm_world();
+    }
+
+    num_comms_g = 0;
+    pio_comm_g = MPI_COMM_NULL;
+}
+
+/*
+ * Function:    destroy_comm_world
+ * Purpose:     Destroy the created MPI Comm world which is stored in the
+ *              pio_comm_g global variable.
+ * Return:      SUCCESS on success.
+ *              FAIL otherwise.
+ * Programmer:  Bill Wendling, 19. December 2001
+ * Modifications:
+ */
+static int
+destroy_comm_world(void)
+{
+    int     mrc = SUCCESS;      /* return code      */
+
+    /* release MPI resources */
+    if (pio_comm_g != MPI_COMM_NULL)
+        mrc = (MPI_Comm_free(&pio_comm_g) == MPI_SUCCESS ? SUCCESS : FAIL);
+
+    return mrc;
+}
+
+/*
+ * Function:    output_results
+ * Purpose:     Print information about the time & bandwidth for a given
+ *                  minmax & # of iterations.
+ * Return:      Nothing
+ * Programmer:  Quincey Koziol, 9. May 2002
+ * Modifications:
+ */
+static void
+output_results(const struct options *opts, const char *name, minmax *table,
     int table_size,off_t data_size)
 {
-    minmax          total_mm;
+    minmax          total_mm;
+
+    total_mm = accumulate_minmax_stuff(table, table_size);
+
+    print_indent(3);
+    output_report("%s (%d iteration(s)):\n", name,table_size);
+
+    /* Note: The maximum throughput uses the minimum amount of time & vice versa */
+
+    print_indent(4);
+    output_report("Maximum Throughput: %6.2f MB/s", MB_PER_SEC(data_size,total_mm.min));
+    if(opts->print_times)
+        output_report(" (%7.3f s)\n", total_mm.min);
+    else
+        output_report("\n");
+
+    print_indent(4);
+    output_report("Average Throughput: %6.2f MB/s",
+                  MB_PER_SEC(data_size,total_mm.sum / total_mm.num));
+    if(opts->print_times)
+        output_report(" (%7.3f s)\n", (total_mm.sum / total_mm.num));
+    else
+        output_report("\n");
+
+    print_indent(4);
+    output_report("Minimum Throughput: %6.2f MB/s", MB_PER_SEC(data_size,total_mm.max));
+    if(opts->print_times)
+        output_report(" (%7.3f s)\n", total_mm.max);
+    else
+        output_report("\n");
+
+}
+
+/*
+ * Function:    output_chunk_cache
+ * Purpose:     Print the chunk cache hits and misses of all processes.
+ *              They come from the model in pio_engine.c, the library
+ *              does not count them.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+output_chunk_cache(const char *name, long hits, long misses)
+{
+    print_indent(3);
+    output_report("%s Chunk Cache: %ld hit(s), %ld miss(es), %.1f %% hit rate "
+                  "(modeled)\n", name, hits, misses,
+                  100.0 * (double)hits / (double)(hits + misses));
+}
+
+/*
+ * Function:    reduce_counters
+ * Purpose:     Add the counts of the events timer T of PT saw on all
+ *              processes to TOTAL, and their times to WALL.  An event any
+ *              process could not count is set to -1 for good.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+reduce_counters(pio_time *pt, timer_type t, long long *total, double *wall)
+{
+    long long mine[NUM_COUNTERS], sum[NUM_COUNTERS];
+    int have[NUM_COUNTERS], all_have[NUM_COUNTERS];
+    double w, all_w;
+    int c;
+
+    for (c = 0; c < NUM_COUNTERS; c++) {
+        mine[c] = get_counter(pt, t, (counter_type)c);
+        have[c] = mine[c] >= 0;
+        if (!have[c])
+            mine[c] = 0;
+    }
+
+    w = get_time(pt, t);
+    MPI_Allreduce(mine, sum, NUM_COUNTERS, MPI_LONG_LONG, MPI_SUM, pio_comm_g);
+    MPI_Allreduce(have, all_have, NUM_COUNTERS, MPI_INT, MPI_MIN, pio_comm_g);
+    MPI_Allreduce(&w, &all_w, 1, MPI_DOUBLE, MPI_SUM, pio_comm_g);
+
+    for (c = 0; c < NUM_COUNTERS; c++)
+        total[c] = (!all_have[c] || total[c] < 0) ? -1 : total[c] + sum[c];
+    *wall += all_w;
+}
+
+/*
+ * Function:    output_counters
+ * Purpose:     Print the event counts of the NAME phase, open to close,
+ *              of all processes and iterations, with what they mean per
+ *              byte of the BYTES moved.  CPU time against the WALL time
+ *              of all processes tells computing from waiting on I/O.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+output_counters(const char *name, const long long *counts, double wall,
+                double bytes)
+{
+    const long long *n = counts;
+
+    print_indent(3);
+    output_report("%s Event Counters (open to close, all processes):\n", name);
+
+    print_indent(4);
+    if (n[PIO_TASK_CLOCK] >= 0)
+        output_report("CPU Time: %.3f s, %.1f %% of the wall time\n",
+                      n[PIO_TASK_CLOCK] / 1e9,
+                      wall > 0.0 ? n[PIO_TASK_CLOCK] / 1e9 / wall * 100.0 : 0.0);
+    else
+        output_report("CPU Time: n/a\n");
+
+    print_indent(4);
+    if (n[PIO_CPU_CYCLES] >= 0)
+        output_report("Cycles: %.4g, %.3f per byte\n", (double)n[PIO_CPU_CYCLES],
+                      bytes > 0.0 ? n[PIO_CPU_CYCLES] / bytes : 0.0);
+    else
+        output_report("Cycles: n/a\n");
+
+    print_indent(4);
+    if (n[PIO_INSTRUCTIONS] >= 0 && n[PIO_CPU_CYCLES] > 0)
+        output_report("Instructions: %.4g, %.2f per cycle, %.3f per byte\n",
+                      (double)n[PIO_INSTRUCTIONS],
+                      (double)n[PIO_INSTRUCTIONS] / n[PIO_CPU_CYCLES],
+                      bytes > 0.0 ? n[PIO_INSTRUCTIONS] / bytes : 0.0);
+    else if (n[PIO_INSTRUCTIONS] >= 0)
+        output_report("Instructions: %.4g, %.3f per byte\n",
+                      (double)n[PIO_INSTRUCTIONS],
+                      bytes > 0.0 ? n[PIO_INSTRUCTIONS] / bytes : 0.0);
+    else
+        output_report("Instructions: n/a\n");
+
+    print_indent(4);
+    if (n[PIO_CACHE_MISSES] >= 0)
+        output_report("Cache Misses: %.4g, %.3f per KB\n",
+                      (double)n[PIO_CACHE_MISSES],
+                      bytes > 0.0 ? n[PIO_CACHE_MISSES] / (bytes / ONE_KB) : 0.0);
+    else
+        output_report("Cache Misses: n/a\n");
+
+    print_indent(4);
+    if (n[PIO_CONTEXT_SWITCHES] >= 0)
+        output_report("Context Switches: %lld", n[PIO_CONTEXT_SWITCHES]);
+    else
+        output_report("Context Switches: n/a");
+    if (n[PIO_PAGE_FAULTS] >= 0)
+        output_report(", Page Faults: %lld\n", n[PIO_PAGE_FAULTS]);
+    else
+        output_report(", Page Faults: n/a\n");
+}
+
+/*
+ * Function:    reduce_samples
+ * Purpose:     Add up the bytes all processes had moved at each tick of
+ *              the bandwidth sampler of timer T of PT into SERIES, ending
+ *              with the total.  A process done early counts its total at
+ *              the ticks it did not see.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+reduce_samples(pio_time *pt, timer_type t, bw_series *series)
+{
+    const long long *bytes;
+    long long total, *mine;
+    double elapsed;
+    long n, n_min, n_max, k;
+
+    n = get_samples(pt, t, &bytes, &total, &elapsed);
+    MPI_Allreduce(&n, &n_min, 1, MPI_LONG, MPI_MIN, pio_comm_g);
+    MPI_Allreduce(&n, &n_max, 1, MPI_LONG, MPI_MAX, pio_comm_g);
+    MPI_Allreduce(&elapsed, &series->elapsed, 1, MPI_DOUBLE, MPI_MAX, pio_comm_g);
+
+    series->count = -1;
+    if (n_min < 0)
+        return;
+
+    mine = malloc((size_t)(n_max + 1) * sizeof(long long));
+    series->bytes = malloc((size_t)(n_max + 1) * sizeof(long long));
+    if (!mine || !series->bytes) {
+        fprintf(stderr, "pio_perf: out of memory for the bandwidth samples\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (k = 0; k < n_max; k++)
+        mine[k] = k < n ? bytes[k] : total;
+    mine[n_max] = total;
+
+    MPI_Allreduce(mine, series->bytes, (int)(n_max + 1), MPI_LONG_LONG, MPI_SUM,
+                  pio_comm_g);
+    series->count = n_max;
+    free(mine);
+}
+
+/*
+ * Function:    output_samples
+ * Purpose:     Print the bandwidth of all processes over each sample
+ *              interval of the NAME phase, for each of the NITERS
+ *              iterations, the partial interval after the last tick
+ *              included.  Intervals in which nothing moved are counted
+ *              as stalls; dips and stalls are what the averages hide.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+output_samples(const char *name, const bw_series *series, int niters,
+               double interval)
+{
+    int i;
+
+    print_indent(3);
+    output_report("%s Bandwidth over Time (open to close, all processes, "
+                  "%g s samples):\n", name, interval);
+
+    for (i = 0; i < niters; i++) {
+        const bw_series *sr = &series[i];
+        double lo = DBL_MAX, hi = 0.0, tail;
+        long stalls = 0, k;
+
+        print_indent(4);
+        if (sr->count < 0) {
+            output_report("Iteration %d: n/a\n", i + 1);
+            continue;
+        }
+
+        /* the low and high are of whole intervals, unless there is none */
+        for (k = 0; k < sr->count; k++) {
+            double mbs = MB_PER_SEC(sr->bytes[k] - (k ? sr->bytes[k - 1] : 0),
+                                    interval);
+
+            lo = MIN(lo, mbs);
+            hi = MAX(hi, mbs);
+            if (mbs == 0.0)
+                stalls++;
+        }
+        tail = sr->elapsed - (double)sr->count * interval;
+        if (sr->count == 0) {
+            lo = hi = MB_PER_SEC(sr->bytes[0], tail);
+            stalls = sr->bytes[0] == 0;
+        }
+
+        output_report("Iteration %d: %ld sample(s), %.2f to %.2f MB/s, "
+                      "%ld stalled\n", i + 1, sr->count, lo, hi, stalls);
+
+        print_indent(5);
+        output_report("%10s %12s %12s\n", "Time (s)", "MB/s", "Total MB");
+        for (k = 0; k <= sr->count; k++) {
+            long long moved = sr->bytes[k] - (k ? sr->bytes[k - 1] : 0);
+            double dt = k < sr->count ? interval : tail;
+
+            /* no partial interval after the last tick */
+            if (k == sr->count && dt <= 0.0)
+                break;
+
+            print_indent(5);
+            output_report("%10.3f %12.2f %12.2f\n",
+                          k < sr->count ? (double)(k + 1) * interval : sr->elapsed,
+                          MB_PER_SEC(moved, dt), (double)sr->bytes[k] / ONE_MB);
+        }
+    }
+}
+
+/*
+ * Function:    reduce_mpio_modes
+ * Purpose:     Add the collective transfer counts of all processes in
+ *              MODES to TOTAL.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+reduce_mpio_modes(const mpio_modes *modes, mpio_modes *total)
+{
+    mpio_modes sum;
+    int k;
+
+    MPI_Allreduce(modes->io_mode, sum.io_mode, 5, MPI_LONG, MPI_SUM, pio_comm_g);
+    MPI_Allreduce(modes->chunk_opt, sum.chunk_opt, 3, MPI_LONG, MPI_SUM, pio_comm_g);
+    MPI_Allreduce(&modes->fallback, &sum.fallback, 1, MPI_LONG, MPI_SUM, pio_comm_g);
+    MPI_Allreduce(&modes->cause, &sum.cause, 1, MPI_UNSIGNED, MPI_BOR, pio_comm_g);
+
+    for (k = 0; k < 5; k++)
+        total->io_mode[k] += sum.io_mode[k];
+    for (k = 0; k < 3; k++)
+        total->chunk_opt[k] += sum.chunk_opt[k];
+    total->fallback += sum.fallback;
+    total->cause |= sum.cause;
+}
+
+/*
+ * Function:    output_mpio_modes
+ * Purpose:     Print how the MPI-IO driver actually did the collective
+ *              transfers of all processes, and why some were not
+ *              collective.  HDF5 falls back to independent I/O without
+ *              an error, so this is the only sign of it.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+output_mpio_modes(const char *name, const mpio_modes *modes)
+{
+    static const struct {
+        unsigned bit;
+        const char *text;
+    } causes[] = {
+        { H5D_MPIO_SET_INDEPENDENT, "independent I/O requested" },
+        { H5D_MPIO_DATATYPE_CONVERSION, "datatype conversion" },
+        { H5D_MPIO_DATA_TRANSFORMS, "data transform" },
+        { H5D_MPIO_MPI_OPT_TYPES_ENV_VAR_DISABLED, "HDF5_MPI_OPT_TYPES off" },
+        { H5D_MPIO_NOT_SIMPLE_OR_SCALAR_DATASPACES, "not a simple or scalar dataspace" },
+        { H5D_MPIO_NOT_CONTIGUOUS_OR_CHUNKED_DATASET, "not a contiguous or chunked dataset" },
+#ifdef PIO_HAVE_FILTER_CAUSES
+        { H5D_MPIO_PARALLEL_FILTERED_WRITES_DISABLED, "filters" },
+        { H5D_MPIO_ERROR_WHILE_CHECKING_COLLECTIVE_POSSIBLE,
+          "error checking for collective I/O" },
+#endif  /* PIO_HAVE_FILTER_CAUSES */
+    };
+    size_t k;
+    int first = TRUE;
+
+    print_indent(3);
+    output_report("%s MPI-IO: %ld contiguous collective, %ld chunk collective, "
+                  "%ld chunk mixed, %ld chunk independent, %ld independent\n", name,
+                  modes->io_mode[H5D_MPIO_CONTIGUOUS_COLLECTIVE],
+                  modes->io_mode[H5D_MPIO_CHUNK_COLLECTIVE],
+                  modes->io_mode[H5D_MPIO_CHUNK_MIXED],
+                  modes->io_mode[H5D_MPIO_CHUNK_INDEPENDENT],
+                  modes->io_mode[H5D_MPIO_NO_COLLECTIVE]);
+    print_indent(3);
+    output_report("%s Chunk Optimization: %ld link-chunk, %ld multi-chunk, %ld none\n",
+                  name, modes->chunk_opt[H5D_MPIO_LINK_CHUNK],
+                  modes->chunk_opt[H5D_MPIO_MULTI_CHUNK],
+                  modes->chunk_opt[H5D_MPIO_NO_CHUNK_OPTIMIZATION]);
+
+    print_indent(3);
+    if (modes->fallback == 0) {
+        output_report("%s Collective Fallback: none\n", name);
+        return;
+    }
+
+    output_report("%s Collective Fallback: %ld transfer(s) not collective (", name,
+                  modes->fallback);
+    for (k = 0; k < sizeof(causes) / sizeof(causes[0]); k++)
+        if (modes->cause & causes[k].bit) {
+            output_report("%s%s", first ? "" : ", ", causes[k].text);
+            first = FALSE;
+        }
+    if (first)
+        output_report("no cause given");
+    output_report(")\n");
+}
+
+static void
+output_times(const struct options *opts, const char *name, minmax *table,
+    int table_size)
+{
+    minmax          total_mm;
+
+    total_mm = accumulate_minmax_stuff(table, table_size);
+
+    print_indent(3);
+    output_report("%s (%d iteration(s)):\n", name,table_size);
+
+    /* Note: The maximum throughput uses the minimum amount of time & vice versa */
+
+    print_indent(4);
+        output_report("Minimum Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.min));
+
+    print_indent(4);
+        output_report("Average Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.sum / total_mm.num));
+
+    print_indent(4);
+        output_report("Maximum Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.max));
+}
+
+/*
+ * Function:    output_report
+ * Purpose:     Print a line of the report. Only do so if I'm the 0 process.
+ * Return:      Nothing
+ * Programmer:  Bill Wendling, 19. December 2001
+ * Modifications:
+ */
+static void
+output_report(const char *fmt, ...)
+{
+    int myrank;
+
+    MPI_Comm_rank(pio_comm_g, &myrank);
+
+    if (myrank == 0) {
+        va_list ap;
+
+        va_start(ap, fmt);
+        vfprintf(output, fmt, ap);
+        va_end(ap);
+    }
+}
+
+/*
+ * Function:    print_indent
+ * Purpose:     Print spaces to indent a new line of text for pretty printing
+ *              things.
+ * Return:      Nothing
+ * Programmer:  Bill Wendling, 29. October 2001
+ * Modifications:
+ */
+static void
+print_indent(register int indent)
+{
+    int myrank;
+
+    MPI_Comm_rank(pio_comm_g, &myrank);
+
+    if (myrank == 0) {
+	indent *= TAB_SPACE;
+
+	for (; indent > 0; --indent)
+	    fputc(' ', output);
+    }
+}
+
+static void
+recover_size_and_print(long long val, const char *end)
+{
+    if (val >= ONE_KB && (val % ONE_KB) == 0) {
+        if (val >= ONE_MB && (val % ONE_MB) == 0) {
+            if (val >= ONE_GB && (val % ONE_GB) == 0)
+                HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""GB%s", val / ONE_GB, end);
+            else
+                HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""MB%s", val / ONE_MB, end);
+        } else {
+            HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""KB%s", val / ONE_KB, end);
+        }
+    } else {
+        HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""%s", val, end);
+    }
+}
+
+static void
+print_io_api(long io_types)
+{
+    if (io_types & PIO_POSIX)
+	HDfprintf(output, "posix ");
+    if (io_types & PIO_MPI)
+	HDfprintf(output, "mpiio ");
+    if (io_types & PIO_HDF5)
+	HDfprintf(output, "phdf5 ");
+    HDfprintf(output, "\n");
+}
+
+/*
+ * Function:    print_schedule
+ * Purpose:     Print the values of a sweep schedule for report_parameters.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+print_schedule(const char *name, const pio_sched *sched)
+{
+    int i;
+
+    HDfprintf(output, "rank %d: %s=", comm_world_rank_g, name);
+
+    for (i = 0; i < sched->num; i++)
+        recover_size_and_print((long long)sched->vals[i],
+                               i == sched->num - 1 ? "\n" : ",");
+}
+
+static void
+report_parameters(struct options *opts)
+{
+    int rank = comm_world_rank_g;
+
+    print_version("HDF5 Library");	/* print library version */
+    HDfprintf(output, "rank %d: ==== Parameters ====\n", rank);
+
+    HDfprintf(output, "rank %d: IO API=", rank);
+    print_io_api(opts->io_types);
+
+    HDfprintf(output, "rank %d: Number of files=%ld\n", rank,
+              opts->num_files);
+    HDfprintf(output, "rank %d: Number of datasets=%ld\n", rank,
+              opts->num_dsets);
+    HDfprintf(output, "rank %d: Number of iterations=%d\n", rank,
+              opts->num_iters);
+    HDfprintf(output, "rank %d: Number of processes=%d:%d\n", rank,
+              opts->min_num_procs, opts->max_num_procs);
+
+    if (opts->procs_sched.given)
+        print_schedule("Process schedule", &opts->procs_sched);
+    if (opts->xfer_sched.given)
+        print_schedule("Transfer size schedule", &opts->xfer_sched);
+    if (opts->blk_sched.given)
+        print_schedule("Block size schedule", &opts->blk_sched);
+    if (opts->dsets_sched.given)
+        print_schedule("Dataset schedule", &opts->dsets_sched);
+
+    if (opts->num_groups > 0) {
+        int g;
+
+        HDfprintf(output, "rank %d: Concurrent process groups=%d\n", rank,
+                  opts->num_groups);
+
+        for (g = 0; g < opts->num_groups; g++) {
+            HDfprintf(output, "rank %d:   Group %d=%s %s, processes=", rank, g,
+                      opts->groups[g].io_type == POSIXIO ? "posix" :
+                      opts->groups[g].io_type == MPIO ? "mpiio" : "phdf5",
+                      group_mode_name(opts->groups[g].mode));
+            if (opts->groups[g].num_procs > 0)
+                HDfprintf(output, "%d\n", opts->groups[g].num_procs);
+            else
+                HDfprintf(output, "shared\n");
+        }
+    }
+
+    if (opts->dim2d){
+    HDfprintf(output, "rank %d: Number of bytes per process per dataset=", rank);
+    recover_size_and_print((long long)(opts->num_bpp * opts->num_bpp * opts->min_num_procs), ":");
+    recover_size_and_print((long long)(opts->num_bpp * opts->num_bpp * opts->max_num_procs), "\n");
+
+    HDfprintf(output, "rank %d: Size of dataset(s)=", rank);
+    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), "x");
+    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), ":");
+    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "x");
+    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "\n");
+
+    HDfprintf(output, "rank %d: File size=", rank);
+    recover_size_and_print((long long)(pow(opts->num_bpp * opts->min_num_procs,2)
+            * opts->num_dsets), ":");
+    recover_size_and_print((long long)(pow(opts->num_bpp * opts->max_num_procs,2)
+            * opts->num_dsets), "\n");
+
+    HDfprintf(output, "rank %d: Transfer buffer size=", rank);
+    if(opts->interleaved){
+        recover_size_and_print((long long)opts->min_xfer_size, "x");
+        recover_size_and_print((long long)opts->blk_size, ":");
+        recover_size_and_print((long long)opts->max_xfer_size, "x");
+        recover_size_and_print((long long)opts->blk_size, "\n");
+    }
+    else{
+        recover_size_and_print((long long)opts->blk_size, "x");
+        recover_size_and_print((long long)opts->min_xfer_size, ":");
+        recover_size_and_print((long long)opts->blk_size, "x");
+        recover_size_and_print((long long)opts->max_xfer_size, "\n");
+    }
+    HDfprintf(output, "rank %d: Block size=", rank);
+    recover_size_and_print((long long)opts->blk_size, "x");
+    recover_size_and_print((long long)opts->blk_size, "\n");
+    }
+    else{
+    HDfprintf(output, "rank %d: Number of bytes per process per dataset=", rank);
+    recover_size_and_print((long long)opts->num_bpp, "\n");
+
+    HDfprintf(output, "rank %d: Size of dataset(s)=", rank);
+    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), ":");
+    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "\n");
+
+    HDfprintf(output, "rank %d: File size=", rank);
+    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs
+            * opts->num_dsets), ":");
+    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs
+            * opts->num_dsets), "\n");
+
+    HDfprintf(output, "rank %d: Transfer buffer size=", rank);
+    recover_size_and_print((long long)opts->min_xfer_size, ":");
+    recover_size_and_print((long long)opts->max_xfer_size, "\n");
+    HDfprintf(output, "rank %d: Block size=", rank);
+    recover_size_and_print((long long)opts->blk_size, "\n");
+    }
+
+    HDfprintf(output, "rank %d: Block Pattern in Dataset=", rank);
+    if(opts->interleaved)
+        HDfprintf(output, "Interleaved\n");
+    else
+        HDfprintf(output, "Contiguous\n");
+
+    HDfprintf(output, "rank %d: I/O Method for MPI and HDF5=", rank);
+    if(opts->collective)
+        HDfprintf(output, "Collective\n");
+    else
+        HDfprintf(output, "Independent\n");
+
+    if (opts->collective) {
+        HDfprintf(output, "rank %d: Collective chunk I/O=%s", rank,
+                  opts->chunk_opt == H5FD_MPIO_CHUNK_ONE_IO ? "link-chunk" :
+                  opts->chunk_opt == H5FD_MPIO_CHUNK_MULTI_IO ? "multi-chunk" :
+                  "chosen by HDF5");
+        if (opts->chunk_opt == H5FD_MPIO_CHUNK_DEFAULT) {
+            if (opts->chunk_opt_num > 0)
+                HDfprintf(output, ", link-chunk threshold=%d", opts->chunk_opt_num);
+            if (opts->chunk_opt_ratio >= 0)
+                HDfprintf(output, ", collective chunk ratio=%d%%", opts->chunk_opt_ratio);
+        }
+        HDfprintf(output, "\n");
+        if (opts->coll_opt >= 0)
+            HDfprintf(output, "rank %d: MPI-IO calls=%s\n", rank,
+                      opts->coll_opt == H5FD_MPIO_COLLECTIVE_IO ? "collective" :
+                      "individual");
+    }
+
+    HDfprintf(output, "rank %d: Geometry=", rank);
+    if(opts->dim2d)
+        HDfprintf(output, "2D\n");
+    else
+        HDfprintf(output, "1D\n");
+
+    HDfprintf(output, "rank %d: VFL used for HDF5 I/O=%s driver\n", rank,
+              driver_name(opts->h5_driver));
+
+    if (opts->stripe_size > 0) {
+        HDfprintf(output, "rank %d: Stripe size=", rank);
+        recover_size_and_print((long long)opts->stripe_size, "\n");
+        HDfprintf(output, "rank %d: Stripe count=%d\n", rank, opts->stripe_count);
+        HDfprintf(output, "rank %d: HDF5 alignment=", rank);
+        recover_size_and_print((long long)opts->h5_alignment, ", threshold=");
+        recover_size_and_print((long long)opts->h5_threshold, "\n");
+    }
+
+    HDfprintf(output, "rank %d: Data storage method in HDF5=", rank);
+    if(opts->append || opts->swmr)
+        HDfprintf(output, "Appended\n");
+    else if(opts->h5_use_chunks)
+        HDfprintf(output, "Chunked\n");
+    else
+        HDfprintf(output, "Contiguous\n");
+
+    if (opts->h5_use_chunks && !opts->append && !opts->swmr) {
+        HDfprintf(output, "rank %d: Chunk size=", rank);
+        if (opts->num_ratios > 0) {
+            int r;
+
+            HDfprintf(output, "swept over");
+            for (r = 0; r < opts->num_ratios; r++)
+                HDfprintf(output, "%s%g", r ? "," : " ", opts->chunk_ratios[r]);
+            HDfprintf(output, " x transfer buffer size\n");
+        } else if (opts->chunk_dims[0] > 0 && opts->dim2d) {
+            recover_size_and_print((long long)opts->chunk_dims[0], "x");
+            recover_size_and_print((long long)opts->chunk_dims[1], "\n");
+        } else if (opts->chunk_dims[0] > 0) {
+            recover_size_and_print((long long)opts->chunk_dims[0], "\n");
+        } else {
+            HDfprintf(output, "block size\n");
+        }
+    }
+
+    if (opts->h5_use_chunks || opts->append || opts->swmr) {
+        HDfprintf(output, "rank %d: Chunk cache slots=", rank);
+        if (opts->cache_nslots == H5D_CHUNK_CACHE_NSLOTS_DEFAULT)
+            HDfprintf(output, "default");
+        else
+            HDfprintf(output, "%ld", (long)opts->cache_nslots);
+        HDfprintf(output, ", size=");
+        if (opts->cache_nbytes == H5D_CHUNK_CACHE_NBYTES_DEFAULT)
+            HDfprintf(output, "default");
+        else
+            recover_size_and_print((long long)opts->cache_nbytes, "");
+        HDfprintf(output, ", w0=");
+        if (opts->cache_w0 < 0.0)
+            HDfprintf(output, "default\n");
+        else
+            HDfprintf(output, "%g\n", opts->cache_w0);
+    }
+
+    if (opts->filters) {
+        HDfprintf(output, "rank %d: Filters=", rank);
+        if (opts->filters & PIO_FILTER_SHUFFLE)
+            HDfprintf(output, "shuffle ");
+        if (opts->filters & PIO_FILTER_DEFLATE)
+            HDfprintf(output, "deflate:%d ", opts->deflate_level);
+        if (opts->filters & PIO_FILTER_FLETCHER32)
+            HDfprintf(output, "fletcher32 ");
+        HDfprintf(output, "\n");
+    }
+
+    if (opts->swmr)
+        HDfprintf(output, "rank %d: SWMR=process 0 writes, the others read "
+                  "(sec2 driver)\n", rank);
+
+    if (opts->append || opts->swmr) {
+        HDfprintf(output, "rank %d: Append chunk size=", rank);
+        if (opts->append_chunk > 0)
+            recover_size_and_print((long long)opts->append_chunk, "\n");
+        else if (opts->swmr)
+            HDfprintf(output, "transfer buffer size\n");
+        else if (opts->h5_use_chunks)
+            recover_size_and_print((long long)opts->blk_size, "\n");
+        else
+            HDfprintf(output, "one step\n");
+        if (!opts->swmr)
+            HDfprintf(output, "rank %d: Steps per extension=%ld\n", rank,
+                      opts->extend_steps);
+        HDfprintf(output, "rank %d: Flush=", rank);
+        if (opts->flush_steps > 0)
+            HDfprintf(output, "%s every %ld step(s)\n",
+                      opts->flush_file ? "H5Fflush" : "H5Dflush", opts->flush_steps);
+        else
+            HDfprintf(output, "none\n");
+    }
+
+    if (opts->num_restarts > 0) {
+        int r;
+
+        HDfprintf(output, "rank %d: Checkpoint/restart readers=", rank);
+        for (r = 0; r < opts->num_restarts; r++)
+            HDfprintf(output, "%s%d", r ? "," : "", opts->restart_procs[r]);
+        HDfprintf(output, ", scaling=%s\n",
+                  opts->scaling == PIO_SCALE_STRONG ? "strong" :
+                  opts->scaling == PIO_SCALE_WEAK ? "weak" : "strong and weak");
+    }
+
+    {
+        char *prefix = getenv("HDF5_PARAPREFIX");
+
+        HDfprintf(output, "rank %d: Env HDF5_PARAPREFIX=%s\n", rank,
+                  (prefix ? prefix : "not set"));
+    }
+
+    HDfprintf(output, "rank %d: ", rank);
+    h5_dump_info_object(h5_io_info_g);
+
+    HDfprintf(output, "rank %d: ==== End of Parameters ====\n", rank);
+    HDfprintf(output, "\n");
+}
+
+/*
+ * Function:    query_striping
+ * Purpose:     Ask the file system holding DIR for its stripe size and
+ *              stripe count.  Lustre keeps the default layout of a
+ *              directory in the "lustre.lov" extended attribute; anything
+ *              else falls back to the preferred I/O block size reported by
+ *              stat() with a single stripe.
+ * Return:      SUCCESS if a stripe size was found, FAIL otherwise.
+ * Modifications:
+ */
+static int
+query_striping(const char *dir, off_t *stripe_size, int *stripe_count)
+{
+    h5_stat_t sb;
+
+#ifdef __linux__
+    {
+        unsigned char lov[256];     /* lov_user_md as stored by Lustre */
+        ssize_t len;
+
+        len = getxattr(dir, "lustre.lov", lov, sizeof(lov));
+
+        /* lov_user_md_v1/v3: magic, pattern, object id, object seq,
+         * stripe size (u32 @24), stripe count (u16 @28) */
+        if (len >= 32) {
+            uint32_t magic, ssize;
+            uint16_t scount;
+
+            memcpy(&magic, lov, sizeof(magic));
+            memcpy(&ssize, lov + 24, sizeof(ssize));
+            memcpy(&scount, lov + 28, sizeof(scount));
+
+            if ((magic == 0x0BD10BD0 || magic == 0x0BD30BD0) && ssize > 0) {
+                *stripe_size = (off_t)ssize;
+
+                /* 0 means the file system default, -1 means all OSTs;
+                 * neither tells us a count, so leave the caller's value */
+                if (scount != 0 && scount != 0xFFFF)
+                    *stripe_count = (int)scount;
+
+                return SUCCESS;
+            }
+        }
+    }
+#endif  /* __linux__ */
+
+    if (HDstat(dir, &sb) == 0 && sb.st_blksize > 0) {
+        *stripe_size = (off_t)sb.st_blksize;
+        return SUCCESS;
+    }
+
+    return FAIL;
+}
+
+/*
+ * Function:    stripe_block_size
+ * Purpose:     Round BLK_SIZE down so that blocks never straddle a stripe:
+ *              the largest multiple of the stripe size that still divides
+ *              the transfer buffer, otherwise the largest power of two
+ *              that divides both the stripe size and the transfer buffer.
+ * Return:      The block size
+ * Modifications:
+ */
+static size_t
+stripe_block_size(size_t blk_size, const struct options *opts)
+{
+    size_t ssize = (size_t)opts->stripe_size;
+    size_t blk;
+
+    for (blk = blk_size - blk_size % ssize; blk >= ssize; blk -= ssize)
+        if ((opts->min_xfer_size % blk) == 0)
+            break;
+
+    if (blk < ssize) {
+        blk = 1;
+
+        while ((blk << 1) <= blk_size && (ssize % (blk << 1)) == 0
+                && (opts->min_xfer_size % (blk << 1)) == 0)
+            blk <<= 1;
+    }
+
+    return blk;
+}
+
+/*
+ * Function:    setup_striping
+ * Purpose:     Derive HDF5 alignment, the block size and the MPI-IO
+ *              striping hints from the file system stripe size and count.
+ *              A stripe size of -1 (or a count of 0) means "ask the file
+ *              system"; process 0 does that and broadcasts the answer.
+ *              Values given explicitly on the command line or through
+ *              HDF5_MPI_INFO are left alone.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+setup_striping(struct options *opts)
+{
+    long long stripe[2];
+    char val[32];
+    int flag;
+
+    if (opts->stripe_size == 0)
+        return SUCCESS;
+
+    /* Look at the directory the data files go to */
+    if (opts->stripe_size < 0 || opts->stripe_count == 0) {
+        stripe[0] = (long long)opts->stripe_size;
+        stripe[1] = (long long)opts->stripe_count;
+
+        if (comm_world_rank_g == 0) {
+            const char *prefix = HDgetenv("HDF5_PARAPREFIX");
+            off_t size = opts->stripe_size;
+            int count = (opts->stripe_count == 0 ? 1 : opts->stripe_count);
+
+            if (query_striping((prefix && *prefix) ? prefix : ".", &size,
+                               &count) == SUCCESS) {
+                if (opts->stripe_size < 0)
+                    stripe[0] = (long long)size;
+                if (opts->stripe_count == 0)
+                    stripe[1] = (long long)count;
+            }
+        }
+
+        MPI_Bcast(stripe, 2, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+        if (stripe[0] <= 0) {
+            if (comm_world_rank_g == 0)
+                fprintf(stderr, "%s: cannot determine the file system stripe "
+                        "size, use --stripe-size=S\n", progname);
+            return FAIL;
+        }
+
+        opts->stripe_size = (off_t)stripe[0];
+        opts->stripe_count = (stripe[1] > 0) ? (int)stripe[1] : 1;
+    }
+
+    if (opts->stripe_count <= 0)
+        opts->stripe_count = 1;
+
+    /* Align every object of at least one stripe on a stripe boundary */
+    if (!opts->h5_align_set)
+        opts->h5_alignment = opts->stripe_size;
+    if (!opts->h5_thresh_set)
+        opts->h5_threshold = opts->stripe_size;
+
+    /* Round the block sizes so that blocks never straddle a stripe, the
+     * given --blocks schedule as well as the default one-entry one;
+     * sizes that round to the same block run once */
+    {
+        int i, n = 0;
+
+        opts->blk_size = stripe_block_size(opts->blk_size, opts);
+
+        if (!opts->blk_sched.given) {
+            opts->blk_sched.vals[0] = (off_t)opts->blk_size;
+        } else {
+            for (i = 0; i < opts->blk_sched.num; i++) {
+                off_t blk = (off_t)stripe_block_size((size_t)opts->blk_sched.vals[i], opts);
+                int j;
+
+                for (j = 0; j < n; j++)
+                    if (opts->blk_sched.vals[j] == blk)
+                        break;
+                if (j == n)
+                    opts->blk_sched.vals[n++] = blk;
+            }
+
+            opts->blk_sched.num = n;
+            opts->blk_size = (size_t)opts->blk_sched.vals[0];
+        }
+    }
+
+    /* MPI-IO hints: one collective buffering aggregator per stripe */
+    if (h5_io_info_g == MPI_INFO_NULL)
+        MPI_Info_create(&h5_io_info_g);
+
+    MPI_Info_get(h5_io_info_g, "striping_unit", sizeof(val) - 1, val, &flag);
+    if (!flag) {
+        sprintf(val, "%lld", (long long)opts->stripe_size);
+        MPI_Info_set(h5_io_info_g, "striping_unit", val);
+    }
+
+    MPI_Info_get(h5_io_info_g, "striping_factor", sizeof(val) - 1, val, &flag);
+    if (!flag) {
+        sprintf(val, "%d", opts->stripe_count);
+        MPI_Info_set(h5_io_info_g, "striping_factor", val);
+    }
+
+    MPI_Info_get(h5_io_info_g, "cb_nodes", sizeof(val) - 1, val, &flag);
+    if (!flag) {
+        sprintf(val, "%d", MIN(opts->stripe_count, opts->max_num_procs));
+        MPI_Info_set(h5_io_info_g, "cb_nodes", val);
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Function:    parse_command_line
+ * Purpose:     Parse the command line options and return a STRUCT OPTIONS
+ *              structure which will need to be freed by the calling function.
+ * Return:      Pointer to an OPTIONS structure
+ * Programmer:  Bill Wendling, 31. October 2001
+ * Modifications:
+ *    Added 2D testing (Christian Chilan, 10. August 2005)
+ */
+static struct options *
+parse_command_line(int argc, char *argv[])
+{
+    register int opt;
+    struct options *cl_opts;
+    off_t size;
+
+    cl_opts = (struct options *)malloc(sizeof(struct options));
+    bad_arg_g = 0;
+
+    cl_opts->output_file = NULL;
+    cl_opts->io_types =  0;    /* will set default after parsing options */
+    cl_opts->num_dsets = 1;
+    cl_opts->num_files = 1;
+    cl_opts->num_bpp = 0;
+    cl_opts->num_iters = 1;
+    cl_opts->max_num_procs = comm_world_nprocs_g;
+    cl_opts->min_num_procs = 1;
+    cl_opts->max_xfer_size = 0;
+    cl_opts->min_xfer_size = 0;
+    cl_opts->blk_size = 0;
+    cl_opts->interleaved = 0;       /* Default to contiguous blocks in dataset */
+    cl_opts->collective = 0;        /* Default to independent I/O access */
+    cl_opts->dim2d = 0;             /* Default to 1D */
+    cl_opts->print_times = FALSE;   /* Printing times is off by default */
+    cl_opts->print_raw = FALSE;     /* Printing raw data throughput is off by default */
+    cl_opts->print_counters = FALSE;    /* So are the event counters */
+    cl_opts->sample_interval = 0.0;     /* and the bandwidth samples */
+    cl_opts->h5_alignment = 1;      /* No alignment for HDF5 objects by default */
+    cl_opts->h5_threshold = 1;      /* No threshold for aligning HDF5 objects by default */
+#ifdef PIO_THREADS
+    cl_opts->h5_driver = PIO_DRIVER_SEC2;   /* there is no MPI-IO driver */
+#else
+    cl_opts->h5_driver = PIO_DRIVER_MPIO;
+#endif  /* PIO_THREADS */
+    cl_opts->h5_use_chunks = FALSE; /* Don't chunk the HDF5 dataset by default */
+    cl_opts->h5_write_only = FALSE; /* Do both read and write by default */
+    cl_opts->verify = FALSE;        /* No Verify data correctness by default */
+    cl_opts->stripe_size = 0;       /* Don't derive settings from striping by default */
+    cl_opts->stripe_count = 1;      /* Single stripe unless told otherwise */
+    cl_opts->h5_align_set = FALSE;
+    cl_opts->h5_thresh_set = FALSE;
+    cl_opts->num_groups = 0;        /* One process group by default */
+    cl_opts->append = FALSE;        /* Fixed size datasets by default */
+    cl_opts->append_chunk = 0;      /* One step per chunk by default */
+    cl_opts->extend_steps = 1;      /* Extend before every step by default */
+    cl_opts->flush_steps = 0;       /* Don't flush while appending by default */
+    cl_opts->flush_file = FALSE;
+    cl_opts->swmr = FALSE;          /* No SWMR readers by default */
+    cl_opts->chunk_dims[0] = 0;     /* Chunks of one block by default */
+    cl_opts->chunk_dims[1] = 0;
+    cl_opts->cache_nslots = H5D_CHUNK_CACHE_NSLOTS_DEFAULT;
+    cl_opts->cache_nbytes = H5D_CHUNK_CACHE_NBYTES_DEFAULT;
+    cl_opts->cache_w0 = H5D_CHUNK_CACHE_W0_DEFAULT;
+    cl_opts->cache_set = FALSE;
+    cl_opts->num_ratios = 0;        /* No chunk size sweep by default */
+    cl_opts->chunk_opt = H5FD_MPIO_CHUNK_DEFAULT;
+    cl_opts->chunk_opt_num = 0;
+    cl_opts->chunk_opt_ratio = -1;
+    cl_opts->coll_opt = -1;
+    cl_opts->num_restarts = 0;      /* No checkpoint/restart by default */
+    cl_opts->scaling = PIO_SCALE_STRONG;
+    cl_opts->procs_sched.given = FALSE;     /* the usual loops by default */
+    cl_opts->xfer_sched.given = FALSE;
+    cl_opts->blk_sched.given = FALSE;
+    cl_opts->dsets_sched.given = FALSE;
+    cl_opts->filters = 0;                   /* No filters by default */
+    cl_opts->deflate_level = 6;
+    cl_opts->read_only = FALSE;             /* Set by --workload phases */
+    cl_opts->keep_files = FALSE;
+    cl_opts->workload = NULL;
+    cl_opts->replay = NULL;
+    cl_opts->replay_timed = FALSE;          /* as fast as possible */
+    cl_opts->compare = NULL;
+    cl_opts->num_reports = 0;
+    cl_opts->reports = NULL;
+
+    while ((opt = get_option(argc, (const char **)argv, s_opts, l_opts)) != EOF) {
+        switch ((char)opt) {
+        case 'a':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->h5_alignment = size;
+            cl_opts->h5_align_set = TRUE;
+            break;
+        case 'A':
+            {
+                const char *end = opt_arg;
+
+                while (end && *end != '\0') {
+                    char buf[10];
+                    int i;
+
+                    memset(buf, '\0', sizeof(buf));
+
+                    for (i = 0; *end != '\0' && *end != ','; ++end)
+                        if (isalnum(*end) && i < 10)
+                            buf[i++] = *end;
+
+                    if (!HDstrcasecmp(buf, "phdf5")) {
+                        cl_opts->io_types |= PIO_HDF5;
+                    } else if (!HDstrcasecmp(buf, "mpiio")) {
+                        cl_opts->io_types |= PIO_MPI;
+                    } else if (!HDstrcasecmp(buf, "posix")) {
+                        cl_opts->io_types |= PIO_POSIX;
+                    } else {
+                        fprintf(stderr, "pio_perf: invalid --api option %s\n",
+                                buf);
+                        goto bad_option;
+                    }
+
+                    if (*end == '\0')
+                        break;
+
+                    end++;
+                }
+            }
+
+            break;
+#if 0
+        case 'b':
+            /* the future "binary" option */
+            break;
+#endif  /* 0 */
+        case 'B':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->blk_size = size;
+            break;
+        case 'c':
+            /* Turn on chunked HDF5 dataset creation */
+            cl_opts->h5_use_chunks = TRUE;
+            break;
+        case 'C':
+            cl_opts->collective = 1;
+            break;
+        case 'd':
+            cl_opts->num_dsets = atoi(opt_arg);
+            break;
+        case 'D':
+            {
+                const char *end = opt_arg;
+
+                while (end && *end != '\0') {
+                    char buf[10];
+                    int i;
+
+                    memset(buf, '\0', sizeof(buf));
+
+                    for (i = 0; *end != '\0' && *end != ','; ++end)
+                        if (isalnum(*end) && i < 10)
+                            buf[i++] = *end;
+
+                    if (strlen(buf) > 1 || isdigit(buf[0])) {
+                        size_t j;
+
+                        for (j = 0; j < 10 && buf[j] != '\0'; ++j)
+                            if (!isdigit(buf[j])) {
+                                fprintf(stderr, "pio_perf: invalid --debug option %s\n",
+                                        buf);
+                                goto bad_option;
+                            }
+
+                        pio_debug_level = atoi(buf);
+
+                        if (pio_debug_level > 4)
+                            pio_debug_level = 4;
+                        else if (pio_debug_level < 0)
+                            pio_debug_level = 0;
+                    } else {
+                        switch (*buf) {
+                        case 'r':
+                            /* Turn on raw data throughput info */
+                            cl_opts->print_raw = TRUE;
+                            break;
+                        case 't':
+                            /* Turn on time printing */
+                            cl_opts->print_times = TRUE;
+                            break;
+                        case 'c':
+                            /* Turn on the event counters */
+                            cl_opts->print_counters = TRUE;
+                            break;
+            case 'v':
+                            /* Turn on verify data correctness*/
+                cl_opts->verify = TRUE;
+                break;
+                        default:
+                            fprintf(stderr, "pio_perf: invalid --debug option %s\n", buf);
+                            goto bad_option;
+                        }
+                    }
+
+                    if (*end == '\0')
+                        break;
+
+                    end++;
+                }
+            }
+
+            break;
+        case 'e':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->num_bpp = size;
+            break;
+        case 'E':
+            cl_opts->extend_steps = atol(opt_arg);
+            break;
+        case 'f':
+            cl_opts->flush_steps = atol(opt_arg);
+            break;
+        case 'F':
+            cl_opts->num_files = atoi(opt_arg);
+            break;
+        case 'g':
+            cl_opts->dim2d = 1;
+            break;
+        case 'G':
+            if (parse_group_spec(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'i':
+            cl_opts->num_iters = atoi(opt_arg);
+            break;
+        case 'I':
+            cl_opts->interleaved = 1;
+            break;
+        case 'j':
+            if (parse_chunk_cache(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'J':
+            if (parse_chunk_ratios(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            cl_opts->h5_use_chunks = TRUE;
+            break;
+        case 'K':
+            if (parse_chunk_dims(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            cl_opts->h5_use_chunks = TRUE;
+            break;
+        case 'M':
+            if (parse_schedule(opt_arg, "procs", &cl_opts->procs_sched) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'N':
+            cl_opts->chunk_opt_num = atoi(opt_arg);
+            if (cl_opts->chunk_opt_num <= 0) {
+                fprintf(stderr, "pio_perf: invalid --chunk-opt-num option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'o':
+            cl_opts->output_file = opt_arg;
+            break;
+        case 'O':
+            if (!HDstrcasecmp(opt_arg, "link"))
+                cl_opts->chunk_opt = H5FD_MPIO_CHUNK_ONE_IO;
+            else if (!HDstrcasecmp(opt_arg, "multi"))
+                cl_opts->chunk_opt = H5FD_MPIO_CHUNK_MULTI_IO;
+            else if (!HDstrcasecmp(opt_arg, "auto"))
+                cl_opts->chunk_opt = H5FD_MPIO_CHUNK_DEFAULT;
+            else {
+                fprintf(stderr, "pio_perf: invalid --chunk-opt option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'p':
+            cl_opts->min_num_procs = atoi(opt_arg);
+            break;
+        case 'P':
+            cl_opts->max_num_procs = atoi(opt_arg);
+            break;
+        case 'L':
+            cl_opts->flush_file = TRUE;
+            break;
+        case 'Q':
+            if (!HDstrcasecmp(opt_arg, "collective"))
+                cl_opts->coll_opt = H5FD_MPIO_COLLECTIVE_IO;
+            else if (!HDstrcasecmp(opt_arg, "individual"))
+                cl_opts->coll_opt = H5FD_MPIO_INDIVIDUAL_IO;
+            else {
+                fprintf(stderr, "pio_perf: invalid --collective-opt option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'r':
+            if (parse_restart_procs(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'R':
+            cl_opts->chunk_opt_ratio = atoi(opt_arg);
+            if (cl_opts->chunk_opt_ratio < 0 || cl_opts->chunk_opt_ratio > 100) {
+                fprintf(stderr, "pio_perf: invalid --chunk-opt-ratio option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'k':
+            if (!HDstrcasecmp(opt_arg, "auto"))
+                cl_opts->stripe_count = 0;
+            else
+                cl_opts->stripe_count = atoi(opt_arg);
+            break;
+        case 'S':
+            if (!HDstrcasecmp(opt_arg, "auto"))
+                cl_opts->stripe_size = -1;
+            else if ((cl_opts->stripe_size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            break;
+        case 'T':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->h5_threshold = size;
+            cl_opts->h5_thresh_set = TRUE;
+            break;
+        case 'u':
+            if (!HDstrcasecmp(opt_arg, "strong"))
+                cl_opts->scaling = PIO_SCALE_STRONG;
+            else if (!HDstrcasecmp(opt_arg, "weak"))
+                cl_opts->scaling = PIO_SCALE_WEAK;
+            else if (!HDstrcasecmp(opt_arg, "both"))
+                cl_opts->scaling = PIO_SCALE_STRONG | PIO_SCALE_WEAK;
+            else {
+                fprintf(stderr, "pio_perf: invalid --scaling option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'V':
+            if (parse_schedule(opt_arg, "xfers", &cl_opts->xfer_sched) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'w':
+            cl_opts->h5_write_only = TRUE;
+            break;
+        case 'W':
+            cl_opts->swmr = TRUE;
+            break;
+        case 'x':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->min_xfer_size = size;
+            break;
+        case 'X':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->max_xfer_size = size;
+            break;
+        case 'y':
+            cl_opts->append = TRUE;
+            break;
+        case 'Y':
+            if (parse_schedule(opt_arg, "blocks", &cl_opts->blk_sched) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'z':
+            if ((size = parse_size_directive(opt_arg)) < 0)
+                goto bad_option;
+            cl_opts->append_chunk = size;
+            break;
+        case 'Z':
+            if (parse_schedule(opt_arg, "dsets", &cl_opts->dsets_sched) != SUCCESS)
+                goto bad_option;
+            break;
+        case 'H':
+            if (parse_filters(opt_arg, cl_opts) != SUCCESS)
+                goto bad_option;
+            if (cl_opts->filters)
+                cl_opts->h5_use_chunks = TRUE;
+            break;
+        case 'l':
+            cl_opts->workload = opt_arg;
+            break;
+        case 'U':
+            cl_opts->replay = opt_arg;
+            break;
+        case 'v':
+            cl_opts->compare = opt_arg;
+            break;
+        case '#':
+            {
+                char *end;
+
+                cl_opts->sample_interval = strtod(opt_arg, &end);
+                if (!HDstrcasecmp(end, "ms"))
+                    cl_opts->sample_interval /= 1000.0;
+                else if (*end != '\0' && HDstrcasecmp(end, "s"))
+                    cl_opts->sample_interval = -1.0;
+
+                if (end == opt_arg || cl_opts->sample_interval <= 0.0) {
+                    fprintf(stderr, "pio_perf: invalid --sample option %s\n", opt_arg);
+                    goto bad_option;
+                }
+            }
+            break;
+        case '@':
+            /* the processes share the HDF5 files through the one driver
+             * of the build that can: MPI-IO, or sec2 and core in threads */
+#ifdef PIO_THREADS
+            if (!HDstrcasecmp(opt_arg, "sec2"))
+                cl_opts->h5_driver = PIO_DRIVER_SEC2;
+            else if (!HDstrcasecmp(opt_arg, "core"))
+                cl_opts->h5_driver = PIO_DRIVER_CORE;
+#else
+            if (!HDstrcasecmp(opt_arg, "mpio"))
+                cl_opts->h5_driver = PIO_DRIVER_MPIO;
+#endif  /* PIO_THREADS */
+            else {
+                fprintf(stderr, "pio_perf: invalid --driver option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'q':
+            if (!HDstrcasecmp(opt_arg, "timed"))
+                cl_opts->replay_timed = TRUE;
+            else if (!HDstrcasecmp(opt_arg, "asap"))
+                cl_opts->replay_timed = FALSE;
+            else {
+                fprintf(stderr, "pio_perf: invalid --replay-mode option %s\n", opt_arg);
+                goto bad_option;
+            }
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(progname);
+            free(cl_opts);
+            return NULL;
+        }
+    }
+
+
+    if (cl_opts->num_bpp == 0){
+        if (cl_opts->dim2d == 0)
+            cl_opts->num_bpp = 256 * ONE_KB;
+        else
+            cl_opts->num_bpp = 8 * ONE_KB;
+    }
+
+    if (cl_opts->max_xfer_size == 0)
+        cl_opts->max_xfer_size = cl_opts->num_bpp;
+
+    if (cl_opts->min_xfer_size == 0)
+        cl_opts->min_xfer_size = (cl_opts->num_bpp)/2;
+
+    if (cl_opts->blk_size == 0)
+        cl_opts->blk_size = (cl_opts->num_bpp)/2;
+
+
+    /* the append and SWMR workloads grow 1D HDF5 datasets */
+    if (cl_opts->append || cl_opts->swmr) {
+        if ((cl_opts->io_types & ~PIO_HDF5) || cl_opts->dim2d) {
+            fprintf(stderr, "pio_perf: --%s needs --api=phdf5 and 1D geometry\n",
+                    cl_opts->swmr ? "swmr" : "append");
+            goto error;
+        }
+
+        cl_opts->io_types = PIO_HDF5;
+
+        if (cl_opts->extend_steps <= 0)
+            cl_opts->extend_steps = 1;
+
+        /* SWMR readers only see what has been flushed */
+        if (cl_opts->swmr && cl_opts->flush_steps <= 0)
+            cl_opts->flush_steps = 1;
+    }
+
+    /* the collective tuning only reaches the transfers with --collective */
+    if (!cl_opts->collective && (cl_opts->chunk_opt != H5FD_MPIO_CHUNK_DEFAULT ||
+            cl_opts->chunk_opt_num > 0 || cl_opts->chunk_opt_ratio >= 0 ||
+            cl_opts->coll_opt >= 0)) {
+        fprintf(stderr, "pio_perf: --chunk-opt, --chunk-opt-num, --chunk-opt-ratio "
+                "and --collective-opt need --collective\n");
+        goto error;
+    }
+
+    /* a checkpoint/restart writes and reads whole datasets on its own */
+    if (cl_opts->num_restarts > 0 && (cl_opts->append || cl_opts->swmr ||
+            cl_opts->num_groups > 0 || cl_opts->num_ratios > 0 ||
+            cl_opts->h5_write_only)) {
+        fprintf(stderr, "pio_perf: --restart does not mix with --append, --swmr, "
+                "--groups, --chunk-sweep or --write-only\n");
+        goto error;
+    }
+
+    /* the reports to compare follow the options */
+    if (cl_opts->compare) {
+        cl_opts->num_reports = argc - opt_ind;
+        cl_opts->reports = &argv[opt_ind];
+
+        if (cl_opts->num_reports <= 0) {
+            fprintf(stderr, "pio_perf: --compare needs the reports to compare "
+                    "after the options\n");
+            goto error;
+        }
+    }
+
+#ifdef PIO_THREADS
+    /* the threads have POSIX and the serial HDF5 drivers, no MPI-IO */
+    if ((cl_opts->io_types & PIO_MPI) || cl_opts->collective || cl_opts->swmr) {
+        fprintf(stderr, "pio_perf: the threaded build runs --api=posix or phdf5 "
+                "and does not mix with --collective or --swmr\n");
+        goto error;
+    }
+
+    if (!cl_opts->io_types)
+        cl_opts->io_types = cl_opts->replay ? PIO_POSIX : PIO_HDF5 | PIO_POSIX;
+#endif  /* PIO_THREADS */
+
+    /* a replay issues the traced accesses itself, through POSIX or MPI-IO */
+    if (cl_opts->replay) {
+        if ((cl_opts->io_types & PIO_HDF5) || cl_opts->workload ||
+                cl_opts->num_restarts > 0 || cl_opts->append || cl_opts->swmr ||
+                cl_opts->num_groups > 0 || cl_opts->num_ratios > 0) {
+            fprintf(stderr, "pio_perf: --replay runs with --api=posix or mpiio and does "
+                    "not mix with --workload, --restart, --append, --swmr, --groups "
+                    "or --chunk-sweep\n");
+            goto error;
+        }
+
+        if (!cl_opts->io_types)
+            cl_opts->io_types = PIO_MPI | PIO_POSIX;
+    }
+
+    /* set default if none specified yet */
+    if (!cl_opts->io_types)
+    cl_opts->io_types = PIO_HDF5 | PIO_MPI | PIO_POSIX; /* run all API */
+
+#ifndef PIO_THREADS
+    /* parallel HDF5 writes filtered datasets only collectively */
+    if (cl_opts->filters && !cl_opts->collective && (cl_opts->io_types & PIO_HDF5)) {
+        fprintf(stderr, "pio_perf: --filters needs --collective with --api=phdf5\n");
+        goto error;
+    }
+#endif  /* !PIO_THREADS */
+
+    /* verify parameters sanity.  Adjust if needed. */
+    /* cap xfer_size with bytes per process */
+    if (!cl_opts->dim2d) {
+        if (cl_opts->min_xfer_size > cl_opts->num_bpp)
+        cl_opts->min_xfer_size = cl_opts->num_bpp;
+        if (cl_opts->max_xfer_size > cl_opts->num_bpp)
+        cl_opts->max_xfer_size = cl_opts->num_bpp;
+    }
+    if (cl_opts->min_xfer_size > cl_opts->max_xfer_size)
+    cl_opts->min_xfer_size = cl_opts->max_xfer_size;
+    if (cl_opts->blk_size > cl_opts->num_bpp )
+        cl_opts->blk_size = cl_opts->num_bpp;
+    /* check range of number of processes */
+    if (cl_opts->min_num_procs <= 0)
+    cl_opts->min_num_procs = 1;
+    if (cl_opts->max_num_procs <= 0)
+    cl_opts->max_num_procs = 1;
+    if (cl_opts->min_num_procs > cl_opts->max_num_procs)
+    cl_opts->min_num_procs = cl_opts->max_num_procs;
+    /* check iteration */
+    if (cl_opts->num_iters <= 0)
+    cl_opts->num_iters = 1;
+
+    /* process groups size themselves and run one dataset layout */
+    if (cl_opts->num_groups > 0 && (cl_opts->procs_sched.given ||
+            cl_opts->blk_sched.given || cl_opts->dsets_sched.given)) {
+        fprintf(stderr, "pio_perf: --groups does not mix with --procs, --blocks "
+                "or --dsets\n");
+        goto error;
+    }
+
+    if (fill_schedules(cl_opts) != SUCCESS)
+        goto error;
+
+    return cl_opts;
+
+bad_option:
+    /* the argument that was wrong, for the workload file messages */
+    bad_arg_g = opt_ind - 1;
+error:
+    free(cl_opts);
+    return NULL;
+}
+
+/*
+ * Function:    fill_schedules
+ * Purpose:     Give every sweep schedule not set on the command line the
+ *              values of the usual loops: the number of processes halving
+ *              from the maximum to the minimum, the transfer buffer size
+ *              doubling from the minimum to the maximum, and the single
+ *              block size, no larger than the smallest transfer, and
+ *              dataset count.  Schedules that were set decide the minimum
+ *              and maximum reported instead.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+fill_schedules(struct options *opts)
+{
+    int i;
+
+    if (opts->procs_sched.given) {
+        opts->min_num_procs = opts->max_num_procs = (int)opts->procs_sched.vals[0];
+
+        for (i = 0; i < opts->procs_sched.num; i++) {
+            int num_procs = (int)opts->procs_sched.vals[i];
+
+            if (num_procs > comm_world_nprocs_g) {
+                fprintf(stderr, "pio_perf: --procs asks for %d processes of %d\n",
+                        num_procs, comm_world_nprocs_g);
+                return FAIL;
+            }
+
+            opts->min_num_procs = MIN(opts->min_num_procs, num_procs);
+            opts->max_num_procs = MAX(opts->max_num_procs, num_procs);
+        }
+    } else {
+        int num_procs;
+
+        opts->procs_sched.num = 0;
+
+        for (num_procs = opts->max_num_procs; num_procs >= opts->min_num_procs &&
+                opts->procs_sched.num < PIO_MAX_SCHED; num_procs >>= 1)
+            opts->procs_sched.vals[opts->procs_sched.num++] = num_procs;
+    }
+
+    if (opts->xfer_sched.given) {
+        opts->min_xfer_size = opts->max_xfer_size = (size_t)opts->xfer_sched.vals[0];
+
+        for (i = 1; i < opts->xfer_sched.num; i++) {
+            opts->min_xfer_size = MIN(opts->min_xfer_size, (size_t)opts->xfer_sched.vals[i]);
+            opts->max_xfer_size = MAX(opts->max_xfer_size, (size_t)opts->xfer_sched.vals[i]);
+        }
+    } else {
+        size_t buf_size;
+
+        opts->xfer_sched.num = 0;
+
+        for (buf_size = opts->min_xfer_size; buf_size <= opts->max_xfer_size &&
+                opts->xfer_sched.num < PIO_MAX_SCHED; buf_size <<= 1) {
+            opts->xfer_sched.vals[opts->xfer_sched.num++] = (off_t)buf_size;
+
+            /* Run the tests once if buf_size==0 */
+            if (buf_size == 0)
+                break;
+        }
+    }
+
+    if (opts->blk_sched.given) {
+        opts->blk_size = (size_t)opts->blk_sched.vals[0];
+    } else {
+        /* a block never spans transfers */
+        if (opts->xfer_sched.given && opts->blk_size > opts->min_xfer_size)
+            opts->blk_size = opts->min_xfer_size;
+
+        opts->blk_sched.num = 1;
+        opts->blk_sched.vals[0] = (off_t)opts->blk_size;
+    }
+
+    if (opts->dsets_sched.given) {
+        opts->num_dsets = (long)opts->dsets_sched.vals[0];
+    } else {
+        opts->dsets_sched.num = 1;
+        opts->dsets_sched.vals[0] = (off_t)opts->num_dsets;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Function:    parse_group_spec
+ * Purpose:     Parse the --groups list.  Each comma separated entry is
+ *              API[:MODE[:N]] where MODE is w, r or rw and N the number of
+ *              processes; groups without N share the remaining processes.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_group_spec(const char *spec, struct options *opts)
+{
+    const char *end = spec;
+
+    while (end && *end != '\0') {
+        char buf[3][16];
+        group_spec *group;
+        int field = 0, i = 0;
+
+        memset(buf, '\0', sizeof(buf));
+
+        for (; *end != '\0' && *end != ','; ++end)
+            if (*end == ':') {
+                if (++field > 2)
+                    break;
+                i = 0;
+            } else if (isalnum(*end) && i < 15)
+                buf[field][i++] = *end;
+
+        if (opts->num_groups == PIO_MAX_GROUPS || field > 2) {
+            fprintf(stderr, "pio_perf: invalid --groups option %s\n", spec);
+            return FAIL;
+        }
+
+        group = &opts->groups[opts->num_groups++];
+
+        if (!HDstrcasecmp(buf[0], "phdf5")) {
+            group->io_type = PHDF5;
+#ifndef PIO_THREADS
+        } else if (!HDstrcasecmp(buf[0], "mpiio")) {
+            group->io_type = MPIO;
+#endif  /* !PIO_THREADS */
+        } else if (!HDstrcasecmp(buf[0], "posix")) {
+            group->io_type = POSIXIO;
+        } else {
+            fprintf(stderr, "pio_perf: invalid --groups API %s\n", buf[0]);
+            return FAIL;
+        }
+
+        if (buf[1][0] == '\0' || !HDstrcasecmp(buf[1], "rw")) {
+            group->mode = PIO_GROUP_WRITE | PIO_GROUP_READ;
+        } else if (!HDstrcasecmp(buf[1], "w")) {
+            group->mode = PIO_GROUP_WRITE;
+        } else if (!HDstrcasecmp(buf[1], "r")) {
+            group->mode = PIO_GROUP_READ;
+        } else {
+            fprintf(stderr, "pio_perf: invalid --groups mode %s\n", buf[1]);
+            return FAIL;
+        }
+
+        group->num_procs = atoi(buf[2]);
+
+        if (group->num_procs < 0) {
+            fprintf(stderr, "pio_perf: invalid --groups size %s\n", buf[2]);
+            return FAIL;
+        }
+
+        if (*end == '\0')
+            break;
+
+        end++;
+    }
 
-    total_mm = accumulate_minmax_stuff(table, table_size);
+    return SUCCESS;
+}
 
-    print_indent(3);
-    output_report("%s (%d iteration(s)):\n", name,table_size);
+/*
+ * Function:    parse_chunk_dims
+ * Purpose:     Parse the --chunk-dims size, S for 1D or SxS for 2D.  A
+ *              single size gives square chunks in 2D.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_chunk_dims(const char *spec, struct options *opts)
+{
+    char buf[2][32];
+    const char *sep = strchr(spec, 'x');
 
-    /* Note: The maximum throughput uses the minimum amount of time & vice versa */
+    memset(buf, '\0', sizeof(buf));
 
-    print_indent(4);
-    output_report("Maximum Throughput: %6.2f MB/s", MB_PER_SEC(data_size,total_mm.min));
-    if(opts->print_times)
-        output_report(" (%7.3f s)\n", total_mm.min);
-    else
-        output_report("\n");
+    if (sep) {
+        if ((size_t)(sep - spec) >= sizeof(buf[0]) || strlen(sep + 1) >= sizeof(buf[1]))
+            goto error;
+        memcpy(buf[0], spec, (size_t)(sep - spec));
+        strcpy(buf[1], sep + 1);
+    } else {
+        if (strlen(spec) >= sizeof(buf[0]))
+            goto error;
+        strcpy(buf[0], spec);
+        strcpy(buf[1], spec);
+    }
 
-    print_indent(4);
-    output_report("Average Throughput: %6.2f MB/s",
-                  MB_PER_SEC(data_size,total_mm.sum / total_mm.num));
-    if(opts->print_times)
-        output_report(" (%7.3f s)\n", (total_mm.sum / total_mm.num));
-    else
-        output_report("\n");
+    opts->chunk_dims[0] = parse_size_directive(buf[0]);
+    opts->chunk_dims[1] = parse_size_directive(buf[1]);
+    if (opts->chunk_dims[0] <= 0 || opts->chunk_dims[1] <= 0)
+        goto error;
 
-    print_indent(4);
-    output_report("Minimum Throughput: %6.2f MB/s", MB_PER_SEC(data_size,total_mm.max));
-    if(opts->print_times)
-        output_report(" (%7.3f s)\n", total_mm.max);
-    else
-        output_report("\n");
+    return SUCCESS;
 
+error:
+    fprintf(stderr, "pio_perf: invalid --chunk-dims option %s\n", spec);
+    return FAIL;
 }
 
-static void
-output_times(const struct options *opts, const char *name, minmax *table,
-    int table_size)
+/*
+ * Function:    parse_chunk_cache
+ * Purpose:     Parse the --chunk-cache settings NSLOTS,S,W0 handed to
+ *              H5Pset_chunk_cache.  An empty field keeps the default.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_chunk_cache(const char *spec, struct options *opts)
 {
-    minmax          total_mm;
+    const char *end = spec;
+    int field;
 
-    total_mm = accumulate_minmax_stuff(table, table_size);
+    opts->cache_set = TRUE;
 
-    print_indent(3);
-    output_report("%s (%d iteration(s)):\n", name,table_size);
+    for (field = 0; field < 3; field++) {
+        char buf[32];
+        int i = 0;
 
-    /* Note: The maximum throughput uses the minimum amount of time & vice versa */
+        memset(buf, '\0', sizeof(buf));
 
-    print_indent(4);
-        output_report("Minimum Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.min));
+        for (; *end != '\0' && *end != ','; ++end)
+            if (!isspace(*end) && i < 31)
+                buf[i++] = *end;
 
-    print_indent(4);
-        output_report("Average Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.sum / total_mm.num));
+        if (buf[0] != '\0') {
+            switch (field) {
+            case 0:
+                if (atol(buf) <= 0)
+                    goto error;
+                opts->cache_nslots = (size_t)atol(buf);
+                break;
+            case 1:
+                if (parse_size_directive(buf) < 0)
+                    goto error;
+                opts->cache_nbytes = (size_t)parse_size_directive(buf);
+                break;
+            default:
+                opts->cache_w0 = atof(buf);
+                if (opts->cache_w0 < 0.0 || opts->cache_w0 > 1.0)
+                    goto error;
+                break;
+            }
+        }
 
-    print_indent(4);
-        output_report("Maximum Accumulated Time using %d file(s): %7.5f s\n", opts->num_files,(total_mm.max));
+        if (*end == '\0')
+            break;
+
+        end++;
+    }
+
+    if (*end != '\0')
+        goto error;
+
+    return SUCCESS;
+
+error:
+    fprintf(stderr, "pio_perf: invalid --chunk-cache option %s\n", spec);
+    return FAIL;
 }
 
 /*
- * Function:    output_report
- * Purpose:     Print a line of the report. Only do so if I'm the 0 process.
- * Return:      Nothing
- * Programmer:  Bill Wendling, 19. December 2001
+ * Function:    parse_chunk_ratios
+ * Purpose:     Parse the comma separated --chunk-sweep list of chunk to
+ *              transfer size ratios.
+ * Return:      SUCCESS or FAIL
  * Modifications:
  */
-static void
-output_report(const char *fmt, ...)
+static int
+parse_chunk_ratios(const char *spec, struct options *opts)
 {
-    int myrank;
+    const char *end = spec;
 
-    MPI_Comm_rank(pio_comm_g, &myrank);
+    opts->num_ratios = 0;
 
-    if (myrank == 0) {
-        va_list ap;
+    while (*end != '\0') {
+        char *next;
+        double ratio = strtod(end, &next);
 
-        va_start(ap, fmt);
-        vfprintf(output, fmt, ap);
-        va_end(ap);
+        if (next == end || ratio <= 0.0 || opts->num_ratios == PIO_MAX_RATIOS ||
+                (*next != '\0' && *next != ','))
+            goto error;
+
+        opts->chunk_ratios[opts->num_ratios++] = ratio;
+        end = next;
+
+        if (*end == ',')
+            end++;
     }
+
+    if (opts->num_ratios == 0)
+        goto error;
+
+    return SUCCESS;
+
+error:
+    fprintf(stderr, "pio_perf: invalid --chunk-sweep option %s\n", spec);
+    return FAIL;
 }
 
 /*
- * Function:    print_indent
- * Purpose:     Print spaces to indent a new line of text for pretty printing
- *              things.
- * Return:      Nothing
- * Programmer:  Bill Wendling, 29. October 2001
+ * Function:    parse_restart_procs
+ * Purpose:     Parse the comma separated --restart list of the numbers of
+ *              processes that read a checkpoint back.
+ * Return:      SUCCESS or FAIL
  * Modifications:
  */
-static void
-print_indent(register int indent)
+static int
+parse_restart_procs(const char *spec, struct options *opts)
 {
-    int myrank;
+    const char *end = spec;
 
-    MPI_Comm_rank(pio_comm_g, &myrank);
+    opts->num_restarts = 0;
 
-    if (myrank == 0) {
-	indent *= TAB_SPACE;
+    while (*end != '\0') {
+        char *next;
+        long procs = strtol(end, &next, 10);
 
-	for (; indent > 0; --indent)
-	    fputc(' ', output);
+        if (next == end || procs <= 0 || procs > comm_world_nprocs_g ||
+                opts->num_restarts == PIO_MAX_RESTARTS ||
+                (*next != '\0' && *next != ','))
+            goto error;
+
+        opts->restart_procs[opts->num_restarts++] = (int)procs;
+        end = next;
+
+        if (*end == ',')
+            end++;
     }
+
+    if (opts->num_restarts == 0)
+        goto error;
+
+    return SUCCESS;
+
+error:
+    fprintf(stderr, "pio_perf: invalid --restart option %s\n", spec);
+    return FAIL;
 }
 
-static void
-recover_size_and_print(long long val, const char *end)
+/*
+ * Function:    parse_workload
+ * Purpose:     Split the text of workload file FNAME into phases.  The
+ *              lines before the first [NAME] go to PHASES[0], the
+ *              defaults; phases follow from PHASES[1] on.  Option names
+ *              must be spelled out and are checked against l_opts here,
+ *              so mistakes come with a line number.  TEXT is modified and
+ *              must outlive the phases.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_workload(char *text, const char *fname, pio_phase *phases, int *num_phases)
 {
-    if (val >= ONE_KB && (val % ONE_KB) == 0) {
-        if (val >= ONE_MB && (val % ONE_MB) == 0) {
-            if (val >= ONE_GB && (val % ONE_GB) == 0)
-                HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""GB%s", val / ONE_GB, end);
-            else
-                HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""MB%s", val / ONE_MB, end);
-        } else {
-            HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""KB%s", val / ONE_KB, end);
+    pio_phase *phase = &phases[0];
+    char *line = text;
+    int lineno = 0;
+
+    phase->op = phase->keep = -1;
+    HDstrcpy(phase->name, "defaults");
+    *num_phases = 0;
+
+    while (line && *line != '\0') {
+        char *next = HDstrchr(line, '\n');
+        char *key, *val, *end;
+        int i;
+
+        lineno++;
+        if (next)
+            *next++ = '\0';
+
+        /* drop comments and surrounding blanks */
+        if ((end = HDstrchr(line, '#')) != NULL)
+            *end = '\0';
+        key = line + strspn(line, " \t\r");
+        end = key + HDstrlen(key);
+        while (end > key && isspace((int)end[-1]))
+            *--end = '\0';
+
+        line = next;
+
+        if (*key == '\0')
+            continue;
+
+        if (*key == '[') {
+            if (end[-1] != ']' || end - key < 3 || *num_phases == PIO_MAX_PHASES)
+                goto error;
+
+            phase = &phases[++*num_phases];
+            phase->op = phase->keep = -1;
+            phase->line = lineno;
+            end[-1] = '\0';
+            HDstrncpy(phase->name, key + 1, sizeof(phase->name) - 1);
+            continue;
         }
-    } else {
-        HDfprintf(output, "%" H5_PRINTF_LL_WIDTH "d""%s", val, end);
-    }
-}
 
-static void
-print_io_api(long io_types)
-{
-    if (io_types & PIO_POSIX)
-	HDfprintf(output, "posix ");
-    if (io_types & PIO_MPI)
-	HDfprintf(output, "mpiio ");
-    if (io_types & PIO_HDF5)
-	HDfprintf(output, "phdf5 ");
-    HDfprintf(output, "\n");
-}
+        val = HDstrchr(key, '=');
+        if (val) {
+            end = val;
+            *val++ = '\0';
+            val += strspn(val, " \t");
+            while (end > key && isspace((int)end[-1]))
+                *--end = '\0';
+            if (*val == '\0')
+                goto error;
+        }
 
-static void
-report_parameters(struct options *opts)
-{
-    int rank = comm_world_rank_g;
+        if (!HDstrcmp(key, "op")) {
+            if (val && !HDstrcasecmp(val, "readwrite"))
+                phase->op = PIO_PHASE_READWRITE;
+            else if (val && !HDstrcasecmp(val, "write"))
+                phase->op = PIO_PHASE_WRITE;
+            else if (val && !HDstrcasecmp(val, "read"))
+                phase->op = PIO_PHASE_READ;
+            else
+                goto error;
+        } else if (!HDstrcmp(key, "keep")) {
+            if (val && !HDstrcasecmp(val, "yes"))
+                phase->keep = TRUE;
+            else if (val && !HDstrcasecmp(val, "no"))
+                phase->keep = FALSE;
+            else
+                goto error;
+        } else if (!HDstrcmp(key, "hints")) {
+            if (!val)
+                goto error;
+            phase->hints = val;
+        } else {
+            /* the full name of a long option, with a value if it takes one */
+            for (i = 0; l_opts[i].name; i++)
+                if (!HDstrcmp(l_opts[i].name, key))
+                    break;
 
-    print_version("HDF5 Library");	/* print library version */
-    HDfprintf(output, "rank %d: ==== Parameters ====\n", rank);
+            if (!l_opts[i].name || (l_opts[i].has_arg == no_arg) != (val == NULL) ||
+                    phase->nargs == PIO_MAX_PHASE_ARGS)
+                goto error;
 
-    HDfprintf(output, "rank %d: IO API=", rank);
-    print_io_api(opts->io_types);
+            phase->keys[phase->nargs] = key;
+            phase->vals[phase->nargs] = val;
+            phase->lines[phase->nargs] = lineno;
+            phase->nargs++;
+        }
+    }
 
-    HDfprintf(output, "rank %d: Number of files=%ld\n", rank,
-              opts->num_files);
-    HDfprintf(output, "rank %d: Number of datasets=%ld\n", rank,
-              opts->num_dsets);
-    HDfprintf(output, "rank %d: Number of iterations=%d\n", rank,
-              opts->num_iters);
-    HDfprintf(output, "rank %d: Number of processes=%d:%d\n", rank,
-              opts->min_num_procs, opts->max_num_procs);
+    if (*num_phases == 0) {
+        if (comm_world_rank_g == 0)
+            fprintf(stderr, "%s: %s: no [phase] in the workload\n", progname, fname);
+        return FAIL;
+    }
 
-    if (opts->dim2d){
-    HDfprintf(output, "rank %d: Number of bytes per process per dataset=", rank);
-    recover_size_and_print((long long)(opts->num_bpp * opts->num_bpp * opts->min_num_procs), ":");
-    recover_size_and_print((long long)(opts->num_bpp * opts->num_bpp * opts->max_num_procs), "\n");
+    return SUCCESS;
 
-    HDfprintf(output, "rank %d: Size of dataset(s)=", rank);
-    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), "x");
-    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), ":");
-    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "x");
-    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "\n");
+error:
+    if (comm_world_rank_g == 0)
+        fprintf(stderr, "%s: %s:%d: invalid workload line\n", progname, fname, lineno);
+    return FAIL;
+}
 
-    HDfprintf(output, "rank %d: File size=", rank);
-    recover_size_and_print((long long)(pow(opts->num_bpp * opts->min_num_procs,2)
-            * opts->num_dsets), ":");
-    recover_size_and_print((long long)(pow(opts->num_bpp * opts->max_num_procs,2)
-            * opts->num_dsets), "\n");
+/*
+ * Function:    parse_filters
+ * Purpose:     Parse the comma separated --filters list: shuffle,
+ *              deflate[:LEVEL] and fletcher32, or none.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_filters(const char *spec, struct options *opts)
+{
+    const char *end = spec;
 
-    HDfprintf(output, "rank %d: Transfer buffer size=", rank);
-    if(opts->interleaved){
-        recover_size_and_print((long long)opts->min_xfer_size, "x");
-        recover_size_and_print((long long)opts->blk_size, ":");
-        recover_size_and_print((long long)opts->max_xfer_size, "x");
-        recover_size_and_print((long long)opts->blk_size, "\n");
-    }
-    else{
-        recover_size_and_print((long long)opts->blk_size, "x");
-        recover_size_and_print((long long)opts->min_xfer_size, ":");
-        recover_size_and_print((long long)opts->blk_size, "x");
-        recover_size_and_print((long long)opts->max_xfer_size, "\n");
-    }
-    HDfprintf(output, "rank %d: Block size=", rank);
-    recover_size_and_print((long long)opts->blk_size, "x");
-    recover_size_and_print((long long)opts->blk_size, "\n");
-    }
-    else{
-    HDfprintf(output, "rank %d: Number of bytes per process per dataset=", rank);
-    recover_size_and_print((long long)opts->num_bpp, "\n");
+    opts->filters = 0;
 
-    HDfprintf(output, "rank %d: Size of dataset(s)=", rank);
-    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs), ":");
-    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs), "\n");
+    while (*end != '\0') {
+        size_t len = strcspn(end, ",");
+        char buf[16], *level;
 
-    HDfprintf(output, "rank %d: File size=", rank);
-    recover_size_and_print((long long)(opts->num_bpp * opts->min_num_procs
-            * opts->num_dsets), ":");
-    recover_size_and_print((long long)(opts->num_bpp * opts->max_num_procs
-            * opts->num_dsets), "\n");
+        if (len >= sizeof(buf))
+            goto error;
 
-    HDfprintf(output, "rank %d: Transfer buffer size=", rank);
-    recover_size_and_print((long long)opts->min_xfer_size, ":");
-    recover_size_and_print((long long)opts->max_xfer_size, "\n");
-    HDfprintf(output, "rank %d: Block size=", rank);
-    recover_size_and_print((long long)opts->blk_size, "\n");
-    }
+        HDstrncpy(buf, end, len);
+        buf[len] = '\0';
 
-    HDfprintf(output, "rank %d: Block Pattern in Dataset=", rank);
-    if(opts->interleaved)
-        HDfprintf(output, "Interleaved\n");
-    else
-        HDfprintf(output, "Contiguous\n");
+        if ((level = HDstrchr(buf, ':')) != NULL)
+            *level++ = '\0';
 
-    HDfprintf(output, "rank %d: I/O Method for MPI and HDF5=", rank);
-    if(opts->collective)
-        HDfprintf(output, "Collective\n");
-    else
-        HDfprintf(output, "Independent\n");
+        if (!HDstrcasecmp(buf, "deflate")) {
+            opts->filters |= PIO_FILTER_DEFLATE;
 
-    HDfprintf(output, "rank %d: Geometry=", rank);
-    if(opts->dim2d)
-        HDfprintf(output, "2D\n");
-    else
-        HDfprintf(output, "1D\n");
+            if (level) {
+                char *next;
+                long l = strtol(level, &next, 10);
 
-    HDfprintf(output, "rank %d: VFL used for HDF5 I/O=%s\n", rank, "MPI-IO driver");
+                if (*next != '\0' || next == level || l < 0 || l > 9)
+                    goto error;
 
-    HDfprintf(output, "rank %d: Data storage method in HDF5=", rank);
-    if(opts->h5_use_chunks)
-        HDfprintf(output, "Chunked\n");
-    else
-        HDfprintf(output, "Contiguous\n");
+                opts->deflate_level = (int)l;
+            }
+        } else if (level) {
+            goto error;
+        } else if (!HDstrcasecmp(buf, "shuffle")) {
+            opts->filters |= PIO_FILTER_SHUFFLE;
+        } else if (!HDstrcasecmp(buf, "fletcher32")) {
+            opts->filters |= PIO_FILTER_FLETCHER32;
+        } else if (HDstrcasecmp(buf, "none")) {
+            goto error;
+        }
 
-    {
-        char *prefix = getenv("HDF5_PARAPREFIX");
+        end += len;
 
-        HDfprintf(output, "rank %d: Env HDF5_PARAPREFIX=%s\n", rank,
-                  (prefix ? prefix : "not set"));
+        if (*end == ',')
+            end++;
     }
 
-    HDfprintf(output, "rank %d: ", rank);
-    h5_dump_info_object(h5_io_info_g);
-
-    HDfprintf(output, "rank %d: ==== End of Parameters ====\n", rank);
-    HDfprintf(output, "\n");
-}
+    return SUCCESS;
 
-/*
- * Function:    parse_command_line
- * Purpose:     Parse the command line options and return a STRUCT OPTIONS
- *              structure which will need to be freed by the calling function.
- * Return:      Pointer to an OPTIONS structure
- * Programmer:  Bill Wendling, 31. October 2001
+error:
+    fprintf(stderr, "pio_perf: invalid --filters option %s\n", spec);
+    return FAIL;
+}
+
+/*
+ * Function:    parse_schedule
+ * Purpose:     Parse a sweep schedule, a comma separated list whose
+ *              entries are values or progressions FIRST:LAST[:STEP].
+ *              STEP is +N or -N for an arithmetic progression and *N or
+ *              /N for a geometric one; without it the values double up
+ *              to LAST or halve down to it.  Values take the K, M and G
+ *              suffixes of sizes, e.g. 1,3:9:+3,64K:1M.  NAME is the long
+ *              option for the error message.
+ * Return:      SUCCESS or FAIL
  * Modifications:
- *    Added 2D testing (Christian Chilan, 10. August 2005)
  */
-static struct options *
-parse_command_line(int argc, char *argv[])
+static int
+parse_schedule(const char *spec, const char *name, pio_sched *sched)
 {
-    register int opt;
-    struct options *cl_opts;
+    const char *end = spec;
 
-    cl_opts = (struct options *)malloc(sizeof(struct options));
+    sched->num = 0;
 
-    cl_opts->output_file = NULL;
-    cl_opts->io_types =  0;    /* will set default after parsing options */
-    cl_opts->num_dsets = 1;
-    cl_opts->num_files = 1;
-    cl_opts->num_bpp = 0;
-    cl_opts->num_iters = 1;
-    cl_opts->max_num_procs = comm_world_nprocs_g;
-    cl_opts->min_num_procs = 1;
-    cl_opts->max_xfer_size = 0;
-    cl_opts->min_xfer_size = 0;
-    cl_opts->blk_size = 0;
-    cl_opts->interleaved = 0;       /* Default to contiguous blocks in dataset */
-    cl_opts->collective = 0;        /* Default to independent I/O access */
-    cl_opts->dim2d = 0;             /* Default to 1D */
-    cl_opts->print_times = FALSE;   /* Printing times is off by default */
-    cl_opts->print_raw = FALSE;     /* Printing raw data throughput is off by default */
-    cl_opts->h5_alignment = 1;      /* No alignment for HDF5 objects by default */
-    cl_opts->h5_threshold = 1;      /* No threshold for aligning HDF5 objects by default */
-    cl_opts->h5_use_chunks = FALSE; /* Don't chunk the HDF5 dataset by default */
-    cl_opts->h5_write_only = FALSE; /* Do both read and write by default */
-    cl_opts->verify = FALSE;        /* No Verify data correctness by default */
+    while (*end != '\0') {
+        off_t first, last, step = 0, val;
+        char op = '\0';
 
-    while ((opt = get_option(argc, (const char **)argv, s_opts, l_opts)) != EOF) {
-        switch ((char)opt) {
-        case 'a':
-            cl_opts->h5_alignment = parse_size_directive(opt_arg);
-            break;
-        case 'A':
-            {
-                const char *end = opt_arg;
+        if (parse_sched_value(&end, &first) != SUCCESS)
+            goto error;
 
-                while (end && *end != '\0') {
-                    char buf[10];
-                    int i;
+        last = first;
 
-                    memset(buf, '\0', sizeof(buf));
+        if (*end == ':') {
+            end++;
 
-                    for (i = 0; *end != '\0' && *end != ','; ++end)
-                        if (isalnum(*end) && i < 10)
-                            buf[i++] = *end;
+            if (parse_sched_value(&end, &last) != SUCCESS)
+                goto error;
 
-                    if (!HDstrcasecmp(buf, "phdf5")) {
-                        cl_opts->io_types |= PIO_HDF5;
-                    } else if (!HDstrcasecmp(buf, "mpiio")) {
-                        cl_opts->io_types |= PIO_MPI;
-                    } else if (!HDstrcasecmp(buf, "posix")) {
-                        cl_opts->io_types |= PIO_POSIX;
-                    } else {
-                        fprintf(stderr, "pio_perf: invalid --api option %s\n",
-                                buf);
-                        exit(EXIT_FAILURE);
-                    }
+            op = (first <= last) ? '*' : '/';
+            step = 2;
 
-                    if (*end == '\0')
-                        break;
+            if (*end == ':') {
+                end++;
+                op = *end++;
 
-                    end++;
-                }
+                if ((op != '+' && op != '-' && op != '*' && op != '/') ||
+                        parse_sched_value(&end, &step) != SUCCESS)
+                    goto error;
             }
 
-            break;
-#if 0
-        case 'b':
-            /* the future "binary" option */
-            break;
-#endif  /* 0 */
-        case 'B':
-            cl_opts->blk_size = parse_size_directive(opt_arg);
-            break;
-        case 'c':
-            /* Turn on chunked HDF5 dataset creation */
-            cl_opts->h5_use_chunks = TRUE;
-            break;
-        case 'C':
-            cl_opts->collective = 1;
-            break;
-        case 'd':
-            cl_opts->num_dsets = atoi(opt_arg);
-            break;
-        case 'D':
-            {
-                const char *end = opt_arg;
+            /* the progression has to head for LAST */
+            if ((op == '*' || op == '/') && step < 2)
+                goto error;
+            if ((op == '+' || op == '*') ? first > last : first < last)
+                goto error;
+        }
 
-                while (end && *end != '\0') {
-                    char buf[10];
-                    int i;
+        for (val = first; ; ) {
+            if (sched->num == PIO_MAX_SCHED)
+                goto error;
 
-                    memset(buf, '\0', sizeof(buf));
+            sched->vals[sched->num++] = val;
 
-                    for (i = 0; *end != '\0' && *end != ','; ++end)
-                        if (isalnum(*end) && i < 10)
-                            buf[i++] = *end;
+            if (op == '+')
+                val += step;
+            else if (op == '-')
+                val -= step;
+            else if (op == '*')
+                val *= step;
+            else if (op == '/')
+                val /= step;
+            else
+                break;
 
-                    if (strlen(buf) > 1 || isdigit(buf[0])) {
-                        size_t j;
+            if ((op == '+' || op == '*') ? val > last : val < last)
+                break;
+        }
 
-                        for (j = 0; j < 10 && buf[j] != '\0'; ++j)
-                            if (!isdigit(buf[j])) {
-                                fprintf(stderr, "pio_perf: invalid --debug option %s\n",
-                                        buf);
-                                exit(EXIT_FAILURE);
-                            }
+        if (*end == ',')
+            end++;
+        else if (*end != '\0')
+            goto error;
+    }
 
-                        pio_debug_level = atoi(buf);
+    if (sched->num == 0)
+        goto error;
 
-                        if (pio_debug_level > 4)
-                            pio_debug_level = 4;
-                        else if (pio_debug_level < 0)
-                            pio_debug_level = 0;
-                    } else {
-                        switch (*buf) {
-                        case 'r':
-                            /* Turn on raw data throughput info */
-                            cl_opts->print_raw = TRUE;
-                            break;
-                        case 't':
-                            /* Turn on time printing */
-                            cl_opts->print_times = TRUE;
-                            break;
-            case 'v':
-                            /* Turn on verify data correctness*/
-                cl_opts->verify = TRUE;
-                break;
-                        default:
-                            fprintf(stderr, "pio_perf: invalid --debug option %s\n", buf);
-                            exit(EXIT_FAILURE);
-                        }
-                    }
+    sched->given = TRUE;
+    return SUCCESS;
 
-                    if (*end == '\0')
-                        break;
+error:
+    fprintf(stderr, "pio_perf: invalid --%s option %s\n", name, spec);
+    return FAIL;
+}
 
-                    end++;
-                }
-            }
+/*
+ * Function:    parse_sched_value
+ * Purpose:     Parse one positive value of a sweep schedule at *SPEC,
+ *              with an optional K, M or G suffix, and move *SPEC past it.
+ * Return:      SUCCESS or FAIL
+ * Modifications:
+ */
+static int
+parse_sched_value(const char **spec, off_t *val)
+{
+    char *next;
+    long long v = strtoll(*spec, &next, 10);
 
+    if (next == *spec || v <= 0)
+        return FAIL;
+
+    switch (*next) {
+        case 'K':
+        case 'k':
+            v *= ONE_KB;
+            next++;
             break;
-        case 'e':
-            cl_opts->num_bpp = parse_size_directive(opt_arg);
-            break;
-        case 'F':
-            cl_opts->num_files = atoi(opt_arg);
+        case 'M':
+        case 'm':
+            v *= ONE_MB;
+            next++;
             break;
+        case 'G':
         case 'g':
-            cl_opts->dim2d = 1;
-            break;
-        case 'i':
-            cl_opts->num_iters = atoi(opt_arg);
-            break;
-        case 'I':
-            cl_opts->interleaved = 1;
-            break;
-        case 'o':
-            cl_opts->output_file = opt_arg;
-            break;
-        case 'p':
-            cl_opts->min_num_procs = atoi(opt_arg);
-            break;
-        case 'P':
-            cl_opts->max_num_procs = atoi(opt_arg);
-            break;
-        case 'T':
-            cl_opts->h5_threshold = parse_size_directive(opt_arg);
+            v *= ONE_GB;
+            next++;
             break;
-        case 'w':
-            cl_opts->h5_write_only = TRUE;
-            break;
-        case 'x':
-            cl_opts->min_xfer_size = parse_size_directive(opt_arg);
-            break;
-        case 'X':
-            cl_opts->max_xfer_size = parse_size_directive(opt_arg);
-            break;
-        case 'h':
-        case '?':
         default:
-            usage(progname);
-            free(cl_opts);
-            return NULL;
-        }
-    }
-
-
-    if (cl_opts->num_bpp == 0){
-        if (cl_opts->dim2d == 0)
-            cl_opts->num_bpp = 256 * ONE_KB;
-        else
-            cl_opts->num_bpp = 8 * ONE_KB;
+            break;
     }
 
-    if (cl_opts->max_xfer_size == 0)
-        cl_opts->max_xfer_size = cl_opts->num_bpp;
-
-    if (cl_opts->min_xfer_size == 0)
-        cl_opts->min_xfer_size = (cl_opts->num_bpp)/2;
-
-    if (cl_opts->blk_size == 0)
-        cl_opts->blk_size = (cl_opts->num_bpp)/2;
-
+    *val = (off_t)v;
+    *spec = next;
+    return SUCCESS;
+}
 
-    /* set default if none specified yet */
-    if (!cl_opts->io_types)
-    cl_opts->io_types = PIO_HDF5 | PIO_MPI | PIO_POSIX; /* run all API */
+/*
+ * Function:    group_mode_name
+ * Purpose:     Name the workload of a process group for the reports.
+ * Return:      The name
+ * Modifications:
+ */
+static const char *
+group_mode_name(int mode)
+{
+    if (!(mode & PIO_GROUP_READ))
+        return "write";
+    if (!(mode & PIO_GROUP_WRITE))
+        return "read";
+    return "write/read";
+}
 
-    /* verify parameters sanity.  Adjust if needed. */
-    /* cap xfer_size with bytes per process */
-    if (!cl_opts->dim2d) {
-        if (cl_opts->min_xfer_size > cl_opts->num_bpp)
-        cl_opts->min_xfer_size = cl_opts->num_bpp;
-        if (cl_opts->max_xfer_size > cl_opts->num_bpp)
-        cl_opts->max_xfer_size = cl_opts->num_bpp;
+/*
+ * Function:    driver_name
+ * Purpose:     Name the HDF5 file driver for the reports.
+ * Return:      The name
+ * Modifications:
+ */
+static const char *
+driver_name(int driver)
+{
+    switch (driver) {
+        case PIO_DRIVER_SEC2:
+            return "sec2";
+        case PIO_DRIVER_CORE:
+            return "core";
+        default:
+            return "MPI-IO";
     }
-    if (cl_opts->min_xfer_size > cl_opts->max_xfer_size)
-    cl_opts->min_xfer_size = cl_opts->max_xfer_size;
-    if (cl_opts->blk_size > cl_opts->num_bpp )
-        cl_opts->blk_size = cl_opts->num_bpp;
-    /* check range of number of processes */
-    if (cl_opts->min_num_procs <= 0)
-    cl_opts->min_num_procs = 1;
-    if (cl_opts->max_num_procs <= 0)
-    cl_opts->max_num_procs = 1;
-    if (cl_opts->min_num_procs > cl_opts->max_num_procs)
-    cl_opts->min_num_procs = cl_opts->max_num_procs;
-    /* check iteration */
-    if (cl_opts->num_iters <= 0)
-    cl_opts->num_iters = 1;
-
-    return cl_opts;
 }
 
 /*
@@ -1498,8 +4869,8 @@ parse_command_line(int argc, char *argv[])
  *                  G, g - Gigabyte
  *
  * Return:      The size as a off_t because this is related to file size.
- *              If an unknown size indicator is used, then the program will
- *              exit with EXIT_FAILURE as the return value.
+ *              If an unknown size indicator or a negative size is
+ *              used, then -1 is returned.
  * Programmer:  Bill Wendling, 18. December 2001
  * Modifications:
  */
@@ -1530,10 +4901,13 @@ parse_size_directive(const char *size)
                 break;
             default:
                 fprintf(stderr, "Illegal size specifier '%c'\n", *endptr);
-                exit(EXIT_FAILURE);
+                return -1;
         }
     }
 
+    if (s < 0)
+        fprintf(stderr, "Illegal size %s\n", size);
+
     return s;
 }
 
@@ -1566,29 +4940,89 @@ usage(const char *prog)
         printf("                                 (see below for description)\n");
         printf("                                 [default: half the number of bytes per process\n");
         printf("                                           per dataset]\n");
+        printf("     -Y SL, --blocks=SL          Sweep the block size over SL instead of -B\n");
+        printf("                                 (see below for description)\n");
         printf("     -c, --chunk                 Create HDF5 datasets using chunked storage\n");
         printf("                                 [default: contiguous storage]\n");
+        printf("     -j CC, --chunk-cache=CC     Chunk cache of HDF5 datasets\n");
+        printf("                                 (see below for description)\n");
+        printf("                                 [default: the library's]\n");
+        printf("     -J RL, --chunk-sweep=RL     Run PHDF5 once per chunk to transfer size\n");
+        printf("                                 ratio (see below for description)\n");
         printf("     -C, --collective            Use collective I/O for MPI and HDF5 APIs\n");
         printf("                                 [default: independent I/O)\n");
+        printf("     -O M, --chunk-opt=M         Collective chunk I/O of HDF5: link, multi or\n");
+        printf("                                 auto (see below for description)\n");
+        printf("                                 [default: auto]\n");
+        printf("     -N N, --chunk-opt-num=N     Chunks per process above which auto picks\n");
+        printf("                                 link-chunk I/O [default: the library's]\n");
+        printf("     -R N, --chunk-opt-ratio=N   Percent of processes per chunk above which\n");
+        printf("                                 multi-chunk I/O does the chunk collectively\n");
+        printf("                                 [default: the library's]\n");
+        printf("     -Q M, --collective-opt=M    MPI-IO calls under collective HDF5 I/O:\n");
+        printf("                                 collective or individual\n");
+        printf("                                 [default: collective]\n");
         printf("     -d N, --num-dsets=N         Number of datasets per file [default: 1]\n");
+        printf("     -Z NL, --dsets=NL           Sweep the datasets per file over NL\n");
         printf("     -D DL, --debug=DL           Indicate the debugging level\n");
         printf("                                 [default: no debugging]\n");
         printf("     -e S, --num-bytes=S         Number of bytes per process per dataset\n");
         printf("                                 (see below for description)\n");
         printf("                                 [default: 256K for 1D, 8K for 2D]\n");
+        printf("     -E N, --extend-steps=N      Append steps added per H5Dset_extent call\n");
+        printf("                                 [default: 1]\n");
+        printf("     -f N, --flush-steps=N       Flush appended datasets every N steps\n");
+        printf("                                 [default: never]\n");
         printf("     -F N, --num-files=N         Number of files [default: 1]\n");
+        printf("     -H FL, --filters=FL         HDF5 filters: shuffle, deflate[:N] and\n");
+        printf("                                 fletcher32; implies --chunk and, with\n");
+        printf("                                 MPI-IO, needs --collective [default: none]\n");
         printf("     -g, --geometry              Use 2D geometry [default: 1D geometry]\n");
+        printf("     -G GL, --groups=GL          Run concurrent process groups\n");
+        printf("                                 (see below for description)\n");
+        printf("                                 [default: one group]\n");
         printf("     -i N, --num-iterations=N    Number of iterations to perform [default: 1]\n");
         printf("     -I, --interleaved           Interleaved access pattern\n");
         printf("                                 (see below for example)\n");
         printf("                                 [default: Contiguous access pattern]\n");
+        printf("     -k N, --stripe-count=N      File system stripe count, or 'auto'\n");
+        printf("                                 [default: 1]\n");
+        printf("     -K S, --chunk-dims=S        Chunk size of HDF5 datasets, SxS in 2D;\n");
+        printf("                                 implies --chunk [default: block size]\n");
+        printf("     -l F, --workload=F          Run the phases of workload file F\n");
+        printf("                                 (see below for description)\n");
+        printf("     -L, --flush-file            Flush the whole file instead of the dataset\n");
         printf("     -o F, --output=F            Output raw data into file F [default: none]\n");
         printf("     -p N, --min-num-processes=N Minimum number of processes to use [default: 1]\n");
         printf("     -P N, --max-num-processes=N Maximum number of processes to use\n");
         printf("                                 [default: all MPI_COMM_WORLD processes ]\n");
+        printf("     -M NL, --procs=NL           Numbers of processes to run with instead of\n");
+        printf("                                 -p and -P (see below for description)\n");
+        printf("     -q M, --replay-mode=M       Replay at the traced times (timed) or as\n");
+        printf("                                 fast as possible (asap) [default: asap]\n");
+        printf("     -r NL, --restart=NL         Checkpoint with every number of processes,\n");
+        printf("                                 restart with each of the list NL\n");
+        printf("                                 (see below for description)\n");
+        printf("     -u M, --scaling=M           Checkpoint size for --restart: strong, weak\n");
+        printf("                                 or both [default: strong]\n");
+        printf("     -U F, --replay=F            Replay the I/O of Darshan trace F\n");
+        printf("                                 (see below for description)\n");
+        printf("         --sample=T              Sample the bandwidth of all processes every\n");
+        printf("                                 T seconds (or Tms) from open to close of the\n");
+        printf("                                 write and read phases [default: off]\n");
+        printf("         --driver=D              HDF5 file driver: mpio, or in the threaded\n");
+        printf("                                 build sec2 or core, which keeps the file in\n");
+        printf("                                 memory and writes it out on close\n");
+        printf("                                 [default: mpio, sec2 threaded]\n");
+        printf("     -S S, --stripe-size=S       File system stripe size, or 'auto' to query\n");
+        printf("                                 the file system (see below for description)\n");
+        printf("                                 [default: none]\n");
         printf("     -T S, --threshold=S         Threshold for alignment of objects in HDF5 file\n");
         printf("                                 [default: 1]\n");
         printf("     -w, --write-only            Perform write tests not the read tests\n");
+        printf("     -W, --swmr                  One SWMR writer appends while the other\n");
+        printf("                                 processes read (PHDF5, 1D only)\n");
+        printf("                                 (see below for description)\n");
         printf("     -x S, --min-xfer-size=S     Minimum transfer buffer size\n");
         printf("                                 (see below for description)\n");
         printf("                                 [default: half the number of bytes per process\n");
@@ -1596,6 +5030,17 @@ usage(const char *prog)
         printf("     -X S, --max-xfer-size=S     Maximum transfer buffer size\n");
         printf("                                 [default: the number of bytes per process per\n");
         printf("                                           dataset]\n");
+        printf("     -v D, --compare=D           Compare the reports given after the options\n");
+        printf("                                 with the baseline reports in D\n");
+        printf("                                 (see below for description)\n");
+        printf("     -V SL, --xfers=SL           Transfer buffer sizes instead of -x and -X\n");
+        printf("                                 (see below for description)\n");
+        printf("     -y, --append                Append workload: grow unlimited chunked\n");
+        printf("                                 datasets one step at a time (PHDF5, 1D only)\n");
+        printf("                                 (see below for description)\n");
+        printf("     -z S, --append-chunk=S      Chunk size of appended datasets\n");
+        printf("                                 [default: block size with --chunk, else\n");
+        printf("                                           one step]\n");
         printf("\n");
         printf("  F  - is a filename.\n");
         printf("  N  - is an integer >=0.\n");
@@ -1613,6 +5058,19 @@ usage(const char *prog)
         printf("\n");
         printf("      Example: --api=mpiio,phdf5\n");
         printf("\n");
+        printf("  GL - is a list of process groups, each API[:MODE[:N]] where MODE is\n");
+        printf("       w (write), r (read) or rw [default: rw] and N the number of\n");
+        printf("       processes [default: share the processes left over].\n");
+        printf("\n");
+        printf("      Example: --groups=mpiio:w:8,posix:r\n");
+        printf("\n");
+        printf("      The groups run at the same time, each against its own files, so one\n");
+        printf("      group's I/O competes with the others' for the file system. A read\n");
+        printf("      group writes its files untimed first. Each group reports into\n");
+        printf("      F.groupN (or h5perf.groupN without --output) and the per-group and\n");
+        printf("      aggregate bandwidth follow the parameters. --min-num-processes and\n");
+        printf("      --max-num-processes are ignored.\n");
+        printf("\n");
         printf("  Dataset size:\n");
         printf("      Depending on the selected geometry, each test dataset is either a linear\n");
         printf("      array of size bytes-per-process * num-processes, or a square array of size\n");
@@ -1657,6 +5115,113 @@ usage(const char *prog)
         printf("      For information about access patterns in 2D geometry, please refer to the\n");
         printf("      HDF5 Reference Manual.\n");
         printf("\n");
+        printf("  Stripe size and count:\n");
+        printf("      When a stripe size is given, the HDF5 alignment and threshold default to\n");
+        printf("      the stripe size, the block size (each --blocks entry too) is rounded\n");
+        printf("      so blocks do not straddle stripes, and the striping_unit,\n");
+        printf("      striping_factor and cb_nodes MPI-IO hints are set unless\n");
+        printf("      HDF5_MPI_INFO already provides them. The write results then report\n");
+        printf("      how many process boundaries fall inside a stripe.\n");
+        printf("\n");
+        printf("  Append workload:\n");
+        printf("      Each dataset is created empty with an unlimited dimension. In every\n");
+        printf("      step each process appends one transfer buffer, so a step grows the\n");
+        printf("      dataset by buffer-size * num-processes bytes. All processes extend\n");
+        printf("      the dataset together with H5Dset_extent every extend-steps steps.\n");
+        printf("      The write results add the minimum, average and maximum time of a\n");
+        printf("      step, extension and flush included.\n");
+        printf("\n");
+        printf("  SWMR workload:\n");
+        printf("      Process 0 appends to chunked datasets in a file it holds in SWMR\n");
+        printf("      write mode, flushing every flush-steps steps [default: 1]. All other\n");
+        printf("      processes open the file for SWMR reading and poll the last dataset\n");
+        printf("      with H5Drefresh, sleeping 0.1 ms after a poll that saw nothing new.\n");
+        printf("      The writer first runs the same appends without SWMR\n");
+        printf("      so its throughput can be compared; the readers report the time from\n");
+        printf("      the write of a step until they saw it. Both use the sec2 driver.\n");
+        printf("\n");
+        printf("  Chunk cache and chunk size sweep:\n");
+        printf("      CC is NSLOTS,S,W0 as passed to H5Pset_chunk_cache: hash table slots,\n");
+        printf("      cache size and preemption policy (0 to 1). Empty fields keep the\n");
+        printf("      default, e.g. --chunk-cache=10007,64M, . RL is a list of ratios of\n");
+        printf("      chunk size to transfer buffer size, e.g. --chunk-sweep=0.25,1,4. For\n");
+        printf("      every transfer buffer size the PHDF5 test runs once per ratio and a\n");
+        printf("      table of throughput against the ratio follows. In 2D only the long\n");
+        printf("      side of the transfer is scaled. With either option, chunked PHDF5\n");
+        printf("      results report chunk cache hits and misses; the library keeps no\n");
+        printf("      counts, so they come from replaying each transfer against a model\n");
+        printf("      of the configured cache after the timers have stopped.\n");
+        printf("\n");
+        printf("  Collective chunk I/O:\n");
+        printf("      With --collective, link-chunk I/O moves all chunks of a transfer in\n");
+        printf("      one MPI-IO call and multi-chunk I/O one chunk at a time. auto lets\n");
+        printf("      HDF5 choose using --chunk-opt-num and --chunk-opt-ratio. After every\n");
+        printf("      PHDF5 transfer the I/O mode and chunk optimization the library used\n");
+        printf("      are queried; the results count them and list why transfers that\n");
+        printf("      were asked to be collective were not. --chunk-opt, --chunk-opt-num,\n");
+        printf("      --chunk-opt-ratio and --collective-opt need --collective.\n");
+        printf("\n");
+        printf("  Sweep schedules:\n");
+        printf("      NL and SL are lists of values and progressions FIRST:LAST[:STEP],\n");
+        printf("      STEP being +N or -N for arithmetic and *N or /N for geometric ones\n");
+        printf("      [default: *2 up to LAST or /2 down to it]. Sizes take the K, M and\n");
+        printf("      G suffixes. E.g. --procs=8192:1 --xfers=64K:1M,4M --dsets=1:4:+1\n");
+        printf("      runs every combination of the schedules from one launch. The\n");
+        printf("      communicator of each distinct number of processes is split once.\n");
+        printf("\n");
+        printf("  Checkpoint/restart:\n");
+        printf("      With --restart the datasets are written by N processes, N going\n");
+        printf("      through the process schedule, and\n");
+        printf("      read back by each count in NL, e.g. --restart=3,4,8, so readers\n");
+        printf("      take slices that other processes wrote. Strong scaling keeps the\n");
+        printf("      checkpoint at num-bytes times max-num-processes for every N; weak\n");
+        printf("      scaling makes it num-bytes times N. A row gives the checkpoint and\n");
+        printf("      restart times of the slowest process, file open to close, and\n");
+        printf("      their sum as the time to solution. Combinations that do not split\n");
+        printf("      into whole transfers per process are skipped. With --debug=v all\n");
+        printf("      writers write the same bytes and the readers check them, so a row\n");
+        printf("      whose restart reads back anything else fails; the check does not\n");
+        printf("      tell which writer a slice came from.\n");
+        printf("\n");
+        printf("  Workload files:\n");
+        printf("      A workload file lists phases that run one after the other. A line\n");
+        printf("      [NAME] starts a phase; the other lines are OPTION or OPTION = VALUE\n");
+        printf("      with the long options above, e.g. api = phdf5, collective or\n");
+        printf("      num-bytes = 1G. Lines before the first phase apply to every phase\n");
+        printf("      unless the phase sets the option too; # starts a comment. Besides\n");
+        printf("      options a phase takes op = readwrite, write or read: write keeps\n");
+        printf("      its files for a later read phase with the same api, num-files and\n");
+        printf("      sizes, which removes them; keep = yes or no overrides that. hints\n");
+        printf("      = KEY=VALUE;... adds MPI-IO hints to those of $HDF5_MPI_INFO.\n");
+        printf("      Process 0 reads the file and broadcasts it. Of the command line\n");
+        printf("      only --output and --debug still apply.\n");
+        printf("\n");
+        printf("  Baseline comparison:\n");
+        printf("      h5perf --compare=BASE REPORT... reads the h5perf reports REPORT\n");
+        printf("      and those in BASE; a directory stands for all *.out files below\n");
+        printf("      it, e.g. --compare=results/baseline results/new. Results are\n");
+        printf("      matched on processes, API, phase, transfer and file size, file\n");
+        printf("      and dataset counts, I/O method, geometry, storage and block\n");
+        printf("      size and pattern, and each is shown as a percentage of the\n");
+        printf("      baseline average. A change of 5%% or more is a regression or an\n");
+        printf("      improvement if a Welch t-test finds it significant at 5%%, with\n");
+        printf("      the deviation estimated from the min-max range of the\n");
+        printf("      iterations; with a single iteration it is flagged with a ?.\n");
+        printf("      Process 0 does the comparison. h5perf exits with failure if it\n");
+        printf("      finds a significant regression.\n");
+        printf("\n");
+        printf("  Trace replay:\n");
+        printf("      --replay takes the text output of darshan-parser (POSIX counters,\n");
+        printf("      per process or --total) or of darshan-dxt-parser. DXT accesses are\n");
+        printf("      issued as traced; for counters each process issues accesses with\n");
+        printf("      the traced counts, size histogram, bytes and share of consecutive\n");
+        printf("      and sequential accesses, spread over the traced time window. A\n");
+        printf("      shared (--total) record is split evenly between the processes,\n");
+        printf("      traced processes are folded onto the replaying ones. Every traced\n");
+        printf("      file gets a file of its own, filled before the clock starts where\n");
+        printf("      the trace reads it. MPI-IO accesses are independent. Runs for each\n");
+        printf("      number of processes of the process schedule.\n");
+        printf("\n");
         printf("  DL - is a list of debugging flags. Valid values are:\n");
         printf("          1 - Minimal\n");
         printf("          2 - Not quite everything\n");
@@ -1664,6 +5229,11 @@ usage(const char *prog)
         printf("          4 - The kitchen sink\n");
         printf("          r - Raw data I/O throughput information\n");
         printf("          t - Times as well as throughputs\n");
+        printf("          c - CPU event counters of the write and read phases,\n");
+        printf("              from open to close: cycles, instructions, cache\n");
+        printf("              misses, context switches, page faults and CPU time\n");
+        printf("              (Linux perf_event_open; events the system does not\n");
+        printf("              allow show as n/a)\n");
         printf("          v - Verify data correctness\n");
         printf("\n");
         printf("      Example: --debug=2,r,t\n");
@@ -1672,6 +5242,21 @@ usage(const char *prog)
         printf("  HDF5_NOCLEANUP   Do not remove data files if set [default remove]\n");
         printf("  HDF5_MPI_INFO    MPI INFO object key=value separated by ;\n");
         printf("  HDF5_PARAPREFIX  Paralllel data files prefix\n");
+#ifdef PIO_THREADS
+        printf("  H5PERF_THREADS   Number of threads, the processes of this build\n");
+        printf("                   [default: 1]\n");
+        printf("\n");
+        printf("  Threaded build:\n");
+        printf("  Built with -DPIO_THREADS, h5perf runs without MPI: the processes are\n");
+        printf("  threads of one process, for characterizing a single node.  It runs\n");
+        printf("  the POSIX and PHDF5 APIs; the HDF5 files use the sec2 or core driver\n");
+        printf("  of a thread-safe serial HDF5 and are shared by all the threads.\n");
+        printf("  There is no MPI-IO, --collective or --swmr.\n");
+        printf("  A thread-safe HDF5 holds one global lock for every API call, so the\n");
+        printf("  PHDF5 threads take turns in the library: their rates measure the\n");
+        printf("  lock as much as the storage and do not compare with the POSIX ones.\n");
+        printf("  The report marks them serialized by the HDF5 library lock.\n");
+#endif  /* PIO_THREADS */
         fflush(stdout);
     }
 }
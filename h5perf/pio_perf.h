@@ -16,6 +16,11 @@
 #ifndef PIO_PERF_H__
 #define PIO_PERF_H__
 
+/* Globals that differ between processes; per thread in the threaded build */
+#ifndef PIO_TLS
+#define PIO_TLS
+#endif  /* !PIO_TLS */
+
 #ifndef STANDALONE
 #include "H5private.h"
 #include "h5test.h"
@@ -38,6 +43,16 @@ typedef enum iotype_ {
     /*NUM_TYPES*/
 } iotype;
 
+/* HDF5 filters of chunked datasets, applied in this order */
+#define PIO_FILTER_SHUFFLE      0x1
+#define PIO_FILTER_DEFLATE      0x2
+#define PIO_FILTER_FLETCHER32   0x4
+
+/* HDF5 file drivers */
+#define PIO_DRIVER_MPIO         0
+#define PIO_DRIVER_SEC2         1
+#define PIO_DRIVER_CORE         2
+
 typedef struct parameters_ {
     iotype	io_type;        /* The type of IO test to perform       */
     int		num_procs;      /* Maximum number of processes to use   */
@@ -52,16 +67,124 @@ typedef struct parameters_ {
     unsigned    dim2d;          /* 1D vs. 2D                            */
     hsize_t 	h5_align;       /* HDF5 object alignment                */
     hsize_t 	h5_thresh;      /* HDF5 object alignment threshold      */
+    int         h5_driver;      /* PIO_DRIVER_* of the HDF5 files       */
+    hsize_t     stripe_size;    /* File system stripe size, 0 if unknown*/
+    int         stripe_count;   /* File system stripe count             */
     int 	h5_use_chunks;  /* Make HDF5 dataset chunked            */
     int    	h5_write_only;  /* Perform the write tests only         */
+    int         read_only;      /* Only read files kept by earlier runs */
+    int         keep_files;     /* Don't remove the files afterwards    */
+    int         group;          /* Concurrent process group, -1 if none */
+    int         append;         /* Grow the datasets step by step       */
+    hsize_t     append_chunk;   /* Chunk size of appended datasets      */
+    long        extend_steps;   /* Steps added per H5Dset_extent call   */
+    long        flush_steps;    /* Steps between flushes, 0 for none    */
+    int         flush_file;     /* Flush with H5Fflush, not H5Dflush    */
+    int         swmr;           /* One SWMR writer, the rest read       */
+    hsize_t     h5_chunk[2];    /* HDF5 chunk dims, 0 for the block size */
+    size_t      cache_nslots;   /* Chunk cache hash table slots         */
+    size_t      cache_nbytes;   /* Chunk cache size in bytes            */
+    double      cache_w0;       /* Chunk cache preemption policy        */
+    int         model_cache;    /* Count chunk cache hits and misses    */
+    int         chunk_opt;      /* H5FD_mpio_chunk_opt_t of collective I/O */
+    int         chunk_opt_num;  /* Link-chunk threshold, 0 for default  */
+    int         chunk_opt_ratio;/* Collective chunk percent, -1 for default */
+    int         coll_opt;       /* H5FD_mpio_collective_opt_t, -1 for default */
+    unsigned    filters;        /* PIO_FILTER_* of chunked datasets     */
+    int         deflate_level;  /* Compression level of PIO_FILTER_DEFLATE */
+    int         counters;       /* Sample event counters with the timers */
+    double      sample_interval;/* Seconds between bandwidth samples, 0 for none */
     int 	verify;    	/* Verify data correctness              */
+    int         verify_shared;  /* Verify one pattern all processes write */
 } parameters;
 
+/* What the MPI-IO driver did with collective HDF5 transfers */
+typedef struct mpio_modes_ {
+    long        io_mode[5];     /* Transfers per H5D_mpio_actual_io_mode_t */
+    long        chunk_opt[3];   /* Transfers per H5D_mpio_actual_chunk_opt_mode_t */
+    long        fallback;       /* Transfers that were not collective   */
+    unsigned    cause;          /* H5D_mpio_no_collective_cause_t bits seen */
+} mpio_modes;
+
 typedef struct results_ {
     herr_t      ret_code;
     pio_time   *timers;
+    int         stripe_misaligned; /* 1 if this process's first byte is
+                                    * off a stripe boundary             */
+    int         stripe_unknown; /* 1 if the alignment was not checked   */
+    long        num_steps;      /* Append steps taken by this process   */
+    double      step_min;       /* Fastest append step, in seconds      */
+    double      step_max;       /* Slowest append step, in seconds      */
+    double      step_sum;       /* Time spent in append steps           */
+    double      swmr_plain;     /* Writer time without SWMR             */
+    double      swmr_write;     /* Writer time with SWMR                */
+    double      swmr_flush;     /* Part of swmr_write spent flushing    */
+    long        num_seen;       /* Steps a SWMR reader saw appear       */
+    double      seen_min;       /* Shortest time from write to visible  */
+    double      seen_max;       /* Longest time from write to visible   */
+    double      seen_sum;       /* Sum of the times from write to visible */
+    long        write_hits;     /* Chunk cache hits while writing       */
+    long        write_misses;   /* Chunk cache misses while writing     */
+    long        read_hits;      /* Chunk cache hits while reading       */
+    long        read_misses;    /* Chunk cache misses while reading     */
+    mpio_modes  write_modes;    /* Collective writes as actually done   */
+    mpio_modes  read_modes;     /* Collective reads as actually done    */
 } results;
 
+/* Trace replay, see pio_replay.c */
+#define REPLAY_NBINS    10      /* Bins of the Darshan access size histograms */
+
+typedef struct replay_op_ {
+    double      start;          /* Seconds after the first traced access,
+                                 * negative if the trace has no time    */
+    off_t       offset;
+    size_t      length;
+    int         file;           /* Replayed file of the access          */
+    int         write;          /* Nonzero for a write                  */
+    long        seq;            /* Place in the trace, orders equal starts */
+} replay_op;
+
+typedef struct replay_record_ {
+    char        id[32];         /* Darshan record id of the file        */
+    int         rank;           /* Rank of the traced job, -1 if shared */
+    int         mpiio;          /* DXT accesses of the MPI-IO module    */
+    int         file;           /* Replayed file, shared by the records
+                                 * of a file id                         */
+    long long   reads, writes;
+    long long   bytes_read, bytes_written;
+    long long   max_byte_read, max_byte_written;
+    long long   consec_reads, consec_writes;
+    long long   seq_reads, seq_writes;
+    long long   size_read[REPLAY_NBINS];
+    long long   size_write[REPLAY_NBINS];
+    double      read_start, read_end;   /* Timestamps, 0 if unknown     */
+    double      write_start, write_end;
+    long        nops;           /* DXT accesses, 0 for a counter record */
+    long        max_ops;
+    replay_op  *ops;
+} replay_record;
+
+typedef struct replay_trace_ {
+    int         nprocs;         /* Processes of the traced job, 0 if unknown */
+    double      run_time;       /* Run time of the traced job, 0 if unknown */
+    double      first, last;    /* First and last traced access         */
+    int         nfiles;         /* Distinct files of the records        */
+    int         nrecords;
+    int         max_records;
+    replay_record *records;
+} replay_trace;
+
+typedef struct replay_results_ {
+    herr_t      ret_code;
+    long        reads, writes;  /* Operations issued by this process    */
+    long long   bytes_read, bytes_written;
+    double      elapsed;        /* From the common start to the last op */
+    double      read_time;      /* Time spent in read calls             */
+    double      write_time;     /* Time spent in write calls            */
+    double      max_lag;        /* Worst delay behind the traced schedule */
+    double      sum_lag;        /* Sum of the delays of all operations  */
+} replay_results;
+
 #ifndef SUCCESS
 #define SUCCESS     0
 #endif  /* !SUCCESS */
@@ -70,14 +193,14 @@ typedef struct results_ {
 #define FAIL        -1
 #endif  /* !FAIL */
 
-extern FILE     *output;            /* output file                          */
-extern pio_time *timer_g;           /* timer: global for stub functions     */
-extern int      comm_world_rank_g;  /* my rank in MPI_COMM_RANK             */
-extern int      comm_world_nprocs_g;/* num. of processes of MPI_COMM_WORLD  */
-extern MPI_Comm pio_comm_g;         /* Communicator to run the PIO          */
-extern int      pio_mpi_rank_g;     /* MPI rank of pio_comm_g               */
-extern int      pio_mpi_nprocs_g;   /* number of processes of pio_comm_g    */
-extern int      pio_debug_level;    /* The debug level:
+extern PIO_TLS FILE     *output;            /* output file                  */
+extern PIO_TLS pio_time *timer_g;           /* timer: global for stub functions */
+extern PIO_TLS int      comm_world_rank_g;  /* my rank in MPI_COMM_RANK     */
+extern PIO_TLS int      comm_world_nprocs_g;/* num. of processes of MPI_COMM_WORLD */
+extern PIO_TLS MPI_Comm pio_comm_g;         /* Communicator to run the PIO  */
+extern PIO_TLS int      pio_mpi_rank_g;     /* MPI rank of pio_comm_g       */
+extern PIO_TLS int      pio_mpi_nprocs_g;   /* number of processes of pio_comm_g */
+extern PIO_TLS int      pio_debug_level;    /* The debug level:
                                      *   0 - Off
                                      *   1 - Minimal
                                      *   2 - Some more
@@ -97,6 +220,19 @@ extern "C" {
 #endif  /* __cplusplus */
 
 extern results do_pio(parameters param);
+extern void do_pio_cleanup(parameters param);
+extern char *pio_create_filename(iotype iot, const char *base_name,
+    char *fullname, size_t size);
+extern void do_cleanupfile(iotype iot, char *fname);
+extern int pio_file_write_at(MPI_File fh, MPI_Offset offset, void *buf,
+    size_t nbytes, int collective, MPI_Status *status);
+extern int pio_file_read_at(MPI_File fh, MPI_Offset offset, void *buf,
+    size_t nbytes, int collective, MPI_Status *status);
+extern herr_t replay_parse(char *text, replay_trace *trace);
+extern void replay_free(replay_trace *trace);
+extern replay_results do_replay(const replay_trace *trace, iotype iot,
+    int timed);
+extern int pio_compare(const char *base, int nreports, char *const *reports);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,848 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF5.  The full HDF5 copyright notice, including     *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the files COPYING and Copyright.html.  COPYING can be found at the root   *
+ * of the source code distribution tree; Copyright.html can be found at the  *
+ * root level of an installed copy of the electronic HDF5 document set and   *
+ * is linked from the top-level documents page.  It can also be found at     *
+ * http://hdfgroup.org/HDF5/doc/Copyright.html.  If you do not have          *
+ * access to either file, you may request a copy from help@hdfgroup.org.     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+ * Purpose:
+ *
+ * Replay of the I/O of a traced job.  The trace is the text output of
+ * darshan-parser: either the POSIX counters of each file (operation counts,
+ * access size histograms, consecutive and sequential counts, byte counts
+ * and timestamps; per rank or reduced with --total), or the individual
+ * accesses of a DXT trace (darshan-dxt-parser).  Counter records are
+ * turned into a synthetic stream of accesses with the same counts, sizes
+ * and access pattern; DXT accesses are issued as traced.  The accesses are
+ * replayed through POSIX or MPI-IO, either as fast as possible or at the
+ * times they happened in the traced job.
+ */
+
+#include <sys/types.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+
+#include "hdf5.h"
+
+#ifdef H5_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
+
+#ifdef PIO_THREADS
+#include "pio_thread.h"
+#else
+#include <mpi.h>
+#endif  /* PIO_THREADS */
+
+#ifndef MPI_FILE_NULL           /*MPIO may be defined in mpi.h already       */
+#   include <mpio.h>
+#endif  /* !MPI_FILE_NULL */
+
+#include "pio_perf.h"
+
+#ifndef MIN
+#   define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif  /* !MIN */
+
+#ifndef MAX
+#   define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif  /* !MAX */
+
+/* Largest single POSIX call, larger accesses are issued in pieces */
+#define REPLAY_PIECE        ((size_t)1 << 30)
+
+/* Buffer used to fill the files read by the trace before the replay */
+#define REPLAY_FILL_SIZE    ((size_t)4 * 1024 * 1024)
+
+/* Access sizes of the Darshan histogram bins, the last bin is open */
+static const double replay_bin_lo[REPLAY_NBINS] = {
+    0, 100, 1024, 10240, 102400, 1048576, 4194304, 10485760, 104857600,
+    1073741824.0
+};
+static const double replay_bin_hi[REPLAY_NBINS] = {
+    100, 1024, 10240, 102400, 1048576, 4194304, 10485760, 104857600,
+    1073741824.0, 2147483648.0
+};
+
+/* Counters taken from the trace, by name without the CP_ and POSIX_ prefixes */
+typedef struct replay_counter_ {
+    const char *name;
+    size_t      offset;         /* Offset of the field in replay_record */
+    int         timestamp;      /* Field is a double, not a long long   */
+} replay_counter;
+
+#define REPLAY_COUNTER(n, f)    { n, offsetof(replay_record, f), 0 }
+#define REPLAY_BIN(n, f, i)     { n, offsetof(replay_record, f) + (i) * sizeof(long long), 0 }
+#define REPLAY_TIME(n, f)       { n, offsetof(replay_record, f), 1 }
+
+static const replay_counter replay_counters[] = {
+    REPLAY_COUNTER("READS", reads),
+    REPLAY_COUNTER("WRITES", writes),
+    REPLAY_COUNTER("BYTES_READ", bytes_read),
+    REPLAY_COUNTER("BYTES_WRITTEN", bytes_written),
+    REPLAY_COUNTER("MAX_BYTE_READ", max_byte_read),
+    REPLAY_COUNTER("MAX_BYTE_WRITTEN", max_byte_written),
+    REPLAY_COUNTER("CONSEC_READS", consec_reads),
+    REPLAY_COUNTER("CONSEC_WRITES", consec_writes),
+    REPLAY_COUNTER("SEQ_READS", seq_reads),
+    REPLAY_COUNTER("SEQ_WRITES", seq_writes),
+    REPLAY_BIN("SIZE_READ_0_100", size_read, 0),
+    REPLAY_BIN("SIZE_READ_100_1K", size_read, 1),
+    REPLAY_BIN("SIZE_READ_1K_10K", size_read, 2),
+    REPLAY_BIN("SIZE_READ_10K_100K", size_read, 3),
+    REPLAY_BIN("SIZE_READ_100K_1M", size_read, 4),
+    REPLAY_BIN("SIZE_READ_1M_4M", size_read, 5),
+    REPLAY_BIN("SIZE_READ_4M_10M", size_read, 6),
+    REPLAY_BIN("SIZE_READ_10M_100M", size_read, 7),
+    REPLAY_BIN("SIZE_READ_100M_1G", size_read, 8),
+    REPLAY_BIN("SIZE_READ_1G_PLUS", size_read, 9),
+    REPLAY_BIN("SIZE_WRITE_0_100", size_write, 0),
+    REPLAY_BIN("SIZE_WRITE_100_1K", size_write, 1),
+    REPLAY_BIN("SIZE_WRITE_1K_10K", size_write, 2),
+    REPLAY_BIN("SIZE_WRITE_10K_100K", size_write, 3),
+    REPLAY_BIN("SIZE_WRITE_100K_1M", size_write, 4),
+    REPLAY_BIN("SIZE_WRITE_1M_4M", size_write, 5),
+    REPLAY_BIN("SIZE_WRITE_4M_10M", size_write, 6),
+    REPLAY_BIN("SIZE_WRITE_10M_100M", size_write, 7),
+    REPLAY_BIN("SIZE_WRITE_100M_1G", size_write, 8),
+    REPLAY_BIN("SIZE_WRITE_1G_PLUS", size_write, 9),
+    REPLAY_TIME("F_READ_START_TIMESTAMP", read_start),
+    REPLAY_TIME("F_READ_END_TIMESTAMP", read_end),
+    REPLAY_TIME("F_WRITE_START_TIMESTAMP", write_start),
+    REPLAY_TIME("F_WRITE_END_TIMESTAMP", write_end),
+    { NULL, 0, 0 }
+};
+
+/* local functions */
+static replay_record *replay_record_get(replay_trace *trace, const char *id,
+    int rank, int mpiio);
+static void replay_set_counter(replay_record *rec, const char *name,
+    const char *value);
+static herr_t replay_add_op(replay_record *rec, replay_op *op);
+static long replay_synthesize(const replay_trace *trace, int rank, int nprocs,
+    replay_op **ops_out);
+static long replay_counter_ops(const replay_trace *trace, int f, int write,
+    int rank, int nprocs, replay_op **ops, long nops, long *max_ops);
+static double replay_random(unsigned long *state);
+static int replay_op_cmp(const void *a, const void *b);
+static void replay_wait(double until);
+
+/*
+ * Function:    replay_parse
+ * Purpose:     Parse the output of darshan-parser (format 2 or 3, per rank
+ *              or --total) or darshan-dxt-parser into TRACE.  TEXT is
+ *              modified.  Counters of other modules than POSIX are
+ *              ignored; MPI-IO DXT accesses are used only if the trace has
+ *              no POSIX ones, since the former are also seen as the latter.
+ * Return:      SUCCESS if the trace has any POSIX activity, FAIL otherwise
+ * Modifications:
+ */
+herr_t
+replay_parse(char *text, replay_trace *trace)
+{
+    char       *line, *next;
+    char        dxt_id[32] = "dxt";
+    int         have_posix_ops = 0;
+    int         f, g;
+
+    HDmemset(trace, 0, sizeof(*trace));
+
+    for (line = text; line && *line; line = next) {
+        char   *tok[8];
+        int     ntok = 0;
+        char   *p, *save;
+
+        if ((next = HDstrchr(line, '\n')) != NULL)
+            *next++ = '\0';
+
+        if (*line == '#') {
+            int     n;
+            double  t;
+
+            if (sscanf(line, "# nprocs: %d", &n) == 1)
+                trace->nprocs = n;
+            else if (sscanf(line, "# run time: %lf", &t) == 1)
+                trace->run_time = t;
+            else if (!HDstrncmp(line, "# DXT, file_id:", 15) &&
+                     sscanf(line + 15, " %31[^, ]", dxt_id) != 1)
+                HDstrcpy(dxt_id, "dxt");
+            continue;
+        }
+
+        /* darshan-parser --total: "total_CP_NAME: value" */
+        if (!HDstrncmp(line, "total_", 6) && (p = HDstrchr(line, ':')) != NULL) {
+            *p = '\0';
+            replay_set_counter(replay_record_get(trace, "total", -1, 0),
+                line + 6, p + 1);
+            continue;
+        }
+
+        for (p = strtok_r(line, " \t\r", &save); p && ntok < 8;
+                p = strtok_r(NULL, " \t\r", &save))
+            tok[ntok++] = p;
+
+        if (ntok >= 8 && (!HDstrcmp(tok[0], "X_POSIX") || !HDstrcmp(tok[0], "X_MPIIO"))) {
+            /* DXT: module rank op segment offset length start end */
+            replay_record  *rec;
+            replay_op       op;
+            int             mpiio = tok[0][2] == 'M';
+
+            op.write = !HDstrcmp(tok[2], "write");
+            if (!op.write && HDstrcmp(tok[2], "read"))
+                continue;
+            op.offset = (off_t)strtoll(tok[4], NULL, 10);
+            op.length = (size_t)strtoll(tok[5], NULL, 10);
+            op.start = strtod(tok[6], NULL);
+            if ((rec = replay_record_get(trace, dxt_id, atoi(tok[1]), mpiio)) == NULL ||
+                    replay_add_op(rec, &op) < 0)
+                return FAIL;
+            have_posix_ops |= !mpiio;
+        } else if (ntok >= 5 && !HDstrcmp(tok[0], "POSIX")) {
+            /* Format 3: module rank record-id counter value file ... */
+            replay_set_counter(replay_record_get(trace, tok[2], atoi(tok[1]), 0),
+                tok[3], tok[4]);
+        } else if (ntok >= 4 && !HDstrncmp(tok[2], "CP_", 3)) {
+            /* Format 2: rank record-id counter value file ... */
+            replay_set_counter(replay_record_get(trace, tok[1], atoi(tok[0]), 0),
+                tok[2], tok[3]);
+        }
+    }
+
+    /* Drop the MPI-IO accesses traced below as POSIX ones, and empty records */
+    for (f = g = 0; f < trace->nrecords; f++) {
+        replay_record *rec = &trace->records[f];
+
+        if ((rec->mpiio && have_posix_ops) ||
+                (rec->nops == 0 && rec->reads <= 0 && rec->writes <= 0)) {
+            HDfree(rec->ops);
+            continue;
+        }
+        trace->records[g++] = *rec;
+    }
+    trace->nrecords = g;
+
+    /* Records of the same file id, from different ranks, share a file */
+    for (f = 0; f < trace->nrecords; f++) {
+        for (g = 0; g < f; g++)
+            if (!HDstrcmp(trace->records[g].id, trace->records[f].id))
+                break;
+        trace->records[f].file = g < f ? trace->records[g].file : trace->nfiles++;
+    }
+
+    /* The time of the first and last access */
+    trace->first = trace->last = -1;
+    for (f = 0; f < trace->nrecords; f++) {
+        replay_record  *rec = &trace->records[f];
+        double          t[4];
+        int             i, n = 0;
+        long            k;
+
+        for (k = 0; k < rec->nops; k++) {
+            if (trace->first < 0 || rec->ops[k].start < trace->first)
+                trace->first = rec->ops[k].start;
+            trace->last = MAX(trace->last, rec->ops[k].start);
+        }
+
+        if (rec->reads > 0 && rec->read_start > 0) {
+            t[n++] = rec->read_start;
+            t[n++] = MAX(rec->read_end, rec->read_start);
+        }
+        if (rec->writes > 0 && rec->write_start > 0) {
+            t[n++] = rec->write_start;
+            t[n++] = MAX(rec->write_end, rec->write_start);
+        }
+        for (i = 0; i < n; i += 2) {
+            if (trace->first < 0 || t[i] < trace->first)
+                trace->first = t[i];
+            trace->last = MAX(trace->last, t[i + 1]);
+        }
+    }
+    if (trace->first < 0)
+        trace->first = trace->last = 0;
+
+    return trace->nrecords > 0 ? SUCCESS : FAIL;
+}
+
+/*
+ * Function:    replay_free
+ * Purpose:     Release the memory of a trace read by replay_parse.
+ * Return:      void
+ * Modifications:
+ */
+void
+replay_free(replay_trace *trace)
+{
+    int f;
+
+    for (f = 0; f < trace->nrecords; f++)
+        HDfree(trace->records[f].ops);
+    HDfree(trace->records);
+    HDmemset(trace, 0, sizeof(*trace));
+}
+
+/*
+ * Function:    replay_record_get
+ * Purpose:     Find the record of file ID as seen by RANK, adding it to
+ *              TRACE if it is new.
+ * Return:      The record, or NULL if out of memory
+ * Modifications:
+ */
+static replay_record *
+replay_record_get(replay_trace *trace, const char *id, int rank, int mpiio)
+{
+    replay_record  *rec;
+    int             f;
+
+    for (f = trace->nrecords - 1; f >= 0; f--) {
+        rec = &trace->records[f];
+        if (rec->rank == rank && rec->mpiio == mpiio && !HDstrcmp(rec->id, id))
+            return rec;
+    }
+
+    if (trace->nrecords == trace->max_records) {
+        int n = trace->max_records ? 2 * trace->max_records : 16;
+
+        if ((rec = (replay_record *)realloc(trace->records, n * sizeof(*rec))) == NULL) {
+            fprintf(stderr, "h5perf: out of memory for the trace records\n");
+            return NULL;
+        }
+        trace->records = rec;
+        trace->max_records = n;
+    }
+
+    rec = &trace->records[trace->nrecords++];
+    HDmemset(rec, 0, sizeof(*rec));
+    HDstrncpy(rec->id, id, sizeof(rec->id) - 1);
+    rec->rank = rank;
+    rec->mpiio = mpiio;
+    return rec;
+}
+
+/*
+ * Function:    replay_set_counter
+ * Purpose:     Store counter NAME of a darshan-parser line in REC, if it
+ *              is one the replay uses.
+ * Return:      void
+ * Modifications:
+ */
+static void
+replay_set_counter(replay_record *rec, const char *name, const char *value)
+{
+    const replay_counter *c;
+
+    if (rec == NULL)
+        return;
+    if (!HDstrncmp(name, "CP_", 3))
+        name += 3;
+    if (!HDstrncmp(name, "POSIX_", 6))
+        name += 6;
+
+    for (c = replay_counters; c->name; c++)
+        if (!HDstrcmp(c->name, name)) {
+            char *field = (char *)rec + c->offset;
+
+            if (c->timestamp)
+                *(double *)field = strtod(value, NULL);
+            else
+                *(long long *)field = strtoll(value, NULL, 10);
+            return;
+        }
+}
+
+/*
+ * Function:    replay_add_op
+ * Purpose:     Append a traced access to REC.
+ * Return:      SUCCESS or FAIL if out of memory
+ * Modifications:
+ */
+static herr_t
+replay_add_op(replay_record *rec, replay_op *op)
+{
+    if (rec->nops == rec->max_ops) {
+        long        n = rec->max_ops ? 2 * rec->max_ops : 256;
+        replay_op  *ops;
+
+        if ((ops = (replay_op *)realloc(rec->ops, n * sizeof(*ops))) == NULL) {
+            fprintf(stderr, "h5perf: out of memory for the traced accesses\n");
+            return FAIL;
+        }
+        rec->ops = ops;
+        rec->max_ops = n;
+    }
+    rec->ops[rec->nops++] = *op;
+    return SUCCESS;
+}
+
+/*
+ * Function:    replay_synthesize
+ * Purpose:     Build the accesses process RANK of NPROCS replays, sorted
+ *              by start time.  Processes of the traced job are folded onto
+ *              the replaying ones modulo NPROCS; the counters of a shared
+ *              (--total or rank -1) record are split evenly, each process
+ *              taking its own part of the file.
+ * Return:      Number of accesses, or -1 if out of memory
+ * Modifications:
+ */
+static long
+replay_synthesize(const replay_trace *trace, int rank, int nprocs,
+    replay_op **ops_out)
+{
+    replay_op  *ops = NULL;
+    long        nops = 0, max_ops = 0;
+    int         f;
+
+    for (f = 0; f < trace->nrecords; f++) {
+        const replay_record *rec = &trace->records[f];
+        long    k;
+
+        if (rec->nops > 0) {
+            if (rec->rank >= 0 && rec->rank % nprocs != rank)
+                continue;
+            for (k = 0; k < rec->nops; k++) {
+                if (nops == max_ops) {
+                    replay_op *p;
+
+                    max_ops = max_ops ? 2 * max_ops : 256;
+                    if ((p = (replay_op *)realloc(ops, max_ops * sizeof(*p))) == NULL)
+                        goto oom;
+                    ops = p;
+                }
+                ops[nops] = rec->ops[k];
+                ops[nops].file = rec->file;
+                ops[nops].start -= trace->first;
+                ops[nops].seq = nops;
+                nops++;
+            }
+            continue;
+        }
+
+        if ((nops = replay_counter_ops(trace, f, 1, rank, nprocs, &ops, nops, &max_ops)) < 0 ||
+                (nops = replay_counter_ops(trace, f, 0, rank, nprocs, &ops, nops, &max_ops)) < 0)
+            goto oom;
+    }
+
+    if (nops > 1)
+        qsort(ops, (size_t)nops, sizeof(*ops), replay_op_cmp);
+    *ops_out = ops;
+    return nops;
+
+oom:
+    fprintf(stderr, "h5perf: out of memory for the replayed accesses\n");
+    HDfree(ops);
+    *ops_out = NULL;
+    return -1;
+}
+
+/*
+ * Function:    replay_counter_ops
+ * Purpose:     Append to OPS the writes (WRITE nonzero) or reads that
+ *              process RANK issues for counter record F.  Each access
+ *              takes a size from the histogram bins in proportion to their
+ *              counts, scaled so the byte count matches the trace.  It
+ *              follows the previous access with the traced odds of being
+ *              consecutive or sequential, and otherwise seeks backwards.
+ *              The accesses are spread evenly between the first and last
+ *              traced access times.
+ * Return:      New number of accesses in OPS, or -1 if out of memory
+ * Modifications:
+ */
+static long
+replay_counter_ops(const replay_trace *trace, int f, int write, int rank,
+    int nprocs, replay_op **ops, long nops, long *max_ops)
+{
+    const replay_record *rec = &trace->records[f];
+    long long   count = write ? rec->writes : rec->reads;
+    long long   bytes = write ? rec->bytes_written : rec->bytes_read;
+    long long   max_byte = write ? rec->max_byte_written : rec->max_byte_read;
+    long long   consec = write ? rec->consec_writes : rec->consec_reads;
+    long long   seq = write ? rec->seq_writes : rec->seq_reads;
+    const long long *bins = write ? rec->size_write : rec->size_read;
+    double      t_start = write ? rec->write_start : rec->read_start;
+    double      t_end = write ? rec->write_end : rec->read_end;
+    double      size[REPLAY_NBINS], used[REPLAY_NBINS];
+    double      rep_bytes = 0, scale;
+    long long   nbins = 0, my_count, extent, base, pos, k;
+    unsigned long state;
+    int         i;
+
+    if (count <= 0 || bytes < 0)
+        return nops;
+
+    /* This process's share of the accesses and of the file */
+    extent = MAX(max_byte + 1, bytes);
+    if (rec->rank < 0) {
+        my_count = count / nprocs + (rank < count % nprocs);
+        extent = (extent + nprocs - 1) / nprocs;
+        base = rank * extent;
+    } else {
+        if (rec->rank % nprocs != rank)
+            return nops;
+        my_count = count;
+        base = 0;
+    }
+    if (my_count == 0)
+        return nops;
+
+    /* Access size of each bin, scaled to match the traced bytes */
+    for (i = 0; i < REPLAY_NBINS; i++) {
+        size[i] = (replay_bin_lo[i] + replay_bin_hi[i]) / 2;
+        rep_bytes += size[i] * (double)bins[i];
+        nbins += bins[i];
+        used[i] = 0;
+    }
+    if (nbins > 0) {
+        scale = bytes / rep_bytes;
+        for (i = 0; i < REPLAY_NBINS; i++) {
+            size[i] *= scale;
+            size[i] = MAX(size[i], MAX(replay_bin_lo[i], 1));
+            size[i] = MIN(size[i], replay_bin_hi[i] - 1);
+        }
+    }
+
+    state = (unsigned long)(f * 7919 + rank * 31 + write + 1);
+    pos = base;
+    for (k = 0; k < my_count; k++) {
+        replay_op   op;
+        double      u;
+
+        /* The bin furthest behind its share of the accesses so far */
+        if (nbins > 0) {
+            double  worst = 0;
+            int     b = -1;
+
+            for (i = 0; i < REPLAY_NBINS; i++) {
+                double  due;
+
+                if (bins[i] == 0)
+                    continue;
+                due = (double)(k + 1) * bins[i] / nbins - used[i];
+                if (b < 0 || due > worst) {
+                    worst = due;
+                    b = i;
+                }
+            }
+            used[b]++;
+            op.length = (size_t)size[b];
+        } else
+            op.length = (size_t)MAX(bytes / count, 1);
+
+        u = replay_random(&state);
+        if (k == 0 || u < (double)consec / count)
+            op.offset = (off_t)pos;
+        else if (u < (double)seq / count)
+            op.offset = (off_t)(pos + op.length);
+        else
+            op.offset = (off_t)(base + (long long)(replay_random(&state) * (pos - base)));
+        if (op.offset + (long long)op.length > base + extent &&
+                (long long)op.length <= extent)
+            op.offset = (off_t)base;
+        pos = op.offset + op.length;
+
+        op.write = write;
+        op.file = rec->file;
+        if (t_start > 0)
+            op.start = t_start - trace->first +
+                (MAX(t_end, t_start) - t_start) * k / my_count;
+        else
+            op.start = -1;
+
+        if (nops == *max_ops) {
+            replay_op *p;
+
+            *max_ops = *max_ops ? 2 * *max_ops : 256;
+            if ((p = (replay_op *)realloc(*ops, *max_ops * sizeof(*p))) == NULL)
+                return -1;
+            *ops = p;
+        }
+        op.seq = nops;
+        (*ops)[nops++] = op;
+    }
+
+    return nops;
+}
+
+/*
+ * Function:    replay_random
+ * Purpose:     Deterministic pseudo-random numbers, so that every run of a
+ *              trace issues the same accesses.
+ * Return:      A number in [0, 1)
+ * Modifications:
+ */
+static double
+replay_random(unsigned long *state)
+{
+    *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+    return (double)((*state >> 11) & 0xfffffffffffffUL) / 4503599627370496.0;
+}
+
+/*
+ * Function:    replay_op_cmp
+ * Purpose:     qsort comparator ordering accesses by start time, keeping
+ *              the trace order of accesses with the same time.
+ * Return:      <0, 0 or >0
+ * Modifications:
+ */
+static int
+replay_op_cmp(const void *a, const void *b)
+{
+    const replay_op *x = (const replay_op *)a, *y = (const replay_op *)b;
+    double  tx = MAX(x->start, 0), ty = MAX(y->start, 0);
+
+    if (tx != ty)
+        return tx < ty ? -1 : 1;
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+/*
+ * Function:    replay_wait
+ * Purpose:     Wait until MPI_Wtime() reaches UNTIL, sleeping for most of
+ *              the time and spinning for the last bit.
+ * Return:      void
+ * Modifications:
+ */
+static void
+replay_wait(double until)
+{
+    double  left;
+
+    while ((left = until - MPI_Wtime()) > 0) {
+        if (left > 0.002) {
+            struct timespec ts;
+
+            left = (left - 0.001) / 2;
+            ts.tv_sec = (time_t)left;
+            ts.tv_nsec = (long)((left - ts.tv_sec) * 1e9);
+            nanosleep(&ts, NULL);
+        }
+    }
+}
+
+/*
+ * Function:    do_replay
+ * Purpose:     Replay TRACE on the processes of pio_comm_g through IOT,
+ *              which is POSIXIO or MPIO.  Each traced file id gets its own
+ *              file, the parts of it the trace reads are filled before the
+ *              clock starts.  With TIMED nonzero every access waits for its
+ *              traced start time, otherwise they are issued back to back.
+ *              MPI-IO accesses are independent.
+ * Return:      The results of this process, ret_code FAIL on error
+ * Modifications:
+ */
+replay_results
+do_replay(const replay_trace *trace, iotype iot, int timed)
+{
+    replay_results  res;
+    replay_op      *ops = NULL;
+    long            nops, k;
+    int             nfiles = trace->nfiles;
+    int            *fds = NULL;
+    MPI_File       *fhs = NULL;
+    long long      *read_end = NULL, *fill_end = NULL;
+    char          (*fnames)[FILENAME_MAX] = NULL;
+    char           *buffer = NULL;
+    size_t          buf_size = REPLAY_FILL_SIZE;
+    double          t0, t;
+    int             f, mrc, failed = 0;
+
+    HDmemset(&res, 0, sizeof(res));
+
+    nops = replay_synthesize(trace, pio_mpi_rank_g, pio_mpi_nprocs_g, &ops);
+    fds = (int *)calloc((size_t)nfiles, sizeof(int));
+    fhs = (MPI_File *)calloc((size_t)nfiles, sizeof(MPI_File));
+    read_end = (long long *)calloc((size_t)nfiles, sizeof(long long));
+    fill_end = (long long *)calloc((size_t)nfiles, sizeof(long long));
+    fnames = (char (*)[FILENAME_MAX])calloc((size_t)nfiles, FILENAME_MAX);
+    for (k = 0; k < nops; k++)
+        buf_size = MAX(buf_size, MIN(ops[k].length, REPLAY_PIECE));
+    buffer = (char *)malloc(buf_size);
+    failed = nops < 0 || !fds || !fhs || !read_end || !fill_end || !fnames || !buffer;
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, pio_comm_g);
+    if (failed) {
+        if (pio_mpi_rank_g == 0)
+            fprintf(stderr, "h5perf: out of memory for the replay\n");
+        res.ret_code = FAIL;
+        goto done;
+    }
+    HDmemset(buffer, 'r', buf_size);
+
+    /* Every process must see the whole of what any of them reads */
+    for (k = 0; k < nops; k++)
+        if (!ops[k].write)
+            read_end[ops[k].file] = MAX(read_end[ops[k].file],
+                (long long)(ops[k].offset + ops[k].length));
+    MPI_Allreduce(read_end, fill_end, nfiles, MPI_LONG_LONG, MPI_MAX, pio_comm_g);
+
+    /* Create the files */
+    for (f = 0; f < nfiles; f++) {
+        char    base_name[32];
+
+        sprintf(base_name, "#pio_replay_%d", f);
+        pio_create_filename(iot, base_name, fnames[f], FILENAME_MAX);
+        if (iot == POSIXIO) {
+            if (pio_mpi_rank_g == 0)
+                fds[f] = HDopen(fnames[f], O_CREAT|O_TRUNC|O_RDWR, 0600);
+            MPI_Barrier(pio_comm_g);
+            if (pio_mpi_rank_g != 0)
+                fds[f] = HDopen(fnames[f], O_RDWR, 0600);
+            if (fds[f] < 0) {
+                fprintf(stderr, "POSIX File Open failed(%s)\n", fnames[f]);
+                failed = 1;
+            }
+        } else {
+            fhs[f] = MPI_FILE_NULL;
+            mrc = MPI_File_open(pio_comm_g, fnames[f], MPI_MODE_CREATE | MPI_MODE_RDWR,
+                    h5_io_info_g, &fhs[f]);
+            if (mrc == MPI_SUCCESS)
+                mrc = MPI_File_set_size(fhs[f], (MPI_Offset)0);
+            if (mrc != MPI_SUCCESS) {
+                fprintf(stderr, "MPI File Open failed(%s)\n", fnames[f]);
+                failed = 1;
+            }
+        }
+    }
+
+    /* Fill what will be read, each process writing its share */
+    for (f = 0; f < nfiles && !failed; f++) {
+        long long   part = (fill_end[f] + pio_mpi_nprocs_g - 1) / pio_mpi_nprocs_g;
+        long long   off = part * pio_mpi_rank_g;
+        long long   end = MIN(off + part, fill_end[f]);
+
+        for (; off < end && !failed; off += REPLAY_FILL_SIZE) {
+            size_t  n = (size_t)MIN((long long)REPLAY_FILL_SIZE, end - off);
+
+            if (iot == POSIXIO)
+                failed = HDlseek(fds[f], (off_t)off, SEEK_SET) < 0 ||
+                    HDwrite(fds[f], buffer, n) != (ssize_t)n;
+            else {
+                MPI_Status  status;
+
+                failed = pio_file_write_at(fhs[f], (MPI_Offset)off, buffer, n, 0,
+                    &status) != MPI_SUCCESS;
+            }
+        }
+    }
+    if (failed)
+        fprintf(stderr, "Proc %d: failed to prepare the replayed files\n",
+            pio_mpi_rank_g);
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, pio_comm_g);
+    if (failed) {
+        res.ret_code = FAIL;
+        goto close;
+    }
+
+    /* The replay */
+    MPI_Barrier(pio_comm_g);
+    t0 = MPI_Wtime();
+    for (k = 0; k < nops && !failed; k++) {
+        replay_op  *op = &ops[k];
+        size_t      done;
+
+        if (timed && op->start >= 0) {
+            double  lag = MPI_Wtime() - (t0 + op->start);
+
+            if (lag < 0)
+                replay_wait(t0 + op->start);
+            else {
+                res.max_lag = MAX(res.max_lag, lag);
+                res.sum_lag += lag;
+            }
+        }
+
+        t = MPI_Wtime();
+        for (done = 0; done < op->length && !failed; ) {
+            size_t  n = MIN(op->length - done, buf_size);
+            off_t   off = op->offset + (off_t)done;
+            ssize_t rc;
+
+            if (iot == POSIXIO) {
+                if (HDlseek(fds[op->file], off, SEEK_SET) < 0)
+                    rc = -1;
+                else if (op->write)
+                    rc = HDwrite(fds[op->file], buffer, n);
+                else
+                    rc = HDread(fds[op->file], buffer, n);
+                if (rc < 0) {
+                    fprintf(stderr, "POSIX %s failed at %ld\n",
+                        op->write ? "write" : "read", (long)off);
+                    failed = 1;
+                } else if (rc == 0)
+                    break;          /* Read past the end */
+                else
+                    done += (size_t)rc;
+            } else {
+                MPI_Status  status;
+                int         count;
+
+                if (op->write)
+                    mrc = pio_file_write_at(fhs[op->file], (MPI_Offset)off,
+                        buffer, n, 0, &status);
+                else
+                    mrc = pio_file_read_at(fhs[op->file], (MPI_Offset)off,
+                        buffer, n, 0, &status);
+                if (mrc != MPI_SUCCESS ||
+                        MPI_Get_count(&status, MPI_BYTE, &count) != MPI_SUCCESS) {
+                    fprintf(stderr, "MPI File %s failed at %ld\n",
+                        op->write ? "write" : "read", (long)off);
+                    failed = 1;
+                } else if (count == 0)
+                    break;          /* Nothing moved, past the end */
+                else if (count == MPI_UNDEFINED)
+                    done += n;      /* More than an int of bytes moved */
+                else
+                    done += (size_t)count;
+            }
+        }
+
+        if (op->write) {
+            res.write_time += MPI_Wtime() - t;
+            res.bytes_written += done;
+            res.writes++;
+        } else {
+            res.read_time += MPI_Wtime() - t;
+            res.bytes_read += done;
+            res.reads++;
+        }
+    }
+    res.elapsed = MPI_Wtime() - t0;
+    if (failed)
+        res.ret_code = FAIL;
+
+close:
+    for (f = 0; f < nfiles; f++) {
+        if (iot == POSIXIO) {
+            if (fds[f] >= 0)
+                HDclose(fds[f]);
+        } else if (fhs[f] != MPI_FILE_NULL)
+            MPI_File_close(&fhs[f]);
+    }
+    MPI_Barrier(pio_comm_g);
+    for (f = 0; f < nfiles; f++)
+        do_cleanupfile(iot, fnames[f]);
+
+done:
+    HDfree(ops);
+    HDfree(fds);
+    HDfree(fhs);
+    HDfree(read_end);
+    HDfree(fill_end);
+    HDfree(fnames);
+    HDfree(buffer);
+    return res;
+}
+
+#endif /* H5_HAVE_PARALLEL */
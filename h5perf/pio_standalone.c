@@ -28,15 +28,15 @@
 int   nCols = 80;
 
 /* ``get_option'' variables */
-int         opt_err = 1;    /*get_option prints errors if this is on */
-int         opt_ind = 1;    /*token pointer                          */
-const char *opt_arg;        /*flag argument (or value)               */
+PIO_TLS int         opt_err = 1;    /*get_option prints errors if this is on */
+PIO_TLS int         opt_ind = 1;    /*token pointer                          */
+PIO_TLS const char *opt_arg;        /*flag argument (or value)               */
 
 
 int
 get_option(int argc, const char **argv, const char *opts, const struct long_options *l_opts)
 {
-    static int sp = 1;    /* character index in current token */
+    static PIO_TLS int sp = 1;    /* character index in current token */
     int opt_opt = '?';    /* option character passed back to user */
 
     if (sp == 1) {
@@ -169,8 +169,8 @@ print_version(const char *progname)
 
 /** From h5test.c **/
 
-#ifdef H5_HAVE_PARALLEL
-MPI_Info    h5_io_info_g=MPI_INFO_NULL;/* MPI INFO object for IO */
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
+PIO_TLS MPI_Info h5_io_info_g=MPI_INFO_NULL;/* MPI INFO object for IO */
 #endif
 
 int
@@ -264,7 +264,9 @@ h5_dump_info_object(MPI_Info info)
     int  	flag;
     int		i, nkeys;
 
-    printf("Dumping MPI Info Object(%d) (up to %d bytes per item):\n", (int)info,
+    /* MPI_Info is an int in some MPI libraries and a pointer in others,
+     * so the handle itself is not printed */
+    printf("Dumping MPI Info Object (up to %d bytes per item):\n",
 	MPI_MAX_INFO_VAL);
     if (info==MPI_INFO_NULL){
 	printf("object is MPI_INFO_NULL\n");
@@ -122,11 +122,11 @@ typedef off_t                   h5_stat_size_t;
 
 /** From h5test.h **/
 
-#ifdef H5_HAVE_PARALLEL
-extern MPI_Info h5_io_info_g;         /* MPI INFO object for IO */
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
+extern PIO_TLS MPI_Info h5_io_info_g; /* MPI INFO object for IO */
 #endif
 
-#ifdef H5_HAVE_PARALLEL
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
 H5TEST_DLL int h5_set_info_object(void);
 H5TEST_DLL void h5_dump_info_object(MPI_Info info);
 #endif
@@ -135,9 +135,9 @@ H5TEST_DLL void h5_dump_info_object(MPI_Info info);
 
 /** From h5tools_utils.h **/
 
-extern int         opt_err;     /* getoption prints errors if this is on    */
-extern int         opt_ind;     /* token pointer                            */
-extern const char *opt_arg;     /* flag argument (or value)                 */
+extern PIO_TLS int         opt_err; /* getoption prints errors if this is on */
+extern PIO_TLS int         opt_ind; /* token pointer                        */
+extern PIO_TLS const char *opt_arg; /* flag argument (or value)             */
 
 
 enum {
@@ -0,0 +1,776 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF5.  The full HDF5 copyright notice, including     *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the files COPYING and Copyright.html.  COPYING can be found at the root   *
+ * of the source code distribution tree; Copyright.html can be found at the  *
+ * root level of an installed copy of the electronic HDF5 document set and   *
+ * is linked from the top-level documents page.  It can also be found at     *
+ * http://hdfgroup.org/HDF5/doc/Copyright.html.  If you do not have          *
+ * access to either file, you may request a copy from help@hdfgroup.org.     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+ * Purpose:
+ *
+ * Runtime of the threaded build of h5perf (-DPIO_THREADS), for single
+ * node runs on machines without MPI.  main starts H5PERF_THREADS threads
+ * (default 1) that each run h5perf's own main as one process of
+ * MPI_COMM_WORLD.  The collectives are done in shared memory: every
+ * thread of a communicator puts up a pointer to its data, waits at the
+ * communicator's barrier, takes what it needs from the others and waits
+ * again before its data may change.  That is slow next to a real MPI, but
+ * h5perf only calls them between the timed transfers.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hdf5.h"
+
+#ifdef PIO_THREADS
+
+#include "pio_thread.h"
+
+/* Most keys an MPI_Info holds */
+#define PIO_MAX_INFO_KEYS   64
+
+/* The threads of one communicator */
+typedef struct pio_group_ {
+    int             size;           /* number of threads                */
+    int             refs;           /* threads still holding it         */
+    pthread_mutex_t lock;
+    pthread_cond_t  turn;           /* signaled when the barrier opens  */
+    int             waiting;        /* threads at the barrier           */
+    unsigned long   generation;     /* times the barrier opened         */
+    const void    **slots;          /* what each thread put up          */
+} pio_group;
+
+/* A communicator as one thread sees it */
+struct pio_comm_ {
+    pio_group      *group;
+    int             rank;
+};
+
+struct pio_info_ {
+    int             nkeys;
+    char           *keys[PIO_MAX_INFO_KEYS];
+    char           *vals[PIO_MAX_INFO_KEYS];
+};
+
+/* What main hands to a thread */
+typedef struct pio_rank_args_ {
+    int             rank;
+    int             argc;
+    char          **argv;
+    int             ret;            /* what pio_rank_main returned      */
+} pio_rank_args;
+
+/* Entry of one thread in an MPI_Comm_split */
+typedef struct pio_split_ {
+    int             color;
+    int             key;
+    int             rank;
+    pio_group      *group;          /* set by the first of its color    */
+} pio_split;
+
+static pio_group           *world_g;    /* all the threads              */
+static __thread struct pio_comm_ world_comm_g;
+
+/*
+ * Function:    group_new
+ * Purpose:     Make a communicator group of SIZE threads.
+ * Return:      The group, or NULL when out of memory
+ * Modifications:
+ */
+static pio_group *
+group_new(int size)
+{
+    pio_group *g = (pio_group *)calloc(1, sizeof(pio_group));
+
+    if (!g)
+        return NULL;
+
+    if ((g->slots = (const void **)calloc((size_t)size, sizeof(void *))) == NULL) {
+        free(g);
+        return NULL;
+    }
+
+    g->size = size;
+    g->refs = size;
+    pthread_mutex_init(&g->lock, NULL);
+    pthread_cond_init(&g->turn, NULL);
+    return g;
+}
+
+/*
+ * Function:    group_barrier
+ * Purpose:     Wait until all threads of G are here.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+group_barrier(pio_group *g)
+{
+    unsigned long generation;
+
+    pthread_mutex_lock(&g->lock);
+    generation = g->generation;
+
+    if (++g->waiting == g->size) {
+        g->waiting = 0;
+        g->generation++;
+        pthread_cond_broadcast(&g->turn);
+    }
+    else {
+        while (generation == g->generation)
+            pthread_cond_wait(&g->turn, &g->lock);
+    }
+
+    pthread_mutex_unlock(&g->lock);
+}
+
+/*
+ * Function:    group_post
+ * Purpose:     Put up DATA for the other threads of COMM and wait until
+ *              they all have.  DATA must not change before group_done.
+ * Return:      The slots of all threads
+ * Modifications:
+ */
+static const void **
+group_post(MPI_Comm comm, const void *data)
+{
+    comm->group->slots[comm->rank] = data;
+    group_barrier(comm->group);
+    return comm->group->slots;
+}
+
+/*
+ * Function:    group_done
+ * Purpose:     Wait until all threads of COMM are done with the data put
+ *              up by group_post.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+group_done(MPI_Comm comm)
+{
+    group_barrier(comm->group);
+}
+
+/*
+ * Function:    type_size
+ * Purpose:     Get the size of the predefined TYPE.
+ * Return:      Bytes
+ * Modifications:
+ */
+static size_t
+type_size(MPI_Datatype type)
+{
+    switch (type) {
+    case MPI_INT:
+        return sizeof(int);
+    case MPI_UNSIGNED:
+        return sizeof(unsigned);
+    case MPI_LONG:
+        return sizeof(long);
+    case MPI_LONG_LONG:
+        return sizeof(long long);
+    case MPI_DOUBLE:
+        return sizeof(double);
+    default:
+        return 1;
+    }
+}
+
+#define REDUCE(T)                                               \
+    do {                                                        \
+        T *a = (T *)acc;                                        \
+        const T *b = (const T *)in;                             \
+                                                                \
+        for (i = 0; i < count; i++) {                           \
+            if (op == MPI_SUM)                                  \
+                a[i] += b[i];                                   \
+            else if (op == MPI_MAX ? b[i] > a[i] : b[i] < a[i]) \
+                a[i] = b[i];                                    \
+        }                                                       \
+    } while (0)
+
+/*
+ * Function:    reduce
+ * Purpose:     Fold the COUNT values of TYPE in IN into ACC with OP.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+reduce(void *acc, const void *in, int count, MPI_Datatype type, MPI_Op op)
+{
+    int i;
+
+    /* a bitwise or is one of the bytes */
+    if (op == MPI_BOR) {
+        unsigned char *a = (unsigned char *)acc;
+        const unsigned char *b = (const unsigned char *)in;
+        size_t k, n = (size_t)count * type_size(type);
+
+        for (k = 0; k < n; k++)
+            a[k] |= b[k];
+        return;
+    }
+
+    switch (type) {
+    case MPI_INT:
+        REDUCE(int);
+        break;
+    case MPI_UNSIGNED:
+        REDUCE(unsigned);
+        break;
+    case MPI_LONG:
+        REDUCE(long);
+        break;
+    case MPI_LONG_LONG:
+        REDUCE(long long);
+        break;
+    case MPI_DOUBLE:
+        REDUCE(double);
+        break;
+    default:
+        REDUCE(unsigned char);
+        break;
+    }
+}
+
+/*
+ * Function:    rank_main
+ * Purpose:     Body of the thread of one process: run h5perf as it.
+ * Return:      NULL
+ * Modifications:
+ */
+static void *
+rank_main(void *arg)
+{
+    pio_rank_args *args = (pio_rank_args *)arg;
+
+    world_comm_g.group = world_g;
+    world_comm_g.rank = args->rank;
+    args->ret = pio_rank_main(args->argc, args->argv);
+    return NULL;
+}
+
+/*
+ * Function:    main
+ * Purpose:     Run h5perf in H5PERF_THREADS threads.
+ * Return:      EXIT_SUCCESS, or EXIT_FAILURE if any thread failed
+ * Modifications:
+ */
+int
+main(int argc, char **argv)
+{
+    const char *env = getenv("H5PERF_THREADS");
+    int nthreads = env ? atoi(env) : 1;
+    pio_rank_args *args;
+    pthread_t *threads;
+    int ret = EXIT_SUCCESS;
+    int r;
+
+    if (nthreads <= 0) {
+        fprintf(stderr, "h5perf: invalid H5PERF_THREADS %s\n", env);
+        return EXIT_FAILURE;
+    }
+
+    world_g = group_new(nthreads);
+    args = (pio_rank_args *)calloc((size_t)nthreads, sizeof(pio_rank_args));
+    threads = (pthread_t *)calloc((size_t)nthreads, sizeof(pthread_t));
+    if (!world_g || !args || !threads) {
+        fprintf(stderr, "h5perf: out of memory for %d threads\n", nthreads);
+        return EXIT_FAILURE;
+    }
+
+    for (r = 0; r < nthreads; r++) {
+        args[r].rank = r;
+        args[r].argc = argc;
+        args[r].argv = argv;
+
+        if (pthread_create(&threads[r], NULL, rank_main, &args[r]) != 0) {
+            fprintf(stderr, "h5perf: cannot start thread %d: %s\n", r,
+                    strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (r = 0; r < nthreads; r++) {
+        pthread_join(threads[r], NULL);
+        if (args[r].ret != EXIT_SUCCESS)
+            ret = EXIT_FAILURE;
+    }
+
+    free(threads);
+    free(args);
+    return ret;
+}
+
+MPI_Comm
+pio_comm_world(void)
+{
+    return &world_comm_g;
+}
+
+int
+MPI_Init(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Finalize(void)
+{
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Abort(MPI_Comm comm, int errorcode)
+{
+    (void)comm;
+    exit(errorcode);
+}
+
+double
+MPI_Wtime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int
+MPI_Comm_rank(MPI_Comm comm, int *rank)
+{
+    if (comm == MPI_COMM_NULL)
+        return MPI_ERR_COMM;
+    *rank = comm->rank;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Comm_size(MPI_Comm comm, int *size)
+{
+    if (comm == MPI_COMM_NULL)
+        return MPI_ERR_COMM;
+    *size = comm->group->size;
+    return MPI_SUCCESS;
+}
+
+/*
+ * Function:    MPI_Comm_split
+ * Purpose:     Split COMM by COLOR, ordering each part by KEY and then
+ *              by rank.  The first thread of a color makes its group and
+ *              the others pick it up from its entry.
+ * Return:      MPI_SUCCESS, or MPI_ERR_OTHER when out of memory
+ * Modifications:
+ */
+int
+MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm)
+{
+    pio_split me;
+    const pio_split *first = NULL;
+    const void **slots;
+    int size = comm->group->size;
+    int nmembers = 0, rank = 0, r;
+
+    me.color = color;
+    me.key = key;
+    me.rank = comm->rank;
+    me.group = NULL;
+
+    slots = group_post(comm, &me);
+
+    if (color != MPI_UNDEFINED) {
+        for (r = 0; r < size; r++) {
+            const pio_split *s = (const pio_split *)slots[r];
+
+            if (s->color != color)
+                continue;
+
+            nmembers++;
+            if (s->key < key || (s->key == key && s->rank < me.rank))
+                rank++;
+            if (!first || s->key < first->key ||
+                    (s->key == first->key && s->rank < first->rank))
+                first = s;
+        }
+
+        if (first == &me)
+            me.group = group_new(nmembers);
+    }
+
+    /* the groups are made */
+    group_barrier(comm->group);
+
+    *newcomm = MPI_COMM_NULL;
+    if (color != MPI_UNDEFINED && first->group) {
+        *newcomm = (MPI_Comm)malloc(sizeof(struct pio_comm_));
+        if (*newcomm) {
+            (*newcomm)->group = first->group;
+            (*newcomm)->rank = rank;
+        }
+    }
+
+    group_done(comm);
+
+    if (color != MPI_UNDEFINED && *newcomm == MPI_COMM_NULL)
+        return MPI_ERR_OTHER;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Comm_free(MPI_Comm *comm)
+{
+    pio_group *g;
+    int refs;
+
+    if (*comm == MPI_COMM_NULL || *comm == &world_comm_g)
+        return MPI_ERR_COMM;
+
+    g = (*comm)->group;
+    pthread_mutex_lock(&g->lock);
+    refs = --g->refs;
+    pthread_mutex_unlock(&g->lock);
+
+    if (refs == 0) {
+        pthread_mutex_destroy(&g->lock);
+        pthread_cond_destroy(&g->turn);
+        free(g->slots);
+        free(g);
+    }
+
+    free(*comm);
+    *comm = MPI_COMM_NULL;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Barrier(MPI_Comm comm)
+{
+    group_barrier(comm->group);
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm)
+{
+    const void **slots = group_post(comm, buf);
+
+    if (comm->rank != root)
+        memcpy(buf, slots[root], (size_t)count * type_size(type));
+    group_done(comm);
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+           void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+           MPI_Comm comm)
+{
+    const void **slots = group_post(comm, sendbuf);
+    size_t n = (size_t)recvcount * type_size(recvtype);
+    int r;
+
+    (void)sendcount;
+    (void)sendtype;
+
+    if (comm->rank == root)
+        for (r = 0; r < comm->group->size; r++)
+            memcpy((char *)recvbuf + (size_t)r * n, slots[r], n);
+    group_done(comm);
+    return MPI_SUCCESS;
+}
+
+/*
+ * Function:    MPI_Allreduce
+ * Purpose:     Every thread folds the values of all threads into a copy
+ *              of its own, so the inputs stay put until all are done.
+ * Return:      MPI_SUCCESS, or MPI_ERR_OTHER when out of memory
+ * Modifications:
+ */
+int
+MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+              MPI_Op op, MPI_Comm comm)
+{
+    size_t n = (size_t)count * type_size(type);
+    void *acc = malloc(n ? n : 1);
+    const void **slots;
+    int r;
+
+    if (sendbuf == MPI_IN_PLACE)
+        sendbuf = recvbuf;
+
+    slots = group_post(comm, sendbuf);
+    if (acc) {
+        memcpy(acc, slots[0], n);
+        for (r = 1; r < comm->group->size; r++)
+            reduce(acc, slots[r], count, type, op);
+    }
+    group_done(comm);
+
+    if (!acc)
+        return MPI_ERR_OTHER;
+
+    memcpy(recvbuf, acc, n);
+    free(acc);
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_create(MPI_Info *info)
+{
+    *info = (MPI_Info)calloc(1, sizeof(struct pio_info_));
+    return *info ? MPI_SUCCESS : MPI_ERR_OTHER;
+}
+
+int
+MPI_Info_dup(MPI_Info info, MPI_Info *newinfo)
+{
+    int k;
+
+    if (MPI_Info_create(newinfo) != MPI_SUCCESS)
+        return MPI_ERR_OTHER;
+    for (k = 0; k < info->nkeys; k++)
+        MPI_Info_set(*newinfo, info->keys[k], info->vals[k]);
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_free(MPI_Info *info)
+{
+    int k;
+
+    if (*info == MPI_INFO_NULL)
+        return MPI_ERR_OTHER;
+
+    for (k = 0; k < (*info)->nkeys; k++) {
+        free((*info)->keys[k]);
+        free((*info)->vals[k]);
+    }
+    free(*info);
+    *info = MPI_INFO_NULL;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_set(MPI_Info info, const char *key, const char *value)
+{
+    char *val = strdup(value);
+    int k;
+
+    if (!val)
+        return MPI_ERR_OTHER;
+
+    for (k = 0; k < info->nkeys; k++)
+        if (!strcmp(info->keys[k], key)) {
+            free(info->vals[k]);
+            info->vals[k] = val;
+            return MPI_SUCCESS;
+        }
+
+    if (info->nkeys == PIO_MAX_INFO_KEYS ||
+            (info->keys[info->nkeys] = strdup(key)) == NULL) {
+        free(val);
+        return MPI_ERR_OTHER;
+    }
+    info->vals[info->nkeys++] = val;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_get(MPI_Info info, const char *key, int valuelen, char *value, int *flag)
+{
+    int k;
+
+    *flag = 0;
+    if (info == MPI_INFO_NULL)
+        return MPI_SUCCESS;
+
+    for (k = 0; k < info->nkeys; k++)
+        if (!strcmp(info->keys[k], key)) {
+            strncpy(value, info->vals[k], (size_t)valuelen);
+            value[valuelen] = '\0';
+            *flag = 1;
+            break;
+        }
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_get_nkeys(MPI_Info info, int *nkeys)
+{
+    *nkeys = info == MPI_INFO_NULL ? 0 : info->nkeys;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Info_get_nthkey(MPI_Info info, int n, char *key)
+{
+    if (info == MPI_INFO_NULL || n < 0 || n >= info->nkeys)
+        return MPI_ERR_OTHER;
+    strncpy(key, info->keys[n], MPI_MAX_INFO_KEY);
+    key[MPI_MAX_INFO_KEY] = '\0';
+    return MPI_SUCCESS;
+}
+
+/* Derived types only describe MPI-IO transfers, which there are none of */
+int
+MPI_Type_contiguous(int count, MPI_Datatype oldtype, MPI_Datatype *newtype)
+{
+    (void)count;
+    (void)oldtype;
+    *newtype = MPI_DATATYPE_NULL;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Type_vector(int count, int blocklength, int stride, MPI_Datatype oldtype,
+                MPI_Datatype *newtype)
+{
+    (void)count;
+    (void)blocklength;
+    (void)stride;
+    (void)oldtype;
+    *newtype = MPI_DATATYPE_NULL;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Type_create_struct(int count, const int blocklengths[],
+                       const MPI_Aint displacements[], const MPI_Datatype types[],
+                       MPI_Datatype *newtype)
+{
+    (void)count;
+    (void)blocklengths;
+    (void)displacements;
+    (void)types;
+    *newtype = MPI_DATATYPE_NULL;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Type_commit(MPI_Datatype *type)
+{
+    (void)type;
+    return MPI_SUCCESS;
+}
+
+int
+MPI_Type_free(MPI_Datatype *type)
+{
+    *type = MPI_DATATYPE_NULL;
+    return MPI_SUCCESS;
+}
+
+/* No MPI-IO: parse_command_line turns --api=mpiio down */
+int
+MPI_File_open(MPI_Comm comm, const char *filename, int amode, MPI_Info info,
+              MPI_File *fh)
+{
+    (void)comm;
+    (void)filename;
+    (void)amode;
+    (void)info;
+    *fh = MPI_FILE_NULL;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_close(MPI_File *fh)
+{
+    *fh = MPI_FILE_NULL;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_delete(const char *filename, MPI_Info info)
+{
+    (void)info;
+    return remove(filename) == 0 ? MPI_SUCCESS : MPI_ERR_OTHER;
+}
+
+int
+MPI_File_set_size(MPI_File fh, MPI_Offset size)
+{
+    (void)fh;
+    (void)size;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_set_view(MPI_File fh, MPI_Offset disp, MPI_Datatype etype,
+                  MPI_Datatype filetype, const char *datarep, MPI_Info info)
+{
+    (void)fh;
+    (void)disp;
+    (void)etype;
+    (void)filetype;
+    (void)datarep;
+    (void)info;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_read_at(MPI_File fh, MPI_Offset offset, void *buf, int count,
+                 MPI_Datatype type, MPI_Status *status)
+{
+    (void)fh;
+    (void)offset;
+    (void)buf;
+    (void)count;
+    (void)type;
+    (void)status;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void *buf, int count,
+                     MPI_Datatype type, MPI_Status *status)
+{
+    return MPI_File_read_at(fh, offset, buf, count, type, status);
+}
+
+int
+MPI_File_write_at(MPI_File fh, MPI_Offset offset, const void *buf, int count,
+                  MPI_Datatype type, MPI_Status *status)
+{
+    (void)fh;
+    (void)offset;
+    (void)buf;
+    (void)count;
+    (void)type;
+    (void)status;
+    return MPI_ERR_OTHER;
+}
+
+int
+MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void *buf, int count,
+                      MPI_Datatype type, MPI_Status *status)
+{
+    return MPI_File_write_at(fh, offset, buf, count, type, status);
+}
+
+int
+MPI_Get_count(const MPI_Status *status, MPI_Datatype type, int *count)
+{
+    (void)status;
+    (void)type;
+    *count = 0;
+    return MPI_ERR_OTHER;
+}
+
+#endif /* PIO_THREADS */
@@ -0,0 +1,165 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Board of Trustees of the University of Illinois.         *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of HDF5.  The full HDF5 copyright notice, including     *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the files COPYING and Copyright.html.  COPYING can be found at the root   *
+ * of the source code distribution tree; Copyright.html can be found at the  *
+ * root level of an installed copy of the electronic HDF5 document set and   *
+ * is linked from the top-level documents page.  It can also be found at     *
+ * http://hdfgroup.org/HDF5/doc/Copyright.html.  If you do not have          *
+ * access to either file, you may request a copy from help@hdfgroup.org.     *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+ * The MPI of the threaded build (-DPIO_THREADS), included instead of
+ * mpi.h.  The processes are threads of one process and the MPI calls
+ * h5perf makes are done with a barrier and shared memory; see
+ * pio_thread.c.  There is no MPI-IO: the file calls fail, except for
+ * MPI_File_delete, and the derived types describe nothing.
+ */
+
+#ifndef PIO_THREAD_H__
+#define PIO_THREAD_H__
+
+#ifndef STANDALONE
+#error "the threaded build needs -DSTANDALONE"
+#endif  /* !STANDALONE */
+
+#ifdef H5_HAVE_PARALLEL
+#error "the threaded build needs a serial HDF5"
+#endif  /* H5_HAVE_PARALLEL */
+
+#ifndef H5_HAVE_THREADSAFE
+#error "the threaded build needs an HDF5 configured with --enable-threadsafe"
+#endif  /* !H5_HAVE_THREADSAFE */
+
+/* Globals that differ between processes are per thread */
+#define PIO_TLS     __thread
+
+typedef struct pio_comm_   *MPI_Comm;
+typedef struct pio_info_   *MPI_Info;
+typedef struct pio_file_   *MPI_File;   /* never opened */
+typedef int                 MPI_Datatype;
+typedef int                 MPI_Op;
+typedef long long           MPI_Offset;
+typedef long long           MPI_Count;
+typedef long                MPI_Aint;
+
+typedef struct MPI_Status {
+    int MPI_SOURCE;
+    int MPI_TAG;
+    int MPI_ERROR;
+} MPI_Status;
+
+#define MPI_SUCCESS         0
+#define MPI_ERR_COMM        5
+#define MPI_ERR_OTHER       15
+#define MPI_UNDEFINED       (-32766)
+
+#define MPI_COMM_NULL       ((MPI_Comm)0)
+#define MPI_COMM_WORLD      (pio_comm_world())
+#define MPI_INFO_NULL       ((MPI_Info)0)
+#define MPI_FILE_NULL       ((MPI_File)0)
+#define MPI_DATATYPE_NULL   0
+#define MPI_IN_PLACE        ((void *)1)
+
+#define MPI_MAX_INFO_KEY    255
+#define MPI_MAX_INFO_VAL    1024
+
+#define MPI_MODE_CREATE     1
+#define MPI_MODE_RDONLY     2
+#define MPI_MODE_WRONLY     4
+#define MPI_MODE_RDWR       8
+
+/* The types and reductions h5perf uses */
+enum {
+    MPI_BYTE = 1,
+    MPI_CHAR,
+    MPI_INT,
+    MPI_UNSIGNED,
+    MPI_LONG,
+    MPI_LONG_LONG,
+    MPI_DOUBLE
+};
+
+enum {
+    MPI_SUM = 1,
+    MPI_MAX,
+    MPI_MIN,
+    MPI_BOR
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+/* The main of each thread, h5perf's own main */
+extern int      pio_rank_main(int argc, char **argv);
+extern MPI_Comm pio_comm_world(void);
+
+extern int      MPI_Init(int *argc, char ***argv);
+extern int      MPI_Finalize(void);
+extern int      MPI_Abort(MPI_Comm comm, int errorcode);
+extern double   MPI_Wtime(void);
+
+extern int      MPI_Comm_rank(MPI_Comm comm, int *rank);
+extern int      MPI_Comm_size(MPI_Comm comm, int *size);
+extern int      MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm);
+extern int      MPI_Comm_free(MPI_Comm *comm);
+
+extern int      MPI_Barrier(MPI_Comm comm);
+extern int      MPI_Bcast(void *buf, int count, MPI_Datatype type, int root,
+                          MPI_Comm comm);
+extern int      MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                           void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                           int root, MPI_Comm comm);
+extern int      MPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
+                              MPI_Datatype type, MPI_Op op, MPI_Comm comm);
+
+extern int      MPI_Info_create(MPI_Info *info);
+extern int      MPI_Info_dup(MPI_Info info, MPI_Info *newinfo);
+extern int      MPI_Info_free(MPI_Info *info);
+extern int      MPI_Info_set(MPI_Info info, const char *key, const char *value);
+extern int      MPI_Info_get(MPI_Info info, const char *key, int valuelen,
+                             char *value, int *flag);
+extern int      MPI_Info_get_nkeys(MPI_Info info, int *nkeys);
+extern int      MPI_Info_get_nthkey(MPI_Info info, int n, char *key);
+
+extern int      MPI_Type_contiguous(int count, MPI_Datatype oldtype,
+                                    MPI_Datatype *newtype);
+extern int      MPI_Type_vector(int count, int blocklength, int stride,
+                                MPI_Datatype oldtype, MPI_Datatype *newtype);
+extern int      MPI_Type_create_struct(int count, const int blocklengths[],
+                                       const MPI_Aint displacements[],
+                                       const MPI_Datatype types[],
+                                       MPI_Datatype *newtype);
+extern int      MPI_Type_commit(MPI_Datatype *type);
+extern int      MPI_Type_free(MPI_Datatype *type);
+
+extern int      MPI_File_open(MPI_Comm comm, const char *filename, int amode,
+                              MPI_Info info, MPI_File *fh);
+extern int      MPI_File_close(MPI_File *fh);
+extern int      MPI_File_delete(const char *filename, MPI_Info info);
+extern int      MPI_File_set_size(MPI_File fh, MPI_Offset size);
+extern int      MPI_File_set_view(MPI_File fh, MPI_Offset disp, MPI_Datatype etype,
+                                  MPI_Datatype filetype, const char *datarep,
+                                  MPI_Info info);
+extern int      MPI_File_read_at(MPI_File fh, MPI_Offset offset, void *buf,
+                                 int count, MPI_Datatype type, MPI_Status *status);
+extern int      MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void *buf,
+                                     int count, MPI_Datatype type,
+                                     MPI_Status *status);
+extern int      MPI_File_write_at(MPI_File fh, MPI_Offset offset, const void *buf,
+                                  int count, MPI_Datatype type, MPI_Status *status);
+extern int      MPI_File_write_at_all(MPI_File fh, MPI_Offset offset,
+                                      const void *buf, int count, MPI_Datatype type,
+                                      MPI_Status *status);
+extern int      MPI_Get_count(const MPI_Status *status, MPI_Datatype type,
+                              int *count);
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif  /* PIO_THREAD_H__ */
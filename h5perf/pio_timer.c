@@ -17,6 +17,9 @@
  * Purpose:
  *
  * This is a module of useful timing functions for performance testing.
+ * On Linux the timers can also sample hardware and software event
+ * counters of the calling process with perf_event_open(2), and the open
+ * to close timers can sample the bandwidth of the transfers they time.
  */
 
 #include <stdio.h>
@@ -24,9 +27,29 @@
 
 #include "hdf5.h"
 
-#ifdef H5_HAVE_PARALLEL
+#if defined(H5_HAVE_PARALLEL) || defined(PIO_THREADS)
 
+#ifdef PIO_THREADS
+#include "pio_thread.h"
+#else
 #include <mpi.h>
+#endif  /* PIO_THREADS */
+
+#if defined(__linux__)
+#   define PIO_HAVE_PERF_EVENT
+#   include <string.h>
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#   include <linux/perf_event.h>
+#endif  /* __linux__ */
+
+/* The bandwidth sampler is a thread waiting on the monotonic clock */
+#if defined(__linux__) && defined(__GNUC__)
+#   define PIO_HAVE_SAMPLER
+#   include <errno.h>
+#   include <pthread.h>
+#   include <time.h>
+#endif  /* __linux__ */
 
 #include "pio_perf.h"
 
@@ -36,8 +59,48 @@
  */
 #define MICROSECOND     1000000.0
 
+/* The timers whose transfers the bandwidth sampler follows */
+#define SAMPLED_TIMER(t)    ((t) == HDF5_GROSS_WRITE_FIXED_DIMS || \
+                             (t) == HDF5_GROSS_READ_FIXED_DIMS)
+
+/* The bytes one timer saw moved, at every tick of the sampler */
+typedef struct pio_series_ {
+    long long  *bytes;          /* bytes moved so far, at each tick     */
+    long        count;          /* number of ticks                      */
+    long        alloc;          /* room in BYTES                        */
+    long long   total;          /* bytes moved so far                   */
+    double      elapsed;        /* seconds the timer ran so far         */
+} pio_series;
+
+/*
+ * The sampler thread wakes every INTERVAL seconds of the running timer and
+ * notes the bytes the I/O loop has counted.  The I/O loop adds to BYTES
+ * and the thread reads it while a timer runs, both with relaxed atomics:
+ * a plain or volatile counter would be a data race, and a torn read on a
+ * 32-bit target.  The thread makes no MPI calls.
+ */
+struct pio_sampler_ {
+    double      interval;       /* seconds between ticks                */
+    long long   bytes;          /* bytes moved by the running timer     */
+    pio_series  series[NUM_TIMERS];
+#ifdef PIO_HAVE_SAMPLER
+    pio_series *active;         /* series of the running timer, or NULL */
+    double      t0;             /* clock at tick 0 of the active series */
+    int         stop;           /* tell the thread to finish            */
+    pthread_t   thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif  /* PIO_HAVE_SAMPLER */
+};
+
 /* global variables */
-pio_time   *timer_g;            /* timer: global for stub functions     */
+PIO_TLS pio_time *timer_g;      /* timer: global for stub functions     */
+
+static void read_counters(pio_time *pt, long long *vals);
+#ifdef PIO_HAVE_SAMPLER
+static void sampler_start(struct pio_sampler_ *s, timer_type t);
+static void sampler_stop(struct pio_sampler_ *s);
+#endif  /* PIO_HAVE_SAMPLER */
 
 /*
  * Function:  sub_time
@@ -69,6 +132,10 @@ pio_time *
 pio_time_new(clock_type type)
 {
     pio_time *pt = (pio_time *)calloc(1, sizeof(struct pio_time_));
+    int c;
+
+    for (c = 0; c < NUM_COUNTERS; c++)
+        pt->counter_fd[c] = -1;
 
     /* set global timer variable */
     timer_g = pt;
@@ -89,6 +156,29 @@ pio_time_new(clock_type type)
 void
 pio_time_destroy(pio_time *pt)
 {
+#ifdef PIO_HAVE_PERF_EVENT
+    int c;
+
+    if (pt)
+        for (c = 0; c < NUM_COUNTERS; c++)
+            if (pt->counter_fd[c] >= 0)
+                close(pt->counter_fd[c]);
+#endif  /* PIO_HAVE_PERF_EVENT */
+
+    if (pt && pt->sampler) {
+        struct pio_sampler_ *s = pt->sampler;
+        int t;
+
+#ifdef PIO_HAVE_SAMPLER
+        sampler_stop(s);
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->wake);
+#endif  /* PIO_HAVE_SAMPLER */
+        for (t = 0; t < NUM_TIMERS; t++)
+            HDfree(s->series[t].bytes);
+        HDfree(s);
+    }
+
     HDfree(pt);
     /* reset the global timer pointer too. */
     timer_g = NULL;
@@ -122,6 +212,98 @@ get_timer_type(pio_time *pt)
     return pt->type;
 }
 
+/*
+ * Function:    pio_time_counters
+ * Purpose:     Make the timers of PT also count CPU cycles, instructions,
+ *              cache misses, context switches, page faults and CPU time of
+ *              the calling process, kernel included where the system
+ *              allows it.  Each event is opened on its own, so events
+ *              the hardware or perf_event_paranoid rule out are left out
+ *              without losing the others.
+ * Return:      Number of events that can be counted
+ * Modifications:
+ */
+int
+pio_time_counters(pio_time *pt)
+{
+    int n = 0;
+
+#ifdef PIO_HAVE_PERF_EVENT
+    static const struct {
+        unsigned type;
+        unsigned long long config;
+    } events[NUM_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    };
+    int c;
+
+    for (c = 0; c < NUM_COUNTERS; c++) {
+        struct perf_event_attr attr;
+        int user_only;
+
+        if (pt->counter_fd[c] >= 0) {
+            n++;
+            continue;
+        }
+
+        /* count the kernel too if allowed, the user part otherwise */
+        for (user_only = 0; user_only < 2 && pt->counter_fd[c] < 0; user_only++) {
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[c].type;
+            attr.config = events[c].config;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = user_only;
+            attr.exclude_hv = 1;
+            pt->counter_fd[c] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        if (pt->counter_fd[c] >= 0)
+            n++;
+    }
+#endif  /* PIO_HAVE_PERF_EVENT */
+
+    pt->counters = n > 0;
+    return n;
+}
+
+/*
+ * Function:    read_counters
+ * Purpose:     Read the event counters of PT into VALS, scaled up for the
+ *              time an event was multiplexed out.  Events that are not
+ *              counted read as 0.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+read_counters(pio_time *pt, long long *vals)
+{
+    int c;
+
+    for (c = 0; c < NUM_COUNTERS; c++) {
+#ifdef PIO_HAVE_PERF_EVENT
+        unsigned long long buf[3];  /* value, time enabled, time running */
+
+        if (pt->counter_fd[c] >= 0 &&
+                read(pt->counter_fd[c], buf, sizeof(buf)) == (ssize_t)sizeof(buf)) {
+            if (buf[2] > 0 && buf[2] < buf[1])
+                vals[c] = (long long)((double)buf[0] * buf[1] / buf[2]);
+            else
+                vals[c] = (long long)buf[0];
+            continue;
+        }
+#endif  /* PIO_HAVE_PERF_EVENT */
+
+        vals[c] = 0;
+    }
+}
+
 /*
  * Function:    set_time
  * Purpose:     Set the time in a ``pio_time'' object.
@@ -133,6 +315,14 @@ pio_time *
 set_time(pio_time *pt, timer_type t, int start_stop)
 {
     if (pt) {
+        if (pt->counters && start_stop == TSTART)
+            read_counters(pt, pt->counter_start[t]);
+
+#ifdef PIO_HAVE_SAMPLER
+        if (pt->sampler && SAMPLED_TIMER(t) && start_stop == TSTART)
+            sampler_start(pt->sampler, t);
+#endif  /* PIO_HAVE_SAMPLER */
+
         if (pt->type == MPI_TIMER) {
             if (start_stop == TSTART) {
                 pt->mpi_timer[t] = MPI_Wtime();
@@ -188,6 +378,20 @@ set_time(pio_time *pt, timer_type t, int start_stop)
             }
         }
 
+        if (pt->counters && start_stop == TSTOP) {
+            long long now[NUM_COUNTERS];
+            int c;
+
+            read_counters(pt, now);
+            for (c = 0; c < NUM_COUNTERS; c++)
+                pt->counter_total[t][c] += now[c] - pt->counter_start[t][c];
+        }
+
+#ifdef PIO_HAVE_SAMPLER
+        if (pt->sampler && SAMPLED_TIMER(t) && start_stop == TSTOP)
+            sampler_stop(pt->sampler);
+#endif  /* PIO_HAVE_SAMPLER */
+
         if (pio_debug_level >= 4) {
             const char *msg;
             int myrank;
@@ -252,6 +456,211 @@ get_time(pio_time *pt, timer_type t)
     return pt->total_time[t];
 }
 
+/*
+ * Function:    get_counter
+ * Purpose:     Get the count of event C while timer T was running.
+ * Return:      The count, or -1 if the event is not counted
+ * Modifications:
+ */
+long long
+get_counter(pio_time *pt, timer_type t, counter_type c)
+{
+    if (!pt->counters || pt->counter_fd[c] < 0)
+        return -1;
+    return pt->counter_total[t][c];
+}
+
+#ifdef PIO_HAVE_SAMPLER
+/*
+ * Function:    sampler_clock
+ * Purpose:     Read the clock the sampler thread waits on.
+ * Return:      Seconds
+ * Modifications:
+ */
+static double
+sampler_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*
+ * Function:    sampler_main
+ * Purpose:     Body of the sampler thread: note the bytes moved at every
+ *              tick of the active series until told to stop.  Ticks
+ *              are kept on the timer's own clock, so a late wakeup does
+ *              not shift the ones after it.
+ * Return:      NULL
+ * Modifications:
+ */
+static void *
+sampler_main(void *arg)
+{
+    struct pio_sampler_ *s = (struct pio_sampler_ *)arg;
+    pio_series *sr = s->active;
+
+    pthread_mutex_lock(&s->lock);
+
+    while (!s->stop) {
+        double tick = s->t0 + (double)(sr->count + 1) * s->interval;
+        struct timespec ts;
+
+        ts.tv_sec = (time_t)tick;
+        ts.tv_nsec = (long)((tick - (double)ts.tv_sec) * 1e9);
+        if (ts.tv_nsec > 999999999L)
+            ts.tv_nsec = 999999999L;
+
+        if (pthread_cond_timedwait(&s->wake, &s->lock, &ts) != ETIMEDOUT || s->stop)
+            continue;
+
+        if (sr->count == sr->alloc) {
+            long alloc = sr->alloc ? 2 * sr->alloc : 1024;
+            long long *bytes = (long long *)realloc(sr->bytes,
+                                                   (size_t)alloc * sizeof(long long));
+
+            /* out of memory: keep what we have */
+            if (!bytes)
+                break;
+            sr->bytes = bytes;
+            sr->alloc = alloc;
+        }
+        sr->bytes[sr->count++] = __atomic_load_n(&s->bytes, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/*
+ * Function:    sampler_start
+ * Purpose:     Start sampling the series of timer T where it left off,
+ *              so the files of a phase make one series of its run time.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+sampler_start(struct pio_sampler_ *s, timer_type t)
+{
+    pio_series *sr = &s->series[t];
+
+    if (s->active)
+        return;
+
+    s->bytes = sr->total;
+    s->stop = 0;
+    s->t0 = sampler_clock() - sr->elapsed;
+    s->active = sr;
+    if (pthread_create(&s->thread, NULL, sampler_main, s) != 0)
+        s->active = NULL;
+}
+
+/*
+ * Function:    sampler_stop
+ * Purpose:     Stop the sampler thread, if running, and close its series.
+ * Return:      Nothing
+ * Modifications:
+ */
+static void
+sampler_stop(struct pio_sampler_ *s)
+{
+    pio_series *sr = s->active;
+    double now = sampler_clock();
+
+    if (!sr)
+        return;
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+
+    sr->elapsed = now - s->t0;
+    sr->total = s->bytes;
+    s->active = NULL;
+}
+#endif  /* PIO_HAVE_SAMPLER */
+
+/*
+ * Function:    pio_time_sampling
+ * Purpose:     Make the open to close timers of PT sample the bytes
+ *              moved every INTERVAL seconds, as counted by
+ *              add_sample_bytes.
+ * Return:      0 on success, -1 if the system can't sample
+ * Modifications:
+ */
+int
+pio_time_sampling(pio_time *pt, double interval)
+{
+#ifdef PIO_HAVE_SAMPLER
+    struct pio_sampler_ *s;
+    pthread_condattr_t attr;
+
+    if (pt->sampler)
+        return 0;
+
+    if (interval <= 0.0 ||
+            (s = (struct pio_sampler_ *)calloc(1, sizeof(*s))) == NULL)
+        return -1;
+
+    s->interval = interval;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pt->sampler = s;
+    return 0;
+#else
+    return -1;
+#endif  /* PIO_HAVE_SAMPLER */
+}
+
+/*
+ * Function:    add_sample_bytes
+ * Purpose:     Count NBYTES more bytes moved for the bandwidth sampler.
+ *              Called from the transfer loops, so it has to stay cheap.
+ * Return:      Nothing
+ * Modifications:
+ */
+void
+add_sample_bytes(pio_time *pt, long long nbytes)
+{
+    if (pt->sampler)
+#ifdef PIO_HAVE_SAMPLER
+        __atomic_fetch_add(&pt->sampler->bytes, nbytes, __ATOMIC_RELAXED);
+#else
+        pt->sampler->bytes += nbytes;
+#endif  /* PIO_HAVE_SAMPLER */
+}
+
+/*
+ * Function:    get_samples
+ * Purpose:     Get the series timer T sampled: the bytes moved so far at
+ *              each tick in BYTES, and the TOTAL bytes moved in the
+ *              ELAPSED seconds the timer ran.
+ * Return:      Number of ticks, or -1 if the timers don't sample
+ * Modifications:
+ */
+long
+get_samples(pio_time *pt, timer_type t, const long long **bytes,
+            long long *total, double *elapsed)
+{
+    const pio_series *sr;
+
+    if (!pt->sampler)
+        return -1;
+
+    sr = &pt->sampler->series[t];
+    *bytes = sr->bytes;
+    *total = sr->total;
+    *elapsed = sr->elapsed;
+    return sr->count;
+}
+
 #endif /* H5_HAVE_PARALLEL */
 #ifdef STANDALONE
 #include "pio_standalone.c"
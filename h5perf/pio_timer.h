@@ -51,18 +51,37 @@ typedef enum clock_type_ {
     SYS_TIMER = 1   /* Use system clock to measure time     */
 } clock_type;
 
+/* The hardware and software event counters sampled with the timers */
+typedef enum counter_type_ {
+    PIO_CPU_CYCLES,
+    PIO_INSTRUCTIONS,
+    PIO_CACHE_MISSES,
+    PIO_CONTEXT_SWITCHES,
+    PIO_PAGE_FAULTS,
+    PIO_TASK_CLOCK,     /* CPU time in nanoseconds */
+    NUM_COUNTERS
+} counter_type;
+
 /* Miscellaneous identifiers */
 enum {
     TSTART,          /* Start a specified timer              */
     TSTOP            /* Stop a specified timer               */
 };
 
+/* The bandwidth sampler of the open to close timers, see pio_timer.c */
+struct pio_sampler_;
+
 /* The performance time structure */
 typedef struct pio_time_ {
     clock_type type;
     double total_time[NUM_TIMERS];
     double mpi_timer[NUM_TIMERS];
     struct timeval sys_timer[NUM_TIMERS];
+    int counters;                       /* sample the event counters too */
+    int counter_fd[NUM_COUNTERS];       /* -1 if the event can't be counted */
+    long long counter_start[NUM_TIMERS][NUM_COUNTERS];
+    long long counter_total[NUM_TIMERS][NUM_COUNTERS];
+    struct pio_sampler_ *sampler;       /* NULL if not sampling bandwidth */
 } pio_time;
 
 /* External function declarations */
@@ -75,6 +94,13 @@ extern void         set_timer_type(pio_time *pt, clock_type type);
 extern clock_type   get_timer_type(pio_time *pt);
 extern pio_time    *set_time(pio_time *pt, timer_type t, int start_stop);
 extern double       get_time(pio_time *pt, timer_type t);
+extern int          pio_time_counters(pio_time *pt);
+extern long long    get_counter(pio_time *pt, timer_type t, counter_type c);
+extern int          pio_time_sampling(pio_time *pt, double interval);
+extern void         add_sample_bytes(pio_time *pt, long long nbytes);
+extern long         get_samples(pio_time *pt, timer_type t,
+                                const long long **bytes, long long *total,
+                                double *elapsed);
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -0,0 +1,39 @@
+# Production I/O signatures as an h5perf workload: h5perf --workload=FILE
+#
+# Options before the first phase apply to every phase that does not set
+# them itself.  Sizes below suit a small test; scale num-bytes and the
+# transfer sizes up for real runs.
+
+api = phdf5
+num-iterations = 3
+num-bytes = 1M
+
+# Every process dumps its share of the state with collective writes into
+# chunked, stripe aligned datasets and leaves the file for the restart.
+[checkpoint]
+op = write
+collective
+num-dsets = 4
+xfers = 256K:1M
+chunk-dims = 256K
+align = 1M
+threshold = 64K
+hints = romio_cb_write=enable;cb_buffer_size=16777216
+
+# Analysis reads the checkpoint back independently, then removes it.
+[analysis read]
+op = read
+num-dsets = 4
+xfers = 256K:1M
+hints = romio_cb_read=disable
+
+# Small, compressed log records appended step by step and flushed often;
+# parallel HDF5 writes filtered datasets only collectively.
+[log appends]
+append
+collective
+num-bytes = 64K
+xfers = 4K
+append-chunk = 64K
+flush-steps = 4
+filters = shuffle,deflate:4